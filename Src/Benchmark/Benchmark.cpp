@@ -0,0 +1,774 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Training and inference benchmark suite
+//
+// Generates reproducible synthetic data sets, then measures load time, epoch time, training throughput,
+// inference throughput/latency and peak memory usage for a matrix of network sizes and thread counts.
+// Each benchmark thread owns its own network replica so that the thread count measures how well the
+// host scales with multiple independent networks. A separate set of layer shapes times the matrix
+// multiplications of a batched training step with every available GEMM backend. Results are written out as JSON.
+
+#include "NeuralNetwork/Ensemble.h"
+#include "NeuralNetwork/FixedNetwork.h"
+#include "NeuralNetwork/Gemm.h"
+#include "NeuralNetwork/NeuralNetworkTrainer.h"
+#include "NeuralNetwork/TrainingDataReader.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#if _MSC_VER
+#pragma warning(push, 0)
+#pragma warning(disable: 4702)
+#endif
+
+#include "cmdParser.h"
+
+#if _MSC_VER
+#pragma warning(pop)
+#endif
+
+#if _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#if __GLIBC__
+#include <malloc.h>
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    inline double GetElapsedMS( Clock::time_point start, Clock::time_point end )
+    {
+        return std::chrono::duration<double, std::milli>( end - start ).count();
+    }
+
+    // Restarts the peak RSS from the current RSS so that each configuration reports its own peak. Returns false
+    // where that isn't possible and GetPeakRSSKB returns the peak of the whole process.
+    bool ResetPeakRSS()
+    {
+        #if __linux__
+        #if __GLIBC__
+        // Return the heap freed by the previous configuration to the OS so that it isn't counted again
+        malloc_trim( 0 );
+        #endif
+
+        // Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0+)
+        std::ofstream clearRefsFile( "/proc/self/clear_refs" );
+        clearRefsFile << "5";
+        clearRefsFile.close();
+        return !clearRefsFile.fail();
+        #else
+        return false;
+        #endif
+    }
+
+    uint64_t GetPeakRSSKB()
+    {
+        #if _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+        {
+            return (uint64_t) counters.PeakWorkingSetSize / 1024;
+        }
+        return 0;
+        #else
+        #if __linux__
+        // Unlike ru_maxrss, VmHWM follows the resets done by ResetPeakRSS
+        std::ifstream statusFile( "/proc/self/status" );
+        std::string line;
+        while ( std::getline( statusFile, line ) )
+        {
+            if ( line.compare( 0, 6, "VmHWM:" ) == 0 )
+            {
+                return std::stoull( line.substr( 6 ) );
+            }
+        }
+        #endif
+
+        struct rusage usage;
+        if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+        {
+            return 0;
+        }
+
+        #if __APPLE__
+        return (uint64_t) usage.ru_maxrss / 1024;
+        #else
+        return (uint64_t) usage.ru_maxrss;
+        #endif
+        #endif
+    }
+
+    //-------------------------------------------------------------------------
+
+    struct BenchmarkConfig
+    {
+        uint32_t                            m_numRows = 20000;
+        uint32_t                            m_numEpochs = 3;
+        uint32_t                            m_numEvaluationPasses = 1;
+        uint32_t                            m_seed = 42;
+        uint32_t                            m_numEnsembleMembers = 5;
+        std::string                         m_dataDirectory = ".";
+    };
+
+    struct BenchmarkResult
+    {
+        BPN::Network::Settings              m_networkSettings;
+        uint32_t                            m_numThreads = 0;
+        uint32_t                            m_numTrainingRows = 0;
+        uint32_t                            m_numEvaluationRows = 0;
+
+        double                              m_loadTimeMS = 0;
+        double                              m_meanEpochTimeMS = 0;
+        double                              m_trainingSamplesPerSecond = 0;
+        double                              m_evaluationRowsPerSecond = 0;
+
+        double                              m_latencyP50NS = 0;
+        double                              m_latencyP90NS = 0;
+        double                              m_latencyP99NS = 0;
+        double                              m_latencyP999NS = 0;
+        double                              m_latencyMaxNS = 0;
+
+        bool                                m_hasFixedNetworkResult = false;
+        double                              m_fixedNetworkRowsPerSecond = 0;
+        double                              m_fixedNetworkMeanLatencyNS = 0;
+
+        uint32_t                            m_numEnsembleMembers = 0;
+        double                              m_ensembleSeparateRowsPerSecond = 0;   // Each member evaluated with its own Network::Evaluate
+        double                              m_ensemblePackedRowsPerSecond = 0;     // Packed Ensemble::EvaluateBatch
+
+        uint64_t                            m_peakRSSKB = 0;
+        bool                                m_isPeakRSSPerConfiguration = false; // Otherwise the peak of the process so far
+    };
+
+    struct GemmResult
+    {
+        BPN::Network::Settings              m_networkSettings;
+        BPN::Gemm::Backend                  m_backend = BPN::Gemm::Backend::MicroKernel;
+        uint32_t                            m_numRows = 0;
+        double                              m_forwardTimeMS = 0;        // Both layers of the forward pass
+        double                              m_trainingStepTimeMS = 0;   // Forward pass, hidden error gradients and both delta updates
+        double                              m_trainingStepGFlops = 0;
+    };
+
+    //-------------------------------------------------------------------------
+
+    // Parses a network shape in the form "InputsxHiddenxOutputs" i.e. "16x16x3"
+    bool ParseNetworkShape( std::string const& str, BPN::Network::Settings& settings )
+    {
+        uint32_t values[3] = { 0, 0, 0 };
+        char separators[2] = { 0, 0 };
+
+        std::istringstream stream( str );
+        stream >> values[0] >> separators[0] >> values[1] >> separators[1] >> values[2];
+        if ( stream.fail() || separators[0] != 'x' || separators[1] != 'x' || values[0] == 0 || values[1] == 0 || values[2] == 0 )
+        {
+            return false;
+        }
+
+        settings = BPN::Network::Settings{ values[0], values[1], values[2] };
+        return true;
+    }
+
+    // Writes out a synthetic data set matching the format of the example data set: small integer features (0-15)
+    // and 0/1 labels. The labels are produced by a fixed random linear teacher so that the data is learnable.
+    bool GenerateSyntheticDataSet( std::string const& path, BPN::Network::Settings const& settings, uint32_t numRows, uint32_t seed )
+    {
+        std::ofstream outputFile( path, std::ios::out | std::ios::trunc );
+        if ( !outputFile.is_open() )
+        {
+            return false;
+        }
+
+        std::mt19937 generator( seed );
+        std::uniform_int_distribution<int32_t> featureDistribution( 0, 15 );
+        std::normal_distribution<double> teacherDistribution( 0.0, 1.0 );
+
+        std::vector<double> teacherWeights( settings.m_numInputs * settings.m_numOutputs );
+        for ( auto& weight : teacherWeights )
+        {
+            weight = teacherDistribution( generator );
+        }
+
+        std::vector<int32_t> features( settings.m_numInputs );
+        std::string line;
+        for ( uint32_t rowIdx = 0; rowIdx < numRows; rowIdx++ )
+        {
+            line.clear();
+
+            for ( uint32_t inputIdx = 0; inputIdx < settings.m_numInputs; inputIdx++ )
+            {
+                features[inputIdx] = featureDistribution( generator );
+                line += std::to_string( features[inputIdx] );
+                line += ',';
+            }
+
+            for ( uint32_t outputIdx = 0; outputIdx < settings.m_numOutputs; outputIdx++ )
+            {
+                // Center the features so that the labels are roughly balanced
+                double sum = 0;
+                for ( uint32_t inputIdx = 0; inputIdx < settings.m_numInputs; inputIdx++ )
+                {
+                    sum += ( features[inputIdx] - 7.5 ) * teacherWeights[outputIdx * settings.m_numInputs + inputIdx];
+                }
+
+                line += ( sum > 0 ) ? '1' : '0';
+                line += ( outputIdx < settings.m_numOutputs - 1 ) ? ',' : '\n';
+            }
+
+            outputFile << line;
+        }
+
+        return outputFile.good();
+    }
+
+    //-------------------------------------------------------------------------
+
+    void RunTrainingBenchmark( BenchmarkConfig const& config, BPN::TrainingData const& trainingData, BenchmarkResult& result )
+    {
+        uint32_t const numThreads = result.m_numThreads;
+        std::vector<double> threadEpochTimesMS( numThreads, 0.0 );
+
+        auto TrainingThread = [&] ( uint32_t threadIdx )
+        {
+            BPN::Network network( result.m_networkSettings );
+
+            BPN::NetworkTrainer::Settings trainerSettings;
+            BPN::NetworkTrainer trainer( trainerSettings, &network );
+
+            double totalEpochTimeMS = 0;
+            for ( uint32_t epochIdx = 0; epochIdx < config.m_numEpochs; epochIdx++ )
+            {
+                auto const epochStart = Clock::now();
+                trainer.RunEpoch( trainingData.m_trainingSet );
+                totalEpochTimeMS += GetElapsedMS( epochStart, Clock::now() );
+            }
+
+            threadEpochTimesMS[threadIdx] = totalEpochTimeMS / config.m_numEpochs;
+        };
+
+        std::vector<std::thread> threads;
+        auto const benchmarkStart = Clock::now();
+        for ( uint32_t threadIdx = 0; threadIdx < numThreads; threadIdx++ )
+        {
+            threads.emplace_back( TrainingThread, threadIdx );
+        }
+
+        for ( auto& thread : threads )
+        {
+            thread.join();
+        }
+        double const totalTimeMS = GetElapsedMS( benchmarkStart, Clock::now() );
+
+        double meanEpochTimeMS = 0;
+        for ( auto epochTimeMS : threadEpochTimesMS )
+        {
+            meanEpochTimeMS += epochTimeMS;
+        }
+
+        double const totalSamples = (double) trainingData.m_trainingSet.size() * config.m_numEpochs * numThreads;
+        result.m_numTrainingRows = (uint32_t) trainingData.m_trainingSet.size();
+        result.m_meanEpochTimeMS = meanEpochTimeMS / numThreads;
+        result.m_trainingSamplesPerSecond = totalSamples / ( totalTimeMS / 1000.0 );
+    }
+
+    void RunEvaluationBenchmark( BenchmarkConfig const& config, BPN::TrainingData const& trainingData, BenchmarkResult& result )
+    {
+        // Score every row we loaded, regardless of which set it ended up in
+        BPN::TrainingSet const* sets[] = { &trainingData.m_trainingSet, &trainingData.m_generalizationSet, &trainingData.m_validationSet };
+
+        uint32_t const numThreads = result.m_numThreads;
+        std::vector<std::vector<double>> threadLatenciesNS( numThreads );
+        BPN::Network const referenceNetwork( result.m_networkSettings );
+
+        auto EvaluationThread = [&] ( uint32_t threadIdx )
+        {
+            BPN::Network network( referenceNetwork );
+            std::vector<double>& latencies = threadLatenciesNS[threadIdx];
+
+            for ( uint32_t passIdx = 0; passIdx < config.m_numEvaluationPasses; passIdx++ )
+            {
+                for ( auto pSet : sets )
+                {
+                    for ( auto const& entry : *pSet )
+                    {
+                        auto const evaluationStart = Clock::now();
+                        network.Evaluate( entry.m_inputs );
+                        auto const evaluationEnd = Clock::now();
+                        latencies.push_back( std::chrono::duration<double, std::nano>( evaluationEnd - evaluationStart ).count() );
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        auto const benchmarkStart = Clock::now();
+        for ( uint32_t threadIdx = 0; threadIdx < numThreads; threadIdx++ )
+        {
+            threads.emplace_back( EvaluationThread, threadIdx );
+        }
+
+        for ( auto& thread : threads )
+        {
+            thread.join();
+        }
+        double const totalTimeMS = GetElapsedMS( benchmarkStart, Clock::now() );
+
+        // Merge and sort all latencies to get the percentiles
+        std::vector<double> latencies;
+        for ( auto const& threadLatencies : threadLatenciesNS )
+        {
+            latencies.insert( latencies.end(), threadLatencies.begin(), threadLatencies.end() );
+        }
+
+        if ( latencies.empty() )
+        {
+            return;
+        }
+
+        std::sort( latencies.begin(), latencies.end() );
+        auto GetPercentile = [&latencies] ( double percentile )
+        {
+            size_t const idx = std::min( latencies.size() - 1, (size_t) ( percentile / 100.0 * latencies.size() ) );
+            return latencies[idx];
+        };
+
+        result.m_numEvaluationRows = (uint32_t) ( latencies.size() / numThreads / config.m_numEvaluationPasses );
+        result.m_evaluationRowsPerSecond = latencies.size() / ( totalTimeMS / 1000.0 );
+        result.m_latencyP50NS = GetPercentile( 50 );
+        result.m_latencyP90NS = GetPercentile( 90 );
+        result.m_latencyP99NS = GetPercentile( 99 );
+        result.m_latencyP999NS = GetPercentile( 99.9 );
+        result.m_latencyMaxNS = latencies.back();
+    }
+
+    // Compile-time specialized networks can only be benchmarked for the shapes compiled in here
+    template<uint32_t NumInputs, uint32_t NumHidden, uint32_t NumOutputs>
+    void RunFixedNetworkEvaluationBenchmark( BenchmarkConfig const& config, BPN::TrainingData const& trainingData, BenchmarkResult& result )
+    {
+        typedef BPN::FixedNetwork<NumInputs, NumHidden, NumOutputs> FixedNetworkType;
+
+        if ( result.m_networkSettings.m_numInputs != NumInputs || result.m_networkSettings.m_numHidden != NumHidden || result.m_networkSettings.m_numOutputs != NumOutputs )
+        {
+            return;
+        }
+
+        // Convert all rows up front so that the conversion isn't timed
+        std::vector<typename FixedNetworkType::InputArray> inputs;
+        for ( auto pSet : { &trainingData.m_trainingSet, &trainingData.m_generalizationSet, &trainingData.m_validationSet } )
+        {
+            for ( auto const& entry : *pSet )
+            {
+                typename FixedNetworkType::InputArray input;
+                std::copy( entry.m_inputs.begin(), entry.m_inputs.end(), input.begin() );
+                inputs.push_back( input );
+            }
+        }
+
+        BPN::Network const referenceNetwork( result.m_networkSettings );
+        FixedNetworkType const fixedNetwork( referenceNetwork );
+
+        uint32_t const numThreads = result.m_numThreads;
+        std::vector<int64_t> threadChecksums( numThreads, 0 );
+
+        auto EvaluationThread = [&] ( uint32_t threadIdx )
+        {
+            int64_t checksum = 0;
+            for ( uint32_t passIdx = 0; passIdx < config.m_numEvaluationPasses; passIdx++ )
+            {
+                for ( auto const& input : inputs )
+                {
+                    checksum += fixedNetwork.Evaluate( input )[0];
+                }
+            }
+            threadChecksums[threadIdx] = checksum;
+        };
+
+        std::vector<std::thread> threads;
+        auto const benchmarkStart = Clock::now();
+        for ( uint32_t threadIdx = 0; threadIdx < numThreads; threadIdx++ )
+        {
+            threads.emplace_back( EvaluationThread, threadIdx );
+        }
+
+        for ( auto& thread : threads )
+        {
+            thread.join();
+        }
+        double const totalTimeMS = GetElapsedMS( benchmarkStart, Clock::now() );
+
+        double const numEvaluatedRows = (double) inputs.size() * config.m_numEvaluationPasses * numThreads;
+        result.m_hasFixedNetworkResult = true;
+        result.m_fixedNetworkRowsPerSecond = numEvaluatedRows / ( totalTimeMS / 1000.0 );
+        result.m_fixedNetworkMeanLatencyNS = ( totalTimeMS * 1000000.0 * numThreads ) / numEvaluatedRows;
+    }
+
+    // Compares evaluating the members of an ensemble one by one against the packed ensemble kernel
+    void RunEnsembleEvaluationBenchmark( BenchmarkConfig const& config, BPN::TrainingData const& trainingData, BenchmarkResult& result )
+    {
+        uint32_t const numInputs = result.m_networkSettings.m_numInputs;
+        uint32_t const numOutputs = result.m_networkSettings.m_numOutputs;
+        uint32_t const numMembers = config.m_numEnsembleMembers;
+        if ( numMembers == 0 )
+        {
+            return;
+        }
+
+        std::vector<std::vector<double> const*> inputs;
+        for ( auto pSet : { &trainingData.m_trainingSet, &trainingData.m_generalizationSet, &trainingData.m_validationSet } )
+        {
+            for ( auto const& entry : *pSet )
+            {
+                inputs.push_back( &entry.m_inputs );
+            }
+        }
+
+        // The packed kernel reads contiguous rows, convert them up front so that the conversion isn't timed
+        std::vector<double> contiguousInputs;
+        contiguousInputs.reserve( inputs.size() * numInputs );
+        for ( auto pInput : inputs )
+        {
+            contiguousInputs.insert( contiguousInputs.end(), pInput->begin(), pInput->end() );
+        }
+
+        BPN::Ensemble::Settings ensembleSettings;
+        ensembleSettings.m_numMembers = numMembers;
+        BPN::Ensemble const ensemble( ensembleSettings, result.m_networkSettings );
+
+        uint32_t const numThreads = result.m_numThreads;
+        std::vector<double> threadChecksums( numThreads, 0 );
+
+        auto SeparateEvaluationThread = [&] ( uint32_t threadIdx )
+        {
+            std::vector<BPN::Network> members;
+            for ( uint32_t memberIdx = 0; memberIdx < numMembers; memberIdx++ )
+            {
+                members.push_back( ensemble.GetMember( memberIdx ) );
+            }
+
+            std::vector<double> combinedOutputs( numOutputs );
+            double checksum = 0;
+            for ( uint32_t passIdx = 0; passIdx < config.m_numEvaluationPasses; passIdx++ )
+            {
+                for ( auto pInput : inputs )
+                {
+                    std::fill( combinedOutputs.begin(), combinedOutputs.end(), 0.0 );
+                    for ( auto& member : members )
+                    {
+                        member.Evaluate( *pInput );
+                        for ( uint32_t outputIdx = 0; outputIdx < numOutputs; outputIdx++ )
+                        {
+                            combinedOutputs[outputIdx] += member.GetOutputs()[outputIdx] / numMembers;
+                        }
+                    }
+                    checksum += combinedOutputs[0];
+                }
+            }
+            threadChecksums[threadIdx] = checksum;
+        };
+
+        auto PackedEvaluationThread = [&] ( uint32_t threadIdx )
+        {
+            uint32_t const batchSize = 64;
+            std::vector<double> outputs( batchSize * numOutputs );
+            std::vector<int32_t> clampedOutputs( batchSize * numOutputs );
+            double checksum = 0;
+            for ( uint32_t passIdx = 0; passIdx < config.m_numEvaluationPasses; passIdx++ )
+            {
+                for ( size_t batchStart = 0; batchStart < inputs.size(); batchStart += batchSize )
+                {
+                    uint32_t const numEntries = (uint32_t) std::min( (size_t) batchSize, inputs.size() - batchStart );
+                    ensemble.EvaluateBatch( &contiguousInputs[batchStart * numInputs], numEntries, outputs.data(), clampedOutputs.data() );
+                    checksum += outputs[0];
+                }
+            }
+            threadChecksums[threadIdx] = checksum;
+        };
+
+        auto TimeThreads = [numThreads] ( std::function<void( uint32_t )> const& threadFunction )
+        {
+            std::vector<std::thread> threads;
+            auto const benchmarkStart = Clock::now();
+            for ( uint32_t threadIdx = 0; threadIdx < numThreads; threadIdx++ )
+            {
+                threads.emplace_back( threadFunction, threadIdx );
+            }
+
+            for ( auto& thread : threads )
+            {
+                thread.join();
+            }
+            return GetElapsedMS( benchmarkStart, Clock::now() );
+        };
+
+        double const numEvaluatedRows = (double) inputs.size() * config.m_numEvaluationPasses * numThreads;
+        result.m_numEnsembleMembers = numMembers;
+        result.m_ensembleSeparateRowsPerSecond = numEvaluatedRows / ( TimeThreads( SeparateEvaluationThread ) / 1000.0 );
+        result.m_ensemblePackedRowsPerSecond = numEvaluatedRows / ( TimeThreads( PackedEvaluationThread ) / 1000.0 );
+    }
+
+    // Times the multiplications made by NetworkTrainer's batch path for one tile of rows, repeated for at least the minimum time
+    GemmResult RunGemmBenchmark( BPN::Network::Settings const& settings, BPN::Gemm::Backend backend, uint32_t numRows, uint32_t seed )
+    {
+        uint32_t const I = settings.m_numInputs;
+        uint32_t const H = settings.m_numHidden;
+        uint32_t const O = settings.m_numOutputs;
+
+        std::mt19937 generator( seed );
+        std::uniform_real_distribution<double> distribution( -1.0, 1.0 );
+        auto CreateMatrix = [&] ( size_t numValues )
+        {
+            std::vector<double> matrix( numValues );
+            for ( auto& value : matrix )
+            {
+                value = distribution( generator );
+            }
+            return matrix;
+        };
+
+        std::vector<double> const inputs = CreateMatrix( (size_t) numRows * I );
+        std::vector<double> const weightsInputHidden = CreateMatrix( (size_t) I * H );
+        std::vector<double> const weightsHiddenOutput = CreateMatrix( (size_t) ( H + 1 ) * O );
+        std::vector<double> const errorGradientsOutput = CreateMatrix( (size_t) numRows * O );
+        std::vector<double> hidden = CreateMatrix( (size_t) numRows * ( H + 1 ) );
+        std::vector<double> outputs( (size_t) numRows * O );
+        std::vector<double> errorGradientsHidden( (size_t) numRows * H );
+        std::vector<double> deltaInputHidden( (size_t) I * H, 0.0 );
+        std::vector<double> deltaHiddenOutput( (size_t) ( H + 1 ) * O, 0.0 );
+
+        auto Forward = [&] ()
+        {
+            BPN::Gemm::Multiply( backend, false, false, numRows, H, I, 1.0, inputs.data(), I, weightsInputHidden.data(), H, 0.0, hidden.data(), H + 1 );
+            BPN::Gemm::Multiply( backend, false, false, numRows, O, H + 1, 1.0, hidden.data(), H + 1, weightsHiddenOutput.data(), O, 0.0, outputs.data(), O );
+        };
+
+        auto TrainingStep = [&] ()
+        {
+            Forward();
+            BPN::Gemm::Multiply( backend, false, true, numRows, H, O, 1.0, errorGradientsOutput.data(), O, weightsHiddenOutput.data(), O, 0.0, errorGradientsHidden.data(), H );
+            BPN::Gemm::Multiply( backend, true, false, H + 1, O, numRows, 0.001, hidden.data(), H + 1, errorGradientsOutput.data(), O, 1.0, deltaHiddenOutput.data(), O );
+            BPN::Gemm::Multiply( backend, true, false, I, H, numRows, 0.001, inputs.data(), I, errorGradientsHidden.data(), H, 1.0, deltaInputHidden.data(), H );
+        };
+
+        auto TimeRepeated = [] ( std::function<void()> const& function )
+        {
+            uint32_t numRepetitions = 0;
+            auto const startTime = Clock::now();
+            do
+            {
+                function();
+                numRepetitions++;
+            }
+            while ( GetElapsedMS( startTime, Clock::now() ) < 200.0 );
+            return GetElapsedMS( startTime, Clock::now() ) / numRepetitions;
+        };
+
+        GemmResult result;
+        result.m_networkSettings = settings;
+        result.m_backend = backend;
+        result.m_numRows = numRows;
+        result.m_forwardTimeMS = TimeRepeated( Forward );
+        result.m_trainingStepTimeMS = TimeRepeated( TrainingStep );
+
+        double const numFlops = 2.0 * numRows * ( (double) I * H + ( H + 1.0 ) * O ) * 3.0;
+        result.m_trainingStepGFlops = numFlops / ( result.m_trainingStepTimeMS / 1000.0 ) / 1e9;
+        return result;
+    }
+
+    //-------------------------------------------------------------------------
+
+    void WriteResultsJSON( std::ostream& stream, BenchmarkConfig const& config, std::vector<BenchmarkResult> const& results, std::vector<GemmResult> const& gemmResults )
+    {
+        stream << "{\n";
+        stream << "  \"config\": { \"rows\": " << config.m_numRows << ", \"epochs\": " << config.m_numEpochs << ", \"evaluationPasses\": " << config.m_numEvaluationPasses << ", \"seed\": " << config.m_seed << ", \"hardwareThreads\": " << std::thread::hardware_concurrency() << " },\n";
+        stream << "  \"results\": [\n";
+
+        for ( size_t resultIdx = 0; resultIdx < results.size(); resultIdx++ )
+        {
+            BenchmarkResult const& result = results[resultIdx];
+            stream << "    {\n";
+            stream << "      \"inputs\": " << result.m_networkSettings.m_numInputs << ", \"hidden\": " << result.m_networkSettings.m_numHidden << ", \"outputs\": " << result.m_networkSettings.m_numOutputs << ", \"threads\": " << result.m_numThreads << ",\n";
+            stream << "      \"loadTimeMs\": " << result.m_loadTimeMS << ",\n";
+            stream << "      \"training\": { \"rows\": " << result.m_numTrainingRows << ", \"epochTimeMs\": " << result.m_meanEpochTimeMS << ", \"samplesPerSec\": " << result.m_trainingSamplesPerSecond << " },\n";
+            stream << "      \"inference\": { \"rows\": " << result.m_numEvaluationRows << ", \"rowsPerSec\": " << result.m_evaluationRowsPerSecond << ", \"latencyNs\": { \"p50\": " << result.m_latencyP50NS << ", \"p90\": " << result.m_latencyP90NS << ", \"p99\": " << result.m_latencyP99NS << ", \"p999\": " << result.m_latencyP999NS << ", \"max\": " << result.m_latencyMaxNS << " } },\n";
+            if ( result.m_hasFixedNetworkResult )
+            {
+                stream << "      \"fixedNetworkInference\": { \"rowsPerSec\": " << result.m_fixedNetworkRowsPerSecond << ", \"meanLatencyNs\": " << result.m_fixedNetworkMeanLatencyNS << " },\n";
+            }
+            if ( result.m_numEnsembleMembers > 0 )
+            {
+                stream << "      \"ensembleInference\": { \"members\": " << result.m_numEnsembleMembers << ", \"separateRowsPerSec\": " << result.m_ensembleSeparateRowsPerSecond << ", \"packedRowsPerSec\": " << result.m_ensemblePackedRowsPerSecond << " },\n";
+            }
+            stream << "      \"peakRssKb\": " << result.m_peakRSSKB << ", \"peakRssScope\": \"" << ( result.m_isPeakRSSPerConfiguration ? "configuration" : "process" ) << "\"\n";
+            stream << "    }" << ( resultIdx < results.size() - 1 ? "," : "" ) << "\n";
+        }
+
+        stream << "  ],\n";
+        stream << "  \"gemm\": [\n";
+
+        for ( size_t resultIdx = 0; resultIdx < gemmResults.size(); resultIdx++ )
+        {
+            GemmResult const& result = gemmResults[resultIdx];
+            stream << "    { \"inputs\": " << result.m_networkSettings.m_numInputs << ", \"hidden\": " << result.m_networkSettings.m_numHidden << ", \"outputs\": " << result.m_networkSettings.m_numOutputs
+                   << ", \"backend\": \"" << BPN::Gemm::GetBackendName( result.m_backend ) << "\", \"rows\": " << result.m_numRows << ", \"forwardMs\": " << result.m_forwardTimeMS
+                   << ", \"trainingStepMs\": " << result.m_trainingStepTimeMS << ", \"trainingStepGflops\": " << result.m_trainingStepGFlops << " }" << ( resultIdx < gemmResults.size() - 1 ? "," : "" ) << "\n";
+        }
+
+        stream << "  ]\n";
+        stream << "}\n";
+    }
+}
+
+//-------------------------------------------------------------------------
+
+int main( int argc, char* argv[] )
+{
+    cli::Parser cmdParser( argc, argv );
+    cmdParser.set_optional<std::vector<std::string>>( "sizes", "NetworkSizes", { "16x16x3", "64x64x8", "256x128x16" }, "Network sizes to benchmark in the form InputsxHiddenxOutputs." );
+    cmdParser.set_optional<std::vector<uint32_t>>( "threads", "ThreadCounts", { 1, 2, 4 }, "Thread counts to benchmark." );
+    cmdParser.set_optional<uint32_t>( "rows", "NumRows", 20000, "Num rows in each synthetic data set." );
+    cmdParser.set_optional<uint32_t>( "epochs", "NumEpochs", 3, "Num training epochs to time." );
+    cmdParser.set_optional<uint32_t>( "passes", "NumEvaluationPasses", 1, "Num evaluation passes over the data set." );
+    cmdParser.set_optional<uint32_t>( "seed", "Seed", 42, "Seed used to generate and split the synthetic data sets and to initialize the networks." );
+    cmdParser.set_optional<uint32_t>( "ensemble", "NumEnsembleMembers", 5, "Num members for the ensemble inference benchmark, 0 to skip it." );
+    cmdParser.set_optional<std::vector<std::string>>( "gemmSizes", "GemmNetworkSizes", { "16x16x3", "64x64x8", "256x256x16", "1024x1024x16", "4096x4096x16" }, "Network sizes for the GEMM backend benchmark, none to skip it." );
+    cmdParser.set_optional<uint32_t>( "gemmRows", "GemmRows", 64, "Rows per batched training step in the GEMM backend benchmark." );
+    cmdParser.set_optional<std::string>( "tmp", "DataDirectory", ".", "Directory in which to write the synthetic data sets." );
+    cmdParser.set_optional<std::string>( "o", "Output", "BenchmarkResults.json", "Path to the JSON results file." );
+
+    if ( !cmdParser.run() )
+    {
+        std::cout << "Invalid command line arguments";
+        return 1;
+    }
+
+    BenchmarkConfig config;
+    config.m_numRows = cmdParser.get<uint32_t>( "rows" );
+    config.m_numEpochs = std::max( 1u, cmdParser.get<uint32_t>( "epochs" ) );
+    config.m_numEvaluationPasses = std::max( 1u, cmdParser.get<uint32_t>( "passes" ) );
+    config.m_seed = cmdParser.get<uint32_t>( "seed" );
+    config.m_numEnsembleMembers = cmdParser.get<uint32_t>( "ensemble" );
+    config.m_dataDirectory = cmdParser.get<std::string>( "tmp" );
+
+    std::vector<BPN::Network::Settings> networkSizes;
+    for ( auto const& sizeStr : cmdParser.get<std::vector<std::string>>( "sizes" ) )
+    {
+        BPN::Network::Settings settings;
+        if ( !ParseNetworkShape( sizeStr, settings ) )
+        {
+            std::cout << "Invalid network size: " << sizeStr << std::endl;
+            return 1;
+        }
+        settings.m_seed = config.m_seed;
+        networkSizes.push_back( settings );
+    }
+
+    std::vector<uint32_t> threadCounts = cmdParser.get<std::vector<uint32_t>>( "threads" );
+    threadCounts.erase( std::remove( threadCounts.begin(), threadCounts.end(), 0u ), threadCounts.end() );
+
+    // Run benchmark matrix
+    //-------------------------------------------------------------------------
+
+    std::vector<BenchmarkResult> results;
+    for ( auto const& networkSettings : networkSizes )
+    {
+        std::string const dataPath = config.m_dataDirectory + "/BenchmarkData_" + std::to_string( networkSettings.m_numInputs ) + "_" + std::to_string( networkSettings.m_numOutputs ) + ".csv";
+        if ( !GenerateSyntheticDataSet( dataPath, networkSettings, config.m_numRows, config.m_seed ) )
+        {
+            std::cout << "Failed to write synthetic data set: " << dataPath << std::endl;
+            return 1;
+        }
+
+        auto const loadStart = Clock::now();
+        BPN::TrainingDataReader dataReader( dataPath, networkSettings.m_numInputs, networkSettings.m_numOutputs, BPN::NormalizationType::None, config.m_seed );
+        bool const dataLoaded = dataReader.ReadData();
+        double const loadTimeMS = GetElapsedMS( loadStart, Clock::now() );
+        std::remove( dataPath.c_str() );
+
+        if ( !dataLoaded )
+        {
+            return 1;
+        }
+
+        for ( auto numThreads : threadCounts )
+        {
+            std::cout << "Benchmarking " << networkSettings.m_numInputs << "x" << networkSettings.m_numHidden << "x" << networkSettings.m_numOutputs << " with " << numThreads << " thread(s)" << std::endl;
+
+            BenchmarkResult result;
+            result.m_networkSettings = networkSettings;
+            result.m_numThreads = numThreads;
+            result.m_loadTimeMS = loadTimeMS;
+            result.m_isPeakRSSPerConfiguration = ResetPeakRSS();
+
+            RunTrainingBenchmark( config, dataReader.GetTrainingData(), result );
+            RunEvaluationBenchmark( config, dataReader.GetTrainingData(), result );
+            RunFixedNetworkEvaluationBenchmark<16, 16, 3>( config, dataReader.GetTrainingData(), result );
+            RunEnsembleEvaluationBenchmark( config, dataReader.GetTrainingData(), result );
+            result.m_peakRSSKB = GetPeakRSSKB();
+
+            results.push_back( result );
+        }
+    }
+
+    // GEMM backends
+    //-------------------------------------------------------------------------
+
+    std::vector<GemmResult> gemmResults;
+    for ( auto const& sizeStr : cmdParser.get<std::vector<std::string>>( "gemmSizes" ) )
+    {
+        BPN::Network::Settings settings;
+        if ( sizeStr == "none" )
+        {
+            continue;
+        }
+
+        if ( !ParseNetworkShape( sizeStr, settings ) )
+        {
+            std::cout << "Invalid network size: " << sizeStr << std::endl;
+            return 1;
+        }
+
+        for ( auto backend : { BPN::Gemm::Backend::Reference, BPN::Gemm::Backend::MicroKernel, BPN::Gemm::Backend::Blas } )
+        {
+            if ( BPN::Gemm::IsBackendAvailable( backend ) )
+            {
+                GemmResult const result = RunGemmBenchmark( settings, backend, std::max( 1u, cmdParser.get<uint32_t>( "gemmRows" ) ), config.m_seed );
+                std::cout << "GEMM " << sizeStr << " " << BPN::Gemm::GetBackendName( result.m_backend ) << ": forward " << result.m_forwardTimeMS << " ms, training step " << result.m_trainingStepTimeMS << " ms (" << result.m_trainingStepGFlops << " GFLOP/s)" << std::endl;
+                gemmResults.push_back( result );
+            }
+        }
+    }
+
+    // Output results
+    //-------------------------------------------------------------------------
+
+    std::string const outputPath = cmdParser.get<std::string>( "o" );
+    std::ofstream outputFile( outputPath, std::ios::out | std::ios::trunc );
+    if ( !outputFile.is_open() )
+    {
+        std::cout << "Failed to open output file: " << outputPath << std::endl;
+        return 1;
+    }
+
+    WriteResultsJSON( outputFile, config, results, gemmResults );
+    std::cout << "Results written to: " << outputPath << std::endl;
+
+    return 0;
+}
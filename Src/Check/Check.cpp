@@ -0,0 +1,312 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Numerical regression checks
+//
+// Runs the gradient, weight update and evaluation path checks (see GradientCheck.h) on a seeded network
+// before and after a few training epochs, then compares the outputs of both networks and the trained
+// network's validation accuracy/MSE against a golden file recorded with -record. Returns a non-zero exit
+// code if anything is out of tolerance so it can be used as a gate for optimized code paths.
+
+#include "NeuralNetwork/Gemm.h"
+#include "NeuralNetwork/GradientCheck.h"
+#include "NeuralNetwork/TrainingDataReader.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#if _MSC_VER
+#pragma warning(push, 0)
+#pragma warning(disable: 4702)
+#endif
+
+#include "cmdParser.h"
+
+#if _MSC_VER
+#pragma warning(pop)
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace
+{
+    struct GoldenOutputs
+    {
+        uint32_t                            m_numInputs = 0;
+        uint32_t                            m_numHidden = 0;
+        uint32_t                            m_numOutputs = 0;
+        uint32_t                            m_seed = 0;
+        uint32_t                            m_numEpochs = 0;
+        uint32_t                            m_numRows = 0;
+        double                              m_validationAccuracy = 0;
+        double                              m_validationMSE = 0;
+        std::vector<double>                 m_initialOutputs;
+        std::vector<double>                 m_trainedOutputs;
+    };
+
+    void GetOutputs( BPN::Network& network, BPN::TrainingSet const& entries, uint32_t numRows, std::vector<double>& outputs )
+    {
+        outputs.clear();
+        for ( uint32_t rowIdx = 0; rowIdx < numRows; rowIdx++ )
+        {
+            network.Evaluate( entries[rowIdx].m_inputs );
+            outputs.insert( outputs.end(), network.GetOutputs().begin(), network.GetOutputs().end() );
+        }
+    }
+
+    bool WriteGoldenOutputs( std::string const& path, GoldenOutputs const& golden )
+    {
+        std::ofstream outputFile( path, std::ios::out | std::ios::trunc );
+        if ( !outputFile.is_open() )
+        {
+            std::cout << "Error Opening Golden File: " << path << std::endl;
+            return false;
+        }
+
+        outputFile << std::setprecision( 17 );
+        outputFile << "shape " << golden.m_numInputs << " " << golden.m_numHidden << " " << golden.m_numOutputs << "\n";
+        outputFile << "seed " << golden.m_seed << "\n";
+        outputFile << "epochs " << golden.m_numEpochs << "\n";
+        outputFile << "rows " << golden.m_numRows << "\n";
+        outputFile << "validation " << golden.m_validationAccuracy << " " << golden.m_validationMSE << "\n";
+
+        for ( auto const* pOutputs : { &golden.m_initialOutputs, &golden.m_trainedOutputs } )
+        {
+            outputFile << ( pOutputs == &golden.m_initialOutputs ? "initial" : "trained" );
+            for ( double output : *pOutputs )
+            {
+                outputFile << " " << output;
+            }
+            outputFile << "\n";
+        }
+
+        return outputFile.good();
+    }
+
+    bool ReadGoldenOutputs( std::string const& path, GoldenOutputs& golden )
+    {
+        std::ifstream inputFile( path, std::ios::in );
+        if ( !inputFile.is_open() )
+        {
+            std::cout << "Error Opening Golden File: " << path << std::endl;
+            return false;
+        }
+
+        std::string label[7];
+        inputFile >> label[0] >> golden.m_numInputs >> golden.m_numHidden >> golden.m_numOutputs;
+        inputFile >> label[1] >> golden.m_seed;
+        inputFile >> label[2] >> golden.m_numEpochs;
+        inputFile >> label[3] >> golden.m_numRows;
+        inputFile >> label[4] >> golden.m_validationAccuracy >> golden.m_validationMSE;
+
+        size_t const numValues = (size_t) golden.m_numRows * golden.m_numOutputs;
+        golden.m_initialOutputs.resize( numValues );
+        golden.m_trainedOutputs.resize( numValues );
+
+        inputFile >> label[5];
+        for ( double& output : golden.m_initialOutputs )
+        {
+            inputFile >> output;
+        }
+
+        inputFile >> label[6];
+        for ( double& output : golden.m_trainedOutputs )
+        {
+            inputFile >> output;
+        }
+
+        if ( inputFile.fail() || label[0] != "shape" || label[1] != "seed" || label[2] != "epochs" || label[3] != "rows" || label[4] != "validation" || label[5] != "initial" || label[6] != "trained" )
+        {
+            std::cout << "Invalid Golden File: " << path << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CompareOutputs( char const* pName, std::vector<double> const& outputs, std::vector<double> const& goldenOutputs, double tolerance )
+    {
+        double maxError = 0;
+        for ( size_t valueIdx = 0; valueIdx < outputs.size(); valueIdx++ )
+        {
+            maxError = std::max( maxError, fabs( outputs[valueIdx] - goldenOutputs[valueIdx] ) );
+        }
+
+        bool const passed = maxError <= tolerance;
+        std::cout << ( passed ? " PASS " : " FAIL " ) << pName << " - max error: " << maxError << " (tolerance: " << tolerance << ")" << std::endl;
+        return passed;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+int main( int argc, char* argv[] )
+{
+    cli::Parser cmdParser( argc, argv );
+    cmdParser.set_required<std::string>( "d", "DataFile", "Path to training data csv file." );
+    cmdParser.set_required<uint32_t>( "in", "NumInputs", "Num Input neurons." );
+    cmdParser.set_required<uint32_t>( "hidden", "NumHidden", "Num Hidden neurons." );
+    cmdParser.set_required<uint32_t>( "out", "NumOutputs", "Num Output neurons." );
+    cmdParser.set_optional<std::string>( "golden", "GoldenFile", "", "Golden outputs to compare against, no golden comparison if not set." );
+    cmdParser.set_optional<bool>( "record", "Record", false, "Write the golden file instead of comparing against it." );
+    cmdParser.set_optional<uint32_t>( "seed", "Seed", 0, "Seed for the data split and the initial weights." );
+    cmdParser.set_optional<uint32_t>( "epochs", "NumEpochs", 5, "Num training epochs before the checks are repeated on the trained network." );
+    cmdParser.set_optional<uint32_t>( "rows", "NumRows", 32, "Num validation rows whose outputs are recorded in the golden file." );
+    cmdParser.set_optional<uint32_t>( "entries", "NumEntries", 16, "Num training entries used for the gradient and update checks." );
+    cmdParser.set_optional<double>( "gradientTolerance", "GradientTolerance", 1e-6, "Max relative error between the backpropagated and numerical gradients." );
+    cmdParser.set_optional<double>( "evaluationTolerance", "EvaluationTolerance", 0.0, "Max output difference between the evaluation paths." );
+    cmdParser.set_optional<double>( "incrementalTolerance", "IncrementalTolerance", 1e-12, "Max output difference between incremental updates and full evaluations." );
+    cmdParser.set_optional<double>( "outputTolerance", "OutputTolerance", 1e-12, "Max output difference from the golden outputs of the initial network." );
+    cmdParser.set_optional<double>( "trainedTolerance", "TrainedOutputTolerance", 1e-6, "Max output difference from the golden outputs of the trained network." );
+    cmdParser.set_optional<double>( "accuracyTolerance", "AccuracyTolerance", 0.5, "Max validation accuracy difference (percentage points) from the golden accuracy." );
+    cmdParser.set_optional<std::string>( "gemm", "GemmBackend", "kernel", "Matrix multiplication backend of the batch evaluation and training paths: reference, kernel or blas (builds with NN_BLAS only), blas sums in a different order and needs an -evaluationTolerance." );
+
+    if ( !cmdParser.run() )
+    {
+        std::cout << "Invalid command line arguments";
+        return 1;
+    }
+
+    uint32_t const numInputs = cmdParser.get<uint32_t>( "in" );
+    uint32_t const numHidden = cmdParser.get<uint32_t>( "hidden" );
+    uint32_t const numOutputs = cmdParser.get<uint32_t>( "out" );
+    uint32_t const seed = cmdParser.get<uint32_t>( "seed" );
+    uint32_t const numEpochs = cmdParser.get<uint32_t>( "epochs" );
+
+    std::string const gemmBackendName = cmdParser.get<std::string>( "gemm" );
+    BPN::Gemm::Backend gemmBackend = BPN::Gemm::Backend::MicroKernel;
+    if ( !BPN::Gemm::ParseBackendName( gemmBackendName.c_str(), gemmBackend ) || !BPN::Gemm::SetBackend( gemmBackend ) )
+    {
+        std::cout << "Unavailable GEMM backend: " << gemmBackendName << std::endl;
+        return 1;
+    }
+
+    BPN::TrainingDataReader dataReader( cmdParser.get<std::string>( "d" ), numInputs, numOutputs, BPN::NormalizationType::None, seed );
+    if ( !dataReader.ReadData() )
+    {
+        return 1;
+    }
+
+    BPN::TrainingData const& trainingData = dataReader.GetTrainingData();
+    size_t const numCheckEntries = std::min( (size_t) cmdParser.get<uint32_t>( "entries" ), trainingData.m_trainingSet.size() );
+    uint32_t const numGoldenRows = std::min( cmdParser.get<uint32_t>( "rows" ), (uint32_t) trainingData.m_validationSet.size() );
+    if ( numCheckEntries == 0 || numGoldenRows == 0 )
+    {
+        std::cout << "Not enough data to run the checks" << std::endl;
+        return 1;
+    }
+
+    BPN::GradientChecker::Settings checkSettings;
+    checkSettings.m_gradientTolerance = cmdParser.get<double>( "gradientTolerance" );
+    checkSettings.m_evaluationTolerance = cmdParser.get<double>( "evaluationTolerance" );
+    checkSettings.m_incrementalTolerance = cmdParser.get<double>( "incrementalTolerance" );
+
+    BPN::TrainingSet const checkEntries( trainingData.m_trainingSet.begin(), trainingData.m_trainingSet.begin() + numCheckEntries );
+    bool passed = true;
+    auto RunChecks = [&] ( BPN::Network const& network )
+    {
+        BPN::GradientChecker::Result const checkResults[] =
+        {
+            BPN::GradientChecker::CheckGradient( checkSettings, network, checkEntries.data(), checkEntries.size() ),
+            BPN::GradientChecker::CheckStochasticUpdate( checkSettings, network, checkEntries.data(), checkEntries.size() ),
+            BPN::GradientChecker::CheckBatchUpdate( checkSettings, network, checkEntries ),
+            BPN::GradientChecker::CheckEvaluation( checkSettings, network, trainingData.m_validationSet ),
+            BPN::GradientChecker::CheckIncrementalEvaluation( checkSettings, network, trainingData.m_validationSet ),
+            BPN::GradientChecker::CheckEnsembleVote( checkSettings, network, trainingData.m_validationSet ),
+            BPN::GradientChecker::CheckCollapsedGradient( checkSettings, network, checkEntries.data(), checkEntries.size() ),
+            BPN::GradientChecker::CheckPredictionCache( checkSettings, network, trainingData.m_validationSet )
+        };
+
+        char const* const checkNames[] = { "Gradient", "Stochastic Update", "Batch Update", "Evaluation Paths", "Incremental Evaluation", "Ensemble Vote", "Collapsed Gradient", "Prediction Cache" };
+        static_assert( sizeof( checkNames ) / sizeof( checkNames[0] ) == sizeof( checkResults ) / sizeof( checkResults[0] ), "Every check needs a name" );
+        for ( uint32_t checkIdx = 0; checkIdx < sizeof( checkResults ) / sizeof( checkResults[0] ); checkIdx++ )
+        {
+            BPN::GradientChecker::PrintResult( std::cout, checkNames[checkIdx], checkResults[checkIdx] );
+            passed = passed && checkResults[checkIdx].Passed();
+        }
+    };
+
+    // Initial network
+    //-------------------------------------------------------------------------
+
+    GoldenOutputs results;
+    results.m_numInputs = numInputs;
+    results.m_numHidden = numHidden;
+    results.m_numOutputs = numOutputs;
+    results.m_seed = seed;
+    results.m_numEpochs = numEpochs;
+    results.m_numRows = numGoldenRows;
+
+    BPN::Network::Settings const networkSettings{ numInputs, numHidden, numOutputs, seed };
+    BPN::Network network( networkSettings );
+
+    std::cout << std::endl << "Initial network:" << std::endl;
+    RunChecks( network );
+    GetOutputs( network, trainingData.m_validationSet, numGoldenRows, results.m_initialOutputs );
+
+    // Trained network
+    //-------------------------------------------------------------------------
+
+    BPN::NetworkTrainer::Settings trainerSettings;
+    trainerSettings.m_maxEpochs = numEpochs;
+    trainerSettings.m_desiredAccuracy = 100;
+    trainerSettings.m_seed = seed;
+    BPN::NetworkTrainer trainer( trainerSettings, &network );
+    trainer.Train( trainingData );
+    trainer.GetSetAccuracyAndMSE( trainingData.m_validationSet, results.m_validationAccuracy, results.m_validationMSE );
+
+    std::cout << std::endl << "Trained network (" << numEpochs << " epochs):" << std::endl;
+    RunChecks( network );
+    GetOutputs( network, trainingData.m_validationSet, numGoldenRows, results.m_trainedOutputs );
+
+    // Golden outputs
+    //-------------------------------------------------------------------------
+
+    std::string const goldenPath = cmdParser.get<std::string>( "golden" );
+    if ( !goldenPath.empty() )
+    {
+        std::cout << std::endl;
+        if ( cmdParser.get<bool>( "record" ) )
+        {
+            if ( !WriteGoldenOutputs( goldenPath, results ) )
+            {
+                return 1;
+            }
+
+            std::cout << "Recorded golden outputs to: " << goldenPath << std::endl;
+        }
+        else
+        {
+            GoldenOutputs golden;
+            if ( !ReadGoldenOutputs( goldenPath, golden ) )
+            {
+                return 1;
+            }
+
+            if ( golden.m_numInputs != numInputs || golden.m_numHidden != numHidden || golden.m_numOutputs != numOutputs || golden.m_seed != seed || golden.m_numEpochs != numEpochs || golden.m_numRows != numGoldenRows )
+            {
+                std::cout << "Golden file was recorded with a different configuration: " << golden.m_numInputs << "x" << golden.m_numHidden << "x" << golden.m_numOutputs
+                          << ", seed " << golden.m_seed << ", " << golden.m_numEpochs << " epochs, " << golden.m_numRows << " rows" << std::endl;
+                return 1;
+            }
+
+            std::cout << "Golden outputs:" << std::endl;
+            passed = CompareOutputs( "Initial Outputs", results.m_initialOutputs, golden.m_initialOutputs, cmdParser.get<double>( "outputTolerance" ) ) && passed;
+            passed = CompareOutputs( "Trained Outputs", results.m_trainedOutputs, golden.m_trainedOutputs, cmdParser.get<double>( "trainedTolerance" ) ) && passed;
+
+            double const accuracyError = fabs( results.m_validationAccuracy - golden.m_validationAccuracy );
+            bool const accuracyPassed = accuracyError <= cmdParser.get<double>( "accuracyTolerance" );
+            std::cout << ( accuracyPassed ? " PASS " : " FAIL " ) << "Validation Accuracy - " << results.m_validationAccuracy << "% (golden: " << golden.m_validationAccuracy << "%), MSE: "
+                      << results.m_validationMSE << " (golden: " << golden.m_validationMSE << ")" << std::endl;
+            passed = passed && accuracyPassed;
+        }
+    }
+
+    std::cout << std::endl << ( passed ? "All checks passed" : "Checks FAILED" ) << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Binary protocol between the inference server and its clients
+//
+// All values are in the host byte order, the server only accepts local connections. On connect the
+// server sends a ServerHello. Clients then send a MessageHeader followed by the message payload:
+//
+//  Evaluate:   numRows * numInputs doubles
+//              -> EvaluateResponseHeader, numRows * numOutputs doubles, numRows * numOutputs int8 clamped outputs
+//  GetStats:   no payload
+//              -> ServerStats
+//
+// Requests on a connection may be pipelined, responses carry the request id and can arrive out of order.
+
+#pragma once
+
+#include <stdint.h>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace InferenceProtocol
+    {
+        constexpr uint32_t  g_magic = 0x4E4E5042;          // "BPNN"
+        constexpr uint16_t  g_version = 3;
+        constexpr uint16_t  g_maxRowsPerRequest = 4096;
+
+        enum class MessageType : uint8_t
+        {
+            Evaluate = 1,
+            GetStats = 2,
+        };
+
+        enum class Status : uint8_t
+        {
+            Ok = 0,
+            InvalidRequest = 1,
+        };
+
+        #pragma pack( push, 1 )
+
+        struct ServerHello
+        {
+            uint32_t        m_magic = g_magic;
+            uint16_t        m_version = g_version;
+            uint16_t        m_reserved = 0;
+            uint32_t        m_numInputs = 0;
+            uint32_t        m_numOutputs = 0;
+        };
+
+        struct MessageHeader
+        {
+            MessageType     m_type = MessageType::Evaluate;
+            uint8_t         m_reserved = 0;
+            uint16_t        m_numRows = 0;
+            uint32_t        m_requestID = 0;
+        };
+
+        struct EvaluateResponseHeader
+        {
+            Status          m_status = Status::Ok;
+            uint8_t         m_reserved = 0;
+            uint16_t        m_numRows = 0;
+            uint32_t        m_requestID = 0;
+        };
+
+        struct ServerStats
+        {
+            uint64_t        m_numRequests = 0;
+            uint64_t        m_numRows = 0;
+            uint64_t        m_numBatches = 0;
+            double          m_uptimeSeconds = 0;
+            double          m_requestsPerSecond = 0;
+            double          m_rowsPerSecond = 0;
+            double          m_meanBatchRows = 0;
+
+            // Server side latency from a request being received to its response being sent, over the most recent requests
+            double          m_latencyP50US = 0;
+            double          m_latencyP90US = 0;
+            double          m_latencyP99US = 0;
+            double          m_latencyMaxUS = 0;
+
+            // Version of the model currently being served, incremented every time a new model is published
+            uint64_t        m_modelVersion = 0;
+
+            // Prediction cache, all zero when the server runs without one
+            uint64_t        m_cacheHits = 0;
+            uint64_t        m_cacheMisses = 0;
+            uint64_t        m_cacheEvictions = 0;
+            uint64_t        m_cacheEntries = 0;
+            uint64_t        m_cacheMemoryBytes = 0;
+            double          m_cacheHitRate = 0;
+        };
+
+        #pragma pack( pop )
+    }
+}
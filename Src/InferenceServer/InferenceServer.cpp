@@ -0,0 +1,410 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "InferenceServer.h"
+#include "NeuralNetwork/ThreadPool.h"
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    using namespace InferenceProtocol;
+
+    //-------------------------------------------------------------------------
+
+    InferenceServer::InferenceServer( Settings const& settings, ModelHandle const& modelHandle )
+        : m_settings( settings )
+        , m_modelHandle( modelHandle )
+        , m_isRunning( false )
+    {
+        {
+            ModelHandle::ReadGuard const pNetwork = m_modelHandle.Acquire();
+            m_numInputs = pNetwork->GetNumInputs();
+            m_numOutputs = pNetwork->GetNumOutputs();
+        }
+
+        m_settings.m_maxBatchRows = std::max( 1u, m_settings.m_maxBatchRows );
+        m_settings.m_numLatencySamples = std::max( 1u, m_settings.m_numLatencySamples );
+
+        if ( m_settings.m_cacheMemoryBytes > 0 )
+        {
+            PredictionCache::Settings cacheSettings;
+            cacheSettings.m_maxMemoryBytes = m_settings.m_cacheMemoryBytes;
+            m_pCache.reset( new PredictionCache( cacheSettings, m_numInputs, m_numOutputs ) );
+        }
+    }
+
+    InferenceServer::~InferenceServer()
+    {
+        Stop();
+    }
+
+    bool InferenceServer::Start()
+    {
+        assert( !m_isRunning );
+
+        m_listenSocket = Socket::Listen( m_settings.m_address );
+        if ( m_listenSocket == Socket::g_invalidSocket )
+        {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_statsMutex );
+            m_startTime = Clock::now();
+            m_numRequests = 0;
+            m_numRows = 0;
+            m_numBatches = 0;
+            m_latencySamplesUS.clear();
+            m_nextLatencySampleIdx = 0;
+        }
+
+        m_isStopping = false;
+        m_isRunning = true;
+        m_pWorkerPool.reset( new ThreadPool( m_settings.m_numWorkerThreads ) );
+        m_batchingThread = std::thread( &InferenceServer::BatchingThread, this );
+        m_acceptThread = std::thread( &InferenceServer::AcceptThread, this );
+        return true;
+    }
+
+    void InferenceServer::Stop()
+    {
+        if ( !m_isRunning )
+        {
+            return;
+        }
+
+        m_isRunning = false;
+
+        // Stop accepting connections
+        Socket::Shutdown( m_listenSocket );
+        m_acceptThread.join();
+        Socket::Close( m_listenSocket );
+        m_listenSocket = Socket::g_invalidSocket;
+
+        // Close all connections, this unblocks the connection threads
+        {
+            std::lock_guard<std::mutex> lock( m_connectionsMutex );
+            for ( auto& connection : m_connections )
+            {
+                Socket::Shutdown( connection.first->m_socket );
+            }
+        }
+        JoinFinishedConnections( true );
+
+        // Flush the remaining requests and wait for the workers
+        {
+            std::lock_guard<std::mutex> lock( m_queueMutex );
+            m_isStopping = true;
+        }
+        m_queueCondition.notify_all();
+        m_batchingThread.join();
+        m_pWorkerPool.reset();
+
+        if ( !m_settings.m_address.m_unixSocketPath.empty() )
+        {
+            unlink( m_settings.m_address.m_unixSocketPath.c_str() );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    void InferenceServer::JoinFinishedConnections( bool waitForAll )
+    {
+        std::lock_guard<std::mutex> lock( m_connectionsMutex );
+        for ( auto iter = m_connections.begin(); iter != m_connections.end(); )
+        {
+            if ( waitForAll || iter->first->m_isFinished )
+            {
+                iter->second.join();
+                iter = m_connections.erase( iter );
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    void InferenceServer::AcceptThread()
+    {
+        while ( m_isRunning )
+        {
+            int const socket = Socket::Accept( m_listenSocket );
+            if ( socket == Socket::g_invalidSocket )
+            {
+                if ( m_isRunning )
+                {
+                    std::cout << "Error Accepting Connection" << std::endl;
+                }
+                break;
+            }
+
+            JoinFinishedConnections( false );
+
+            std::shared_ptr<Connection> pConnection = std::make_shared<Connection>( socket );
+            std::lock_guard<std::mutex> lock( m_connectionsMutex );
+            m_connections.emplace_back( pConnection, std::thread( &InferenceServer::ConnectionThread, this, pConnection ) );
+        }
+    }
+
+    void InferenceServer::ConnectionThread( std::shared_ptr<Connection> pConnection )
+    {
+        ServerHello hello;
+        hello.m_numInputs = m_numInputs;
+        hello.m_numOutputs = m_numOutputs;
+
+        bool isConnectionValid;
+        {
+            std::lock_guard<std::mutex> lock( pConnection->m_sendMutex );
+            isConnectionValid = Socket::SendAll( pConnection->m_socket, &hello, sizeof( hello ) );
+        }
+
+        MessageHeader header;
+        while ( isConnectionValid && m_isRunning && Socket::ReceiveAll( pConnection->m_socket, &header, sizeof( header ) ) )
+        {
+            if ( header.m_type == MessageType::Evaluate )
+            {
+                // Oversized requests are a protocol violation, the payload can't be trusted so drop the connection
+                if ( header.m_numRows > g_maxRowsPerRequest )
+                {
+                    EvaluateResponseHeader response;
+                    response.m_status = Status::InvalidRequest;
+                    response.m_requestID = header.m_requestID;
+                    SendEvaluateResponse( *pConnection, response, nullptr, nullptr );
+                    break;
+                }
+
+                if ( header.m_numRows == 0 )
+                {
+                    EvaluateResponseHeader response;
+                    response.m_requestID = header.m_requestID;
+                    SendEvaluateResponse( *pConnection, response, nullptr, nullptr );
+                    continue;
+                }
+
+                Request request;
+                request.m_pConnection = pConnection;
+                request.m_requestID = header.m_requestID;
+                request.m_numRows = header.m_numRows;
+                request.m_inputs.resize( (size_t) header.m_numRows * m_numInputs );
+                if ( !Socket::ReceiveAll( pConnection->m_socket, request.m_inputs.data(), request.m_inputs.size() * sizeof( double ) ) )
+                {
+                    break;
+                }
+                request.m_receiveTime = Clock::now();
+
+                {
+                    std::lock_guard<std::mutex> lock( m_queueMutex );
+                    m_numQueuedRows += request.m_numRows;
+                    m_requestQueue.emplace_back( std::move( request ) );
+                }
+                m_queueCondition.notify_one();
+            }
+            else if ( header.m_type == MessageType::GetStats )
+            {
+                ServerStats const stats = GetStats();
+                std::lock_guard<std::mutex> lock( pConnection->m_sendMutex );
+                isConnectionValid = Socket::SendAll( pConnection->m_socket, &stats, sizeof( stats ) );
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        Socket::Shutdown( pConnection->m_socket );
+        pConnection->m_isFinished = true;
+    }
+
+    //-------------------------------------------------------------------------
+
+    void InferenceServer::BatchingThread()
+    {
+        auto const maxBatchDelay = std::chrono::microseconds( m_settings.m_maxBatchDelayUS );
+
+        std::unique_lock<std::mutex> lock( m_queueMutex );
+        while ( true )
+        {
+            m_queueCondition.wait( lock, [this] () { return m_isStopping || !m_requestQueue.empty(); } );
+            if ( m_requestQueue.empty() )
+            {
+                break;
+            }
+
+            // Wait for more requests until the batch is full or the oldest request reaches its deadline
+            Clock::time_point const deadline = m_requestQueue.front().m_receiveTime + maxBatchDelay;
+            m_queueCondition.wait_until( lock, deadline, [this] () { return m_isStopping || m_numQueuedRows >= m_settings.m_maxBatchRows; } );
+
+            // Always take at least one request, even if it exceeds the batch size on its own
+            std::shared_ptr<Batch> pBatch = std::make_shared<Batch>();
+            uint32_t numBatchRows = 0;
+            while ( !m_requestQueue.empty() && ( pBatch->empty() || numBatchRows + m_requestQueue.front().m_numRows <= m_settings.m_maxBatchRows ) )
+            {
+                numBatchRows += m_requestQueue.front().m_numRows;
+                pBatch->emplace_back( std::move( m_requestQueue.front() ) );
+                m_requestQueue.pop_front();
+            }
+            m_numQueuedRows -= numBatchRows;
+
+            lock.unlock();
+            m_pWorkerPool->Submit( [this, pBatch] () { ProcessBatch( *pBatch ); } );
+            lock.lock();
+        }
+    }
+
+    void InferenceServer::ProcessBatch( Batch& batch )
+    {
+        uint32_t const numInputs = m_numInputs;
+        uint32_t const numOutputs = m_numOutputs;
+
+        // Evaluate all requests in a single batch
+        //-------------------------------------------------------------------------
+
+        uint32_t numBatchRows = 0;
+        for ( auto const& request : batch )
+        {
+            numBatchRows += request.m_numRows;
+        }
+
+        std::vector<double> inputs;
+        inputs.reserve( (size_t) numBatchRows * numInputs );
+        for ( auto const& request : batch )
+        {
+            inputs.insert( inputs.end(), request.m_inputs.begin(), request.m_inputs.end() );
+        }
+
+        std::vector<double> outputs( (size_t) numBatchRows * numOutputs );
+        std::vector<int32_t> clampedOutputs( (size_t) numBatchRows * numOutputs );
+        {
+            ModelHandle::ReadGuard const pNetwork = m_modelHandle.Acquire();
+            assert( (uint32_t) pNetwork->GetNumInputs() == numInputs && (uint32_t) pNetwork->GetNumOutputs() == numOutputs );
+            if ( m_pCache != nullptr )
+            {
+                m_pCache->EvaluateBatch( *pNetwork, pNetwork.GetVersion(), inputs.data(), numBatchRows, outputs.data(), clampedOutputs.data() );
+            }
+            else
+            {
+                pNetwork->EvaluateBatch( inputs.data(), numBatchRows, outputs.data(), clampedOutputs.data() );
+            }
+        }
+
+        // Send responses
+        //-------------------------------------------------------------------------
+
+        std::vector<float> latenciesUS;
+        size_t rowOffset = 0;
+        for ( auto const& request : batch )
+        {
+            EvaluateResponseHeader response;
+            response.m_requestID = request.m_requestID;
+            response.m_numRows = request.m_numRows;
+            SendEvaluateResponse( *request.m_pConnection, response, &outputs[rowOffset * numOutputs], &clampedOutputs[rowOffset * numOutputs] );
+            rowOffset += request.m_numRows;
+
+            latenciesUS.push_back( std::chrono::duration<float, std::micro>( Clock::now() - request.m_receiveTime ).count() );
+        }
+
+        // Update stats
+        //-------------------------------------------------------------------------
+
+        std::lock_guard<std::mutex> lock( m_statsMutex );
+        m_numRequests += batch.size();
+        m_numRows += numBatchRows;
+        m_numBatches++;
+
+        for ( auto latencyUS : latenciesUS )
+        {
+            if ( m_latencySamplesUS.size() < m_settings.m_numLatencySamples )
+            {
+                m_latencySamplesUS.push_back( latencyUS );
+            }
+            else
+            {
+                m_latencySamplesUS[m_nextLatencySampleIdx] = latencyUS;
+                m_nextLatencySampleIdx = ( m_nextLatencySampleIdx + 1 ) % m_latencySamplesUS.size();
+            }
+        }
+    }
+
+    void InferenceServer::SendEvaluateResponse( Connection& connection, EvaluateResponseHeader const& header, double const* pOutputs, int32_t const* pClampedOutputs )
+    {
+        // Serialize the whole response so that it is sent with a single call
+        size_t const numValues = (size_t) header.m_numRows * m_numOutputs;
+        std::vector<char> buffer( sizeof( header ) + numValues * ( sizeof( double ) + sizeof( int8_t ) ) );
+        memcpy( buffer.data(), &header, sizeof( header ) );
+        if ( numValues > 0 )
+        {
+            memcpy( &buffer[sizeof( header )], pOutputs, numValues * sizeof( double ) );
+            int8_t* pClampedBuffer = reinterpret_cast<int8_t*>( &buffer[sizeof( header ) + numValues * sizeof( double )] );
+            for ( size_t valueIdx = 0; valueIdx < numValues; valueIdx++ )
+            {
+                pClampedBuffer[valueIdx] = (int8_t) pClampedOutputs[valueIdx];
+            }
+        }
+
+        // Failures mean the client has gone away, the connection thread will clean up
+        std::lock_guard<std::mutex> lock( connection.m_sendMutex );
+        Socket::SendAll( connection.m_socket, buffer.data(), buffer.size() );
+    }
+
+    //-------------------------------------------------------------------------
+
+    ServerStats InferenceServer::GetStats() const
+    {
+        ServerStats stats;
+        std::vector<float> latencySamplesUS;
+        {
+            std::lock_guard<std::mutex> lock( m_statsMutex );
+            stats.m_numRequests = m_numRequests;
+            stats.m_numRows = m_numRows;
+            stats.m_numBatches = m_numBatches;
+            stats.m_uptimeSeconds = std::chrono::duration<double>( Clock::now() - m_startTime ).count();
+            latencySamplesUS = m_latencySamplesUS;
+        }
+
+        stats.m_modelVersion = m_modelHandle.GetVersion();
+
+        if ( m_pCache != nullptr )
+        {
+            PredictionCache::Stats const cacheStats = m_pCache->GetStats();
+            stats.m_cacheHits = cacheStats.m_numHits;
+            stats.m_cacheMisses = cacheStats.m_numMisses;
+            stats.m_cacheEvictions = cacheStats.m_numEvictions;
+            stats.m_cacheEntries = cacheStats.m_numEntries;
+            stats.m_cacheMemoryBytes = cacheStats.m_memoryBytes;
+            stats.m_cacheHitRate = cacheStats.m_hitRate;
+        }
+
+        if ( stats.m_uptimeSeconds > 0 )
+        {
+            stats.m_requestsPerSecond = stats.m_numRequests / stats.m_uptimeSeconds;
+            stats.m_rowsPerSecond = stats.m_numRows / stats.m_uptimeSeconds;
+        }
+
+        if ( stats.m_numBatches > 0 )
+        {
+            stats.m_meanBatchRows = (double) stats.m_numRows / stats.m_numBatches;
+        }
+
+        if ( !latencySamplesUS.empty() )
+        {
+            std::sort( latencySamplesUS.begin(), latencySamplesUS.end() );
+            auto GetPercentile = [&latencySamplesUS] ( double percentile ) { return (double) latencySamplesUS[std::min( latencySamplesUS.size() - 1, (size_t) ( percentile / 100.0 * latencySamplesUS.size() ) )]; };
+            stats.m_latencyP50US = GetPercentile( 50 );
+            stats.m_latencyP90US = GetPercentile( 90 );
+            stats.m_latencyP99US = GetPercentile( 99 );
+            stats.m_latencyMaxUS = latencySamplesUS.back();
+        }
+
+        return stats;
+    }
+}
@@ -0,0 +1,138 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Embeddable inference server
+//
+// Accepts scoring requests over a Unix domain socket or loopback TCP (see InferenceProtocol.h). Each
+// connection is read on its own thread, requests from all connections are coalesced into micro-batches
+// that are closed once they reach the max batch size or once their oldest request has waited for the
+// max batch delay. Batches are evaluated on a worker pool with Network::EvaluateBatch.
+//
+// The network is read through a ModelHandle, so a new model can be published while the server is running.
+// Each batch is evaluated entirely with the model that was current when the batch started.
+//
+// Optionally the outputs of recently scored rows are kept in a PredictionCache keyed on the model version,
+// so repeated rows are served without evaluation and a newly published model never returns stale results.
+
+#pragma once
+
+#include "InferenceProtocol.h"
+#include "Socket.h"
+#include "NeuralNetwork/ModelHandle.h"
+#include "NeuralNetwork/PredictionCache.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class ThreadPool;
+
+    //-------------------------------------------------------------------------
+
+    class InferenceServer
+    {
+        typedef std::chrono::steady_clock Clock;
+
+    public:
+
+        struct Settings
+        {
+            Socket::Address                 m_address;
+            uint32_t                        m_maxBatchRows = 64;            // A batch is dispatched as soon as it has this many rows
+            uint32_t                        m_maxBatchDelayUS = 200;        // Max time the oldest request in a batch waits for more requests
+            uint32_t                        m_numWorkerThreads = 0;         // 0 uses the hardware concurrency
+            uint32_t                        m_numLatencySamples = 65536;    // Number of recent requests the latency percentiles are computed over
+            size_t                          m_cacheMemoryBytes = 0;         // Memory bound of the prediction cache, 0 disables it
+        };
+
+    public:
+
+        // The model handle must outlive the server. Published models must keep the input and output counts of the initial one.
+        InferenceServer( Settings const& settings, ModelHandle const& modelHandle );
+        ~InferenceServer();
+
+        InferenceServer( InferenceServer const& ) = delete;
+        InferenceServer& operator=( InferenceServer const& ) = delete;
+
+        bool Start();
+        void Stop();
+
+        inline bool IsRunning() const { return m_isRunning; }
+
+        InferenceProtocol::ServerStats GetStats() const;
+
+    private:
+
+        struct Connection
+        {
+            explicit Connection( int socket ) : m_socket( socket ) {}
+            ~Connection() { Socket::Close( m_socket ); }
+
+            int                                     m_socket;
+            std::mutex                              m_sendMutex;            // Responses from different workers must not interleave
+            std::atomic<bool>                       m_isFinished{ false };  // Set once the connection thread has exited
+        };
+
+        struct Request
+        {
+            std::shared_ptr<Connection>             m_pConnection;
+            uint32_t                                m_requestID = 0;
+            uint16_t                                m_numRows = 0;
+            std::vector<double>                     m_inputs;
+            Clock::time_point                       m_receiveTime;
+        };
+
+        typedef std::vector<Request> Batch;
+
+        void AcceptThread();
+        void ConnectionThread( std::shared_ptr<Connection> pConnection );
+        void BatchingThread();
+        void ProcessBatch( Batch& batch );
+
+        void SendEvaluateResponse( Connection& connection, InferenceProtocol::EvaluateResponseHeader const& header, double const* pOutputs, int32_t const* pClampedOutputs );
+        void JoinFinishedConnections( bool waitForAll );
+
+    private:
+
+        Settings                                    m_settings;
+        ModelHandle const&                          m_modelHandle;
+        uint32_t                                    m_numInputs;
+        uint32_t                                    m_numOutputs;
+
+        std::atomic<bool>                           m_isRunning;
+        int                                         m_listenSocket = Socket::g_invalidSocket;
+        std::thread                                 m_acceptThread;
+        std::thread                                 m_batchingThread;
+        std::unique_ptr<ThreadPool>                 m_pWorkerPool;
+        std::unique_ptr<PredictionCache>            m_pCache;
+
+        std::mutex                                  m_connectionsMutex;
+        std::vector<std::pair<std::shared_ptr<Connection>, std::thread>> m_connections;
+
+        // Requests waiting to be batched
+        std::mutex                                  m_queueMutex;
+        std::condition_variable                     m_queueCondition;
+        std::deque<Request>                         m_requestQueue;
+        uint32_t                                    m_numQueuedRows = 0;
+        bool                                        m_isStopping = false;
+
+        // Stats
+        mutable std::mutex                          m_statsMutex;
+        Clock::time_point                           m_startTime;
+        uint64_t                                    m_numRequests = 0;
+        uint64_t                                    m_numRows = 0;
+        uint64_t                                    m_numBatches = 0;
+        std::vector<float>                          m_latencySamplesUS;
+        size_t                                      m_nextLatencySampleIdx = 0;
+    };
+}
@@ -0,0 +1,260 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Load generator for the inference server
+//
+// Each connection runs a closed loop on its own thread: send a request of random inputs, wait for the
+// response, repeat. Reports client side throughput and latency percentiles followed by the server stats.
+//
+// By default every request of a connection carries the same rows. With a number of distinct rows, all
+// connections share a pool of that many rows and each request draws its rows from it at random, which
+// gives a controllable repeat rate for exercising the server's prediction cache.
+
+#include "InferenceProtocol.h"
+#include "Socket.h"
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cmdParser.h"
+
+//-------------------------------------------------------------------------
+
+namespace
+{
+    using namespace BPN;
+    using namespace BPN::InferenceProtocol;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct ConnectionResult
+    {
+        bool                    m_succeeded = false;
+        uint64_t                m_numRequests = 0;
+        uint64_t                m_numRows = 0;
+        std::vector<float>      m_latenciesUS;
+    };
+
+    int ConnectToServer( Socket::Address const& address, ServerHello& hello )
+    {
+        int const socket = Socket::Connect( address );
+        if ( socket == Socket::g_invalidSocket )
+        {
+            return Socket::g_invalidSocket;
+        }
+
+        if ( !Socket::ReceiveAll( socket, &hello, sizeof( hello ) ) || hello.m_magic != g_magic || hello.m_version != g_version )
+        {
+            std::cout << "Invalid Server Hello" << std::endl;
+            Socket::Close( socket );
+            return Socket::g_invalidSocket;
+        }
+
+        return socket;
+    }
+
+    void RunConnection( Socket::Address const& address, uint16_t numRowsPerRequest, uint32_t numDistinctRows, Clock::time_point endTime, uint32_t seed, uint32_t connectionIdx, ConnectionResult& result )
+    {
+        ServerHello hello;
+        int const socket = ConnectToServer( address, hello );
+        if ( socket == Socket::g_invalidSocket )
+        {
+            return;
+        }
+
+        // Random inputs in the [0, 1] range, generated up front so they are not part of the timings
+        std::uniform_real_distribution<double> distribution( 0.0, 1.0 );
+        size_t const numRequestInputs = (size_t) numRowsPerRequest * hello.m_numInputs;
+        size_t const numResponseOutputs = (size_t) numRowsPerRequest * hello.m_numOutputs;
+
+        std::vector<char> request( sizeof( MessageHeader ) + numRequestInputs * sizeof( double ) );
+        std::vector<char> response( sizeof( EvaluateResponseHeader ) + numResponseOutputs * ( sizeof( double ) + sizeof( int8_t ) ) );
+        double* pInputs = reinterpret_cast<double*>( &request[sizeof( MessageHeader )] );
+
+        // The row pool uses the same seed on every connection so that the connections share it
+        std::vector<double> rowPool( (size_t) numDistinctRows * hello.m_numInputs );
+        std::mt19937 poolGenerator( seed );
+        for ( auto& value : rowPool )
+        {
+            value = distribution( poolGenerator );
+        }
+
+        std::mt19937 generator( seed + connectionIdx + 1 );
+        std::uniform_int_distribution<uint32_t> rowDistribution( 0, std::max( 1u, numDistinctRows ) - 1 );
+        auto FillRequestInputs = [&] ()
+        {
+            for ( uint32_t rowIdx = 0; rowIdx < numRowsPerRequest; rowIdx++ )
+            {
+                double* pRowInputs = &pInputs[(size_t) rowIdx * hello.m_numInputs];
+                if ( numDistinctRows > 0 )
+                {
+                    memcpy( pRowInputs, &rowPool[(size_t) rowDistribution( generator ) * hello.m_numInputs], hello.m_numInputs * sizeof( double ) );
+                }
+                else
+                {
+                    std::generate( pRowInputs, pRowInputs + hello.m_numInputs, [&] () { return distribution( generator ); } );
+                }
+            }
+        };
+
+        FillRequestInputs();
+
+        MessageHeader header;
+        header.m_type = MessageType::Evaluate;
+        header.m_numRows = numRowsPerRequest;
+
+        result.m_succeeded = true;
+        while ( Clock::now() < endTime )
+        {
+            memcpy( request.data(), &header, sizeof( header ) );
+
+            auto const requestStart = Clock::now();
+            if ( !Socket::SendAll( socket, request.data(), request.size() ) || !Socket::ReceiveAll( socket, response.data(), response.size() ) )
+            {
+                std::cout << "Connection Lost" << std::endl;
+                result.m_succeeded = false;
+                break;
+            }
+            result.m_latenciesUS.push_back( std::chrono::duration<float, std::micro>( Clock::now() - requestStart ).count() );
+
+            EvaluateResponseHeader responseHeader;
+            memcpy( &responseHeader, response.data(), sizeof( responseHeader ) );
+            if ( responseHeader.m_status != Status::Ok || responseHeader.m_requestID != header.m_requestID || responseHeader.m_numRows != numRowsPerRequest )
+            {
+                std::cout << "Invalid Response" << std::endl;
+                result.m_succeeded = false;
+                break;
+            }
+
+            result.m_numRequests++;
+            result.m_numRows += numRowsPerRequest;
+            header.m_requestID++;
+
+            if ( numDistinctRows > 0 )
+            {
+                FillRequestInputs();
+            }
+        }
+
+        Socket::Close( socket );
+    }
+
+    bool GetServerStats( Socket::Address const& address, ServerStats& stats )
+    {
+        ServerHello hello;
+        int const socket = ConnectToServer( address, hello );
+        if ( socket == Socket::g_invalidSocket )
+        {
+            return false;
+        }
+
+        MessageHeader header;
+        header.m_type = MessageType::GetStats;
+        bool const succeeded = Socket::SendAll( socket, &header, sizeof( header ) ) && Socket::ReceiveAll( socket, &stats, sizeof( stats ) );
+        Socket::Close( socket );
+        return succeeded;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+int main( int argc, char* argv[] )
+{
+    cli::Parser cmdParser( argc, argv );
+    cmdParser.set_optional<std::string>( "unix", "UnixSocketPath", "", "Connect to this Unix domain socket instead of TCP." );
+    cmdParser.set_optional<uint32_t>( "port", "Port", 5555, "Loopback TCP port to connect to." );
+    cmdParser.set_optional<uint32_t>( "connections", "NumConnections", 4, "Number of concurrent connections, each with one request in flight." );
+    cmdParser.set_optional<uint32_t>( "rows", "RowsPerRequest", 1, "Number of rows in each request." );
+    cmdParser.set_optional<uint32_t>( "duration", "DurationSeconds", 5, "Duration of the run in seconds." );
+    cmdParser.set_optional<uint32_t>( "seed", "Seed", 42, "Seed used to generate the request inputs." );
+    cmdParser.set_optional<uint32_t>( "distinctRows", "NumDistinctRows", 0, "Draw the rows of every request from a shared pool of this many rows, 0 repeats the same request on each connection." );
+
+    if ( !cmdParser.run() )
+    {
+        std::cout << "Invalid command line arguments";
+        return 1;
+    }
+
+    Socket::Address address;
+    address.m_unixSocketPath = cmdParser.get<std::string>( "unix" );
+    address.m_port = (uint16_t) cmdParser.get<uint32_t>( "port" );
+    uint32_t const numConnections = std::max( 1u, cmdParser.get<uint32_t>( "connections" ) );
+    uint16_t const numRowsPerRequest = (uint16_t) std::min( std::max( 1u, cmdParser.get<uint32_t>( "rows" ) ), (uint32_t) g_maxRowsPerRequest );
+    uint32_t const durationSeconds = std::max( 1u, cmdParser.get<uint32_t>( "duration" ) );
+    uint32_t const seed = cmdParser.get<uint32_t>( "seed" );
+    uint32_t const numDistinctRows = cmdParser.get<uint32_t>( "distinctRows" );
+
+    // Run the load
+    //-------------------------------------------------------------------------
+
+    std::cout << "Running " << numConnections << " connection(s) with " << numRowsPerRequest << " row(s) per request against " << Socket::ToString( address ) << " for " << durationSeconds << "s" << std::endl;
+
+    std::vector<ConnectionResult> results( numConnections );
+    std::vector<std::thread> threads;
+    auto const startTime = Clock::now();
+    auto const endTime = startTime + std::chrono::seconds( durationSeconds );
+    for ( uint32_t connectionIdx = 0; connectionIdx < numConnections; connectionIdx++ )
+    {
+        threads.emplace_back( RunConnection, std::cref( address ), numRowsPerRequest, numDistinctRows, endTime, seed, connectionIdx, std::ref( results[connectionIdx] ) );
+    }
+
+    for ( auto& thread : threads )
+    {
+        thread.join();
+    }
+    double const elapsedSeconds = std::chrono::duration<double>( Clock::now() - startTime ).count();
+
+    // Report
+    //-------------------------------------------------------------------------
+
+    uint64_t numRequests = 0;
+    uint64_t numRows = 0;
+    std::vector<float> latenciesUS;
+    for ( auto const& result : results )
+    {
+        if ( !result.m_succeeded )
+        {
+            return 1;
+        }
+
+        numRequests += result.m_numRequests;
+        numRows += result.m_numRows;
+        latenciesUS.insert( latenciesUS.end(), result.m_latenciesUS.begin(), result.m_latenciesUS.end() );
+    }
+
+    if ( latenciesUS.empty() )
+    {
+        std::cout << "No requests completed" << std::endl;
+        return 1;
+    }
+
+    std::sort( latenciesUS.begin(), latenciesUS.end() );
+    auto GetPercentile = [&latenciesUS] ( double percentile ) { return latenciesUS[std::min( latenciesUS.size() - 1, (size_t) ( percentile / 100.0 * latenciesUS.size() ) )]; };
+
+    std::cout << "Client - Requests: " << numRequests << " (" << numRequests / elapsedSeconds << "/s), Rows: " << numRows << " (" << numRows / elapsedSeconds << "/s)"
+              << ", Latency us - p50: " << GetPercentile( 50 ) << " p90: " << GetPercentile( 90 ) << " p99: " << GetPercentile( 99 ) << " p99.9: " << GetPercentile( 99.9 ) << " max: " << latenciesUS.back() << std::endl;
+
+    ServerStats stats;
+    if ( !GetServerStats( address, stats ) )
+    {
+        return 1;
+    }
+
+    std::cout << "Server - Requests: " << stats.m_numRequests << ", Rows: " << stats.m_numRows << ", Batches: " << stats.m_numBatches << ", Mean Batch Rows: " << stats.m_meanBatchRows
+              << ", Latency us - p50: " << stats.m_latencyP50US << " p90: " << stats.m_latencyP90US << " p99: " << stats.m_latencyP99US << " max: " << stats.m_latencyMaxUS << ", Model Version: " << stats.m_modelVersion << std::endl;
+
+    if ( stats.m_cacheHits + stats.m_cacheMisses > 0 )
+    {
+        std::cout << "Server Cache - Hit Rate: " << stats.m_cacheHitRate << "% (" << stats.m_cacheHits << " hits, " << stats.m_cacheMisses << " misses), Entries: " << stats.m_cacheEntries
+                  << ", Evictions: " << stats.m_cacheEvictions << ", Memory: " << stats.m_cacheMemoryBytes / 1024.0 << " KB" << std::endl;
+    }
+
+    return 0;
+}
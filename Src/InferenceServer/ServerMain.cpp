@@ -0,0 +1,163 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Standalone inference server: serves a saved model until interrupted, SIGHUP reloads the model file without downtime
+
+#include "InferenceServer.h"
+#include "NeuralNetwork/Autotuner.h"
+#include "NeuralNetwork/NetworkSerialization.h"
+#include <signal.h>
+#include <time.h>
+#include <iostream>
+
+#include "cmdParser.h"
+
+//-------------------------------------------------------------------------
+
+namespace
+{
+    void PrintStats( BPN::InferenceProtocol::ServerStats const& stats )
+    {
+        std::cout << "Requests: " << stats.m_numRequests << " (" << stats.m_requestsPerSecond << "/s), Rows: " << stats.m_numRows << " (" << stats.m_rowsPerSecond << "/s)"
+                  << ", Mean Batch Rows: " << stats.m_meanBatchRows
+                  << ", Latency us - p50: " << stats.m_latencyP50US << " p90: " << stats.m_latencyP90US << " p99: " << stats.m_latencyP99US << " max: " << stats.m_latencyMaxUS
+                  << ", Model Version: " << stats.m_modelVersion << std::endl;
+
+        if ( stats.m_cacheHits + stats.m_cacheMisses > 0 )
+        {
+            std::cout << "Cache - Hit Rate: " << stats.m_cacheHitRate << "% (" << stats.m_cacheHits << " hits, " << stats.m_cacheMisses << " misses), Entries: " << stats.m_cacheEntries
+                      << ", Evictions: " << stats.m_cacheEvictions << ", Memory: " << stats.m_cacheMemoryBytes / 1024.0 << " KB" << std::endl;
+        }
+    }
+
+    // Connected clients rely on the input and output counts they were sent on connect, so only same shaped models can be swapped in
+    void ReloadModel( std::string const& path, BPN::ModelHandle& modelHandle )
+    {
+        std::unique_ptr<BPN::Network> pNetwork;
+        if ( !BPN::LoadNetwork( path, pNetwork ) )
+        {
+            return;
+        }
+
+        {
+            BPN::ModelHandle::ReadGuard const pCurrentNetwork = modelHandle.Acquire();
+            if ( pNetwork->GetNumInputs() != pCurrentNetwork->GetNumInputs() || pNetwork->GetNumOutputs() != pCurrentNetwork->GetNumOutputs() )
+            {
+                std::cout << "Reloaded model has " << pNetwork->GetNumInputs() << " inputs and " << pNetwork->GetNumOutputs() << " outputs, expected " << pCurrentNetwork->GetNumInputs() << " and " << pCurrentNetwork->GetNumOutputs() << std::endl;
+                return;
+            }
+        }
+
+        uint64_t const version = modelHandle.Publish( std::move( pNetwork ) );
+        std::cout << "Published model version " << version << " (" << modelHandle.GetNumReclaimed() << " previous versions reclaimed)" << std::endl;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+int main( int argc, char* argv[] )
+{
+    cli::Parser cmdParser( argc, argv );
+    cmdParser.set_required<std::string>( "model", "ModelFile", "Path to a model saved with the -save option of the trainer." );
+    cmdParser.set_optional<std::string>( "unix", "UnixSocketPath", "", "Listen on this Unix domain socket instead of TCP." );
+    cmdParser.set_optional<uint32_t>( "port", "Port", 5555, "Loopback TCP port to listen on." );
+    cmdParser.set_optional<uint32_t>( "batch", "MaxBatchRows", 64, "Max rows per micro-batch." );
+    cmdParser.set_optional<uint32_t>( "delay", "MaxBatchDelayUS", 200, "Max time in microseconds a request waits for its batch to fill up." );
+    cmdParser.set_optional<uint32_t>( "threads", "NumWorkerThreads", 0, "Number of worker threads, 0 uses the hardware concurrency." );
+    cmdParser.set_optional<uint32_t>( "cacheMB", "CacheMemoryMB", 0, "Memory bound in MB of a cache of recently scored rows keyed on the model version, 0 disables caching." );
+    cmdParser.set_optional<uint32_t>( "stats", "StatsIntervalSeconds", 5, "Interval at which stats are printed, 0 to only print them on exit." );
+    cmdParser.set_optional<bool>( "autotune", "Autotune", false, "Measure the highest throughput batch rows, worker thread count and GEMM backend for the model shape on this machine, or reuse the cached choice, instead of -batch and -threads." );
+    cmdParser.set_optional<double>( "latencyBudget", "MaxLatencyP99US", 0, "p99 batch evaluation latency in microseconds that the autotuned configuration must stay within, 0 for no limit." );
+    cmdParser.set_optional<std::string>( "autotuneCache", "AutotuneCacheFile", "NeuralNetwork.autotune", "File the autotuned configurations are cached in." );
+    cmdParser.set_optional<bool>( "retune", "Retune", false, "Measure the autotune candidates again even if the cache has an entry for this shape and machine." );
+
+    if ( !cmdParser.run() )
+    {
+        std::cout << "Invalid command line arguments";
+        return 1;
+    }
+
+    std::string const modelPath = cmdParser.get<std::string>( "model" );
+    std::unique_ptr<BPN::Network> pNetwork;
+    if ( !BPN::LoadNetwork( modelPath, pNetwork ) )
+    {
+        return 1;
+    }
+
+    BPN::Network::Settings const networkSettings = { (uint32_t) pNetwork->GetNumInputs(), (uint32_t) pNetwork->GetNumHidden(), (uint32_t) pNetwork->GetNumOutputs() };
+    BPN::ModelHandle modelHandle( std::move( pNetwork ) );
+
+    BPN::InferenceServer::Settings settings;
+    settings.m_address.m_unixSocketPath = cmdParser.get<std::string>( "unix" );
+    settings.m_address.m_port = (uint16_t) cmdParser.get<uint32_t>( "port" );
+    settings.m_maxBatchRows = cmdParser.get<uint32_t>( "batch" );
+    settings.m_maxBatchDelayUS = cmdParser.get<uint32_t>( "delay" );
+    settings.m_numWorkerThreads = cmdParser.get<uint32_t>( "threads" );
+    settings.m_cacheMemoryBytes = (size_t) cmdParser.get<uint32_t>( "cacheMB" ) << 20;
+    uint32_t const statsIntervalSeconds = cmdParser.get<uint32_t>( "stats" );
+
+    if ( cmdParser.get<bool>( "autotune" ) )
+    {
+        BPN::Autotuner::Settings autotunerSettings;
+        autotunerSettings.m_cachePath = cmdParser.get<std::string>( "autotuneCache" );
+        autotunerSettings.m_forceRetune = cmdParser.get<bool>( "retune" );
+        autotunerSettings.m_maxLatencyP99US = cmdParser.get<double>( "latencyBudget" );
+
+        BPN::Autotuner autotuner( autotunerSettings, networkSettings.m_numInputs, networkSettings.m_numHidden, networkSettings.m_numOutputs );
+        BPN::Autotuner::Result<BPN::Autotuner::InferenceConfig> const autotuneResult = autotuner.TuneInference();
+        BPN::Autotuner::PrintResult( std::cout, autotuneResult );
+
+        BPN::Gemm::SetBackend( autotuneResult.m_best.m_backend );
+        settings.m_maxBatchRows = autotuneResult.m_best.m_batchRows;
+        settings.m_numWorkerThreads = autotuneResult.m_best.m_numThreads;
+    }
+
+    // Block the handled signals before any threads are created so that only this thread receives them
+    sigset_t signals;
+    sigemptyset( &signals );
+    sigaddset( &signals, SIGINT );
+    sigaddset( &signals, SIGTERM );
+    sigaddset( &signals, SIGHUP );
+    pthread_sigmask( SIG_BLOCK, &signals, nullptr );
+
+    BPN::InferenceServer server( settings, modelHandle );
+    if ( !server.Start() )
+    {
+        return 1;
+    }
+
+    std::cout << "Serving " << networkSettings.m_numInputs << "x" << networkSettings.m_numHidden << "x" << networkSettings.m_numOutputs << " network on " << BPN::Socket::ToString( settings.m_address ) << std::endl;
+
+    while ( true )
+    {
+        int signal;
+        if ( statsIntervalSeconds > 0 )
+        {
+            timespec const timeout = { (time_t) statsIntervalSeconds, 0 };
+            signal = sigtimedwait( &signals, nullptr, &timeout );
+            if ( signal < 0 )
+            {
+                PrintStats( server.GetStats() );
+                continue;
+            }
+        }
+        else if ( sigwait( &signals, &signal ) != 0 )
+        {
+            continue;
+        }
+
+        if ( signal == SIGHUP )
+        {
+            ReloadModel( modelPath, modelHandle );
+            continue;
+        }
+
+        break;
+    }
+
+    server.Stop();
+    PrintStats( server.GetStats() );
+    return 0;
+}
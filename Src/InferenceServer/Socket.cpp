@@ -0,0 +1,227 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "Socket.h"
+#include <errno.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace Socket
+    {
+        namespace
+        {
+            bool CreateUnixAddress( std::string const& path, sockaddr_un& address )
+            {
+                memset( &address, 0, sizeof( address ) );
+                address.sun_family = AF_UNIX;
+                if ( path.size() >= sizeof( address.sun_path ) )
+                {
+                    std::cout << "Unix socket path too long: " << path << std::endl;
+                    return false;
+                }
+
+                memcpy( address.sun_path, path.c_str(), path.size() );
+                return true;
+            }
+
+            void CreateLoopbackAddress( uint16_t port, sockaddr_in& address )
+            {
+                memset( &address, 0, sizeof( address ) );
+                address.sin_family = AF_INET;
+                address.sin_port = htons( port );
+                address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+            }
+
+            void DisableNagle( int socket )
+            {
+                int const enable = 1;
+                setsockopt( socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof( enable ) );
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        std::string ToString( Address const& address )
+        {
+            return address.m_unixSocketPath.empty() ? "127.0.0.1:" + std::to_string( address.m_port ) : "unix:" + address.m_unixSocketPath;
+        }
+
+        int Listen( Address const& address )
+        {
+            int listenSocket = g_invalidSocket;
+            int result = -1;
+
+            if ( !address.m_unixSocketPath.empty() )
+            {
+                sockaddr_un unixAddress;
+                if ( !CreateUnixAddress( address.m_unixSocketPath, unixAddress ) )
+                {
+                    return g_invalidSocket;
+                }
+
+                // Remove a stale socket file left behind by a previous run
+                unlink( address.m_unixSocketPath.c_str() );
+
+                listenSocket = socket( AF_UNIX, SOCK_STREAM, 0 );
+                if ( listenSocket != g_invalidSocket )
+                {
+                    result = bind( listenSocket, reinterpret_cast<sockaddr*>( &unixAddress ), sizeof( unixAddress ) );
+                }
+            }
+            else
+            {
+                sockaddr_in tcpAddress;
+                CreateLoopbackAddress( address.m_port, tcpAddress );
+
+                listenSocket = socket( AF_INET, SOCK_STREAM, 0 );
+                if ( listenSocket != g_invalidSocket )
+                {
+                    int const enable = 1;
+                    setsockopt( listenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof( enable ) );
+                    result = bind( listenSocket, reinterpret_cast<sockaddr*>( &tcpAddress ), sizeof( tcpAddress ) );
+                }
+            }
+
+            if ( listenSocket == g_invalidSocket || result != 0 || listen( listenSocket, SOMAXCONN ) != 0 )
+            {
+                std::cout << "Error Listening On: " << ToString( address ) << " (" << strerror( errno ) << ")" << std::endl;
+                Close( listenSocket );
+                return g_invalidSocket;
+            }
+
+            return listenSocket;
+        }
+
+        int Accept( int listenSocket )
+        {
+            int socket = g_invalidSocket;
+            do
+            {
+                socket = accept( listenSocket, nullptr, nullptr );
+            }
+            while ( socket == g_invalidSocket && errno == EINTR );
+
+            if ( socket != g_invalidSocket )
+            {
+                DisableNagle( socket );
+            }
+
+            return socket;
+        }
+
+        int Connect( Address const& address )
+        {
+            int connectSocket = g_invalidSocket;
+            int result = -1;
+
+            if ( !address.m_unixSocketPath.empty() )
+            {
+                sockaddr_un unixAddress;
+                if ( CreateUnixAddress( address.m_unixSocketPath, unixAddress ) )
+                {
+                    connectSocket = socket( AF_UNIX, SOCK_STREAM, 0 );
+                    if ( connectSocket != g_invalidSocket )
+                    {
+                        result = connect( connectSocket, reinterpret_cast<sockaddr*>( &unixAddress ), sizeof( unixAddress ) );
+                    }
+                }
+            }
+            else
+            {
+                sockaddr_in tcpAddress;
+                CreateLoopbackAddress( address.m_port, tcpAddress );
+
+                connectSocket = socket( AF_INET, SOCK_STREAM, 0 );
+                if ( connectSocket != g_invalidSocket )
+                {
+                    result = connect( connectSocket, reinterpret_cast<sockaddr*>( &tcpAddress ), sizeof( tcpAddress ) );
+                    DisableNagle( connectSocket );
+                }
+            }
+
+            if ( connectSocket == g_invalidSocket || result != 0 )
+            {
+                std::cout << "Error Connecting To: " << ToString( address ) << " (" << strerror( errno ) << ")" << std::endl;
+                Close( connectSocket );
+                return g_invalidSocket;
+            }
+
+            return connectSocket;
+        }
+
+        void Shutdown( int socket )
+        {
+            if ( socket != g_invalidSocket )
+            {
+                shutdown( socket, SHUT_RDWR );
+            }
+        }
+
+        void Close( int socket )
+        {
+            if ( socket != g_invalidSocket )
+            {
+                close( socket );
+            }
+        }
+
+        bool SendAll( int socket, void const* pData, size_t size )
+        {
+            char const* pBytes = static_cast<char const*>( pData );
+            while ( size > 0 )
+            {
+                ssize_t const numSent = send( socket, pBytes, size, MSG_NOSIGNAL );
+                if ( numSent < 0 && errno == EINTR )
+                {
+                    continue;
+                }
+
+                if ( numSent <= 0 )
+                {
+                    return false;
+                }
+
+                pBytes += numSent;
+                size -= (size_t) numSent;
+            }
+
+            return true;
+        }
+
+        bool ReceiveAll( int socket, void* pData, size_t size )
+        {
+            char* pBytes = static_cast<char*>( pData );
+            while ( size > 0 )
+            {
+                ssize_t const numReceived = recv( socket, pBytes, size, 0 );
+                if ( numReceived < 0 && errno == EINTR )
+                {
+                    continue;
+                }
+
+                if ( numReceived <= 0 )
+                {
+                    return false;
+                }
+
+                pBytes += numReceived;
+                size -= (size_t) numReceived;
+            }
+
+            return true;
+        }
+    }
+}
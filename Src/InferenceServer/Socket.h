@@ -0,0 +1,41 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Minimal POSIX socket helpers for local (Unix domain socket or loopback TCP) connections
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace Socket
+    {
+        constexpr int g_invalidSocket = -1;
+
+        // A non-empty unix socket path takes precedence over the TCP port, TCP only binds/connects to the loopback address
+        struct Address
+        {
+            std::string     m_unixSocketPath;
+            uint16_t        m_port = 0;
+        };
+
+        std::string ToString( Address const& address );
+
+        int Listen( Address const& address );
+        int Accept( int listenSocket );
+        int Connect( Address const& address );
+        void Shutdown( int socket );
+        void Close( int socket );
+
+        // Blocking transfers of the full buffer, return false on error or a closed connection
+        bool SendAll( int socket, void const* pData, size_t size );
+        bool ReceiveAll( int socket, void* pData, size_t size );
+    }
+}
@@ -0,0 +1,614 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "AsyncFileReader.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+#if !_WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <sys/uio.h>
+#define BPN_HAS_IO_URING 1
+#else
+#define BPN_HAS_IO_URING 0
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        // Buffer and offset alignment required by direct I/O
+        constexpr size_t g_alignment = 4096;
+
+        inline double GetElapsedMS( Clock::time_point start, Clock::time_point end )
+        {
+            return std::chrono::duration<double, std::milli>( end - start ).count();
+        }
+
+        #if BPN_HAS_IO_URING
+        // Kernels 5.1-5.5 have io_uring but neither IORING_OP_READ nor the opcode probe, reads would complete with -EINVAL there
+        bool IsIoUringOpSupported( int ringHandle, uint8_t opcode )
+        {
+            uint32_t const numProbeOps = 256;
+            std::vector<uint8_t> probeMemory( sizeof( io_uring_probe ) + numProbeOps * sizeof( io_uring_probe_op ), 0 );
+            io_uring_probe* pProbe = (io_uring_probe*) probeMemory.data();
+            if ( syscall( __NR_io_uring_register, ringHandle, IORING_REGISTER_PROBE, pProbe, numProbeOps ) != 0 )
+            {
+                return false;
+            }
+
+            return opcode <= pProbe->last_op && opcode < pProbe->ops_len && ( pProbe->ops[opcode].flags & IO_URING_OP_SUPPORTED ) != 0;
+        }
+        #endif
+
+        #if !_WIN32
+        // Reads until the requested size, the end of the file or an error. Returns the bytes read or a negative errno.
+        int64_t ReadFully( int fileHandle, char* pBuffer, size_t size, uint64_t offset )
+        {
+            size_t numBytesRead = 0;
+            while ( numBytesRead < size )
+            {
+                ssize_t const result = pread( fileHandle, pBuffer + numBytesRead, size - numBytesRead, (off_t) ( offset + numBytesRead ) );
+                if ( result < 0 && errno == EINTR )
+                {
+                    continue;
+                }
+
+                if ( result < 0 )
+                {
+                    return -errno;
+                }
+
+                if ( result == 0 )
+                {
+                    break;
+                }
+
+                numBytesRead += (size_t) result;
+            }
+
+            return (int64_t) numBytesRead;
+        }
+        #endif
+    }
+
+    //-------------------------------------------------------------------------
+
+    #if BPN_HAS_IO_URING
+    struct AsyncFileReader::IoUring
+    {
+        ~IoUring()
+        {
+            if ( m_pSubmissionEntries != nullptr ) munmap( m_pSubmissionEntries, m_submissionEntriesSize );
+            if ( m_pCompletionRing != nullptr && m_pCompletionRing != m_pSubmissionRing ) munmap( m_pCompletionRing, m_completionRingSize );
+            if ( m_pSubmissionRing != nullptr ) munmap( m_pSubmissionRing, m_submissionRingSize );
+            if ( m_ringHandle >= 0 ) close( m_ringHandle );
+        }
+
+        int                                 m_ringHandle = -1;
+        void*                               m_pSubmissionRing = nullptr;
+        size_t                              m_submissionRingSize = 0;
+        void*                               m_pCompletionRing = nullptr;
+        size_t                              m_completionRingSize = 0;
+        io_uring_sqe*                       m_pSubmissionEntries = nullptr;
+        size_t                              m_submissionEntriesSize = 0;
+
+        unsigned*                           m_pSubmissionTail = nullptr;
+        unsigned*                           m_pSubmissionMask = nullptr;
+        unsigned*                           m_pSubmissionArray = nullptr;
+        unsigned*                           m_pCompletionHead = nullptr;
+        unsigned*                           m_pCompletionTail = nullptr;
+        unsigned*                           m_pCompletionMask = nullptr;
+        io_uring_cqe*                       m_pCompletionEntries = nullptr;
+        uint32_t                            m_numPendingSubmissions = 0;
+    };
+    #else
+    struct AsyncFileReader::IoUring {};
+    #endif
+
+    //-------------------------------------------------------------------------
+
+    AsyncFileReader::AsyncFileReader( Settings const& settings )
+        : m_settings( settings )
+    {
+        m_settings.m_blockSize = (uint32_t) ( ( std::max( 1u, m_settings.m_blockSize ) + g_alignment - 1 ) / g_alignment * g_alignment );
+        m_settings.m_queueDepth = std::max( 1u, m_settings.m_queueDepth );
+    }
+
+    AsyncFileReader::~AsyncFileReader()
+    {
+        Close();
+    }
+
+    char const* AsyncFileReader::GetBackendName( Backend backend )
+    {
+        return ( backend == Backend::IoUring ) ? "io_uring" : "pread thread pool";
+    }
+
+    bool AsyncFileReader::Open( std::string const& path )
+    {
+        Close();
+        m_openTime = Clock::now();
+        m_stats = Stats();
+        m_stats.m_queueDepth = m_settings.m_queueDepth;
+        m_path = path;
+
+        // Open the file
+        //-------------------------------------------------------------------------
+
+        #if _WIN32
+        std::ifstream file( path, std::ios::in | std::ios::binary | std::ios::ate );
+        if ( !file.is_open() )
+        {
+            return false;
+        }
+        m_fileSize = (uint64_t) file.tellg();
+        #else
+        #ifdef O_DIRECT
+        if ( m_settings.m_useDirectIO )
+        {
+            m_fileHandle = open( path.c_str(), O_RDONLY | O_DIRECT );
+            m_stats.m_isDirectIO = m_fileHandle >= 0;
+        }
+        #endif
+
+        if ( m_fileHandle < 0 )
+        {
+            m_fileHandle = open( path.c_str(), O_RDONLY );
+        }
+
+        struct stat fileStatus;
+        if ( m_fileHandle < 0 || fstat( m_fileHandle, &fileStatus ) != 0 || !S_ISREG( fileStatus.st_mode ) )
+        {
+            Close();
+            return false;
+        }
+        m_fileSize = (uint64_t) fileStatus.st_size;
+        #endif
+
+        // Buffers, one more than the reads in flight since the consumer holds on to one
+        //-------------------------------------------------------------------------
+
+        m_blockSize = m_settings.m_blockSize;
+        m_numFileBlocks = ( m_fileSize + m_blockSize - 1 ) / m_blockSize;
+        m_numBuffers = m_settings.m_queueDepth + 1;
+        m_bufferStride = m_blockSize + g_alignment;
+        m_pBuffers = (char*) ::operator new( m_bufferStride * m_numBuffers, std::align_val_t( g_alignment ) );
+        m_blockResults.assign( m_numBuffers, 0 );
+        m_isBlockComplete.assign( m_numBuffers, 0 );
+
+        if ( !m_settings.m_allowIoUring || !SetupIoUring() )
+        {
+            m_stats.m_backend = Backend::ThreadPool;
+            m_isShuttingDown = false;
+            for ( uint32_t threadIdx = 0; threadIdx < m_settings.m_queueDepth; threadIdx++ )
+            {
+                m_threads.emplace_back( &AsyncFileReader::ReadThread, this );
+            }
+        }
+
+        SubmitReads();
+        return true;
+    }
+
+    void AsyncFileReader::Close()
+    {
+        // Wait for the reads into the buffers to complete before releasing them
+        if ( m_pIoUring != nullptr )
+        {
+            for ( uint64_t blockIdx = m_nextReturnBlockIdx; blockIdx < m_nextSubmitBlockIdx && !m_hasFailed; blockIdx++ )
+            {
+                WaitForBlock( blockIdx );
+            }
+            m_pIoUring.reset();
+        }
+
+        if ( !m_threads.empty() )
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_requestedBlocks.clear();
+                m_isShuttingDown = true;
+            }
+            m_readRequestedCondition.notify_all();
+
+            for ( auto& thread : m_threads )
+            {
+                thread.join();
+            }
+            m_threads.clear();
+        }
+
+        #if !_WIN32
+        if ( m_fileHandle >= 0 )
+        {
+            close( m_fileHandle );
+            m_fileHandle = -1;
+        }
+        #endif
+
+        if ( m_pBuffers != nullptr )
+        {
+            ::operator delete( m_pBuffers, std::align_val_t( g_alignment ) );
+            m_pBuffers = nullptr;
+        }
+
+        m_fileSize = 0;
+        m_numFileBlocks = 0;
+        m_nextSubmitBlockIdx = 0;
+        m_nextReturnBlockIdx = 0;
+        m_hasFailed = false;
+    }
+
+    //-------------------------------------------------------------------------
+
+    bool AsyncFileReader::SetupIoUring()
+    {
+        #if BPN_HAS_IO_URING
+        std::unique_ptr<IoUring> pIoUring( new IoUring );
+
+        io_uring_params params;
+        memset( &params, 0, sizeof( params ) );
+        pIoUring->m_ringHandle = (int) syscall( __NR_io_uring_setup, m_settings.m_queueDepth, &params );
+        if ( pIoUring->m_ringHandle < 0 || !IsIoUringOpSupported( pIoUring->m_ringHandle, IORING_OP_READ ) )
+        {
+            return false;
+        }
+
+        // Map the rings, with IORING_FEAT_SINGLE_MMAP both rings share one mapping
+        pIoUring->m_submissionRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+        pIoUring->m_completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+        bool const isSingleMapping = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+        if ( isSingleMapping )
+        {
+            pIoUring->m_submissionRingSize = pIoUring->m_completionRingSize = std::max( pIoUring->m_submissionRingSize, pIoUring->m_completionRingSize );
+        }
+
+        void* pSubmissionRing = mmap( nullptr, pIoUring->m_submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pIoUring->m_ringHandle, IORING_OFF_SQ_RING );
+        if ( pSubmissionRing == MAP_FAILED )
+        {
+            return false;
+        }
+        pIoUring->m_pSubmissionRing = pSubmissionRing;
+
+        void* pCompletionRing = pSubmissionRing;
+        if ( !isSingleMapping )
+        {
+            pCompletionRing = mmap( nullptr, pIoUring->m_completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pIoUring->m_ringHandle, IORING_OFF_CQ_RING );
+            if ( pCompletionRing == MAP_FAILED )
+            {
+                return false;
+            }
+        }
+        pIoUring->m_pCompletionRing = pCompletionRing;
+
+        pIoUring->m_submissionEntriesSize = params.sq_entries * sizeof( io_uring_sqe );
+        void* pSubmissionEntries = mmap( nullptr, pIoUring->m_submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pIoUring->m_ringHandle, IORING_OFF_SQES );
+        if ( pSubmissionEntries == MAP_FAILED )
+        {
+            return false;
+        }
+        pIoUring->m_pSubmissionEntries = (io_uring_sqe*) pSubmissionEntries;
+
+        char* pSubmissionBase = (char*) pSubmissionRing;
+        pIoUring->m_pSubmissionTail = (unsigned*) ( pSubmissionBase + params.sq_off.tail );
+        pIoUring->m_pSubmissionMask = (unsigned*) ( pSubmissionBase + params.sq_off.ring_mask );
+        pIoUring->m_pSubmissionArray = (unsigned*) ( pSubmissionBase + params.sq_off.array );
+
+        char* pCompletionBase = (char*) pCompletionRing;
+        pIoUring->m_pCompletionHead = (unsigned*) ( pCompletionBase + params.cq_off.head );
+        pIoUring->m_pCompletionTail = (unsigned*) ( pCompletionBase + params.cq_off.tail );
+        pIoUring->m_pCompletionMask = (unsigned*) ( pCompletionBase + params.cq_off.ring_mask );
+        pIoUring->m_pCompletionEntries = (io_uring_cqe*) ( pCompletionBase + params.cq_off.cqes );
+
+        // Register the buffers so that the kernel doesn't have to map them for every read, plain reads are used if this fails (i.e. locked memory limits)
+        std::vector<iovec> buffers( m_numBuffers );
+        for ( uint32_t bufferIdx = 0; bufferIdx < m_numBuffers; bufferIdx++ )
+        {
+            buffers[bufferIdx].iov_base = m_pBuffers + bufferIdx * m_bufferStride;
+            buffers[bufferIdx].iov_len = m_blockSize;
+        }
+        m_stats.m_hasRegisteredBuffers = syscall( __NR_io_uring_register, pIoUring->m_ringHandle, IORING_REGISTER_BUFFERS, buffers.data(), m_numBuffers ) == 0;
+
+        m_pIoUring = std::move( pIoUring );
+        m_stats.m_backend = Backend::IoUring;
+        return true;
+        #else
+        return false;
+        #endif
+    }
+
+    // Keeps up to the queue depth blocks ahead of the consumer requested, every block reuses the buffer of a block that was already consumed
+    void AsyncFileReader::SubmitReads()
+    {
+        uint32_t numSubmitted = 0;
+        while ( m_nextSubmitBlockIdx < m_numFileBlocks && m_nextSubmitBlockIdx < m_nextReturnBlockIdx + m_settings.m_queueDepth )
+        {
+            uint64_t const blockIdx = m_nextSubmitBlockIdx++;
+            uint32_t const bufferIdx = (uint32_t) ( blockIdx % m_numBuffers );
+
+            #if BPN_HAS_IO_URING
+            if ( m_pIoUring != nullptr )
+            {
+                m_isBlockComplete[bufferIdx] = 0;
+
+                IoUring& ring = *m_pIoUring;
+                unsigned const tail = *ring.m_pSubmissionTail;
+                unsigned const entryIdx = tail & *ring.m_pSubmissionMask;
+                io_uring_sqe& entry = ring.m_pSubmissionEntries[entryIdx];
+                memset( &entry, 0, sizeof( entry ) );
+                entry.opcode = m_stats.m_hasRegisteredBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+                entry.fd = m_fileHandle;
+                entry.off = GetBlockOffset( blockIdx );
+                entry.addr = (uint64_t) (uintptr_t) GetBlockBuffer( blockIdx );
+                entry.len = m_blockSize;
+                entry.buf_index = (uint16_t) bufferIdx;
+                entry.user_data = blockIdx;
+                ring.m_pSubmissionArray[entryIdx] = entryIdx;
+                __atomic_store_n( ring.m_pSubmissionTail, tail + 1, __ATOMIC_RELEASE );
+                numSubmitted++;
+                continue;
+            }
+            #endif
+
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_isBlockComplete[bufferIdx] = 0;
+                m_requestedBlocks.push_back( blockIdx );
+            }
+            m_readRequestedCondition.notify_one();
+        }
+
+        #if BPN_HAS_IO_URING
+        if ( numSubmitted > 0 )
+        {
+            IoUring& ring = *m_pIoUring;
+            ring.m_numPendingSubmissions += numSubmitted;
+            while ( ring.m_numPendingSubmissions > 0 )
+            {
+                long const result = syscall( __NR_io_uring_enter, ring.m_ringHandle, ring.m_numPendingSubmissions, 0, 0, nullptr, 0 );
+                if ( result < 0 && errno == EINTR )
+                {
+                    continue;
+                }
+
+                if ( result <= 0 )
+                {
+                    m_hasFailed = true;
+                    break;
+                }
+
+                ring.m_numPendingSubmissions -= (uint32_t) result;
+            }
+        }
+        #endif
+    }
+
+    void AsyncFileReader::SetBlockComplete( uint64_t blockIdx, int64_t result )
+    {
+        uint32_t const bufferIdx = (uint32_t) ( blockIdx % m_numBuffers );
+        m_blockResults[bufferIdx] = result;
+        m_isBlockComplete[bufferIdx] = 1;
+    }
+
+    bool AsyncFileReader::WaitForBlock( uint64_t blockIdx )
+    {
+        uint32_t const bufferIdx = (uint32_t) ( blockIdx % m_numBuffers );
+
+        #if BPN_HAS_IO_URING
+        if ( m_pIoUring != nullptr )
+        {
+            IoUring& ring = *m_pIoUring;
+            while ( m_isBlockComplete[bufferIdx] == 0 )
+            {
+                // Reap everything that has completed
+                unsigned head = *ring.m_pCompletionHead;
+                unsigned const tail = __atomic_load_n( ring.m_pCompletionTail, __ATOMIC_ACQUIRE );
+                for ( ; head != tail; head++ )
+                {
+                    io_uring_cqe const& completion = ring.m_pCompletionEntries[head & *ring.m_pCompletionMask];
+                    uint64_t const completedBlockIdx = completion.user_data;
+                    int64_t result = completion.res;
+
+                    // Short reads are only expected at the end of the file, finish any others synchronously
+                    size_t const expectedSize = (size_t) std::min<uint64_t>( m_blockSize, m_fileSize - GetBlockOffset( completedBlockIdx ) );
+                    if ( result >= 0 && (size_t) result < expectedSize )
+                    {
+                        int64_t const remainderResult = ReadFully( m_fileHandle, GetBlockBuffer( completedBlockIdx ) + result, expectedSize - (size_t) result, GetBlockOffset( completedBlockIdx ) + result );
+                        result = ( remainderResult < 0 ) ? remainderResult : result + remainderResult;
+                    }
+
+                    SetBlockComplete( completedBlockIdx, result );
+                }
+                __atomic_store_n( ring.m_pCompletionHead, head, __ATOMIC_RELEASE );
+
+                if ( m_isBlockComplete[bufferIdx] == 0 )
+                {
+                    long const result = syscall( __NR_io_uring_enter, ring.m_ringHandle, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0 );
+                    if ( result < 0 && errno != EINTR )
+                    {
+                        m_hasFailed = true;
+                        return false;
+                    }
+                }
+            }
+
+            return m_blockResults[bufferIdx] >= 0;
+        }
+        #endif
+
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_readCompleteCondition.wait( lock, [this, bufferIdx] () { return m_isBlockComplete[bufferIdx] != 0; } );
+        return m_blockResults[bufferIdx] >= 0;
+    }
+
+    void AsyncFileReader::ReadThread()
+    {
+        #if _WIN32
+        std::ifstream file( m_path, std::ios::in | std::ios::binary );
+        #endif
+
+        while ( true )
+        {
+            uint64_t blockIdx = 0;
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                m_readRequestedCondition.wait( lock, [this] () { return m_isShuttingDown || !m_requestedBlocks.empty(); } );
+                if ( m_isShuttingDown )
+                {
+                    return;
+                }
+
+                blockIdx = m_requestedBlocks.front();
+                m_requestedBlocks.pop_front();
+            }
+
+            size_t const expectedSize = (size_t) std::min<uint64_t>( m_blockSize, m_fileSize - GetBlockOffset( blockIdx ) );
+
+            #if _WIN32
+            file.clear();
+            file.seekg( (std::streamoff) GetBlockOffset( blockIdx ) );
+            file.read( GetBlockBuffer( blockIdx ), (std::streamsize) expectedSize );
+            int64_t const result = file.bad() ? -EIO : (int64_t) file.gcount();
+            #else
+            // Direct I/O needs the full aligned size, the read stops at the end of the file
+            int64_t const result = ReadFully( m_fileHandle, GetBlockBuffer( blockIdx ), m_stats.m_isDirectIO ? m_blockSize : expectedSize, GetBlockOffset( blockIdx ) );
+            #endif
+
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                SetBlockComplete( blockIdx, result );
+            }
+            m_readCompleteCondition.notify_all();
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    bool AsyncFileReader::GetNextBlock( char*& pData, size_t& size )
+    {
+        // The previously returned block is released here, its buffer can take the next read
+        SubmitReads();
+
+        if ( m_hasFailed || m_nextReturnBlockIdx >= m_numFileBlocks )
+        {
+            return false;
+        }
+
+        auto const waitStartTime = Clock::now();
+        uint64_t const blockIdx = m_nextReturnBlockIdx;
+        if ( !WaitForBlock( blockIdx ) )
+        {
+            m_hasFailed = true;
+            return false;
+        }
+        m_stats.m_waitTimeMS += GetElapsedMS( waitStartTime, Clock::now() );
+
+        uint32_t const bufferIdx = (uint32_t) ( blockIdx % m_numBuffers );
+        size_t const expectedSize = (size_t) std::min<uint64_t>( m_blockSize, m_fileSize - GetBlockOffset( blockIdx ) );
+        if ( (size_t) m_blockResults[bufferIdx] < expectedSize )
+        {
+            // The file was truncated while being read
+            m_hasFailed = true;
+            return false;
+        }
+
+        pData = GetBlockBuffer( blockIdx );
+        size = expectedSize;
+        m_nextReturnBlockIdx++;
+
+        m_stats.m_numBlocks++;
+        m_stats.m_numBytesRead += size;
+        m_stats.m_totalTimeMS = GetElapsedMS( m_openTime, Clock::now() );
+        m_stats.m_throughputMBs = ( m_stats.m_totalTimeMS > 0 ) ? m_stats.m_numBytesRead / ( m_stats.m_totalTimeMS * 1000.0 ) : 0.0;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+
+    double AsyncFileReader::MeasureDeviceThroughputMBs( std::string const& path, Settings const& settings )
+    {
+        Settings deviceSettings = settings;
+        deviceSettings.m_useDirectIO = true;
+        deviceSettings.m_queueDepth = std::max( 32u, settings.m_queueDepth );
+
+        AsyncFileReader reader( deviceSettings );
+        if ( !reader.Open( path ) )
+        {
+            return 0;
+        }
+
+        char* pData = nullptr;
+        size_t size = 0;
+        while ( reader.GetNextBlock( pData, size ) ) {}
+        return reader.HasFailed() ? 0 : reader.GetStats().m_throughputMBs;
+    }
+
+    std::string AsyncFileReader::GetDeviceName( std::string const& path )
+    {
+        #if __linux__
+        struct stat fileStatus;
+        if ( stat( path.c_str(), &fileStatus ) != 0 )
+        {
+            return std::string();
+        }
+
+        std::ifstream deviceInfo( "/sys/dev/block/" + std::to_string( major( fileStatus.st_dev ) ) + ":" + std::to_string( minor( fileStatus.st_dev ) ) + "/uevent" );
+        std::string line;
+        while ( std::getline( deviceInfo, line ) )
+        {
+            if ( line.compare( 0, 8, "DEVNAME=" ) == 0 )
+            {
+                return line.substr( 8 );
+            }
+        }
+        #else
+        (void) path;
+        #endif
+
+        return std::string();
+    }
+
+    void AsyncFileReader::PrintStats( std::ostream& stream, Stats const& stats, std::string const& deviceName, double deviceThroughputMBs )
+    {
+        stream << "Read " << stats.m_numBytesRead / ( 1024.0 * 1024.0 ) << " MB in " << stats.m_numBlocks << " blocks with " << GetBackendName( stats.m_backend )
+               << ( stats.m_hasRegisteredBuffers ? " (registered buffers" : " (" ) << ( stats.m_hasRegisteredBuffers ? ", " : "" ) << stats.m_queueDepth << " reads in flight"
+               << ( stats.m_isDirectIO ? ", direct I/O)" : ")" ) << ": " << stats.m_throughputMBs << " MB/s, waited " << stats.m_waitTimeMS << " ms of " << stats.m_totalTimeMS << " ms for reads" << std::endl;
+
+        if ( deviceThroughputMBs > 0 )
+        {
+            stream << "Device " << ( deviceName.empty() ? "(unknown)" : deviceName ) << " delivers " << deviceThroughputMBs << " MB/s for this file with deep direct reads, the load reached "
+                   << stats.m_throughputMBs / deviceThroughputMBs * 100.0 << "% of it" << std::endl;
+
+            if ( stats.m_throughputMBs > deviceThroughputMBs )
+            {
+                stream << "The load was served from the page cache" << std::endl;
+            }
+            else if ( stats.m_waitTimeMS < 0.1 * stats.m_totalTimeMS )
+            {
+                stream << "The load is bound by parsing, not by the reads" << std::endl;
+            }
+        }
+    }
+}
@@ -0,0 +1,134 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Asynchronous sequential file reader
+//
+// Reads a file as a sequence of large blocks while keeping several reads in flight, so that parsing one
+// block overlaps with reading the following ones. On Linux the reads go through io_uring into buffers
+// registered with the kernel; if io_uring isn't available (old kernel, seccomp, other platforms) a pool
+// of threads issuing positional reads is used instead. Blocks are handed out in file order directly from
+// the read buffers, a block stays valid and writable until the next block is requested, at which point
+// its buffer is reused for a read further ahead.
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class AsyncFileReader
+    {
+    public:
+
+        enum class Backend : uint8_t
+        {
+            IoUring,
+            ThreadPool,
+        };
+
+        struct Settings
+        {
+            uint32_t                        m_blockSize = 1 << 20;      // Rounded up to a multiple of 4KB
+            uint32_t                        m_queueDepth = 8;           // Reads in flight, also the number of fallback threads
+            bool                            m_allowIoUring = true;
+            bool                            m_useDirectIO = false;      // Bypass the page cache, falls back to buffered reads if the file system doesn't support it
+        };
+
+        struct Stats
+        {
+            Backend                         m_backend = Backend::ThreadPool;
+            bool                            m_hasRegisteredBuffers = false;
+            bool                            m_isDirectIO = false;
+            uint32_t                        m_queueDepth = 0;
+            uint64_t                        m_numBytesRead = 0;
+            uint64_t                        m_numBlocks = 0;
+            double                          m_totalTimeMS = 0;          // From opening the file to handing out the last block
+            double                          m_waitTimeMS = 0;           // Time the consumer spent waiting for reads to complete
+            double                          m_throughputMBs = 0;
+        };
+
+    public:
+
+        explicit AsyncFileReader( Settings const& settings );
+        ~AsyncFileReader();
+
+        AsyncFileReader( AsyncFileReader const& ) = delete;
+        AsyncFileReader& operator=( AsyncFileReader const& ) = delete;
+
+        // Opens the file and starts reading its first blocks
+        bool Open( std::string const& path );
+        void Close();
+
+        // Next block in file order. There is always one writable byte past the end of the block, i.e. for a terminator.
+        // Returns false once the whole file has been returned or if a read failed.
+        bool GetNextBlock( char*& pData, size_t& size );
+
+        inline bool HasFailed() const { return m_hasFailed; }
+        inline Stats const& GetStats() const { return m_stats; }
+
+        // Reads the whole file with direct I/O at a deep queue without doing anything with the data, i.e. what the device
+        // behind the file can deliver. Returns 0 if the file can't be read.
+        static double MeasureDeviceThroughputMBs( std::string const& path, Settings const& settings );
+
+        // Name of the block device the file is on, empty if unknown
+        static std::string GetDeviceName( std::string const& path );
+
+        static char const* GetBackendName( Backend backend );
+        static void PrintStats( std::ostream& stream, Stats const& stats, std::string const& deviceName, double deviceThroughputMBs );
+
+    private:
+
+        struct IoUring;
+
+        bool SetupIoUring();
+        void SubmitReads();
+        bool WaitForBlock( uint64_t blockIdx );
+        void ReadThread();
+        void SetBlockComplete( uint64_t blockIdx, int64_t result );
+
+        inline size_t GetBlockOffset( uint64_t blockIdx ) const { return (size_t) ( blockIdx * m_blockSize ); }
+        inline char* GetBlockBuffer( uint64_t blockIdx ) { return m_pBuffers + ( blockIdx % m_numBuffers ) * m_bufferStride; }
+
+    private:
+
+        Settings                            m_settings;
+        Stats                               m_stats;
+        int                                 m_fileHandle = -1;
+        uint64_t                            m_fileSize = 0;
+        uint64_t                            m_numFileBlocks = 0;
+        uint32_t                            m_blockSize = 0;
+        uint32_t                            m_numBuffers = 0;
+        size_t                              m_bufferStride = 0;
+        char*                               m_pBuffers = nullptr;
+        std::unique_ptr<IoUring>            m_pIoUring;
+
+        uint64_t                            m_nextSubmitBlockIdx = 0;
+        uint64_t                            m_nextReturnBlockIdx = 0;
+        std::vector<int64_t>                m_blockResults;             // Bytes read per buffer, negative errno on failure, only valid once complete
+        std::vector<uint8_t>                m_isBlockComplete;          // Per buffer
+        bool                                m_hasFailed = false;
+        std::chrono::steady_clock::time_point m_openTime;
+
+        // Thread pool fallback, the block queue and completion flags are protected by the mutex
+        std::vector<std::thread>            m_threads;
+        std::mutex                          m_mutex;
+        std::condition_variable             m_readRequestedCondition;
+        std::condition_variable             m_readCompleteCondition;
+        std::deque<uint64_t>                m_requestedBlocks;
+        bool                                m_isShuttingDown = false;
+        std::string                         m_path;
+    };
+}
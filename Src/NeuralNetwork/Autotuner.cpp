@@ -0,0 +1,590 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "Autotuner.h"
+#include "NumaTrainer.h"
+#include "Random.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define BPN_HAS_CPUID 1
+#elif defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#include <cpuid.h>
+#define BPN_HAS_CPUID 1
+#else
+#define BPN_HAS_CPUID 0
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        inline double GetElapsedUS( Clock::time_point start, Clock::time_point end )
+        {
+            return std::chrono::duration<double, std::micro>( end - start ).count();
+        }
+
+        // Restores the process wide GEMM backend once the measurements are done
+        class ScopedGemmBackend
+        {
+        public:
+
+            explicit ScopedGemmBackend( Gemm::Backend backend ) : m_previousBackend( Gemm::GetBackend() ) { Gemm::SetBackend( backend ); }
+            ~ScopedGemmBackend() { Gemm::SetBackend( m_previousBackend ); }
+
+        private:
+
+            Gemm::Backend                   m_previousBackend;
+        };
+
+        std::string Trim( std::string const& value )
+        {
+            size_t const start = value.find_first_not_of( " \t\r\n" );
+            if ( start == std::string::npos )
+            {
+                return std::string();
+            }
+
+            size_t const end = value.find_last_not_of( " \t\r\n" );
+            return value.substr( start, end - start + 1 );
+        }
+
+        bool ParseUInt32( std::string const& value, uint32_t& result )
+        {
+            char* pEnd = nullptr;
+            unsigned long const parsedValue = strtoul( value.c_str(), &pEnd, 10 );
+            if ( value.empty() || *pEnd != 0 || parsedValue == 0 )
+            {
+                return false;
+            }
+
+            result = (uint32_t) parsedValue;
+            return true;
+        }
+
+        bool ParseDouble( std::string const& value, double& result )
+        {
+            char* pEnd = nullptr;
+            result = strtod( value.c_str(), &pEnd );
+            return !value.empty() && *pEnd == 0;
+        }
+
+        bool ParseAvailableBackend( std::string const& value, Gemm::Backend& backend )
+        {
+            return Gemm::ParseBackendName( value.c_str(), backend ) && Gemm::IsBackendAvailable( backend );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    Autotuner::Autotuner( Settings const& settings, uint32_t numInputs, uint32_t numHidden, uint32_t numOutputs )
+        : m_settings( settings )
+        , m_numInputs( numInputs )
+        , m_numHidden( numHidden )
+        , m_numOutputs( numOutputs )
+    {
+        assert( numInputs > 0 && numHidden > 0 && numOutputs > 0 );
+    }
+
+    std::string Autotuner::GetCpuModel()
+    {
+        std::string model;
+
+        #if BPN_HAS_CPUID
+        uint32_t registers[12] = {};
+        #if _MSC_VER
+        int maxExtendedLeaf[4];
+        __cpuid( maxExtendedLeaf, 0x80000000 );
+        if ( (uint32_t) maxExtendedLeaf[0] >= 0x80000004 )
+        {
+            for ( uint32_t leafIdx = 0; leafIdx < 3; leafIdx++ )
+            {
+                __cpuid( (int*) &registers[leafIdx * 4], 0x80000002 + leafIdx );
+            }
+        }
+        #else
+        if ( __get_cpuid_max( 0x80000000, nullptr ) >= 0x80000004 )
+        {
+            for ( uint32_t leafIdx = 0; leafIdx < 3; leafIdx++ )
+            {
+                __get_cpuid( 0x80000002 + leafIdx, &registers[leafIdx * 4], &registers[leafIdx * 4 + 1], &registers[leafIdx * 4 + 2], &registers[leafIdx * 4 + 3] );
+            }
+        }
+        #endif
+
+        char brand[sizeof( registers ) + 1] = {};
+        memcpy( brand, registers, sizeof( registers ) );
+        model = Trim( brand );
+        #else
+        std::ifstream cpuInfo( "/proc/cpuinfo" );
+        std::string line;
+        while ( model.empty() && std::getline( cpuInfo, line ) )
+        {
+            if ( line.compare( 0, 10, "model name" ) == 0 || line.compare( 0, 8, "Hardware" ) == 0 )
+            {
+                size_t const separatorIdx = line.find( ':' );
+                model = ( separatorIdx != std::string::npos ) ? Trim( line.substr( separatorIdx + 1 ) ) : std::string();
+            }
+        }
+        #endif
+
+        return model.empty() ? "unknown" : model;
+    }
+
+    //-------------------------------------------------------------------------
+
+    std::vector<uint32_t> Autotuner::GetThreadCounts() const
+    {
+        uint32_t const numHardwareThreads = std::max( 1u, std::thread::hardware_concurrency() );
+
+        std::vector<uint32_t> threadCounts;
+        if ( m_settings.m_threadCounts.empty() )
+        {
+            for ( uint32_t numThreads = 1; numThreads < numHardwareThreads; numThreads *= 2 )
+            {
+                threadCounts.push_back( numThreads );
+            }
+            threadCounts.push_back( numHardwareThreads );
+        }
+        else
+        {
+            for ( uint32_t numThreads : m_settings.m_threadCounts )
+            {
+                if ( numThreads > 0 && numThreads <= numHardwareThreads && std::find( threadCounts.begin(), threadCounts.end(), numThreads ) == threadCounts.end() )
+                {
+                    threadCounts.push_back( numThreads );
+                }
+            }
+
+            if ( threadCounts.empty() )
+            {
+                threadCounts.push_back( 1 );
+            }
+        }
+
+        return threadCounts;
+    }
+
+    std::vector<Gemm::Backend> Autotuner::GetBackends() const
+    {
+        std::vector<Gemm::Backend> backends;
+        for ( Gemm::Backend backend : m_settings.m_backends )
+        {
+            if ( Gemm::IsBackendAvailable( backend ) && std::find( backends.begin(), backends.end(), backend ) == backends.end() )
+            {
+                backends.push_back( backend );
+            }
+        }
+
+        if ( backends.empty() )
+        {
+            backends.push_back( Gemm::Backend::MicroKernel );
+        }
+
+        return backends;
+    }
+
+    // The key holds everything the measurements depend on besides the candidate lists, i.e. "training|16x16x3|<cpu>|4 threads|reference,kernel"
+    std::string Autotuner::GetCacheKey( char const* pMode ) const
+    {
+        std::stringstream key;
+        key << pMode << "|" << m_numInputs << "x" << m_numHidden << "x" << m_numOutputs << "|" << GetCpuModel() << "|" << std::max( 1u, std::thread::hardware_concurrency() ) << " threads|";
+
+        std::vector<Gemm::Backend> const backends = GetBackends();
+        for ( size_t backendIdx = 0; backendIdx < backends.size(); backendIdx++ )
+        {
+            key << ( backendIdx > 0 ? "," : "" ) << Gemm::GetBackendName( backends[backendIdx] );
+        }
+
+        return key.str();
+    }
+
+    //-------------------------------------------------------------------------
+
+    // Each line of the cache file is the key followed by the values, separated by tabs
+    bool Autotuner::ReadCacheEntry( std::string const& key, std::vector<std::string>& values ) const
+    {
+        std::ifstream cacheFile( m_settings.m_cachePath );
+        std::string line;
+        while ( std::getline( cacheFile, line ) )
+        {
+            if ( !line.empty() && line.back() == '\r' )
+            {
+                line.pop_back();
+            }
+
+            size_t const keyEnd = line.find( '\t' );
+            if ( keyEnd == std::string::npos || line.compare( 0, keyEnd, key ) != 0 || keyEnd != key.size() )
+            {
+                continue;
+            }
+
+            values.clear();
+            std::stringstream valueStream( line.substr( keyEnd + 1 ) );
+            std::string value;
+            while ( std::getline( valueStream, value, '\t' ) )
+            {
+                values.push_back( value );
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool Autotuner::WriteCacheEntry( std::string const& key, std::vector<std::string> const& values ) const
+    {
+        std::vector<std::string> lines;
+        {
+            std::ifstream cacheFile( m_settings.m_cachePath );
+            std::string line;
+            while ( std::getline( cacheFile, line ) )
+            {
+                if ( !line.empty() && line.compare( 0, key.size() + 1, key + "\t" ) != 0 )
+                {
+                    lines.push_back( line );
+                }
+            }
+        }
+
+        std::stringstream entry;
+        entry << key;
+        for ( auto const& value : values )
+        {
+            entry << "\t" << value;
+        }
+        lines.push_back( entry.str() );
+
+        std::ofstream cacheFile( m_settings.m_cachePath, std::ios::out | std::ios::trunc );
+        for ( auto const& line : lines )
+        {
+            cacheFile << line << "\n";
+        }
+
+        if ( !cacheFile.good() )
+        {
+            std::cout << "Error Writing Autotune Cache: " << m_settings.m_cachePath << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+
+    Autotuner::TrainingConfig Autotuner::MeasureTraining( TrainingData const& data, uint32_t batchSize, uint32_t numThreads, Gemm::Backend backend ) const
+    {
+        ScopedGemmBackend const scopedBackend( backend );
+
+        Network network( Network::Settings{ m_numInputs, m_numHidden, m_numOutputs, m_settings.m_seed } );
+        NumaTrainer::Settings trainerSettings;
+        trainerSettings.m_batchSize = batchSize;
+        trainerSettings.m_numThreads = numThreads;
+        trainerSettings.m_maxEpochs = 1;
+        trainerSettings.m_desiredAccuracy = 101;
+        NumaTrainer trainer( trainerSettings, &network );
+
+        // The first epoch warms up the caches and the pack buffers
+        trainer.Train( data );
+
+        double totalTimeMS = 0;
+        uint64_t numSamples = 0;
+        while ( totalTimeMS < m_settings.m_measureTimeMS )
+        {
+            trainer.Train( data );
+            totalTimeMS += trainer.GetStats().m_totalTimeMS;
+            numSamples += data.m_trainingSet.size();
+        }
+
+        TrainingConfig config;
+        config.m_batchSize = batchSize;
+        config.m_numThreads = numThreads;
+        config.m_backend = backend;
+        config.m_samplesPerSecond = numSamples / ( totalTimeMS / 1000.0 );
+        return config;
+    }
+
+    // Every thread evaluates batches of the inputs back to back, the way the inference server workers do when saturated
+    Autotuner::InferenceConfig Autotuner::MeasureInference( std::vector<double> const& inputs, uint32_t batchRows, uint32_t numThreads, Gemm::Backend backend ) const
+    {
+        ScopedGemmBackend const scopedBackend( backend );
+
+        Network const network( Network::Settings{ m_numInputs, m_numHidden, m_numOutputs, m_settings.m_seed } );
+        uint32_t const numRows = (uint32_t) ( inputs.size() / m_numInputs );
+        assert( numRows >= batchRows );
+
+        std::vector<std::vector<double>> threadLatenciesUS( numThreads );
+        std::vector<uint64_t> threadNumRows( numThreads, 0 );
+
+        auto MeasureThread = [&] ( uint32_t threadIdx, Clock::time_point endTime )
+        {
+            std::vector<double> outputs( (size_t) batchRows * m_numOutputs );
+            std::vector<int32_t> clampedOutputs( (size_t) batchRows * m_numOutputs );
+            uint32_t rowStart = ( threadIdx * batchRows ) % ( numRows - batchRows + 1 );
+
+            do
+            {
+                auto const callStartTime = Clock::now();
+                network.EvaluateBatch( &inputs[(size_t) rowStart * m_numInputs], batchRows, outputs.data(), clampedOutputs.data() );
+                threadLatenciesUS[threadIdx].push_back( GetElapsedUS( callStartTime, Clock::now() ) );
+                threadNumRows[threadIdx] += batchRows;
+
+                rowStart += batchRows;
+                if ( rowStart + batchRows > numRows )
+                {
+                    rowStart = 0;
+                }
+            }
+            while ( Clock::now() < endTime );
+        };
+
+        // Warm up on the calling thread
+        MeasureThread( 0, Clock::now() + std::chrono::microseconds( (int64_t) ( m_settings.m_measureTimeMS * 100 ) ) );
+        threadLatenciesUS[0].clear();
+        threadNumRows[0] = 0;
+
+        auto const startTime = Clock::now();
+        auto const endTime = startTime + std::chrono::microseconds( (int64_t) ( m_settings.m_measureTimeMS * 1000 ) );
+        std::vector<std::thread> threads;
+        for ( uint32_t threadIdx = 1; threadIdx < numThreads; threadIdx++ )
+        {
+            threads.emplace_back( MeasureThread, threadIdx, endTime );
+        }
+        MeasureThread( 0, endTime );
+
+        for ( auto& thread : threads )
+        {
+            thread.join();
+        }
+        double const elapsedUS = GetElapsedUS( startTime, Clock::now() );
+
+        std::vector<double> latenciesUS;
+        uint64_t totalNumRows = 0;
+        for ( uint32_t threadIdx = 0; threadIdx < numThreads; threadIdx++ )
+        {
+            latenciesUS.insert( latenciesUS.end(), threadLatenciesUS[threadIdx].begin(), threadLatenciesUS[threadIdx].end() );
+            totalNumRows += threadNumRows[threadIdx];
+        }
+
+        size_t const p99Idx = std::min( latenciesUS.size() - 1, latenciesUS.size() * 99 / 100 );
+        std::nth_element( latenciesUS.begin(), latenciesUS.begin() + p99Idx, latenciesUS.end() );
+
+        InferenceConfig config;
+        config.m_batchRows = batchRows;
+        config.m_numThreads = numThreads;
+        config.m_backend = backend;
+        config.m_rowsPerSecond = totalNumRows / ( elapsedUS / 1000000.0 );
+        config.m_latencyP99US = latenciesUS[p99Idx];
+        return config;
+    }
+
+    //-------------------------------------------------------------------------
+
+    Autotuner::Result<Autotuner::TrainingConfig> Autotuner::TuneTraining()
+    {
+        Result<TrainingConfig> result;
+        std::string const key = GetCacheKey( "training" );
+
+        std::vector<std::string> values;
+        if ( !m_settings.m_forceRetune && ReadCacheEntry( key, values ) && values.size() == 4 )
+        {
+            TrainingConfig& config = result.m_best;
+            if ( ParseUInt32( values[0], config.m_batchSize ) && ParseUInt32( values[1], config.m_numThreads ) && ParseAvailableBackend( values[2], config.m_backend ) && ParseDouble( values[3], config.m_samplesPerSecond ) )
+            {
+                result.m_isFromCache = true;
+                return result;
+            }
+        }
+
+        // Synthetic training set, large enough for every worker to run several batches per epoch
+        //-------------------------------------------------------------------------
+
+        std::vector<uint32_t> const threadCounts = GetThreadCounts();
+        std::vector<Gemm::Backend> const backends = GetBackends();
+        uint32_t const maxBatchSize = m_settings.m_trainingBatchSizes.empty() ? 64 : *std::max_element( m_settings.m_trainingBatchSizes.begin(), m_settings.m_trainingBatchSizes.end() );
+        uint32_t const maxThreads = *std::max_element( threadCounts.begin(), threadCounts.end() );
+        size_t const maxRowsInMemory = std::max<size_t>( 1, ( 64u << 20 ) / ( m_numInputs * sizeof( double ) ) );
+        size_t const numRows = std::max<size_t>( (size_t) maxBatchSize * maxThreads, std::min<size_t>( std::max( 4096u, maxBatchSize * maxThreads * 4 ), maxRowsInMemory ) );
+
+        RandomStream random( m_settings.m_seed, 1 );
+        TrainingData data;
+        data.m_trainingSet.resize( numRows );
+        for ( auto& entry : data.m_trainingSet )
+        {
+            entry.m_inputs.resize( m_numInputs );
+            for ( auto& input : entry.m_inputs )
+            {
+                input = random.NextNormal( 0.0, 1.0 );
+            }
+
+            entry.m_expectedOutputs.resize( m_numOutputs );
+            for ( auto& expectedOutput : entry.m_expectedOutputs )
+            {
+                expectedOutput = (int32_t) random.NextUInt32( 2 );
+            }
+        }
+
+        // Measure every candidate
+        //-------------------------------------------------------------------------
+
+        for ( Gemm::Backend backend : backends )
+        {
+            for ( uint32_t numThreads : threadCounts )
+            {
+                for ( uint32_t batchSize : m_settings.m_trainingBatchSizes )
+                {
+                    if ( batchSize > 0 )
+                    {
+                        result.m_candidates.push_back( MeasureTraining( data, batchSize, numThreads, backend ) );
+                    }
+                }
+            }
+        }
+
+        if ( result.m_candidates.empty() )
+        {
+            result.m_candidates.push_back( MeasureTraining( data, result.m_best.m_batchSize, threadCounts[0], backends[0] ) );
+        }
+
+        result.m_best = *std::max_element( result.m_candidates.begin(), result.m_candidates.end(), [] ( TrainingConfig const& a, TrainingConfig const& b ) { return a.m_samplesPerSecond < b.m_samplesPerSecond; } );
+
+        WriteCacheEntry( key, { std::to_string( result.m_best.m_batchSize ), std::to_string( result.m_best.m_numThreads ), Gemm::GetBackendName( result.m_best.m_backend ), std::to_string( result.m_best.m_samplesPerSecond ) } );
+        return result;
+    }
+
+    Autotuner::Result<Autotuner::InferenceConfig> Autotuner::TuneInference()
+    {
+        Result<InferenceConfig> result;
+        std::stringstream keyStream;
+        keyStream << GetCacheKey( "inference" ) << "|p99<=" << m_settings.m_maxLatencyP99US << "us";
+        std::string const key = keyStream.str();
+
+        std::vector<std::string> values;
+        if ( !m_settings.m_forceRetune && ReadCacheEntry( key, values ) && values.size() == 5 )
+        {
+            InferenceConfig& config = result.m_best;
+            if ( ParseUInt32( values[0], config.m_batchRows ) && ParseUInt32( values[1], config.m_numThreads ) && ParseAvailableBackend( values[2], config.m_backend ) && ParseDouble( values[3], config.m_rowsPerSecond ) && ParseDouble( values[4], config.m_latencyP99US ) )
+            {
+                result.m_isFromCache = true;
+                return result;
+            }
+        }
+
+        // Synthetic inputs, each thread starts at a different batch
+        //-------------------------------------------------------------------------
+
+        std::vector<uint32_t> const threadCounts = GetThreadCounts();
+        std::vector<Gemm::Backend> const backends = GetBackends();
+        uint32_t const maxBatchRows = m_settings.m_inferenceBatchRows.empty() ? 64 : *std::max_element( m_settings.m_inferenceBatchRows.begin(), m_settings.m_inferenceBatchRows.end() );
+        size_t const maxRowsInMemory = std::max<size_t>( 1, ( 64u << 20 ) / ( m_numInputs * sizeof( double ) ) );
+        size_t const numRows = std::max<size_t>( maxBatchRows, std::min<size_t>( 4096, maxRowsInMemory ) );
+
+        RandomStream random( m_settings.m_seed, 1 );
+        std::vector<double> inputs( numRows * m_numInputs );
+        for ( auto& input : inputs )
+        {
+            input = random.NextNormal( 0.0, 1.0 );
+        }
+
+        // Measure every candidate, the fastest one within the latency budget wins or the lowest latency one if none are
+        //-------------------------------------------------------------------------
+
+        for ( Gemm::Backend backend : backends )
+        {
+            for ( uint32_t numThreads : threadCounts )
+            {
+                for ( uint32_t batchRows : m_settings.m_inferenceBatchRows )
+                {
+                    if ( batchRows > 0 )
+                    {
+                        result.m_candidates.push_back( MeasureInference( inputs, batchRows, numThreads, backend ) );
+                    }
+                }
+            }
+        }
+
+        if ( result.m_candidates.empty() )
+        {
+            result.m_candidates.push_back( MeasureInference( inputs, result.m_best.m_batchRows, threadCounts[0], backends[0] ) );
+        }
+
+        double const maxLatencyP99US = m_settings.m_maxLatencyP99US;
+        auto IsWithinBudget = [maxLatencyP99US] ( InferenceConfig const& config ) { return maxLatencyP99US <= 0 || config.m_latencyP99US <= maxLatencyP99US; };
+        auto const bestIter = std::max_element( result.m_candidates.begin(), result.m_candidates.end(), [&IsWithinBudget] ( InferenceConfig const& a, InferenceConfig const& b )
+        {
+            if ( IsWithinBudget( a ) != IsWithinBudget( b ) )
+            {
+                return !IsWithinBudget( a );
+            }
+
+            return IsWithinBudget( a ) ? a.m_rowsPerSecond < b.m_rowsPerSecond : a.m_latencyP99US > b.m_latencyP99US;
+        } );
+        result.m_best = *bestIter;
+
+        WriteCacheEntry( key, { std::to_string( result.m_best.m_batchRows ), std::to_string( result.m_best.m_numThreads ), Gemm::GetBackendName( result.m_best.m_backend ), std::to_string( result.m_best.m_rowsPerSecond ), std::to_string( result.m_best.m_latencyP99US ) } );
+        return result;
+    }
+
+    //-------------------------------------------------------------------------
+
+    void Autotuner::PrintResult( std::ostream& stream, Result<TrainingConfig> const& result )
+    {
+        if ( !result.m_candidates.empty() )
+        {
+            stream << std::endl << " Training Autotune Candidates: " << std::endl
+                   << "==========================================================" << std::endl
+                   << std::setw( 10 ) << "Backend" << std::setw( 10 ) << "Threads" << std::setw( 10 ) << "Batch" << std::setw( 16 ) << "Samples/s" << std::endl
+                   << "==========================================================" << std::endl;
+
+            for ( auto const& candidate : result.m_candidates )
+            {
+                stream << std::setw( 10 ) << Gemm::GetBackendName( candidate.m_backend ) << std::setw( 10 ) << candidate.m_numThreads << std::setw( 10 ) << candidate.m_batchSize << std::setw( 16 ) << (uint64_t) candidate.m_samplesPerSecond << std::endl;
+            }
+
+            stream << std::endl;
+        }
+
+        stream << "Autotuned training" << ( result.m_isFromCache ? " (cached)" : "" ) << " - backend: " << Gemm::GetBackendName( result.m_best.m_backend ) << ", threads: " << result.m_best.m_numThreads
+               << ", batch size: " << result.m_best.m_batchSize << ", samples/s: " << (uint64_t) result.m_best.m_samplesPerSecond << std::endl;
+    }
+
+    void Autotuner::PrintResult( std::ostream& stream, Result<InferenceConfig> const& result )
+    {
+        if ( !result.m_candidates.empty() )
+        {
+            std::streamsize const precision = stream.precision();
+            stream << std::endl << " Inference Autotune Candidates: " << std::endl
+                   << "==========================================================" << std::endl
+                   << std::setw( 10 ) << "Backend" << std::setw( 10 ) << "Threads" << std::setw( 10 ) << "Rows" << std::setw( 16 ) << "Rows/s" << std::setw( 12 ) << "p99 (us)" << std::endl
+                   << "==========================================================" << std::endl;
+
+            for ( auto const& candidate : result.m_candidates )
+            {
+                stream << std::setw( 10 ) << Gemm::GetBackendName( candidate.m_backend ) << std::setw( 10 ) << candidate.m_numThreads << std::setw( 10 ) << candidate.m_batchRows << std::setw( 16 ) << (uint64_t) candidate.m_rowsPerSecond
+                       << std::setw( 12 ) << std::fixed << std::setprecision( 1 ) << candidate.m_latencyP99US << std::defaultfloat << std::setprecision( precision ) << std::endl;
+            }
+
+            stream << std::endl;
+        }
+
+        stream << "Autotuned inference" << ( result.m_isFromCache ? " (cached)" : "" ) << " - backend: " << Gemm::GetBackendName( result.m_best.m_backend ) << ", threads: " << result.m_best.m_numThreads
+               << ", batch rows: " << result.m_best.m_batchRows << ", rows/s: " << (uint64_t) result.m_best.m_rowsPerSecond << ", p99 latency us: " << result.m_best.m_latencyP99US << std::endl;
+    }
+}
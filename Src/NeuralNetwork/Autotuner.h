@@ -0,0 +1,106 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Startup autotuner for the execution settings of a network shape
+//
+// Micro-benchmarks candidate configurations on synthetic data with the network shape being trained or
+// served: the data parallel batch size, thread count and GEMM backend for training (by samples per
+// second), and the batch rows, thread count and GEMM backend for inference (by rows per second, within an
+// optional p99 call latency budget). The chosen configurations are cached in a text file keyed by the
+// shape, the cpu model, the hardware thread count and the available backends, so later runs on the same
+// machine skip the measurements. Only speed is measured, the batch size candidates should be limited to
+// values that converge well for the model.
+
+#pragma once
+
+#include "Gemm.h"
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class Autotuner
+    {
+    public:
+
+        struct Settings
+        {
+            std::string                     m_cachePath = "NeuralNetwork.autotune";
+            bool                            m_forceRetune = false;      // Measure even if the cache has an entry, the entry is replaced
+
+            // Candidates, the thread counts are limited to the hardware concurrency and only the available backends are measured
+            std::vector<uint32_t>           m_trainingBatchSizes = { 16, 32, 64, 128, 256 };
+            std::vector<uint32_t>           m_inferenceBatchRows = { 1, 8, 16, 32, 64, 128, 256 };
+            std::vector<uint32_t>           m_threadCounts;             // Empty uses the powers of two up to the hardware concurrency, and the hardware concurrency
+            std::vector<Gemm::Backend>      m_backends = { Gemm::Backend::Reference, Gemm::Backend::MicroKernel, Gemm::Backend::Blas };
+
+            double                          m_maxLatencyP99US = 0;      // Inference calls must stay within this p99 latency, 0 for no limit
+            double                          m_measureTimeMS = 100;      // Measurement time per candidate, after a warm up run
+            uint32_t                        m_seed = 0;                 // Synthetic weights and data
+        };
+
+        struct TrainingConfig
+        {
+            uint32_t                        m_batchSize = 64;
+            uint32_t                        m_numThreads = 1;
+            Gemm::Backend                   m_backend = Gemm::Backend::MicroKernel;
+            double                          m_samplesPerSecond = 0;
+        };
+
+        struct InferenceConfig
+        {
+            uint32_t                        m_batchRows = 64;
+            uint32_t                        m_numThreads = 1;
+            Gemm::Backend                   m_backend = Gemm::Backend::MicroKernel;
+            double                          m_rowsPerSecond = 0;
+            double                          m_latencyP99US = 0;         // Per EvaluateBatch call
+        };
+
+        template<typename Config>
+        struct Result
+        {
+            Config                          m_best;
+            bool                            m_isFromCache = false;
+            std::vector<Config>             m_candidates;               // Every measured candidate, empty if the result is from the cache
+        };
+
+    public:
+
+        Autotuner( Settings const& settings, uint32_t numInputs, uint32_t numHidden, uint32_t numOutputs );
+
+        // Returns the cached configuration for this shape and machine, or measures the candidates and caches the fastest
+        Result<TrainingConfig> TuneTraining();
+        Result<InferenceConfig> TuneInference();
+
+        // Processor brand string, "unknown" if it can't be queried
+        static std::string GetCpuModel();
+
+        static void PrintResult( std::ostream& stream, Result<TrainingConfig> const& result );
+        static void PrintResult( std::ostream& stream, Result<InferenceConfig> const& result );
+
+    private:
+
+        std::string GetCacheKey( char const* pMode ) const;
+        bool ReadCacheEntry( std::string const& key, std::vector<std::string>& values ) const;
+        bool WriteCacheEntry( std::string const& key, std::vector<std::string> const& values ) const;
+
+        std::vector<uint32_t> GetThreadCounts() const;
+        std::vector<Gemm::Backend> GetBackends() const;
+
+        TrainingConfig MeasureTraining( TrainingData const& data, uint32_t batchSize, uint32_t numThreads, Gemm::Backend backend ) const;
+        InferenceConfig MeasureInference( std::vector<double> const& inputs, uint32_t batchRows, uint32_t numThreads, Gemm::Backend backend ) const;
+
+    private:
+
+        Settings                            m_settings;
+        uint32_t                            m_numInputs;
+        uint32_t                            m_numHidden;
+        uint32_t                            m_numOutputs;
+    };
+}
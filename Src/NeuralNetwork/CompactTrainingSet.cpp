@@ -0,0 +1,174 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "CompactTrainingSet.h"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    char const* GetFeatureStorageName( FeatureStorage storage )
+    {
+        switch ( storage )
+        {
+            case FeatureStorage::UInt8: return "uint8";
+            case FeatureStorage::UInt16: return "uint16";
+            case FeatureStorage::Double: return "double";
+        }
+
+        return "unknown";
+    }
+
+    //-------------------------------------------------------------------------
+
+    CompactTrainingSet::CompactTrainingSet( TrainingSet const& entries )
+        : m_numEntries( entries.size() )
+    {
+        if ( entries.empty() )
+        {
+            return;
+        }
+
+        m_numInputs = (uint32_t) entries[0].m_inputs.size();
+        m_numOutputs = (uint32_t) entries[0].m_expectedOutputs.size();
+
+        // Detect the value ranges
+        //-------------------------------------------------------------------------
+
+        double maxInput = 0;
+        bool areInputsIntegers = true;
+        bool areOutputsBits = true;
+        for ( auto const& entry : entries )
+        {
+            assert( entry.m_inputs.size() == m_numInputs && entry.m_expectedOutputs.size() == m_numOutputs );
+            assert( entry.m_weight == 1 ); // Compact sets don't store weights, build them from uncollapsed sets only
+
+            for ( double const input : entry.m_inputs )
+            {
+                areInputsIntegers = areInputsIntegers && input >= 0.0 && input == floor( input );
+                maxInput = std::max( maxInput, input );
+            }
+
+            for ( int32_t const expectedOutput : entry.m_expectedOutputs )
+            {
+                areOutputsBits = areOutputsBits && ( expectedOutput == 0 || expectedOutput == 1 );
+            }
+        }
+
+        if ( areInputsIntegers && maxInput <= 255.0 )
+        {
+            m_featureStorage = FeatureStorage::UInt8;
+        }
+        else if ( areInputsIntegers && maxInput <= 65535.0 )
+        {
+            m_featureStorage = FeatureStorage::UInt16;
+        }
+        else
+        {
+            m_featureStorage = FeatureStorage::Double;
+        }
+
+        // Pack the entries
+        //-------------------------------------------------------------------------
+
+        size_t const numInputValues = m_numEntries * m_numInputs;
+        switch ( m_featureStorage )
+        {
+            case FeatureStorage::UInt8: m_uint8Inputs.resize( numInputValues ); break;
+            case FeatureStorage::UInt16: m_uint16Inputs.resize( numInputValues ); break;
+            case FeatureStorage::Double: m_doubleInputs.resize( numInputValues ); break;
+        }
+
+        size_t const numOutputValues = m_numEntries * m_numOutputs;
+        if ( areOutputsBits )
+        {
+            m_expectedOutputBits.resize( ( numOutputValues + 63 ) / 64, 0 );
+        }
+        else
+        {
+            m_expectedOutputs.resize( numOutputValues );
+        }
+
+        for ( size_t entryIdx = 0; entryIdx < m_numEntries; entryIdx++ )
+        {
+            TrainingEntry const& entry = entries[entryIdx];
+            for ( uint32_t inputIdx = 0; inputIdx < m_numInputs; inputIdx++ )
+            {
+                size_t const valueIdx = entryIdx * m_numInputs + inputIdx;
+                switch ( m_featureStorage )
+                {
+                    case FeatureStorage::UInt8: m_uint8Inputs[valueIdx] = (uint8_t) entry.m_inputs[inputIdx]; break;
+                    case FeatureStorage::UInt16: m_uint16Inputs[valueIdx] = (uint16_t) entry.m_inputs[inputIdx]; break;
+                    case FeatureStorage::Double: m_doubleInputs[valueIdx] = entry.m_inputs[inputIdx]; break;
+                }
+            }
+
+            for ( uint32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+            {
+                size_t const valueIdx = entryIdx * m_numOutputs + outputIdx;
+                if ( areOutputsBits )
+                {
+                    m_expectedOutputBits[valueIdx >> 6] |= (uint64_t) entry.m_expectedOutputs[outputIdx] << ( valueIdx & 63 );
+                }
+                else
+                {
+                    m_expectedOutputs[valueIdx] = entry.m_expectedOutputs[outputIdx];
+                }
+            }
+        }
+    }
+
+    void CompactTrainingSet::GetInputs( size_t entryIdx, double* pInputs ) const
+    {
+        assert( entryIdx < m_numEntries );
+
+        for ( uint32_t inputIdx = 0; inputIdx < m_numInputs; inputIdx++ )
+        {
+            size_t const valueIdx = entryIdx * m_numInputs + inputIdx;
+            switch ( m_featureStorage )
+            {
+                case FeatureStorage::UInt8: pInputs[inputIdx] = (double) m_uint8Inputs[valueIdx]; break;
+                case FeatureStorage::UInt16: pInputs[inputIdx] = (double) m_uint16Inputs[valueIdx]; break;
+                case FeatureStorage::Double: pInputs[inputIdx] = m_doubleInputs[valueIdx]; break;
+            }
+        }
+    }
+
+    void CompactTrainingSet::GetExpectedOutputs( size_t entryIdx, int32_t* pExpectedOutputs ) const
+    {
+        assert( entryIdx < m_numEntries );
+
+        for ( uint32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+        {
+            pExpectedOutputs[outputIdx] = GetExpectedOutput( entryIdx, outputIdx );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    size_t CompactTrainingSet::GetMemoryUsage() const
+    {
+        return m_uint8Inputs.capacity() * sizeof( uint8_t ) + m_uint16Inputs.capacity() * sizeof( uint16_t ) + m_doubleInputs.capacity() * sizeof( double )
+             + m_expectedOutputBits.capacity() * sizeof( uint64_t ) + m_expectedOutputs.capacity() * sizeof( int32_t );
+    }
+
+    size_t CompactTrainingSet::GetEntriesMemoryUsage() const
+    {
+        return m_numEntries * ( sizeof( TrainingEntry ) + m_numInputs * sizeof( double ) + m_numOutputs * sizeof( int32_t ) );
+    }
+
+    void CompactTrainingSet::PrintStats( std::ostream& stream, CompactTrainingSet const& compactSet )
+    {
+        size_t const compactMemoryUsage = compactSet.GetMemoryUsage();
+        size_t const entriesMemoryUsage = compactSet.GetEntriesMemoryUsage();
+        stream << "Compact training set: " << compactSet.GetNumEntries() << " entries, " << GetFeatureStorageName( compactSet.GetFeatureStorage() ) << " features, " << ( compactSet.HasBitLabels() ? "bit" : "int32" ) << " labels - "
+               << compactMemoryUsage / 1024.0 << " KB vs " << entriesMemoryUsage / 1024.0 << " KB (" << ( compactMemoryUsage > 0 ? (double) entriesMemoryUsage / compactMemoryUsage : 0.0 ) << "x smaller)" << std::endl;
+    }
+}
@@ -0,0 +1,97 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Compact storage for training sets with small integer features
+//
+// A TrainingEntry keeps its inputs as doubles and its expected outputs as int32s, each in its own heap
+// allocation. When every input of a set is an integer in [0, 255] (or [0, 65535]) the compact set stores
+// the inputs as one contiguous array of uint8s (uint16s), and 0/1 expected outputs as packed bits. The
+// inputs are widened back to doubles as they are loaded into the network, so training on a compact set
+// gives the same results as training on the original entries while streaming a fraction of the memory
+// through the cache every epoch. Sets with other values fall back to contiguous doubles and int32s.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    enum class FeatureStorage : uint8_t
+    {
+        UInt8,
+        UInt16,
+        Double,
+    };
+
+    char const* GetFeatureStorageName( FeatureStorage storage );
+
+    //-------------------------------------------------------------------------
+
+    class CompactTrainingSet
+    {
+    public:
+
+        CompactTrainingSet() = default;
+
+        // Picks the narrowest storage that holds every value of the entries exactly
+        explicit CompactTrainingSet( TrainingSet const& entries );
+
+        inline size_t GetNumEntries() const { return m_numEntries; }
+        inline uint32_t GetNumInputs() const { return m_numInputs; }
+        inline uint32_t GetNumOutputs() const { return m_numOutputs; }
+        inline FeatureStorage GetFeatureStorage() const { return m_featureStorage; }
+        inline bool HasBitLabels() const { return m_expectedOutputs.empty(); }
+
+        // Inputs of an entry, only valid for the set's feature storage
+        inline uint8_t const* GetUInt8Inputs( size_t entryIdx ) const { return &m_uint8Inputs[entryIdx * m_numInputs]; }
+        inline uint16_t const* GetUInt16Inputs( size_t entryIdx ) const { return &m_uint16Inputs[entryIdx * m_numInputs]; }
+        inline double const* GetDoubleInputs( size_t entryIdx ) const { return &m_doubleInputs[entryIdx * m_numInputs]; }
+
+        // Widens the inputs of an entry to doubles
+        void GetInputs( size_t entryIdx, double* pInputs ) const;
+
+        inline int32_t GetExpectedOutput( size_t entryIdx, uint32_t outputIdx ) const
+        {
+            size_t const valueIdx = entryIdx * m_numOutputs + outputIdx;
+            return HasBitLabels() ? (int32_t) ( ( m_expectedOutputBits[valueIdx >> 6] >> ( valueIdx & 63 ) ) & 1 ) : m_expectedOutputs[valueIdx];
+        }
+
+        void GetExpectedOutputs( size_t entryIdx, int32_t* pExpectedOutputs ) const;
+
+        // Heap bytes used by the compact set and by the equivalent training entries
+        size_t GetMemoryUsage() const;
+        size_t GetEntriesMemoryUsage() const;
+
+        static void PrintStats( std::ostream& stream, CompactTrainingSet const& compactSet );
+
+    private:
+
+        size_t                              m_numEntries = 0;
+        uint32_t                            m_numInputs = 0;
+        uint32_t                            m_numOutputs = 0;
+        FeatureStorage                      m_featureStorage = FeatureStorage::Double;
+
+        // Row major inputs, only the array matching the feature storage is used
+        std::vector<uint8_t>                m_uint8Inputs;
+        std::vector<uint16_t>               m_uint16Inputs;
+        std::vector<double>                 m_doubleInputs;
+
+        // Either one bit per expected output or the values themselves if they aren't all 0 or 1
+        std::vector<uint64_t>               m_expectedOutputBits;
+        std::vector<int32_t>                m_expectedOutputs;
+    };
+
+    //-------------------------------------------------------------------------
+
+    struct CompactTrainingData
+    {
+        CompactTrainingSet m_trainingSet;
+        CompactTrainingSet m_generalizationSet;
+        CompactTrainingSet m_validationSet;
+    };
+}
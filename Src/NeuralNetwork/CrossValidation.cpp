@@ -0,0 +1,174 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "CrossValidation.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    CrossValidation::CrossValidation( Settings const& settings, TrainingSet const& entries )
+        : m_settings( settings )
+        , m_entries( entries )
+    {
+        // A validation fold, a generalization fold and at least one training fold
+        assert( m_settings.m_numFolds >= 3 );
+        assert( m_entries.size() >= m_settings.m_numFolds );
+    }
+
+    void CrossValidation::GetFoldIndices( uint32_t foldIdx, std::vector<uint32_t>& indices ) const
+    {
+        size_t const numEntries = m_entries.size();
+        uint32_t const foldStart = (uint32_t) ( numEntries * foldIdx / m_settings.m_numFolds );
+        uint32_t const foldEnd = (uint32_t) ( numEntries * ( foldIdx + 1 ) / m_settings.m_numFolds );
+        for ( uint32_t entryIdx = foldStart; entryIdx < foldEnd; entryIdx++ )
+        {
+            indices.push_back( entryIdx );
+        }
+    }
+
+    void CrossValidation::TrainFold( uint32_t foldIdx, Network::Settings const& networkSettings, NetworkTrainer::Settings const& trainerSettings, FoldResult& result ) const
+    {
+        auto const startTime = std::chrono::steady_clock::now();
+
+        // Create the fold views
+        //-------------------------------------------------------------------------
+
+        uint32_t const generalizationFoldIdx = ( foldIdx + 1 ) % m_settings.m_numFolds;
+
+        std::vector<uint32_t> trainingIndices;
+        std::vector<uint32_t> generalizationIndices;
+        std::vector<uint32_t> validationIndices;
+        for ( uint32_t otherFoldIdx = 0; otherFoldIdx < m_settings.m_numFolds; otherFoldIdx++ )
+        {
+            if ( otherFoldIdx != foldIdx && otherFoldIdx != generalizationFoldIdx )
+            {
+                GetFoldIndices( otherFoldIdx, trainingIndices );
+            }
+        }
+        GetFoldIndices( generalizationFoldIdx, generalizationIndices );
+        GetFoldIndices( foldIdx, validationIndices );
+
+        // Normalize a copy of the entries with the statistics of the training entries, the other folds must not leak into them
+        //-------------------------------------------------------------------------
+
+        TrainingSet normalizedEntries;
+        if ( m_settings.m_normalization != NormalizationType::None )
+        {
+            TrainingSet trainingEntries;
+            trainingEntries.reserve( trainingIndices.size() );
+            for ( uint32_t entryIdx : trainingIndices )
+            {
+                trainingEntries.push_back( m_entries[entryIdx] );
+            }
+
+            // The folds already run in parallel
+            FeatureNormalizer const normalizer = FeatureNormalizer::Compute( m_settings.m_normalization, trainingEntries, 1 );
+            trainingEntries = TrainingSet();
+            normalizedEntries = m_entries;
+            normalizer.Apply( normalizedEntries, 1 );
+        }
+
+        TrainingSet const& entries = ( m_settings.m_normalization != NormalizationType::None ) ? normalizedEntries : m_entries;
+
+        // Train with the same stopping conditions as the trainer
+        //-------------------------------------------------------------------------
+
+        Network network( networkSettings );
+        NetworkTrainer::Settings foldTrainerSettings = trainerSettings;
+        foldTrainerSettings.m_pTelemetrySink = nullptr;
+        NetworkTrainer trainer( foldTrainerSettings, &network );
+
+        uint32_t epoch = 0;
+        double generalizationSetAccuracy = 0;
+        double generalizationSetMSE = 0;
+        std::vector<uint32_t> epochOrder = trainingIndices;
+        while ( ( trainer.GetTrainingSetAccuracy() < trainerSettings.m_desiredAccuracy || generalizationSetAccuracy < trainerSettings.m_desiredAccuracy ) && epoch < trainerSettings.m_maxEpochs )
+        {
+            // Same epoch shuffles as the trainer
+            if ( trainerSettings.m_shuffleEachEpoch )
+            {
+                epochOrder = trainingIndices;
+                RandomStream( trainerSettings.m_seed, epoch ).Shuffle( epochOrder );
+            }
+
+            trainer.BeginEpoch();
+            trainer.TrainEntries( entries, epochOrder.data(), epochOrder.size() );
+            trainer.EndEpoch();
+            trainer.GetSetAccuracyAndMSE( entries, generalizationIndices, generalizationSetAccuracy, generalizationSetMSE );
+            epoch++;
+        }
+
+        trainer.GetSetAccuracyAndMSE( entries, validationIndices, result.m_validationSetAccuracy, result.m_validationSetMSE );
+
+        result.m_foldIdx = foldIdx;
+        result.m_numTrainingEntries = (uint32_t) trainingIndices.size();
+        result.m_numValidationEntries = (uint32_t) validationIndices.size();
+        result.m_numEpochs = epoch;
+        result.m_trainingTimeMS = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startTime ).count();
+    }
+
+    CrossValidation::Results CrossValidation::Run( Network::Settings const& networkSettings, NetworkTrainer::Settings const& trainerSettings ) const
+    {
+        auto const startTime = std::chrono::steady_clock::now();
+
+        Results results;
+        results.m_folds.resize( m_settings.m_numFolds );
+
+        // No point in having more threads than folds
+        uint32_t const numThreads = ( m_settings.m_numThreads == 0 ) ? std::thread::hardware_concurrency() : m_settings.m_numThreads;
+        ThreadPool threadPool( std::max( 1u, std::min( numThreads, m_settings.m_numFolds ) ) );
+        threadPool.ParallelFor( m_settings.m_numFolds, [&] ( uint32_t foldIdx ) { TrainFold( foldIdx, networkSettings, trainerSettings, results.m_folds[foldIdx] ); } );
+
+        // Summary statistics
+        //-------------------------------------------------------------------------
+
+        double const numFolds = m_settings.m_numFolds;
+        for ( auto const& fold : results.m_folds )
+        {
+            results.m_meanValidationSetAccuracy += fold.m_validationSetAccuracy / numFolds;
+            results.m_meanValidationSetMSE += fold.m_validationSetMSE / numFolds;
+        }
+
+        for ( auto const& fold : results.m_folds )
+        {
+            results.m_validationSetAccuracyVariance += pow( fold.m_validationSetAccuracy - results.m_meanValidationSetAccuracy, 2 ) / numFolds;
+            results.m_validationSetMSEVariance += pow( fold.m_validationSetMSE - results.m_meanValidationSetMSE, 2 ) / numFolds;
+        }
+
+        results.m_totalTimeMS = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startTime ).count();
+        return results;
+    }
+
+    void CrossValidation::PrintResults( std::ostream& stream, Results const& results )
+    {
+        stream << std::endl << " Cross-Validation Results (" << results.m_folds.size() << " folds): " << std::endl
+               << "==========================================================================" << std::endl
+               << std::setw( 6 ) << "Fold" << std::setw( 10 ) << "Train" << std::setw( 10 ) << "Val" << std::setw( 8 ) << "Epochs"
+               << std::setw( 12 ) << "Val Acc" << std::setw( 14 ) << "Val MSE" << std::setw( 12 ) << "Time (ms)" << std::endl
+               << "==========================================================================" << std::endl;
+
+        for ( auto const& fold : results.m_folds )
+        {
+            stream << std::setw( 6 ) << fold.m_foldIdx << std::setw( 10 ) << fold.m_numTrainingEntries << std::setw( 10 ) << fold.m_numValidationEntries << std::setw( 8 ) << fold.m_numEpochs
+                   << std::setw( 12 ) << fold.m_validationSetAccuracy << std::setw( 14 ) << fold.m_validationSetMSE << std::setw( 12 ) << (uint64_t) fold.m_trainingTimeMS << std::endl;
+        }
+
+        stream << "==========================================================================" << std::endl
+               << " Validation Set Accuracy: " << results.m_meanValidationSetAccuracy << " (variance: " << results.m_validationSetAccuracyVariance << ")" << std::endl
+               << " Validation Set MSE: " << results.m_meanValidationSetMSE << " (variance: " << results.m_validationSetMSEVariance << ")" << std::endl
+               << " Total Time: " << (uint64_t) results.m_totalTimeMS << "ms" << std::endl << std::endl;
+    }
+}
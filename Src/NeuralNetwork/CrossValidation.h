@@ -0,0 +1,77 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// K-fold cross-validation
+//
+// Splits a shared, read-only set of entries into K folds. Each fold is held out in turn as the
+// validation set, the following fold is used as the generalization set for the stopping conditions
+// and the remaining folds are trained on. Folds are index views into the shared entries so memory
+// use doesn't grow with K, and the folds are trained concurrently. With normalization the statistics
+// come from each fold's training entries only, and each fold trains on its own normalized copy.
+
+#pragma once
+
+#include "FeatureNormalizer.h"
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class CrossValidation
+    {
+    public:
+
+        struct Settings
+        {
+            uint32_t                    m_numFolds = 5;
+            NormalizationType           m_normalization = NormalizationType::None;     // The entries must not be normalized already
+            uint32_t                    m_numThreads = 0;               // 0 uses the hardware concurrency
+        };
+
+        struct FoldResult
+        {
+            uint32_t                    m_foldIdx = 0;
+            uint32_t                    m_numTrainingEntries = 0;
+            uint32_t                    m_numValidationEntries = 0;
+            uint32_t                    m_numEpochs = 0;
+            double                      m_trainingTimeMS = 0;
+            double                      m_validationSetAccuracy = 0;
+            double                      m_validationSetMSE = 0;
+        };
+
+        struct Results
+        {
+            std::vector<FoldResult>     m_folds;
+            double                      m_meanValidationSetAccuracy = 0;
+            double                      m_validationSetAccuracyVariance = 0;
+            double                      m_meanValidationSetMSE = 0;
+            double                      m_validationSetMSEVariance = 0;
+            double                      m_totalTimeMS = 0;
+        };
+
+    public:
+
+        // The entries must outlive the cross-validation and are expected to be shuffled
+        CrossValidation( Settings const& settings, TrainingSet const& entries );
+
+        Results Run( Network::Settings const& networkSettings, NetworkTrainer::Settings const& trainerSettings ) const;
+
+        static void PrintResults( std::ostream& stream, Results const& results );
+
+    private:
+
+        void TrainFold( uint32_t foldIdx, Network::Settings const& networkSettings, NetworkTrainer::Settings const& trainerSettings, FoldResult& result ) const;
+
+        // Appends the indices of the entries in the fold
+        void GetFoldIndices( uint32_t foldIdx, std::vector<uint32_t>& indices ) const;
+
+    private:
+
+        Settings                        m_settings;
+        TrainingSet const&              m_entries;
+    };
+}
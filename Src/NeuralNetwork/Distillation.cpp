@@ -0,0 +1,154 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "Distillation.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Rows per EvaluateBatch call
+        constexpr uint32_t g_batchSize = 256;
+
+        void GetInputs( TrainingSet const& entries, std::vector<double>& inputs )
+        {
+            inputs.clear();
+            inputs.reserve( entries.size() * ( entries.empty() ? 0 : entries[0].m_inputs.size() ) );
+            for ( auto const& entry : entries )
+            {
+                inputs.insert( inputs.end(), entry.m_inputs.begin(), entry.m_inputs.end() );
+            }
+        }
+
+        double GetAccuracy( TrainingSet const& entries, std::vector<int32_t> const& clampedOutputs, uint32_t numOutputs )
+        {
+            double numIncorrectResults = 0;
+            for ( size_t entryIdx = 0; entryIdx < entries.size(); entryIdx++ )
+            {
+                if ( !std::equal( entries[entryIdx].m_expectedOutputs.begin(), entries[entryIdx].m_expectedOutputs.end(), &clampedOutputs[entryIdx * numOutputs] ) )
+                {
+                    numIncorrectResults++;
+                }
+            }
+
+            return 100.0 - ( numIncorrectResults / entries.size() * 100.0 );
+        }
+
+        double GetRowsPerSecond( Network const& network, std::vector<double> const& inputs, uint32_t numEntries, uint32_t numTimingPasses )
+        {
+            uint32_t const numInputs = network.GetNumInputs();
+            std::vector<double> outputs( (size_t) g_batchSize * network.GetNumOutputs() );
+            std::vector<int32_t> clampedOutputs( outputs.size() );
+
+            auto const startTime = std::chrono::steady_clock::now();
+            for ( uint32_t passIdx = 0; passIdx < numTimingPasses; passIdx++ )
+            {
+                for ( uint32_t batchStart = 0; batchStart < numEntries; batchStart += g_batchSize )
+                {
+                    network.EvaluateBatch( &inputs[(size_t) batchStart * numInputs], std::min( g_batchSize, numEntries - batchStart ), outputs.data(), clampedOutputs.data() );
+                }
+            }
+            double const elapsedSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+
+            return ( elapsedSeconds > 0 ) ? (double) numEntries * numTimingPasses / elapsedSeconds : 0.0;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    void Distiller::GetTeacherOutputs( Network const& teacher, TrainingSet const& entries, std::vector<double>& teacherOutputs )
+    {
+        uint32_t const numEntries = (uint32_t) entries.size();
+        uint32_t const numInputs = teacher.GetNumInputs();
+        uint32_t const numOutputs = teacher.GetNumOutputs();
+
+        std::vector<double> inputs;
+        GetInputs( entries, inputs );
+        assert( inputs.size() == (size_t) numEntries * numInputs );
+
+        teacherOutputs.resize( (size_t) numEntries * numOutputs );
+        std::vector<int32_t> clampedOutputs( teacherOutputs.size() );
+        for ( uint32_t batchStart = 0; batchStart < numEntries; batchStart += g_batchSize )
+        {
+            teacher.EvaluateBatch( &inputs[(size_t) batchStart * numInputs], std::min( g_batchSize, numEntries - batchStart ), &teacherOutputs[(size_t) batchStart * numOutputs], &clampedOutputs[(size_t) batchStart * numOutputs] );
+        }
+    }
+
+    Distiller::Report Distiller::CompareWithTeacher( Network const& teacher, Network const& student, TrainingSet const& evaluationSet, uint32_t numTimingPasses )
+    {
+        assert( teacher.GetNumInputs() == student.GetNumInputs() && teacher.GetNumOutputs() == student.GetNumOutputs() );
+        assert( !evaluationSet.empty() );
+
+        Report report;
+        report.m_teacherNumHidden = teacher.GetNumHidden();
+        report.m_studentNumHidden = student.GetNumHidden();
+
+        // Agreement and accuracy
+        //-------------------------------------------------------------------------
+
+        uint32_t const numEntries = (uint32_t) evaluationSet.size();
+        uint32_t const numOutputs = teacher.GetNumOutputs();
+
+        std::vector<double> inputs;
+        GetInputs( evaluationSet, inputs );
+
+        std::vector<double> teacherOutputs( (size_t) numEntries * numOutputs );
+        std::vector<int32_t> teacherClampedOutputs( teacherOutputs.size() );
+        teacher.EvaluateBatch( inputs.data(), numEntries, teacherOutputs.data(), teacherClampedOutputs.data() );
+
+        std::vector<double> studentOutputs( teacherOutputs.size() );
+        std::vector<int32_t> studentClampedOutputs( teacherOutputs.size() );
+        student.EvaluateBatch( inputs.data(), numEntries, studentOutputs.data(), studentClampedOutputs.data() );
+
+        double numAgreeingEntries = 0;
+        double sumSquaredDifference = 0;
+        for ( size_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            bool isAgreeing = true;
+            for ( uint32_t outputIdx = 0; outputIdx < numOutputs; outputIdx++ )
+            {
+                size_t const valueIdx = entryIdx * numOutputs + outputIdx;
+                isAgreeing = isAgreeing && studentClampedOutputs[valueIdx] == teacherClampedOutputs[valueIdx];
+                sumSquaredDifference += pow( studentOutputs[valueIdx] - teacherOutputs[valueIdx], 2 );
+            }
+
+            numAgreeingEntries += isAgreeing ? 1 : 0;
+        }
+
+        report.m_agreement = numAgreeingEntries / numEntries * 100.0;
+        report.m_outputMSE = sumSquaredDifference / ( (size_t) numEntries * numOutputs );
+        report.m_teacherAccuracy = GetAccuracy( evaluationSet, teacherClampedOutputs, numOutputs );
+        report.m_studentAccuracy = GetAccuracy( evaluationSet, studentClampedOutputs, numOutputs );
+
+        // Inference throughput
+        //-------------------------------------------------------------------------
+
+        report.m_teacherRowsPerSecond = GetRowsPerSecond( teacher, inputs, numEntries, numTimingPasses );
+        report.m_studentRowsPerSecond = GetRowsPerSecond( student, inputs, numEntries, numTimingPasses );
+
+        return report;
+    }
+
+    void Distiller::PrintReport( std::ostream& stream, Report const& report )
+    {
+        double const speedup = ( report.m_teacherRowsPerSecond > 0 ) ? report.m_studentRowsPerSecond / report.m_teacherRowsPerSecond : 0.0;
+
+        stream << std::endl << " Distillation Report: " << std::endl
+               << "==========================================================================" << std::endl
+               << " Hidden Neurons - Teacher: " << report.m_teacherNumHidden << ", Student: " << report.m_studentNumHidden << std::endl
+               << " Student/Teacher Agreement: " << report.m_agreement << "% (output MSE: " << report.m_outputMSE << ")" << std::endl
+               << " Accuracy - Teacher: " << report.m_teacherAccuracy << "%, Student: " << report.m_studentAccuracy << "% (delta: " << report.m_studentAccuracy - report.m_teacherAccuracy << ")" << std::endl
+               << " Rows/s - Teacher: " << report.m_teacherRowsPerSecond << ", Student: " << report.m_studentRowsPerSecond << " (" << speedup << "x)" << std::endl
+               << "==========================================================================" << std::endl << std::endl;
+    }
+}
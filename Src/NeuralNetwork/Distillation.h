@@ -0,0 +1,51 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Knowledge distillation from a large teacher network into a small student
+//
+// The teacher's raw sigmoid outputs for the training set are computed once with a batched evaluation and
+// kept next to the set. NetworkTrainer::Distill then trains the student towards these soft targets rather
+// than the 0/1 expected outputs, which carry more information per entry (how close to the decision
+// boundary the teacher thinks an entry is). The report compares the clamped outputs of the two networks
+// and times their batched inference.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class Distiller
+    {
+    public:
+
+        struct Report
+        {
+            uint32_t                    m_teacherNumHidden = 0;
+            uint32_t                    m_studentNumHidden = 0;
+
+            double                      m_agreement = 0;                    // Percentage of entries with identical clamped outputs
+            double                      m_outputMSE = 0;                    // Mean squared difference between the raw outputs
+            double                      m_teacherAccuracy = 0;
+            double                      m_studentAccuracy = 0;
+
+            double                      m_teacherRowsPerSecond = 0;         // Network::EvaluateBatch
+            double                      m_studentRowsPerSecond = 0;
+        };
+
+    public:
+
+        // Raw outputs of the teacher for every entry of the set, row major, from one batched evaluation
+        static void GetTeacherOutputs( Network const& teacher, TrainingSet const& entries, std::vector<double>& teacherOutputs );
+
+        // Compares the clamped outputs of the student against the teacher on the evaluation set and times both networks over it
+        static Report CompareWithTeacher( Network const& teacher, Network const& student, TrainingSet const& evaluationSet, uint32_t numTimingPasses = 20 );
+
+        static void PrintReport( std::ostream& stream, Report const& report );
+    };
+}
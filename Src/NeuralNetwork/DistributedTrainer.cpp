@@ -0,0 +1,767 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "DistributedTrainer.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#if !_WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        inline double GetElapsedMS( Clock::time_point start, Clock::time_point end )
+        {
+            return std::chrono::duration<double, std::milli>( end - start ).count();
+        }
+
+        // Written by the sending rank, read by the receiving rank
+        struct ChannelHeader
+        {
+            alignas( 64 ) std::atomic<uint64_t>     m_numBytesWritten;
+            alignas( 64 ) std::atomic<uint64_t>     m_numBytesRead;
+        };
+
+        inline size_t GetChannelStride( size_t channelCapacity )
+        {
+            return ( sizeof( ChannelHeader ) + channelCapacity + 63 ) & ~size_t( 63 );
+        }
+
+        // Tracks how long an exchange has gone without progress, spinning briefly before yielding the core
+        class IdleWait
+        {
+        public:
+
+            explicit IdleWait( double timeoutSeconds ) : m_timeoutSeconds( timeoutSeconds ), m_lastProgressTime( Clock::now() ) {}
+
+            inline void OnProgress()
+            {
+                m_numIdleIterations = 0;
+                m_lastProgressTime = Clock::now();
+            }
+
+            // Returns false once the timeout has elapsed
+            bool Wait()
+            {
+                m_numIdleIterations++;
+                if ( m_numIdleIterations < 64 )
+                {
+                    return true;
+                }
+
+                std::this_thread::yield();
+                return ( m_numIdleIterations % 1024 ) != 0 || GetElapsedMS( m_lastProgressTime, Clock::now() ) < m_timeoutSeconds * 1000.0;
+            }
+
+        private:
+
+            double                          m_timeoutSeconds;
+            Clock::time_point               m_lastProgressTime;
+            uint32_t                        m_numIdleIterations = 0;
+        };
+
+        #if !_WIN32
+        bool SplitPeer( std::string const& peer, std::string& host, std::string& port )
+        {
+            size_t const separatorIdx = peer.rfind( ':' );
+            if ( separatorIdx == std::string::npos || separatorIdx == 0 || separatorIdx + 1 == peer.size() )
+            {
+                std::cout << "Invalid peer address: " << peer << ", expected host:port" << std::endl;
+                return false;
+            }
+
+            host = peer.substr( 0, separatorIdx );
+            port = peer.substr( separatorIdx + 1 );
+            return true;
+        }
+
+        void DisableNagle( int socket )
+        {
+            int const enable = 1;
+            setsockopt( socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof( enable ) );
+        }
+
+        int ListenOnPort( std::string const& port )
+        {
+            addrinfo hints;
+            memset( &hints, 0, sizeof( hints ) );
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_PASSIVE;
+
+            addrinfo* pAddresses = nullptr;
+            if ( getaddrinfo( nullptr, port.c_str(), &hints, &pAddresses ) != 0 )
+            {
+                std::cout << "Error Listening On Port: " << port << std::endl;
+                return -1;
+            }
+
+            int listenSocket = socket( pAddresses->ai_family, pAddresses->ai_socktype, pAddresses->ai_protocol );
+            if ( listenSocket >= 0 )
+            {
+                int const enable = 1;
+                setsockopt( listenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof( enable ) );
+                if ( bind( listenSocket, pAddresses->ai_addr, pAddresses->ai_addrlen ) != 0 || listen( listenSocket, 1 ) != 0 )
+                {
+                    std::cout << "Error Listening On Port: " << port << " (" << strerror( errno ) << ")" << std::endl;
+                    close( listenSocket );
+                    listenSocket = -1;
+                }
+            }
+
+            freeaddrinfo( pAddresses );
+            return listenSocket;
+        }
+
+        // The next rank may not be listening yet, so keep retrying until the timeout
+        int ConnectToPeer( std::string const& host, std::string const& port, double timeoutSeconds )
+        {
+            addrinfo hints;
+            memset( &hints, 0, sizeof( hints ) );
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+
+            auto const startTime = Clock::now();
+            while ( GetElapsedMS( startTime, Clock::now() ) < timeoutSeconds * 1000.0 )
+            {
+                addrinfo* pAddresses = nullptr;
+                if ( getaddrinfo( host.c_str(), port.c_str(), &hints, &pAddresses ) == 0 )
+                {
+                    for ( addrinfo* pAddress = pAddresses; pAddress != nullptr; pAddress = pAddress->ai_next )
+                    {
+                        int const connectSocket = socket( pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol );
+                        if ( connectSocket < 0 )
+                        {
+                            continue;
+                        }
+
+                        if ( connect( connectSocket, pAddress->ai_addr, pAddress->ai_addrlen ) == 0 )
+                        {
+                            freeaddrinfo( pAddresses );
+                            DisableNagle( connectSocket );
+                            return connectSocket;
+                        }
+
+                        close( connectSocket );
+                    }
+
+                    freeaddrinfo( pAddresses );
+                }
+
+                std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+            }
+
+            std::cout << "Error Connecting To: " << host << ":" << port << std::endl;
+            return -1;
+        }
+
+        int AcceptPeer( int listenSocket, double timeoutSeconds )
+        {
+            pollfd listenPoll{ listenSocket, POLLIN, 0 };
+            int result = 0;
+            do
+            {
+                result = poll( &listenPoll, 1, (int) ( timeoutSeconds * 1000.0 ) );
+            }
+            while ( result < 0 && errno == EINTR );
+
+            int const acceptedSocket = ( result > 0 ) ? accept( listenSocket, nullptr, nullptr ) : -1;
+            if ( acceptedSocket < 0 )
+            {
+                std::cout << "Error Accepting The Previous Rank" << std::endl;
+                return -1;
+            }
+
+            DisableNagle( acceptedSocket );
+            return acceptedSocket;
+        }
+        #endif
+    }
+
+    //-------------------------------------------------------------------------
+    // Shared memory transport
+    //-------------------------------------------------------------------------
+
+    SharedMemoryTransport::SharedMemoryTransport( uint32_t numRanks, void* pSegment, size_t segmentSize, size_t channelCapacity )
+        : RingTransport( 0, numRanks )
+        , m_pSegment( pSegment )
+        , m_segmentSize( segmentSize )
+        , m_channelCapacity( channelCapacity )
+    {}
+
+    std::unique_ptr<SharedMemoryTransport> SharedMemoryTransport::Create( uint32_t numRanks, size_t channelCapacity )
+    {
+        assert( numRanks > 0 && channelCapacity > 0 );
+
+        #if !_WIN32
+        std::string const segmentName = "/BPN_Ring_" + std::to_string( getpid() );
+        size_t const segmentSize = numRanks * GetChannelStride( channelCapacity );
+
+        int const segmentFile = shm_open( segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600 );
+        if ( segmentFile < 0 )
+        {
+            std::cout << "Error Creating Shared Memory Segment: " << segmentName << " (" << strerror( errno ) << ")" << std::endl;
+            return nullptr;
+        }
+
+        void* pSegment = MAP_FAILED;
+        if ( ftruncate( segmentFile, (off_t) segmentSize ) == 0 )
+        {
+            pSegment = mmap( nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, segmentFile, 0 );
+        }
+
+        // The mapping stays valid for this process and the forked ranks, the name isn't needed anymore
+        close( segmentFile );
+        shm_unlink( segmentName.c_str() );
+
+        if ( pSegment == MAP_FAILED )
+        {
+            std::cout << "Error Mapping Shared Memory Segment: " << segmentName << " (" << strerror( errno ) << ")" << std::endl;
+            return nullptr;
+        }
+
+        for ( uint32_t channelIdx = 0; channelIdx < numRanks; channelIdx++ )
+        {
+            ChannelHeader* pHeader = new( static_cast<char*>( pSegment ) + channelIdx * GetChannelStride( channelCapacity ) ) ChannelHeader;
+            pHeader->m_numBytesWritten.store( 0 );
+            pHeader->m_numBytesRead.store( 0 );
+        }
+
+        return std::unique_ptr<SharedMemoryTransport>( new SharedMemoryTransport( numRanks, pSegment, segmentSize, channelCapacity ) );
+        #else
+        std::cout << "Shared memory transport is not supported on this platform" << std::endl;
+        return nullptr;
+        #endif
+    }
+
+    SharedMemoryTransport::~SharedMemoryTransport()
+    {
+        #if !_WIN32
+        munmap( m_pSegment, m_segmentSize );
+        #endif
+    }
+
+    void SharedMemoryTransport::SetRank( uint32_t rank )
+    {
+        assert( rank < m_numRanks );
+        m_rank = rank;
+    }
+
+    bool SharedMemoryTransport::Exchange( void const* pSendData, size_t sendSize, void* pReceiveData, size_t receiveSize )
+    {
+        // Channel N links rank N to rank N+1
+        size_t const channelStride = GetChannelStride( m_channelCapacity );
+        char* pSendChannel = static_cast<char*>( m_pSegment ) + m_rank * channelStride;
+        char* pReceiveChannel = static_cast<char*>( m_pSegment ) + ( ( m_rank + m_numRanks - 1 ) % m_numRanks ) * channelStride;
+        ChannelHeader* pSendHeader = reinterpret_cast<ChannelHeader*>( pSendChannel );
+        ChannelHeader* pReceiveHeader = reinterpret_cast<ChannelHeader*>( pReceiveChannel );
+        char* pSendBuffer = pSendChannel + sizeof( ChannelHeader );
+        char* pReceiveBuffer = pReceiveChannel + sizeof( ChannelHeader );
+
+        char const* pSendBytes = static_cast<char const*>( pSendData );
+        char* pReceiveBytes = static_cast<char*>( pReceiveData );
+        size_t numSent = 0;
+        size_t numReceived = 0;
+
+        // Both directions make progress together, so messages larger than the channels can't deadlock the ring
+        IdleWait idleWait( m_timeoutSeconds );
+        while ( numSent < sendSize || numReceived < receiveSize )
+        {
+            bool madeProgress = false;
+
+            if ( numSent < sendSize )
+            {
+                uint64_t const numBytesWritten = pSendHeader->m_numBytesWritten.load( std::memory_order_relaxed );
+                uint64_t const numBytesRead = pSendHeader->m_numBytesRead.load( std::memory_order_acquire );
+                size_t const numBytes = std::min( m_channelCapacity - (size_t) ( numBytesWritten - numBytesRead ), sendSize - numSent );
+                if ( numBytes > 0 )
+                {
+                    size_t const offset = numBytesWritten % m_channelCapacity;
+                    size_t const firstPartSize = std::min( numBytes, m_channelCapacity - offset );
+                    memcpy( pSendBuffer + offset, pSendBytes + numSent, firstPartSize );
+                    memcpy( pSendBuffer, pSendBytes + numSent + firstPartSize, numBytes - firstPartSize );
+                    pSendHeader->m_numBytesWritten.store( numBytesWritten + numBytes, std::memory_order_release );
+                    numSent += numBytes;
+                    madeProgress = true;
+                }
+            }
+
+            if ( numReceived < receiveSize )
+            {
+                uint64_t const numBytesRead = pReceiveHeader->m_numBytesRead.load( std::memory_order_relaxed );
+                uint64_t const numBytesWritten = pReceiveHeader->m_numBytesWritten.load( std::memory_order_acquire );
+                size_t const numBytes = std::min( (size_t) ( numBytesWritten - numBytesRead ), receiveSize - numReceived );
+                if ( numBytes > 0 )
+                {
+                    size_t const offset = numBytesRead % m_channelCapacity;
+                    size_t const firstPartSize = std::min( numBytes, m_channelCapacity - offset );
+                    memcpy( pReceiveBytes + numReceived, pReceiveBuffer + offset, firstPartSize );
+                    memcpy( pReceiveBytes + numReceived + firstPartSize, pReceiveBuffer, numBytes - firstPartSize );
+                    pReceiveHeader->m_numBytesRead.store( numBytesRead + numBytes, std::memory_order_release );
+                    numReceived += numBytes;
+                    madeProgress = true;
+                }
+            }
+
+            if ( madeProgress )
+            {
+                idleWait.OnProgress();
+            }
+            else if ( !idleWait.Wait() )
+            {
+                std::cout << "Timed out exchanging with the neighbouring ranks of rank " << m_rank << std::endl;
+                return false;
+            }
+        }
+
+        m_numBytesSent += sendSize;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    // TCP transport
+    //-------------------------------------------------------------------------
+
+    std::unique_ptr<TcpTransport> TcpTransport::Connect( uint32_t rank, std::vector<std::string> const& peers, double timeoutSeconds )
+    {
+        assert( rank < peers.size() );
+
+        std::unique_ptr<TcpTransport> pTransport( new TcpTransport( rank, (uint32_t) peers.size() ) );
+        pTransport->m_timeoutSeconds = timeoutSeconds;
+        if ( peers.size() == 1 )
+        {
+            return pTransport;
+        }
+
+        #if !_WIN32
+        uint32_t const numRanks = (uint32_t) peers.size();
+        uint32_t const nextRank = ( rank + 1 ) % numRanks;
+        uint32_t const previousRank = ( rank + numRanks - 1 ) % numRanks;
+
+        std::string host, port, nextHost, nextPort;
+        if ( !SplitPeer( peers[rank], host, port ) || !SplitPeer( peers[nextRank], nextHost, nextPort ) )
+        {
+            return nullptr;
+        }
+
+        // Listen before connecting so that every rank can complete its outgoing connection before accepting
+        int const listenSocket = ListenOnPort( port );
+        if ( listenSocket < 0 )
+        {
+            return nullptr;
+        }
+
+        pTransport->m_sendSocket = ConnectToPeer( nextHost, nextPort, timeoutSeconds );
+        if ( pTransport->m_sendSocket >= 0 )
+        {
+            pTransport->m_receiveSocket = AcceptPeer( listenSocket, timeoutSeconds );
+        }
+        close( listenSocket );
+
+        if ( pTransport->m_sendSocket < 0 || pTransport->m_receiveSocket < 0 )
+        {
+            return nullptr;
+        }
+
+        // Make sure the ring is wired up as expected
+        uint32_t connectedRank = numRanks;
+        if ( !pTransport->Exchange( &rank, sizeof( rank ), &connectedRank, sizeof( connectedRank ) ) || connectedRank != previousRank )
+        {
+            std::cout << "Rank " << rank << " expected rank " << previousRank << " to connect, got rank " << connectedRank << std::endl;
+            return nullptr;
+        }
+
+        return pTransport;
+        #else
+        std::cout << "TCP transport is not supported on this platform" << std::endl;
+        return nullptr;
+        #endif
+    }
+
+    TcpTransport::~TcpTransport()
+    {
+        #if !_WIN32
+        if ( m_sendSocket >= 0 )
+        {
+            close( m_sendSocket );
+        }
+
+        if ( m_receiveSocket >= 0 )
+        {
+            close( m_receiveSocket );
+        }
+        #endif
+    }
+
+    bool TcpTransport::Exchange( void const* pSendData, size_t sendSize, void* pReceiveData, size_t receiveSize )
+    {
+        #if !_WIN32
+        char const* pSendBytes = static_cast<char const*>( pSendData );
+        char* pReceiveBytes = static_cast<char*>( pReceiveData );
+        size_t numSent = 0;
+        size_t numReceived = 0;
+
+        auto lastProgressTime = Clock::now();
+        while ( numSent < sendSize || numReceived < receiveSize )
+        {
+            pollfd polls[2];
+            uint32_t numPolls = 0;
+            if ( numSent < sendSize )
+            {
+                polls[numPolls++] = pollfd{ m_sendSocket, POLLOUT, 0 };
+            }
+
+            if ( numReceived < receiveSize )
+            {
+                polls[numPolls++] = pollfd{ m_receiveSocket, POLLIN, 0 };
+            }
+
+            int const result = poll( polls, numPolls, 100 );
+            if ( result < 0 && errno != EINTR )
+            {
+                std::cout << "Error polling the ring sockets (" << strerror( errno ) << ")" << std::endl;
+                return false;
+            }
+
+            bool madeProgress = false;
+            for ( uint32_t pollIdx = 0; result > 0 && pollIdx < numPolls; pollIdx++ )
+            {
+                if ( polls[pollIdx].revents == 0 )
+                {
+                    continue;
+                }
+
+                ssize_t numBytes = 0;
+                if ( polls[pollIdx].fd == m_sendSocket && numSent < sendSize )
+                {
+                    numBytes = send( m_sendSocket, pSendBytes + numSent, sendSize - numSent, MSG_NOSIGNAL | MSG_DONTWAIT );
+                    numSent += ( numBytes > 0 ) ? (size_t) numBytes : 0;
+                }
+                else
+                {
+                    numBytes = recv( m_receiveSocket, pReceiveBytes + numReceived, receiveSize - numReceived, MSG_DONTWAIT );
+                    numReceived += ( numBytes > 0 ) ? (size_t) numBytes : 0;
+                    if ( numBytes == 0 )
+                    {
+                        std::cout << "Connection closed by the previous rank of rank " << m_rank << std::endl;
+                        return false;
+                    }
+                }
+
+                if ( numBytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+                {
+                    std::cout << "Error exchanging with the neighbouring ranks of rank " << m_rank << " (" << strerror( errno ) << ")" << std::endl;
+                    return false;
+                }
+
+                madeProgress |= numBytes > 0;
+            }
+
+            if ( madeProgress )
+            {
+                lastProgressTime = Clock::now();
+            }
+            else if ( GetElapsedMS( lastProgressTime, Clock::now() ) > m_timeoutSeconds * 1000.0 )
+            {
+                std::cout << "Timed out exchanging with the neighbouring ranks of rank " << m_rank << std::endl;
+                return false;
+            }
+        }
+
+        m_numBytesSent += sendSize;
+        return true;
+        #else
+        ( void ) pSendData; ( void ) sendSize; ( void ) pReceiveData; ( void ) receiveSize;
+        return false;
+        #endif
+    }
+
+    //-------------------------------------------------------------------------
+    // Collectives and process management
+    //-------------------------------------------------------------------------
+
+    bool RingAllReduceSum( RingTransport& transport, double* pValues, size_t numValues )
+    {
+        uint32_t const numRanks = transport.GetNumRanks();
+        uint32_t const rank = transport.GetRank();
+        if ( numRanks == 1 )
+        {
+            return true;
+        }
+
+        auto GetChunkStart = [numValues, numRanks] ( uint32_t chunkIdx ) { return numValues * chunkIdx / numRanks; };
+        auto GetChunkSize = [&] ( uint32_t chunkIdx ) { return GetChunkStart( chunkIdx + 1 ) - GetChunkStart( chunkIdx ); };
+
+        std::vector<double> receivedValues( GetChunkSize( numRanks - 1 ) + 1 );
+
+        // Reduce-scatter: after N-1 steps rank R holds the complete sum of chunk R+1
+        for ( uint32_t stepIdx = 0; stepIdx < numRanks - 1; stepIdx++ )
+        {
+            uint32_t const sendChunkIdx = ( rank + numRanks - stepIdx ) % numRanks;
+            uint32_t const receiveChunkIdx = ( rank + numRanks - stepIdx - 1 ) % numRanks;
+            if ( !transport.Exchange( pValues + GetChunkStart( sendChunkIdx ), GetChunkSize( sendChunkIdx ) * sizeof( double ), receivedValues.data(), GetChunkSize( receiveChunkIdx ) * sizeof( double ) ) )
+            {
+                return false;
+            }
+
+            double* pChunk = pValues + GetChunkStart( receiveChunkIdx );
+            for ( size_t valueIdx = 0; valueIdx < GetChunkSize( receiveChunkIdx ); valueIdx++ )
+            {
+                pChunk[valueIdx] += receivedValues[valueIdx];
+            }
+        }
+
+        // All-gather: pass the completed chunks around the ring
+        for ( uint32_t stepIdx = 0; stepIdx < numRanks - 1; stepIdx++ )
+        {
+            uint32_t const sendChunkIdx = ( rank + 1 + numRanks - stepIdx ) % numRanks;
+            uint32_t const receiveChunkIdx = ( rank + numRanks - stepIdx ) % numRanks;
+            if ( !transport.Exchange( pValues + GetChunkStart( sendChunkIdx ), GetChunkSize( sendChunkIdx ) * sizeof( double ), pValues + GetChunkStart( receiveChunkIdx ), GetChunkSize( receiveChunkIdx ) * sizeof( double ) ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool ForkLocalRanks( uint32_t numRanks, uint32_t& rank, std::vector<int>& childProcessIDs )
+    {
+        rank = 0;
+        childProcessIDs.clear();
+
+        #if !_WIN32
+        // Buffered output would otherwise be written out again by every child
+        std::cout.flush();
+        fflush( stdout );
+
+        for ( uint32_t childRank = 1; childRank < numRanks; childRank++ )
+        {
+            pid_t const processID = fork();
+            if ( processID < 0 )
+            {
+                std::cout << "Error Forking Rank: " << childRank << " (" << strerror( errno ) << ")" << std::endl;
+                return false;
+            }
+
+            if ( processID == 0 )
+            {
+                rank = childRank;
+                childProcessIDs.clear();
+                return true;
+            }
+
+            childProcessIDs.push_back( processID );
+        }
+
+        return true;
+        #else
+        std::cout << "Forking ranks is not supported on this platform" << std::endl;
+        return numRanks == 1;
+        #endif
+    }
+
+    bool WaitForLocalRanks( std::vector<int> const& childProcessIDs )
+    {
+        bool succeeded = true;
+
+        #if !_WIN32
+        for ( int processID : childProcessIDs )
+        {
+            int status = 0;
+            while ( waitpid( processID, &status, 0 ) < 0 && errno == EINTR ) {}
+            succeeded &= WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+        }
+        #endif
+
+        return succeeded;
+    }
+
+    //-------------------------------------------------------------------------
+    // Trainer
+    //-------------------------------------------------------------------------
+
+    DistributedTrainer::DistributedTrainer( Settings const& settings, Network* pNetwork )
+        : m_settings( settings )
+        , m_pNetwork( pNetwork )
+    {
+        assert( pNetwork != nullptr );
+        m_settings.m_batchSize = std::max( 1u, m_settings.m_batchSize );
+    }
+
+    bool DistributedTrainer::Train( TrainingData const& trainingData, RingTransport& transport )
+    {
+        TrainingSet const& trainingSet = trainingData.m_trainingSet;
+        assert( !trainingSet.empty() );
+
+        auto const trainingStartTime = Clock::now();
+        m_stats = Stats();
+        uint64_t const startNumBytesSent = transport.GetNumBytesSent();
+
+        // Every rank uses the same shard size and number of steps so that they all take part in every all-reduce
+        uint32_t const numRanks = transport.GetNumRanks();
+        size_t const shardSize = ( trainingSet.size() + numRanks - 1 ) / numRanks;
+        size_t const shardStart = std::min( trainingSet.size(), transport.GetRank() * shardSize );
+        size_t const shardEnd = std::min( trainingSet.size(), shardStart + shardSize );
+        TrainingSet const shard( trainingSet.begin() + shardStart, trainingSet.begin() + shardEnd );
+        double const shardWeight = (double) GetTotalWeight( shard );
+        double const trainingSetWeight = (double) GetTotalWeight( trainingSet );
+        uint32_t const numStepsPerEpoch = (uint32_t) ( ( shardSize + m_settings.m_batchSize - 1 ) / m_settings.m_batchSize );
+
+        if ( m_settings.m_pTelemetrySink != nullptr )
+        {
+            TrainingStartTelemetry telemetry;
+            telemetry.m_learningRate = m_settings.m_learningRate;
+            telemetry.m_momentum = m_settings.m_momentum;
+            telemetry.m_maxEpochs = m_settings.m_maxEpochs;
+            telemetry.m_useBatchLearning = false;
+            telemetry.m_numInputs = m_pNetwork->m_numInputs;
+            telemetry.m_numHidden = m_pNetwork->m_numHidden;
+            telemetry.m_numOutputs = m_pNetwork->m_numOutputs;
+            telemetry.m_numTrainingEntries = (uint32_t) trainingSet.size();
+            m_settings.m_pTelemetrySink->OnTrainingStarted( telemetry );
+        }
+
+        NetworkTrainer::Settings trainerSettings;
+        trainerSettings.m_learningRate = m_settings.m_learningRate;
+        trainerSettings.m_momentum = m_settings.m_momentum;
+        NetworkTrainer trainer( trainerSettings, m_pNetwork );
+
+        std::vector<double> weights = m_pNetwork->GetWeights();
+        std::vector<double> deltas( weights.size(), 0.0 );
+        std::vector<double> gradient( weights.size(), 0.0 );
+
+        bool shouldStop = m_settings.m_maxEpochs == 0;
+        while ( !shouldStop )
+        {
+            auto const epochStartTime = Clock::now();
+
+            for ( uint32_t stepIdx = 0; stepIdx < numStepsPerEpoch; stepIdx++ )
+            {
+                auto const computeStartTime = Clock::now();
+                size_t const batchStart = std::min( shard.size(), (size_t) stepIdx * m_settings.m_batchSize );
+                size_t const batchSize = std::min( (size_t) m_settings.m_batchSize, shard.size() - batchStart );
+                if ( batchSize > 0 )
+                {
+                    trainer.GetErrorGradient( &shard[batchStart], batchSize, gradient );
+                }
+                else
+                {
+                    std::fill( gradient.begin(), gradient.end(), 0.0 );
+                }
+
+                auto const allReduceStartTime = Clock::now();
+                m_stats.m_computeTimeMS += GetElapsedMS( computeStartTime, allReduceStartTime );
+
+                if ( !RingAllReduceSum( transport, gradient.data(), gradient.size() ) )
+                {
+                    return false;
+                }
+
+                m_stats.m_allReduceTimeMS += GetElapsedMS( allReduceStartTime, Clock::now() );
+                m_stats.m_numSyncs++;
+
+                for ( size_t weightIdx = 0; weightIdx < weights.size(); weightIdx++ )
+                {
+                    deltas[weightIdx] = -m_settings.m_learningRate * gradient[weightIdx] + m_settings.m_momentum * deltas[weightIdx];
+                    weights[weightIdx] += deltas[weightIdx];
+                }
+                m_pNetwork->LoadWeights( weights );
+            }
+
+            // Epoch results: the shard errors of all ranks and the generalization results of rank 0 are summed
+            //-------------------------------------------------------------------------
+
+            // The last ranks have no rows when there are fewer rows than ranks, they contribute zeros rather than a 0/0 NaN
+            double epochResults[4] = { 0.0, 0.0, 0.0, 0.0 };
+            if ( !shard.empty() )
+            {
+                double shardAccuracy = 0;
+                double shardMSE = 0;
+                trainer.GetSetAccuracyAndMSE( shard, shardAccuracy, shardMSE );
+                epochResults[0] = ( 100.0 - shardAccuracy ) / 100.0 * shardWeight;
+                epochResults[1] = shardMSE * m_pNetwork->m_numOutputs * shardWeight;
+            }
+
+            if ( transport.GetRank() == 0 )
+            {
+                trainer.GetSetAccuracyAndMSE( trainingData.m_generalizationSet, epochResults[2], epochResults[3] );
+            }
+
+            if ( !RingAllReduceSum( transport, epochResults, 4 ) )
+            {
+                return false;
+            }
+
+            double const trainingSetAccuracy = 100.0 - ( epochResults[0] / trainingSetWeight * 100.0 );
+            double const trainingSetMSE = epochResults[1] / ( m_pNetwork->m_numOutputs * trainingSetWeight );
+            double const generalizationSetAccuracy = epochResults[2];
+
+            if ( m_settings.m_pTelemetrySink != nullptr )
+            {
+                EpochTelemetry telemetry;
+                telemetry.m_epoch = m_stats.m_numEpochs;
+                telemetry.m_trainingSetAccuracy = trainingSetAccuracy;
+                telemetry.m_trainingSetMSE = trainingSetMSE;
+                telemetry.m_generalizationSetAccuracy = generalizationSetAccuracy;
+                telemetry.m_generalizationSetMSE = epochResults[3];
+                telemetry.m_epochTimeMS = GetElapsedMS( epochStartTime, Clock::now() );
+                telemetry.m_samplesPerSecond = ( telemetry.m_epochTimeMS > 0 ) ? trainingSet.size() / ( telemetry.m_epochTimeMS / 1000.0 ) : 0.0;
+                m_settings.m_pTelemetrySink->OnEpochComplete( telemetry );
+            }
+
+            m_stats.m_numEpochs++;
+            shouldStop = m_stats.m_numEpochs >= m_settings.m_maxEpochs || ( trainingSetAccuracy >= m_settings.m_desiredAccuracy && generalizationSetAccuracy >= m_settings.m_desiredAccuracy );
+        }
+
+        m_stats.m_numBytesSent = transport.GetNumBytesSent() - startNumBytesSent;
+        m_stats.m_totalTimeMS = GetElapsedMS( trainingStartTime, Clock::now() );
+
+        if ( m_settings.m_pTelemetrySink != nullptr )
+        {
+            TrainingCompleteTelemetry telemetry;
+            telemetry.m_numEpochs = m_stats.m_numEpochs;
+            trainer.GetSetAccuracyAndMSE( trainingData.m_validationSet, telemetry.m_validationSetAccuracy, telemetry.m_validationSetMSE );
+            telemetry.m_totalTimeMS = m_stats.m_totalTimeMS;
+            m_settings.m_pTelemetrySink->OnTrainingComplete( telemetry );
+        }
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+
+    void DistributedTrainer::PrintStats( std::ostream& stream, uint32_t numRanks, Stats const& stats )
+    {
+        stream << std::endl << " Distributed Training: " << numRanks << " ranks, " << stats.m_numEpochs << " epochs, " << stats.m_numSyncs << " all-reduces" << std::endl
+               << "==========================================================================" << std::endl
+               << " Time (ms) - total: " << stats.m_totalTimeMS << ", compute: " << stats.m_computeTimeMS << ", all-reduce: " << stats.m_allReduceTimeMS << std::endl
+               << " Sent per rank: " << stats.m_numBytesSent / ( 1024.0 * 1024.0 ) << " MB (" << ( stats.m_numSyncs > 0 ? stats.m_numBytesSent / stats.m_numSyncs : 0 ) << " bytes per all-reduce)" << std::endl
+               << "==========================================================================" << std::endl << std::endl;
+    }
+}
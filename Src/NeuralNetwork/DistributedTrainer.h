@@ -0,0 +1,159 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Multi-process data parallel training
+//
+// Every process (rank) trains its own copy of the network on a contiguous shard of the training set. After
+// each batch the gradients of all ranks are summed with a ring all-reduce: a reduce-scatter followed by an
+// all-gather, each made of numRanks-1 steps in which every rank sends one chunk of the gradient to the next
+// rank while receiving one from the previous rank. Each rank sends 2*(N-1)/N of the gradient per batch
+// whatever the number of ranks, and since every chunk is reduced by a single rank and then copied, all ranks
+// apply a bit-identical momentum update and their weights never drift apart.
+//
+// Ranks forked on one host exchange chunks through ring buffers in POSIX shared memory, ranks on different
+// hosts through TCP. The transports are POSIX only.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    // Point to point link from each rank to the next one in the ring
+    class RingTransport
+    {
+    public:
+
+        virtual ~RingTransport() = default;
+
+        inline uint32_t GetRank() const { return m_rank; }
+        inline uint32_t GetNumRanks() const { return m_numRanks; }
+        inline uint64_t GetNumBytesSent() const { return m_numBytesSent; }
+
+        // Sends the buffer to the next rank while receiving a buffer from the previous rank, returns false on error or timeout
+        virtual bool Exchange( void const* pSendData, size_t sendSize, void* pReceiveData, size_t receiveSize ) = 0;
+
+    protected:
+
+        RingTransport( uint32_t rank, uint32_t numRanks ) : m_rank( rank ), m_numRanks( numRanks ) {}
+
+    protected:
+
+        uint32_t                            m_rank;
+        uint32_t                            m_numRanks;
+        uint64_t                            m_numBytesSent = 0;
+        double                              m_timeoutSeconds = 60.0;
+    };
+
+    //-------------------------------------------------------------------------
+
+    // Single producer/consumer ring buffers in one shared memory segment, one per link
+    class SharedMemoryTransport final : public RingTransport
+    {
+    public:
+
+        // Maps the segment as rank 0, must be called before the other ranks are forked so that they inherit the mapping
+        static std::unique_ptr<SharedMemoryTransport> Create( uint32_t numRanks, size_t channelCapacity = 1 << 20 );
+
+        ~SharedMemoryTransport();
+
+        // Called by each forked rank on its inherited transport
+        void SetRank( uint32_t rank );
+
+        virtual bool Exchange( void const* pSendData, size_t sendSize, void* pReceiveData, size_t receiveSize ) override;
+
+    private:
+
+        SharedMemoryTransport( uint32_t numRanks, void* pSegment, size_t segmentSize, size_t channelCapacity );
+
+    private:
+
+        void*                               m_pSegment = nullptr;
+        size_t                              m_segmentSize = 0;
+        size_t                              m_channelCapacity = 0;
+    };
+
+    //-------------------------------------------------------------------------
+
+    class TcpTransport final : public RingTransport
+    {
+    public:
+
+        // The peers are "host:port" for each rank, a rank listens on its own port and connects to the next rank's
+        static std::unique_ptr<TcpTransport> Connect( uint32_t rank, std::vector<std::string> const& peers, double timeoutSeconds = 60.0 );
+
+        ~TcpTransport();
+
+        virtual bool Exchange( void const* pSendData, size_t sendSize, void* pReceiveData, size_t receiveSize ) override;
+
+    private:
+
+        TcpTransport( uint32_t rank, uint32_t numRanks ) : RingTransport( rank, numRanks ) {}
+
+    private:
+
+        int                                 m_sendSocket = -1;          // To the next rank
+        int                                 m_receiveSocket = -1;       // From the previous rank
+    };
+
+    //-------------------------------------------------------------------------
+
+    // Sums the values of all ranks in place, every rank ends up with identical values
+    bool RingAllReduceSum( RingTransport& transport, double* pValues, size_t numValues );
+
+    // Forks numRanks-1 child processes, the calling process becomes rank 0
+    bool ForkLocalRanks( uint32_t numRanks, uint32_t& rank, std::vector<int>& childProcessIDs );
+
+    // Returns false if any of the forked ranks failed
+    bool WaitForLocalRanks( std::vector<int> const& childProcessIDs );
+
+    //-------------------------------------------------------------------------
+
+    class DistributedTrainer
+    {
+    public:
+
+        struct Settings
+        {
+            double                          m_learningRate = 0.001;
+            double                          m_momentum = 0.9;
+            uint32_t                        m_batchSize = 64;           // Entries per rank between all-reduces, the update uses the summed gradient of all ranks
+            uint32_t                        m_maxEpochs = 150;
+            double                          m_desiredAccuracy = 90;
+            TrainingTelemetrySink*          m_pTelemetrySink = nullptr; // Usually only set on rank 0
+        };
+
+        struct Stats
+        {
+            uint32_t                        m_numEpochs = 0;
+            uint64_t                        m_numSyncs = 0;
+            uint64_t                        m_numBytesSent = 0;
+            double                          m_computeTimeMS = 0;
+            double                          m_allReduceTimeMS = 0;      // Includes waiting for slower ranks
+            double                          m_totalTimeMS = 0;
+        };
+
+    public:
+
+        DistributedTrainer( Settings const& settings, Network* pNetwork );
+
+        // All ranks must call this with the same data and an identically initialized network, returns false if the ring failed
+        bool Train( TrainingData const& trainingData, RingTransport& transport );
+
+        inline Stats const& GetStats() const { return m_stats; }
+        static void PrintStats( std::ostream& stream, uint32_t numRanks, Stats const& stats );
+
+    private:
+
+        Settings                            m_settings;
+        Network*                            m_pNetwork;
+        Stats                               m_stats;
+    };
+}
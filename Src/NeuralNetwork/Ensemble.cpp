@@ -0,0 +1,360 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "Ensemble.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Number of rows evaluated together so that each packed weight row is loaded once per tile
+        constexpr uint32_t g_evaluationTileSize = 4;
+
+        // Majority of the member votes, a tie is undecided
+        inline int32_t ClampVoteFraction( double voteFraction )
+        {
+            if ( voteFraction > 0.5 ) return 1;
+            else if ( voteFraction < 0.5 ) return 0;
+            else return -1;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    Ensemble::Ensemble( Settings const& settings, Network::Settings const& networkSettings )
+        : m_settings( settings )
+        , m_numInputs( networkSettings.m_numInputs )
+        , m_numHidden( networkSettings.m_numHidden )
+        , m_numOutputs( networkSettings.m_numOutputs )
+    {
+        assert( m_settings.m_numMembers > 0 && m_settings.m_trainingBlockSize > 0 );
+
+        // Each member gets its own random initialization, seeded from its own stream so the ensemble is reproducible
+        for ( uint32_t memberIdx = 0; memberIdx < m_settings.m_numMembers; memberIdx++ )
+        {
+            Network::Settings memberSettings = networkSettings;
+            memberSettings.m_seed = RandomStream::DeriveSeed( networkSettings.m_seed, memberIdx );
+            m_members.emplace_back( new Network( memberSettings ) );
+        }
+
+        m_outputs.resize( m_numOutputs );
+        m_clampedOutputs.resize( m_numOutputs );
+        PackWeights();
+    }
+
+    Ensemble::~Ensemble() = default;
+
+    void Ensemble::LoadMemberWeights( uint32_t memberIdx, std::vector<double> const& weights )
+    {
+        assert( memberIdx < m_members.size() );
+        m_members[memberIdx]->LoadWeights( weights );
+        PackWeights();
+    }
+
+    void Ensemble::PackWeights()
+    {
+        int32_t const numMembers = (int32_t) m_members.size();
+        int32_t const packedHiddenWidth = numMembers * m_numHidden;
+
+        m_packedWeightsInputHidden.resize( ( m_numInputs + 1 ) * packedHiddenWidth );
+        m_packedWeightsHiddenOutput.resize( numMembers * ( m_numHidden + 1 ) * m_numOutputs );
+
+        for ( int32_t memberIdx = 0; memberIdx < numMembers; memberIdx++ )
+        {
+            Network const& member = *m_members[memberIdx];
+
+            for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
+            {
+                for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+                {
+                    m_packedWeightsInputHidden[inputIdx * packedHiddenWidth + memberIdx * m_numHidden + hiddenIdx] = member.m_weightsInputHidden[member.GetInputHiddenWeightIndex( inputIdx, hiddenIdx )];
+                }
+            }
+
+            double* pMemberHiddenOutputWeights = &m_packedWeightsHiddenOutput[memberIdx * ( m_numHidden + 1 ) * m_numOutputs];
+            for ( int32_t hiddenIdx = 0; hiddenIdx <= m_numHidden; hiddenIdx++ )
+            {
+                for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+                {
+                    pMemberHiddenOutputWeights[hiddenIdx * m_numOutputs + outputIdx] = member.m_weightsHiddenOutput[member.GetHiddenOutputWeightIndex( hiddenIdx, outputIdx )];
+                }
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    void Ensemble::Train( NetworkTrainer::Settings const& trainerSettings, TrainingData const& trainingData )
+    {
+        assert( !trainingData.m_trainingSet.empty() );
+
+        typedef std::chrono::steady_clock Clock;
+        auto const trainingStartTime = Clock::now();
+        Profiling::Counters const trainingStartCounters = Profiling::GetThreadCounters();
+
+        TrainingTelemetrySink* pTelemetrySink = trainerSettings.m_pTelemetrySink;
+        if ( pTelemetrySink != nullptr )
+        {
+            TrainingStartTelemetry telemetry;
+            telemetry.m_learningRate = trainerSettings.m_learningRate;
+            telemetry.m_momentum = trainerSettings.m_momentum;
+            telemetry.m_maxEpochs = trainerSettings.m_maxEpochs;
+            telemetry.m_useBatchLearning = trainerSettings.m_useBatchLearning;
+            telemetry.m_numInputs = m_numInputs;
+            telemetry.m_numHidden = m_numHidden;
+            telemetry.m_numOutputs = m_numOutputs;
+            telemetry.m_numTrainingEntries = (uint32_t) trainingData.m_trainingSet.size();
+            telemetry.m_dataLoadStats = trainingStartCounters.m_phases[(uint32_t) Profiling::Phase::ReadData];
+            pTelemetrySink->OnTrainingStarted( telemetry );
+        }
+
+        // Member trainers only train, progress is reported for the ensemble as a whole
+        NetworkTrainer::Settings memberTrainerSettings = trainerSettings;
+        memberTrainerSettings.m_pTelemetrySink = nullptr;
+
+        std::vector<std::unique_ptr<NetworkTrainer>> trainers;
+        for ( auto& pMember : m_members )
+        {
+            trainers.emplace_back( new NetworkTrainer( memberTrainerSettings, pMember.get() ) );
+        }
+
+        // No point in having more threads than members
+        uint32_t const numThreads = ( m_settings.m_numThreads == 0 ) ? std::thread::hardware_concurrency() : m_settings.m_numThreads;
+        ThreadPool threadPool( std::max( 1u, std::min( numThreads, GetNumMembers() ) ) );
+
+        TrainingSet const& trainingSet = trainingData.m_trainingSet;
+        uint32_t const numMembers = GetNumMembers();
+        uint32_t epoch = 0;
+        double trainingSetAccuracy = 0;
+        double trainingSetMSE = 0;
+        double generalizationSetAccuracy = 0;
+        double generalizationSetMSE = 0;
+
+        while ( ( trainingSetAccuracy < trainerSettings.m_desiredAccuracy || generalizationSetAccuracy < trainerSettings.m_desiredAccuracy ) && epoch < trainerSettings.m_maxEpochs )
+        {
+            auto const epochStartTime = Clock::now();
+            Profiling::Counters const epochStartCounters = Profiling::GetThreadCounters();
+
+            // Single pass over the training data, all members train on a block before moving on to the next one
+            //-------------------------------------------------------------------------
+
+            for ( auto& pTrainer : trainers )
+            {
+                pTrainer->BeginEpoch();
+            }
+
+            for ( size_t blockStart = 0; blockStart < trainingSet.size(); blockStart += m_settings.m_trainingBlockSize )
+            {
+                size_t const blockSize = std::min( (size_t) m_settings.m_trainingBlockSize, trainingSet.size() - blockStart );
+                TrainingEntry const* pBlock = &trainingSet[blockStart];
+                threadPool.ParallelFor( numMembers, [&trainers, pBlock, blockSize] ( uint32_t memberIdx ) { trainers[memberIdx]->TrainEntries( pBlock, blockSize ); } );
+            }
+
+            trainingSetAccuracy = 0;
+            trainingSetMSE = 0;
+            for ( auto& pTrainer : trainers )
+            {
+                pTrainer->EndEpoch();
+                trainingSetAccuracy += pTrainer->GetTrainingSetAccuracy() / numMembers;
+                trainingSetMSE += pTrainer->GetTrainingSetMSE() / numMembers;
+            }
+
+            // Evaluate the combined ensemble
+            //-------------------------------------------------------------------------
+
+            PackWeights();
+            GetSetAccuracyAndMSE( trainingData.m_generalizationSet, generalizationSetAccuracy, generalizationSetMSE );
+
+            if ( pTelemetrySink != nullptr )
+            {
+                EpochTelemetry telemetry;
+                telemetry.m_epoch = epoch;
+                telemetry.m_trainingSetAccuracy = trainingSetAccuracy;
+                telemetry.m_trainingSetMSE = trainingSetMSE;
+                telemetry.m_generalizationSetAccuracy = generalizationSetAccuracy;
+                telemetry.m_generalizationSetMSE = generalizationSetMSE;
+                telemetry.m_epochTimeMS = std::chrono::duration<double, std::milli>( Clock::now() - epochStartTime ).count();
+                telemetry.m_samplesPerSecond = ( telemetry.m_epochTimeMS > 0 ) ? trainingSet.size() / ( telemetry.m_epochTimeMS / 1000.0 ) : 0.0;
+                telemetry.m_counters = Profiling::GetThreadCounters() - epochStartCounters;
+                pTelemetrySink->OnEpochComplete( telemetry );
+            }
+
+            epoch++;
+        }
+
+        if ( pTelemetrySink != nullptr )
+        {
+            TrainingCompleteTelemetry telemetry;
+            telemetry.m_numEpochs = epoch;
+            GetSetAccuracyAndMSE( trainingData.m_validationSet, telemetry.m_validationSetAccuracy, telemetry.m_validationSetMSE );
+            telemetry.m_totalTimeMS = std::chrono::duration<double, std::milli>( Clock::now() - trainingStartTime ).count();
+            telemetry.m_counters = Profiling::GetThreadCounters() - trainingStartCounters;
+            pTelemetrySink->OnTrainingComplete( telemetry );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    std::vector<int32_t> const& Ensemble::Evaluate( std::vector<double> const& input )
+    {
+        assert( input.size() == m_numInputs );
+        EvaluateBatch( input.data(), 1, m_outputs.data(), m_clampedOutputs.data(), m_hiddenScratch );
+        return m_clampedOutputs;
+    }
+
+    void Ensemble::EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs ) const
+    {
+        std::vector<double> hiddenScratch;
+        EvaluateBatch( pInputs, numEntries, pOutputs, pClampedOutputs, hiddenScratch );
+    }
+
+    void Ensemble::EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs, std::vector<double>& hiddenScratch ) const
+    {
+        BPN_PROFILE_SCOPE( Evaluate );
+
+        int32_t const numMembers = (int32_t) m_members.size();
+        int32_t const packedHiddenWidth = numMembers * m_numHidden;
+        hiddenScratch.resize( g_evaluationTileSize * packedHiddenWidth + m_numOutputs );
+
+        double* pMemberOutputs = &hiddenScratch[g_evaluationTileSize * packedHiddenWidth];
+        double const* pBiasWeights = &m_packedWeightsInputHidden[m_numInputs * packedHiddenWidth];
+
+        for ( uint32_t tileStart = 0; tileStart < numEntries; tileStart += g_evaluationTileSize )
+        {
+            uint32_t const tileSize = std::min( g_evaluationTileSize, numEntries - tileStart );
+
+            // Hidden layers of all members for all rows in the tile
+            //-------------------------------------------------------------------------
+
+            std::fill( hiddenScratch.begin(), hiddenScratch.begin() + tileSize * packedHiddenWidth, 0.0 );
+
+            for ( int32_t inputIdx = 0; inputIdx < m_numInputs; inputIdx++ )
+            {
+                double const* pWeights = &m_packedWeightsInputHidden[inputIdx * packedHiddenWidth];
+                for ( uint32_t rowIdx = 0; rowIdx < tileSize; rowIdx++ )
+                {
+                    double const inputValue = pInputs[( tileStart + rowIdx ) * m_numInputs + inputIdx];
+                    double* pHidden = &hiddenScratch[rowIdx * packedHiddenWidth];
+                    for ( int32_t packedIdx = 0; packedIdx < packedHiddenWidth; packedIdx++ )
+                    {
+                        pHidden[packedIdx] += inputValue * pWeights[packedIdx];
+                    }
+                }
+            }
+
+            for ( uint32_t rowIdx = 0; rowIdx < tileSize; rowIdx++ )
+            {
+                double* pHidden = &hiddenScratch[rowIdx * packedHiddenWidth];
+                for ( int32_t packedIdx = 0; packedIdx < packedHiddenWidth; packedIdx++ )
+                {
+                    pHidden[packedIdx] = Network::SigmoidActivationFunction( pHidden[packedIdx] + -1.0 * pBiasWeights[packedIdx] );
+                }
+            }
+
+            // Member outputs, combined before clamping
+            //-------------------------------------------------------------------------
+
+            for ( uint32_t rowIdx = 0; rowIdx < tileSize; rowIdx++ )
+            {
+                double const* pHidden = &hiddenScratch[rowIdx * packedHiddenWidth];
+                double* pRowOutputs = &pOutputs[( tileStart + rowIdx ) * m_numOutputs];
+                std::fill( pRowOutputs, pRowOutputs + m_numOutputs, 0.0 );
+
+                for ( int32_t memberIdx = 0; memberIdx < numMembers; memberIdx++ )
+                {
+                    double const* pMemberHidden = &pHidden[memberIdx * m_numHidden];
+                    double const* pMemberWeights = &m_packedWeightsHiddenOutput[memberIdx * ( m_numHidden + 1 ) * m_numOutputs];
+                    std::fill( pMemberOutputs, pMemberOutputs + m_numOutputs, 0.0 );
+
+                    for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+                    {
+                        for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+                        {
+                            pMemberOutputs[outputIdx] += pMemberHidden[hiddenIdx] * pMemberWeights[hiddenIdx * m_numOutputs + outputIdx];
+                        }
+                    }
+
+                    for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+                    {
+                        double const output = Network::SigmoidActivationFunction( pMemberOutputs[outputIdx] + -1.0 * pMemberWeights[m_numHidden * m_numOutputs + outputIdx] );
+                        pRowOutputs[outputIdx] += ( m_settings.m_combineMode == CombineMode::Average ) ? output : ( output > 0.5 ? 1.0 : 0.0 );
+                    }
+                }
+
+                for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+                {
+                    pRowOutputs[outputIdx] /= numMembers;
+                    pClampedOutputs[( tileStart + rowIdx ) * m_numOutputs + outputIdx] = ( m_settings.m_combineMode == CombineMode::Average ) ? Network::ClampOutputValue( pRowOutputs[outputIdx] ) : ClampVoteFraction( pRowOutputs[outputIdx] );
+                }
+            }
+        }
+    }
+
+    void Ensemble::GetSetAccuracyAndMSE( TrainingSet const& trainingSet, double& accuracy, double& mse ) const
+    {
+        BPN_PROFILE_SCOPE( SetEvaluation );
+
+        accuracy = 0;
+        mse = 0;
+        if ( trainingSet.empty() )
+        {
+            return;
+        }
+
+        // Evaluate the set in batches of contiguous rows
+        uint32_t const batchSize = 64;
+        std::vector<double> inputs( batchSize * m_numInputs );
+        std::vector<double> outputs( batchSize * m_numOutputs );
+        std::vector<int32_t> clampedOutputs( batchSize * m_numOutputs );
+        std::vector<double> hiddenScratch;
+
+        double numIncorrectResults = 0;
+        for ( size_t batchStart = 0; batchStart < trainingSet.size(); batchStart += batchSize )
+        {
+            uint32_t const numEntries = (uint32_t) std::min( (size_t) batchSize, trainingSet.size() - batchStart );
+            for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+            {
+                std::copy( trainingSet[batchStart + entryIdx].m_inputs.begin(), trainingSet[batchStart + entryIdx].m_inputs.end(), &inputs[entryIdx * m_numInputs] );
+            }
+
+            EvaluateBatch( inputs.data(), numEntries, outputs.data(), clampedOutputs.data(), hiddenScratch );
+
+            for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+            {
+                TrainingEntry const& trainingEntry = trainingSet[batchStart + entryIdx];
+
+                bool correctResult = true;
+                for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+                {
+                    if ( clampedOutputs[entryIdx * m_numOutputs + outputIdx] != trainingEntry.m_expectedOutputs[outputIdx] )
+                    {
+                        correctResult = false;
+                    }
+
+                    double const error = outputs[entryIdx * m_numOutputs + outputIdx] - trainingEntry.m_expectedOutputs[outputIdx];
+                    mse += error * error * trainingEntry.m_weight;
+                }
+
+                if ( !correctResult )
+                {
+                    numIncorrectResults += trainingEntry.m_weight;
+                }
+            }
+        }
+
+        size_t const totalWeight = GetTotalWeight( trainingSet );
+        accuracy = 100.0 - ( numIncorrectResults / totalWeight * 100.0 );
+        mse = mse / ( m_numOutputs * totalWeight );
+    }
+}
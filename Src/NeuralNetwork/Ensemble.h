@@ -0,0 +1,91 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Ensemble of independently initialized networks
+//
+// All members are trained concurrently over a single pass of the shared training data: each epoch is
+// split into blocks and every member trains on a block before the pass moves on, so the block is read
+// from memory once per epoch rather than once per member. For inference the member weights are packed
+// side by side so that a single kernel computes the hidden layers of all members at once. The member
+// outputs are combined (averaged or voted) before clamping. Averaged outputs are clamped like a single network's,
+// votes by majority.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <memory>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class Ensemble
+    {
+    public:
+
+        enum class CombineMode
+        {
+            Average,                                        // Mean of the member sigmoid outputs
+            Vote                                            // Fraction of members whose sigmoid output is above 0.5, clamped by majority (a tie is -1)
+        };
+
+        struct Settings
+        {
+            uint32_t                        m_numMembers = 5;
+            CombineMode                     m_combineMode = CombineMode::Average;
+            uint32_t                        m_numThreads = 0;           // 0 uses the hardware concurrency
+            uint32_t                        m_trainingBlockSize = 256;  // Entries each member trains on before the pass moves to the next block
+        };
+
+    public:
+
+        Ensemble( Settings const& settings, Network::Settings const& networkSettings );
+        ~Ensemble();
+
+        // Replaces the weights of a member, in the Network::GetWeights layout
+        void LoadMemberWeights( uint32_t memberIdx, std::vector<double> const& weights );
+
+        // Trains all members until the combined ensemble reaches the desired accuracy or the max number of epochs
+        void Train( NetworkTrainer::Settings const& trainerSettings, TrainingData const& trainingData );
+
+        std::vector<int32_t> const& Evaluate( std::vector<double> const& input );
+
+        // Evaluates numEntries contiguous input rows, writes numEntries * numOutputs combined outputs and clamped outputs
+        void EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs ) const;
+
+        void GetSetAccuracyAndMSE( TrainingSet const& trainingSet, double& accuracy, double& mse ) const;
+
+        inline uint32_t GetNumMembers() const { return (uint32_t) m_members.size(); }
+        inline Network const& GetMember( uint32_t memberIdx ) const { return *m_members[memberIdx]; }
+
+        // Combined (pre-clamp) outputs of the last evaluation
+        std::vector<double> const& GetOutputs() const { return m_outputs; }
+
+    private:
+
+        // Copies the member weights into the packed inference layout, must be called whenever the member weights change
+        void PackWeights();
+
+        void EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs, std::vector<double>& hiddenScratch ) const;
+
+    private:
+
+        Settings                                m_settings;
+        int32_t                                 m_numInputs;
+        int32_t                                 m_numHidden;
+        int32_t                                 m_numOutputs;
+        std::vector<std::unique_ptr<Network>>   m_members;
+
+        // [inputIdx][memberIdx * numHidden + hiddenIdx], bias row last
+        std::vector<double>                     m_packedWeightsInputHidden;
+
+        // [memberIdx][hiddenIdx][outputIdx], bias row last for each member
+        std::vector<double>                     m_packedWeightsHiddenOutput;
+
+        std::vector<double>                     m_outputs;
+        std::vector<int32_t>                    m_clampedOutputs;
+        std::vector<double>                     m_hiddenScratch;
+    };
+}
@@ -0,0 +1,224 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "FeatureNormalizer.h"
+#include "ThreadPool.h"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Entries per parallel chunk, the chunks are merged in order so the results don't depend on the thread count
+        uint32_t const g_entriesPerChunk = 4096;
+
+        struct FeatureStats
+        {
+            void Add( double value )
+            {
+                m_min = std::min( m_min, value );
+                m_max = std::max( m_max, value );
+
+                // Welford's online update
+                m_count++;
+                double const delta = value - m_mean;
+                m_mean += delta / m_count;
+                m_sumSquaredDeviations += delta * ( value - m_mean );
+            }
+
+            // Chan et al.'s pairwise combination of the running mean and variance
+            void Merge( FeatureStats const& other )
+            {
+                if ( other.m_count == 0 )
+                {
+                    return;
+                }
+
+                m_min = std::min( m_min, other.m_min );
+                m_max = std::max( m_max, other.m_max );
+
+                double const count = (double) m_count + other.m_count;
+                double const delta = other.m_mean - m_mean;
+                m_mean += delta * other.m_count / count;
+                m_sumSquaredDeviations += other.m_sumSquaredDeviations + delta * delta * m_count * other.m_count / count;
+                m_count += other.m_count;
+            }
+
+            double      m_min = std::numeric_limits<double>::max();
+            double      m_max = std::numeric_limits<double>::lowest();
+            double      m_mean = 0;
+            double      m_sumSquaredDeviations = 0;
+            uint64_t    m_count = 0;
+        };
+
+        uint32_t GetNumChunks( size_t numEntries )
+        {
+            return (uint32_t) ( ( numEntries + g_entriesPerChunk - 1 ) / g_entriesPerChunk );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    FeatureNormalizer::FeatureNormalizer( NormalizationType type, std::vector<double> const& scales, std::vector<double> const& offsets )
+        : m_type( type )
+        , m_scales( scales )
+        , m_offsets( offsets )
+    {
+        assert( m_scales.size() == m_offsets.size() );
+        assert( m_type != NormalizationType::None || m_scales.empty() );
+    }
+
+    FeatureNormalizer FeatureNormalizer::Compute( NormalizationType type, TrainingEntry const* pEntries, size_t numEntries, uint32_t numThreads )
+    {
+        if ( type == NormalizationType::None || numEntries == 0 )
+        {
+            return FeatureNormalizer();
+        }
+
+        // Gather the per-chunk stats in parallel and merge them
+        //-------------------------------------------------------------------------
+
+        size_t const numFeatures = pEntries[0].m_inputs.size();
+        uint32_t const numChunks = GetNumChunks( numEntries );
+        std::vector<std::vector<FeatureStats>> chunkStats( numChunks, std::vector<FeatureStats>( numFeatures ) );
+
+        ThreadPool threadPool( std::max( 1u, std::min( numThreads == 0 ? std::thread::hardware_concurrency() : numThreads, numChunks ) ) );
+        threadPool.ParallelFor( numChunks, [&] ( uint32_t chunkIdx )
+        {
+            std::vector<FeatureStats>& stats = chunkStats[chunkIdx];
+            size_t const chunkEnd = std::min( numEntries, ( (size_t) chunkIdx + 1 ) * g_entriesPerChunk );
+            for ( size_t entryIdx = (size_t) chunkIdx * g_entriesPerChunk; entryIdx < chunkEnd; entryIdx++ )
+            {
+                // The stats count every entry once, so they must be computed before duplicate rows are collapsed
+                assert( pEntries[entryIdx].m_weight == 1 );
+
+                for ( size_t featureIdx = 0; featureIdx < numFeatures; featureIdx++ )
+                {
+                    stats[featureIdx].Add( pEntries[entryIdx].m_inputs[featureIdx] );
+                }
+            }
+        } );
+
+        std::vector<FeatureStats>& stats = chunkStats[0];
+        for ( uint32_t chunkIdx = 1; chunkIdx < numChunks; chunkIdx++ )
+        {
+            for ( size_t featureIdx = 0; featureIdx < numFeatures; featureIdx++ )
+            {
+                stats[featureIdx].Merge( chunkStats[chunkIdx][featureIdx] );
+            }
+        }
+
+        // Derive the scales and offsets, constant features are only shifted to 0
+        //-------------------------------------------------------------------------
+
+        std::vector<double> scales( numFeatures, 1.0 );
+        std::vector<double> offsets( numFeatures, 0.0 );
+        for ( size_t featureIdx = 0; featureIdx < numFeatures; featureIdx++ )
+        {
+            FeatureStats const& featureStats = stats[featureIdx];
+            if ( type == NormalizationType::MinMax )
+            {
+                double const range = featureStats.m_max - featureStats.m_min;
+                scales[featureIdx] = ( range > 0 ) ? 1.0 / range : 1.0;
+                offsets[featureIdx] = -featureStats.m_min * scales[featureIdx];
+            }
+            else
+            {
+                double const standardDeviation = sqrt( featureStats.m_sumSquaredDeviations / featureStats.m_count );
+                scales[featureIdx] = ( standardDeviation > 0 ) ? 1.0 / standardDeviation : 1.0;
+                offsets[featureIdx] = -featureStats.m_mean * scales[featureIdx];
+            }
+        }
+
+        return FeatureNormalizer( type, scales, offsets );
+    }
+
+    //-------------------------------------------------------------------------
+
+    void FeatureNormalizer::Apply( std::vector<double>& inputs ) const
+    {
+        if ( IsIdentity() )
+        {
+            return;
+        }
+
+        assert( inputs.size() == m_scales.size() );
+        for ( size_t featureIdx = 0; featureIdx < inputs.size(); featureIdx++ )
+        {
+            inputs[featureIdx] = inputs[featureIdx] * m_scales[featureIdx] + m_offsets[featureIdx];
+        }
+    }
+
+    void FeatureNormalizer::Restore( std::vector<double>& inputs ) const
+    {
+        if ( IsIdentity() )
+        {
+            return;
+        }
+
+        assert( inputs.size() == m_scales.size() );
+        for ( size_t featureIdx = 0; featureIdx < inputs.size(); featureIdx++ )
+        {
+            inputs[featureIdx] = ( inputs[featureIdx] - m_offsets[featureIdx] ) / m_scales[featureIdx];
+        }
+    }
+
+    void FeatureNormalizer::Apply( TrainingSet& entries, uint32_t numThreads ) const
+    {
+        if ( IsIdentity() || entries.empty() )
+        {
+            return;
+        }
+
+        uint32_t const numChunks = GetNumChunks( entries.size() );
+        ThreadPool threadPool( std::max( 1u, std::min( numThreads == 0 ? std::thread::hardware_concurrency() : numThreads, numChunks ) ) );
+        threadPool.ParallelFor( numChunks, [&] ( uint32_t chunkIdx )
+        {
+            size_t const chunkEnd = std::min( entries.size(), ( (size_t) chunkIdx + 1 ) * g_entriesPerChunk );
+            for ( size_t entryIdx = (size_t) chunkIdx * g_entriesPerChunk; entryIdx < chunkEnd; entryIdx++ )
+            {
+                Apply( entries[entryIdx].m_inputs );
+            }
+        } );
+    }
+
+    Network FeatureNormalizer::FoldIntoNetwork( Network const& network ) const
+    {
+        Network::Settings settings;
+        settings.m_numInputs = network.GetNumInputs();
+        settings.m_numHidden = network.GetNumHidden();
+        settings.m_numOutputs = network.GetNumOutputs();
+
+        std::vector<double> weights = network.GetWeights();
+        if ( IsIdentity() )
+        {
+            return Network( settings, weights );
+        }
+
+        assert( m_scales.size() == settings.m_numInputs );
+
+        // sum( w * ( x * scale + offset ) ) - bias = sum( ( w * scale ) * x ) - ( bias - sum( w * offset ) )
+        uint32_t const numHidden = settings.m_numHidden;
+        for ( uint32_t hiddenIdx = 0; hiddenIdx < numHidden; hiddenIdx++ )
+        {
+            double& biasWeight = weights[settings.m_numInputs * numHidden + hiddenIdx];
+            for ( uint32_t inputIdx = 0; inputIdx < settings.m_numInputs; inputIdx++ )
+            {
+                double& weight = weights[inputIdx * numHidden + hiddenIdx];
+                biasWeight -= weight * m_offsets[inputIdx];
+                weight *= m_scales[inputIdx];
+            }
+        }
+
+        return Network( settings, weights );
+    }
+}
@@ -0,0 +1,64 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Per-feature input normalization
+//
+// Every input is mapped with x' = x * scale + offset, the scales and offsets are derived from per-feature
+// statistics gathered in a single parallel pass over the data (min-max to [0, 1] or z-score). Since the
+// mapping is affine it can be folded into the input->hidden weights, so a network trained on normalized
+// inputs can be exported or saved as a network that takes the raw inputs at no extra cost per row.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    enum class NormalizationType : uint32_t
+    {
+        None = 0,
+        MinMax,
+        ZScore
+    };
+
+    //-------------------------------------------------------------------------
+
+    class FeatureNormalizer
+    {
+    public:
+
+        // Identity normalization
+        FeatureNormalizer() = default;
+        FeatureNormalizer( NormalizationType type, std::vector<double> const& scales, std::vector<double> const& offsets );
+
+        // Computes the per-feature statistics over the entries in one parallel pass, a thread count of 0 uses the hardware concurrency
+        static FeatureNormalizer Compute( NormalizationType type, TrainingEntry const* pEntries, size_t numEntries, uint32_t numThreads = 0 );
+        static FeatureNormalizer Compute( NormalizationType type, TrainingSet const& entries, uint32_t numThreads = 0 ) { return Compute( type, entries.data(), entries.size(), numThreads ); }
+
+        inline NormalizationType GetType() const { return m_type; }
+        inline bool IsIdentity() const { return m_type == NormalizationType::None; }
+        inline std::vector<double> const& GetScales() const { return m_scales; }
+        inline std::vector<double> const& GetOffsets() const { return m_offsets; }
+
+        void Apply( std::vector<double>& inputs ) const;
+
+        // Maps normalized inputs back to the raw inputs (up to rounding)
+        void Restore( std::vector<double>& inputs ) const;
+
+        // Normalizes the inputs of all entries in parallel
+        void Apply( TrainingSet& entries, uint32_t numThreads = 0 ) const;
+
+        // Returns a copy of a network trained on normalized inputs that produces the same outputs from the raw inputs
+        Network FoldIntoNetwork( Network const& network ) const;
+
+    private:
+
+        NormalizationType               m_type = NormalizationType::None;
+        std::vector<double>             m_scales;
+        std::vector<double>             m_offsets;
+    };
+}
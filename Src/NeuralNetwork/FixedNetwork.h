@@ -0,0 +1,167 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Compile-time sized inference-only network
+//
+// The topology is fixed at compile time so all storage lives in std::arrays and all loop bounds are
+// constants. The input loop is explicitly unrolled and the inner loops run across contiguous weight
+// rows so the compiler can vectorize them. Evaluation is const and never touches the heap, so a single
+// instance can be shared between threads. Intended for small models, large layers will produce a lot
+// of code due to the unrolling.
+//
+// With Scalar = double the results are identical to Network::Evaluate as the accumulation order matches.
+
+#pragma once
+
+#include "NeuralNetwork.h"
+#include <assert.h>
+#include <array>
+#include <type_traits>
+#include <utility>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace FixedNetworkInternal
+    {
+        template<typename Function, size_t... Indices>
+        inline void UnrollImpl( Function&& function, std::index_sequence<Indices...> )
+        {
+            ( function( std::integral_constant<size_t, Indices>() ), ... );
+        }
+
+        // Calls function( std::integral_constant<size_t, N>() ) for N = [0, Count)
+        template<size_t Count, typename Function>
+        inline void Unroll( Function&& function )
+        {
+            UnrollImpl( std::forward<Function>( function ), std::make_index_sequence<Count>() );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    template<uint32_t NumInputs, uint32_t NumHidden, uint32_t NumOutputs, typename Scalar = double>
+    class FixedNetwork
+    {
+        static_assert( NumInputs > 0 && NumHidden > 0 && NumOutputs > 0, "Invalid network topology" );
+        static_assert( std::is_floating_point<Scalar>::value, "Scalar must be a floating point type" );
+
+        inline static Scalar SigmoidActivationFunction( Scalar x )
+        {
+            return Scalar( 1 ) / ( Scalar( 1 ) + std::exp( -x ) );
+        }
+
+        inline static int32_t ClampOutputValue( Scalar x )
+        {
+            if ( x < Scalar( 0.1 ) ) return 0;
+            else if ( x > Scalar( 0.9 ) ) return 1;
+            else return -1;
+        }
+
+    public:
+
+        // Weight layouts match the network: [inputIdx][hiddenIdx] and [hiddenIdx][outputIdx], bias neurons last
+        static constexpr uint32_t NumInputHiddenWeights = ( NumInputs + 1 ) * NumHidden;
+        static constexpr uint32_t NumHiddenOutputWeights = ( NumHidden + 1 ) * NumOutputs;
+
+        typedef std::array<Scalar, NumInputs>       InputArray;
+        typedef std::array<Scalar, NumOutputs>      OutputArray;
+        typedef std::array<int32_t, NumOutputs>     ClampedOutputArray;
+
+    public:
+
+        FixedNetwork()
+        {
+            m_weightsInputHidden.fill( 0 );
+            m_weightsHiddenOutput.fill( 0 );
+        }
+
+        explicit FixedNetwork( Network const& network )
+        {
+            assert( network.GetNumInputs() == NumInputs && network.GetNumHidden() == NumHidden && network.GetNumOutputs() == NumOutputs );
+
+            std::vector<double> const& weightsInputHidden = network.GetInputHiddenWeights();
+            for ( uint32_t weightIdx = 0; weightIdx < NumInputHiddenWeights; weightIdx++ )
+            {
+                m_weightsInputHidden[weightIdx] = (Scalar) weightsInputHidden[weightIdx];
+            }
+
+            std::vector<double> const& weightsHiddenOutput = network.GetHiddenOutputWeights();
+            for ( uint32_t weightIdx = 0; weightIdx < NumHiddenOutputWeights; weightIdx++ )
+            {
+                m_weightsHiddenOutput[weightIdx] = (Scalar) weightsHiddenOutput[weightIdx];
+            }
+        }
+
+        inline ClampedOutputArray Evaluate( InputArray const& input ) const
+        {
+            OutputArray outputs;
+            return Evaluate( input, outputs );
+        }
+
+        // Evaluate the network, returns the clamped outputs and fills in the raw (sigmoid) outputs
+        ClampedOutputArray Evaluate( InputArray const& input, OutputArray& outputs ) const
+        {
+            // Hidden layer - accumulate one input row at a time across all hidden neurons
+            //-------------------------------------------------------------------------
+
+            std::array<Scalar, NumHidden> hidden;
+            hidden.fill( 0 );
+
+            FixedNetworkInternal::Unroll<NumInputs>( [&] ( auto inputIdx )
+            {
+                Scalar const inputValue = input[inputIdx];
+                Scalar const* pWeights = &m_weightsInputHidden[inputIdx * NumHidden];
+                for ( uint32_t hiddenIdx = 0; hiddenIdx < NumHidden; hiddenIdx++ )
+                {
+                    hidden[hiddenIdx] += inputValue * pWeights[hiddenIdx];
+                }
+            } );
+
+            // Bias neuron and activation function
+            Scalar const* pInputBiasWeights = &m_weightsInputHidden[NumInputs * NumHidden];
+            for ( uint32_t hiddenIdx = 0; hiddenIdx < NumHidden; hiddenIdx++ )
+            {
+                hidden[hiddenIdx] += Scalar( -1 ) * pInputBiasWeights[hiddenIdx];
+                hidden[hiddenIdx] = SigmoidActivationFunction( hidden[hiddenIdx] );
+            }
+
+            // Output layer
+            //-------------------------------------------------------------------------
+
+            outputs.fill( 0 );
+
+            FixedNetworkInternal::Unroll<NumHidden>( [&] ( auto hiddenIdx )
+            {
+                Scalar const hiddenValue = hidden[hiddenIdx];
+                Scalar const* pWeights = &m_weightsHiddenOutput[hiddenIdx * NumOutputs];
+                for ( uint32_t outputIdx = 0; outputIdx < NumOutputs; outputIdx++ )
+                {
+                    outputs[outputIdx] += hiddenValue * pWeights[outputIdx];
+                }
+            } );
+
+            ClampedOutputArray clampedOutputs;
+            Scalar const* pHiddenBiasWeights = &m_weightsHiddenOutput[NumHidden * NumOutputs];
+            for ( uint32_t outputIdx = 0; outputIdx < NumOutputs; outputIdx++ )
+            {
+                outputs[outputIdx] += Scalar( -1 ) * pHiddenBiasWeights[outputIdx];
+                outputs[outputIdx] = SigmoidActivationFunction( outputs[outputIdx] );
+                clampedOutputs[outputIdx] = ClampOutputValue( outputs[outputIdx] );
+            }
+
+            return clampedOutputs;
+        }
+
+        std::array<Scalar, NumInputHiddenWeights> const& GetInputHiddenWeights() const { return m_weightsInputHidden; }
+        std::array<Scalar, NumHiddenOutputWeights> const& GetHiddenOutputWeights() const { return m_weightsHiddenOutput; }
+
+    private:
+
+        alignas( 64 ) std::array<Scalar, NumInputHiddenWeights>     m_weightsInputHidden;
+        alignas( 64 ) std::array<Scalar, NumHiddenOutputWeights>    m_weightsHiddenOutput;
+    };
+}
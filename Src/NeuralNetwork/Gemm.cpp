@@ -0,0 +1,287 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "Gemm.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#if BPN_ENABLE_BLAS
+#include <cblas.h>
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace Gemm
+    {
+        namespace
+        {
+            // Register block of C computed by the micro-kernel (sized to fit the accumulators in the 16 vector
+            // registers), and the panel sizes that keep the packed A block in L2 and each packed B panel in L1
+            // while it is swept over the A block
+            constexpr uint32_t g_blockRows = 4;
+            #if __AVX__
+            constexpr uint32_t g_blockColumns = 8;
+            #else
+            constexpr uint32_t g_blockColumns = 4;
+            #endif
+            constexpr uint32_t g_panelRows = 64;
+            constexpr uint32_t g_panelDepth = 256;
+            constexpr uint32_t g_panelColumns = 256;
+
+            std::atomic<Backend> g_backend( Backend::MicroKernel );
+
+            inline double GetElement( double const* pMatrix, uint32_t ld, bool transpose, uint32_t row, uint32_t column )
+            {
+                return transpose ? pMatrix[(size_t) column * ld + row] : pMatrix[(size_t) row * ld + column];
+            }
+
+            void ScaleC( uint32_t M, uint32_t N, double beta, double* pC, uint32_t ldc )
+            {
+                for ( uint32_t rowIdx = 0; rowIdx < M; rowIdx++ )
+                {
+                    double* pRow = &pC[(size_t) rowIdx * ldc];
+                    if ( beta == 0.0 )
+                    {
+                        memset( pRow, 0, N * sizeof( double ) );
+                    }
+                    else
+                    {
+                        for ( uint32_t columnIdx = 0; columnIdx < N; columnIdx++ )
+                        {
+                            pRow[columnIdx] *= beta;
+                        }
+                    }
+                }
+            }
+
+            //-------------------------------------------------------------------------
+
+            void MultiplyReference( bool transposeA, bool transposeB, uint32_t M, uint32_t N, uint32_t K, double alpha, double const* pA, uint32_t lda, double const* pB, uint32_t ldb, double* pC, uint32_t ldc )
+            {
+                for ( uint32_t rowIdx = 0; rowIdx < M; rowIdx++ )
+                {
+                    for ( uint32_t columnIdx = 0; columnIdx < N; columnIdx++ )
+                    {
+                        double sum = pC[(size_t) rowIdx * ldc + columnIdx];
+                        for ( uint32_t depthIdx = 0; depthIdx < K; depthIdx++ )
+                        {
+                            sum += ( alpha * GetElement( pA, lda, transposeA, rowIdx, depthIdx ) ) * GetElement( pB, ldb, transposeB, depthIdx, columnIdx );
+                        }
+                        pC[(size_t) rowIdx * ldc + columnIdx] = sum;
+                    }
+                }
+            }
+
+            //-------------------------------------------------------------------------
+
+            // A block is stored as consecutive panels of g_blockRows rows, each panel depth-major and scaled by alpha
+            void PackA( bool transposeA, double const* pA, uint32_t lda, uint32_t rowStart, uint32_t numRows, uint32_t depthStart, uint32_t depth, double alpha, double* pPacked )
+            {
+                for ( uint32_t panelStart = 0; panelStart < numRows; panelStart += g_blockRows )
+                {
+                    uint32_t const numPanelRows = std::min( g_blockRows, numRows - panelStart );
+                    for ( uint32_t depthIdx = 0; depthIdx < depth; depthIdx++ )
+                    {
+                        for ( uint32_t rowIdx = 0; rowIdx < g_blockRows; rowIdx++ )
+                        {
+                            *pPacked++ = ( rowIdx < numPanelRows ) ? alpha * GetElement( pA, lda, transposeA, rowStart + panelStart + rowIdx, depthStart + depthIdx ) : 0.0;
+                        }
+                    }
+                }
+            }
+
+            // B block is stored as consecutive panels of g_blockColumns columns, each panel depth-major
+            void PackB( bool transposeB, double const* pB, uint32_t ldb, uint32_t depthStart, uint32_t depth, uint32_t columnStart, uint32_t numColumns, double* pPacked )
+            {
+                for ( uint32_t panelStart = 0; panelStart < numColumns; panelStart += g_blockColumns )
+                {
+                    uint32_t const numPanelColumns = std::min( g_blockColumns, numColumns - panelStart );
+                    for ( uint32_t depthIdx = 0; depthIdx < depth; depthIdx++ )
+                    {
+                        if ( !transposeB && numPanelColumns == g_blockColumns )
+                        {
+                            memcpy( pPacked, &pB[(size_t) ( depthStart + depthIdx ) * ldb + columnStart + panelStart], g_blockColumns * sizeof( double ) );
+                            pPacked += g_blockColumns;
+                            continue;
+                        }
+
+                        for ( uint32_t columnIdx = 0; columnIdx < g_blockColumns; columnIdx++ )
+                        {
+                            *pPacked++ = ( columnIdx < numPanelColumns ) ? GetElement( pB, ldb, transposeB, depthStart + depthIdx, columnStart + panelStart + columnIdx ) : 0.0;
+                        }
+                    }
+                }
+            }
+
+            // Accumulates a g_blockRows x g_blockColumns block of C in registers, every element is summed over the depth in order
+            void MicroKernel( uint32_t depth, double const* pPackedA, double const* pPackedB, double* pC, uint32_t ldc, uint32_t numRows, uint32_t numColumns )
+            {
+                double accumulators[g_blockRows][g_blockColumns];
+                for ( uint32_t rowIdx = 0; rowIdx < g_blockRows; rowIdx++ )
+                {
+                    for ( uint32_t columnIdx = 0; columnIdx < g_blockColumns; columnIdx++ )
+                    {
+                        accumulators[rowIdx][columnIdx] = ( rowIdx < numRows && columnIdx < numColumns ) ? pC[(size_t) rowIdx * ldc + columnIdx] : 0.0;
+                    }
+                }
+
+                for ( uint32_t depthIdx = 0; depthIdx < depth; depthIdx++ )
+                {
+                    double const* pColumnValues = &pPackedB[depthIdx * g_blockColumns];
+                    for ( uint32_t rowIdx = 0; rowIdx < g_blockRows; rowIdx++ )
+                    {
+                        double const rowValue = pPackedA[depthIdx * g_blockRows + rowIdx];
+                        for ( uint32_t columnIdx = 0; columnIdx < g_blockColumns; columnIdx++ )
+                        {
+                            accumulators[rowIdx][columnIdx] += rowValue * pColumnValues[columnIdx];
+                        }
+                    }
+                }
+
+                for ( uint32_t rowIdx = 0; rowIdx < numRows; rowIdx++ )
+                {
+                    for ( uint32_t columnIdx = 0; columnIdx < numColumns; columnIdx++ )
+                    {
+                        pC[(size_t) rowIdx * ldc + columnIdx] = accumulators[rowIdx][columnIdx];
+                    }
+                }
+            }
+
+            // C is accumulated in place one depth panel at a time, which keeps the per-element summation order
+            void MultiplyMicroKernel( bool transposeA, bool transposeB, uint32_t M, uint32_t N, uint32_t K, double alpha, double const* pA, uint32_t lda, double const* pB, uint32_t ldb, double* pC, uint32_t ldc )
+            {
+                thread_local std::vector<double> packedA;
+                thread_local std::vector<double> packedB;
+                packedA.resize( (size_t) g_panelDepth * ( ( g_panelRows + g_blockRows - 1 ) / g_blockRows * g_blockRows ) );
+                packedB.resize( (size_t) g_panelDepth * ( ( g_panelColumns + g_blockColumns - 1 ) / g_blockColumns * g_blockColumns ) );
+
+                for ( uint32_t columnStart = 0; columnStart < N; columnStart += g_panelColumns )
+                {
+                    uint32_t const numColumns = std::min( g_panelColumns, N - columnStart );
+                    for ( uint32_t depthStart = 0; depthStart < K; depthStart += g_panelDepth )
+                    {
+                        uint32_t const depth = std::min( g_panelDepth, K - depthStart );
+                        PackB( transposeB, pB, ldb, depthStart, depth, columnStart, numColumns, packedB.data() );
+
+                        for ( uint32_t rowStart = 0; rowStart < M; rowStart += g_panelRows )
+                        {
+                            uint32_t const numRows = std::min( g_panelRows, M - rowStart );
+                            PackA( transposeA, pA, lda, rowStart, numRows, depthStart, depth, alpha, packedA.data() );
+
+                            for ( uint32_t blockColumnStart = 0; blockColumnStart < numColumns; blockColumnStart += g_blockColumns )
+                            {
+                                for ( uint32_t blockRowStart = 0; blockRowStart < numRows; blockRowStart += g_blockRows )
+                                {
+                                    double* pBlockC = &pC[(size_t) ( rowStart + blockRowStart ) * ldc + columnStart + blockColumnStart];
+                                    MicroKernel( depth, &packedA[(size_t) blockRowStart * depth], &packedB[(size_t) blockColumnStart * depth], pBlockC, ldc, std::min( g_blockRows, numRows - blockRowStart ), std::min( g_blockColumns, numColumns - blockColumnStart ) );
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        char const* GetBackendName( Backend backend )
+        {
+            switch ( backend )
+            {
+                case Backend::Reference: return "reference";
+                case Backend::MicroKernel: return "kernel";
+                case Backend::Blas: return "blas";
+            }
+
+            return "unknown";
+        }
+
+        bool ParseBackendName( char const* pName, Backend& backend )
+        {
+            for ( Backend candidate : { Backend::Reference, Backend::MicroKernel, Backend::Blas } )
+            {
+                if ( strcmp( pName, GetBackendName( candidate ) ) == 0 )
+                {
+                    backend = candidate;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool IsBackendAvailable( Backend backend )
+        {
+            #if BPN_ENABLE_BLAS
+            return true;
+            #else
+            return backend != Backend::Blas;
+            #endif
+        }
+
+        bool SetBackend( Backend backend )
+        {
+            if ( !IsBackendAvailable( backend ) )
+            {
+                return false;
+            }
+
+            g_backend.store( backend, std::memory_order_relaxed );
+            return true;
+        }
+
+        Backend GetBackend()
+        {
+            return g_backend.load( std::memory_order_relaxed );
+        }
+
+        void Multiply( bool transposeA, bool transposeB, uint32_t M, uint32_t N, uint32_t K, double alpha, double const* pA, uint32_t lda, double const* pB, uint32_t ldb, double beta, double* pC, uint32_t ldc )
+        {
+            Multiply( GetBackend(), transposeA, transposeB, M, N, K, alpha, pA, lda, pB, ldb, beta, pC, ldc );
+        }
+
+        void Multiply( Backend backend, bool transposeA, bool transposeB, uint32_t M, uint32_t N, uint32_t K, double alpha, double const* pA, uint32_t lda, double const* pB, uint32_t ldb, double beta, double* pC, uint32_t ldc )
+        {
+            assert( IsBackendAvailable( backend ) );
+            if ( M == 0 || N == 0 )
+            {
+                return;
+            }
+
+            #if BPN_ENABLE_BLAS
+            if ( backend == Backend::Blas )
+            {
+                cblas_dgemm( CblasRowMajor, transposeA ? CblasTrans : CblasNoTrans, transposeB ? CblasTrans : CblasNoTrans, (int) M, (int) N, (int) K, alpha, pA, (int) lda, pB, (int) ldb, beta, pC, (int) ldc );
+                return;
+            }
+            #endif
+
+            if ( beta != 1.0 )
+            {
+                ScaleC( M, N, beta, pC, ldc );
+            }
+
+            if ( K == 0 || alpha == 0.0 )
+            {
+                return;
+            }
+
+            if ( backend == Backend::Reference )
+            {
+                MultiplyReference( transposeA, transposeB, M, N, K, alpha, pA, lda, pB, ldb, pC, ldc );
+            }
+            else
+            {
+                MultiplyMicroKernel( transposeA, transposeB, M, N, K, alpha, pA, lda, pB, ldb, pC, ldc );
+            }
+        }
+    }
+}
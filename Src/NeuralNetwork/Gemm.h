@@ -0,0 +1,44 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Dense matrix multiplication used by the batch evaluation and training paths
+//
+// C = alpha * op( A ) * op( B ) + beta * C for row-major matrices, op() optionally transposing its matrix.
+// The built-in backends accumulate each element of C over K strictly in order, so that a multiplication
+// with alpha = 1 and beta = 0 gives bit-identical results to a plain dot product loop; the batch kernels
+// rely on this to match Network::Evaluate exactly. The BLAS backend is only available when built with
+// BPN_ENABLE_BLAS (the NN_BLAS CMake option) and does not preserve the summation order.
+
+#pragma once
+
+#include <stdint.h>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace Gemm
+    {
+        enum class Backend : uint32_t
+        {
+            Reference = 0,      // Naive triple loop
+            MicroKernel,        // Packed panels and a register-blocked kernel
+            Blas,               // cblas_dgemm from the linked BLAS library
+        };
+
+        char const* GetBackendName( Backend backend );
+        bool ParseBackendName( char const* pName, Backend& backend );
+        bool IsBackendAvailable( Backend backend );
+
+        // Process wide backend selection, the default is the micro-kernel. Returns false if the backend isn't available.
+        bool SetBackend( Backend backend );
+        Backend GetBackend();
+
+        void Multiply( bool transposeA, bool transposeB, uint32_t M, uint32_t N, uint32_t K, double alpha, double const* pA, uint32_t lda, double const* pB, uint32_t ldb, double beta, double* pC, uint32_t ldc );
+
+        // Explicit backend, for benchmarks and comparisons
+        void Multiply( Backend backend, bool transposeA, bool transposeB, uint32_t M, uint32_t N, uint32_t K, double alpha, double const* pA, uint32_t lda, double const* pB, uint32_t ldb, double beta, double* pC, uint32_t ldc );
+    }
+}
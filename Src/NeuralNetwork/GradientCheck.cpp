@@ -0,0 +1,455 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "GradientCheck.h"
+#include "Ensemble.h"
+#include "IncrementalEvaluator.h"
+#include "PredictionCache.h"
+#include "RowDeduplicator.h"
+#include "SparseNetwork.h"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Relative error, values smaller than the floor are compared absolutely so that tiny gradients don't fail on rounding noise
+        double GetRelativeError( double a, double b, double floor )
+        {
+            return fabs( a - b ) / std::max( fabs( a ) + fabs( b ), floor );
+        }
+
+        void AddError( GradientChecker::Result& result, double error, double tolerance, uint32_t idx )
+        {
+            if ( error > result.m_maxError || result.m_numChecked == 0 )
+            {
+                result.m_maxError = error;
+                result.m_worstIdx = idx;
+            }
+
+            if ( !( error <= tolerance ) )
+            {
+                result.m_numFailures++;
+            }
+
+            result.m_numChecked++;
+        }
+
+        NetworkTrainer::Settings GetTrainerSettings( GradientChecker::Settings const& settings, bool useBatchLearning )
+        {
+            NetworkTrainer::Settings trainerSettings;
+            trainerSettings.m_learningRate = settings.m_learningRate;
+            trainerSettings.m_momentum = 0.0;
+            trainerSettings.m_useBatchLearning = useBatchLearning;
+            return trainerSettings;
+        }
+
+        double GetError( Network& network, TrainingEntry const* pEntries, size_t numEntries )
+        {
+            double error = 0;
+            for ( size_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+            {
+                network.Evaluate( pEntries[entryIdx].m_inputs );
+                std::vector<double> const& outputs = network.GetOutputs();
+                for ( size_t outputIdx = 0; outputIdx < outputs.size(); outputIdx++ )
+                {
+                    double const outputError = pEntries[entryIdx].m_expectedOutputs[outputIdx] - outputs[outputIdx];
+                    error += 0.5 * outputError * outputError;
+                }
+            }
+
+            return error;
+        }
+
+        void CompareWeights( GradientChecker::Settings const& settings, std::vector<double> const& weights, std::vector<double> const& expectedWeights, GradientChecker::Result& result )
+        {
+            assert( weights.size() == expectedWeights.size() );
+            for ( size_t weightIdx = 0; weightIdx < weights.size(); weightIdx++ )
+            {
+                AddError( result, GetRelativeError( weights[weightIdx], expectedWeights[weightIdx], 1e-8 ), settings.m_updateTolerance, (uint32_t) weightIdx );
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    GradientChecker::Result GradientChecker::CheckGradient( Settings const& settings, Network const& network, TrainingEntry const* pEntries, size_t numEntries )
+    {
+        assert( numEntries > 0 );
+
+        Network trainedNetwork( network );
+        NetworkTrainer trainer( GetTrainerSettings( settings, true ), &trainedNetwork );
+        std::vector<double> gradient;
+        trainer.GetErrorGradient( pEntries, numEntries, gradient );
+
+        // Central differences, one weight at a time
+        //-------------------------------------------------------------------------
+
+        Network perturbedNetwork( network );
+        size_t const numInputHiddenWeights = ( (size_t) network.m_numInputs + 1 ) * network.m_numHidden;
+        assert( gradient.size() == numInputHiddenWeights + ( (size_t) network.m_numHidden + 1 ) * network.m_numOutputs );
+
+        Result result;
+        for ( size_t weightIdx = 0; weightIdx < gradient.size(); weightIdx++ )
+        {
+            double& weight = ( weightIdx < numInputHiddenWeights ) ? perturbedNetwork.m_weightsInputHidden[weightIdx] : perturbedNetwork.m_weightsHiddenOutput[weightIdx - numInputHiddenWeights];
+            double const originalWeight = weight;
+
+            weight = originalWeight + settings.m_epsilon;
+            double const errorPlus = GetError( perturbedNetwork, pEntries, numEntries );
+            weight = originalWeight - settings.m_epsilon;
+            double const errorMinus = GetError( perturbedNetwork, pEntries, numEntries );
+            weight = originalWeight;
+
+            double const numericalGradient = ( errorPlus - errorMinus ) / ( 2 * settings.m_epsilon );
+            AddError( result, GetRelativeError( gradient[weightIdx], numericalGradient, 1e-4 ), settings.m_gradientTolerance, (uint32_t) weightIdx );
+        }
+
+        return result;
+    }
+
+    GradientChecker::Result GradientChecker::CheckStochasticUpdate( Settings const& settings, Network const& network, TrainingEntry const* pEntries, size_t numEntries )
+    {
+        Network trainedNetwork( network );
+        NetworkTrainer trainer( GetTrainerSettings( settings, false ), &trainedNetwork );
+
+        Result result;
+        std::vector<double> gradient;
+        for ( size_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            trainer.GetErrorGradient( &pEntries[entryIdx], 1, gradient );
+            std::vector<double> expectedWeights = trainedNetwork.GetWeights();
+            for ( size_t weightIdx = 0; weightIdx < expectedWeights.size(); weightIdx++ )
+            {
+                expectedWeights[weightIdx] -= settings.m_learningRate * gradient[weightIdx];
+            }
+
+            double sumSquaredError = 0;
+            trainer.TrainSample( pEntries[entryIdx], sumSquaredError );
+            CompareWeights( settings, trainedNetwork.GetWeights(), expectedWeights, result );
+        }
+
+        return result;
+    }
+
+    GradientChecker::Result GradientChecker::CheckBatchUpdate( Settings const& settings, Network const& network, TrainingSet const& entries )
+    {
+        Network trainedNetwork( network );
+        NetworkTrainer trainer( GetTrainerSettings( settings, true ), &trainedNetwork );
+
+        // Two epochs, the second one catches deltas that aren't cleared after a batch update
+        Result result;
+        std::vector<double> gradient;
+        for ( uint32_t epochIdx = 0; epochIdx < 2; epochIdx++ )
+        {
+            trainer.GetErrorGradient( entries.data(), entries.size(), gradient );
+            std::vector<double> expectedWeights = trainedNetwork.GetWeights();
+            for ( size_t weightIdx = 0; weightIdx < expectedWeights.size(); weightIdx++ )
+            {
+                expectedWeights[weightIdx] -= settings.m_learningRate * gradient[weightIdx];
+            }
+
+            trainer.RunEpoch( entries );
+            CompareWeights( settings, trainedNetwork.GetWeights(), expectedWeights, result );
+        }
+
+        return result;
+    }
+
+    GradientChecker::Result GradientChecker::CheckEvaluation( Settings const& settings, Network const& network, TrainingSet const& entries )
+    {
+        assert( !entries.empty() );
+
+        uint32_t const numEntries = (uint32_t) entries.size();
+
+        // Reference outputs
+        //-------------------------------------------------------------------------
+
+        Network referenceNetwork( network );
+        std::vector<double> inputs;
+        std::vector<double> referenceOutputs;
+        std::vector<int32_t> referenceClampedOutputs;
+        inputs.reserve( (size_t) numEntries * network.GetNumInputs() );
+        for ( auto const& entry : entries )
+        {
+            inputs.insert( inputs.end(), entry.m_inputs.begin(), entry.m_inputs.end() );
+            std::vector<int32_t> const& clampedOutputs = referenceNetwork.Evaluate( entry.m_inputs );
+            referenceOutputs.insert( referenceOutputs.end(), referenceNetwork.GetOutputs().begin(), referenceNetwork.GetOutputs().end() );
+            referenceClampedOutputs.insert( referenceClampedOutputs.end(), clampedOutputs.begin(), clampedOutputs.end() );
+        }
+
+        // Batch and sparse paths, identical outputs must also be clamped identically
+        //-------------------------------------------------------------------------
+
+        Result result;
+        std::vector<double> outputs( referenceOutputs.size() );
+        std::vector<int32_t> clampedOutputs( referenceOutputs.size() );
+        auto CompareOutputs = [&] ()
+        {
+            for ( size_t valueIdx = 0; valueIdx < outputs.size(); valueIdx++ )
+            {
+                AddError( result, fabs( outputs[valueIdx] - referenceOutputs[valueIdx] ), settings.m_evaluationTolerance, (uint32_t) valueIdx );
+                if ( outputs[valueIdx] == referenceOutputs[valueIdx] && clampedOutputs[valueIdx] != referenceClampedOutputs[valueIdx] )
+                {
+                    result.m_numFailures++;
+                }
+            }
+        };
+
+        network.EvaluateBatch( inputs.data(), numEntries, outputs.data(), clampedOutputs.data() );
+        CompareOutputs();
+
+        for ( SparseNetwork::Format format : { SparseNetwork::Format::CSR, SparseNetwork::Format::BlockSparse } )
+        {
+            SparseNetwork const sparseNetwork( network, format );
+            sparseNetwork.EvaluateBatch( inputs.data(), numEntries, outputs.data(), clampedOutputs.data() );
+            CompareOutputs();
+        }
+
+        return result;
+    }
+
+    GradientChecker::Result GradientChecker::CheckIncrementalEvaluation( Settings const& settings, Network const& network, TrainingSet const& entries )
+    {
+        assert( !entries.empty() );
+
+        Result result;
+        Network referenceNetwork( network );
+        IncrementalEvaluator evaluator( IncrementalEvaluator::Settings(), network );
+        uint32_t valueIdx = 0;
+        auto CompareOutputs = [&] ( double tolerance )
+        {
+            std::vector<int32_t> const& referenceClampedOutputs = referenceNetwork.Evaluate( evaluator.GetInputs() );
+            std::vector<double> const& referenceOutputs = referenceNetwork.GetOutputs();
+            for ( size_t outputIdx = 0; outputIdx < referenceOutputs.size(); outputIdx++, valueIdx++ )
+            {
+                double const output = evaluator.GetOutputs()[outputIdx];
+                AddError( result, fabs( output - referenceOutputs[outputIdx] ), tolerance, valueIdx );
+                if ( output == referenceOutputs[outputIdx] && evaluator.GetClampedOutputs()[outputIdx] != referenceClampedOutputs[outputIdx] )
+                {
+                    result.m_numFailures++;
+                }
+            }
+        };
+
+        // A full evaluation must match exactly, the updates up to rounding
+        //-------------------------------------------------------------------------
+
+        evaluator.Evaluate( entries[0].m_inputs );
+        CompareOutputs( settings.m_evaluationTolerance );
+
+        std::vector<IncrementalEvaluator::InputChange> changes;
+        for ( size_t entryIdx = 1; entryIdx < entries.size(); entryIdx++ )
+        {
+            std::vector<double> const& inputs = entries[entryIdx].m_inputs;
+            for ( uint32_t inputIdx = 0; inputIdx < (uint32_t) inputs.size(); inputIdx++ )
+            {
+                if ( inputs[inputIdx] != evaluator.GetInputs()[inputIdx] )
+                {
+                    changes.push_back( { inputIdx, inputs[inputIdx] } );
+                }
+
+                if ( changes.size() == 2 || ( inputIdx == inputs.size() - 1 && !changes.empty() ) )
+                {
+                    evaluator.Update( changes );
+                    CompareOutputs( settings.m_incrementalTolerance );
+                    changes.clear();
+                }
+            }
+        }
+
+        return result;
+    }
+
+    //-------------------------------------------------------------------------
+
+    GradientChecker::Result GradientChecker::CheckEnsembleVote( Settings const& settings, Network const& network, TrainingSet const& entries )
+    {
+        assert( !entries.empty() );
+
+        uint32_t const numInputs = network.GetNumInputs();
+        uint32_t const numHidden = network.GetNumHidden();
+        uint32_t const numOutputs = network.GetNumOutputs();
+        uint32_t const numEntries = (uint32_t) std::min( entries.size(), (size_t) 16 );
+
+        std::vector<double> inputs;
+        for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            inputs.insert( inputs.end(), entries[entryIdx].m_inputs.begin(), entries[entryIdx].m_inputs.end() );
+        }
+
+        // Members with only output bias weights have constant outputs, sigmoid( 5 ) votes 1 and sigmoid( -5 ) votes 0
+        size_t const numInputHiddenWeights = ( (size_t) numInputs + 1 ) * numHidden;
+        size_t const outputBiasOffset = numInputHiddenWeights + (size_t) numHidden * numOutputs;
+        std::vector<double> weights( numInputHiddenWeights + ( (size_t) numHidden + 1 ) * numOutputs );
+
+        Result result;
+        std::vector<double> outputs( (size_t) numEntries * numOutputs );
+        std::vector<int32_t> clampedOutputs( outputs.size() );
+        for ( uint32_t numMembers : { 4u, 5u } )
+        {
+            Ensemble::Settings ensembleSettings;
+            ensembleSettings.m_numMembers = numMembers;
+            ensembleSettings.m_combineMode = Ensemble::CombineMode::Vote;
+            Ensemble ensemble( ensembleSettings, Network::Settings{ numInputs, numHidden, numOutputs } );
+
+            for ( uint32_t numVotes = 0; numVotes <= numMembers; numVotes++ )
+            {
+                for ( uint32_t memberIdx = 0; memberIdx < numMembers; memberIdx++ )
+                {
+                    std::fill( weights.begin() + outputBiasOffset, weights.end(), ( memberIdx < numVotes ) ? -5.0 : 5.0 );
+                    ensemble.LoadMemberWeights( memberIdx, weights );
+                }
+
+                ensemble.EvaluateBatch( inputs.data(), numEntries, outputs.data(), clampedOutputs.data() );
+
+                double const voteFraction = (double) numVotes / numMembers;
+                int32_t const expectedClampedOutput = ( 2 * numVotes > numMembers ) ? 1 : ( ( 2 * numVotes < numMembers ) ? 0 : -1 );
+                for ( size_t valueIdx = 0; valueIdx < outputs.size(); valueIdx++ )
+                {
+                    AddError( result, fabs( outputs[valueIdx] - voteFraction ), settings.m_evaluationTolerance, numVotes );
+                    if ( clampedOutputs[valueIdx] != expectedClampedOutput )
+                    {
+                        result.m_numFailures++;
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    GradientChecker::Result GradientChecker::CheckCollapsedGradient( Settings const& settings, Network const& network, TrainingEntry const* pEntries, size_t numEntries )
+    {
+        assert( numEntries > 0 );
+
+        // Entry i is repeated 1 + i % 4 times, interleaved so that the copies aren't adjacent
+        TrainingSet fullEntries;
+        for ( size_t copyIdx = 0; copyIdx < 4; copyIdx++ )
+        {
+            for ( size_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+            {
+                if ( copyIdx <= entryIdx % 4 )
+                {
+                    fullEntries.push_back( pEntries[entryIdx] );
+                }
+            }
+        }
+
+        TrainingSet collapsedEntries;
+        RowDeduplicator::Collapse( fullEntries, collapsedEntries, 1 );
+
+        Network trainedNetwork( network );
+        NetworkTrainer trainer( GetTrainerSettings( settings, true ), &trainedNetwork );
+
+        std::vector<double> fullGradient;
+        std::vector<double> collapsedGradient;
+        trainer.GetErrorGradient( fullEntries.data(), fullEntries.size(), fullGradient );
+        trainer.GetErrorGradient( collapsedEntries.data(), collapsedEntries.size(), collapsedGradient );
+
+        Result result;
+        for ( size_t weightIdx = 0; weightIdx < fullGradient.size(); weightIdx++ )
+        {
+            AddError( result, GetRelativeError( fullGradient[weightIdx], collapsedGradient[weightIdx], 1e-8 ), settings.m_updateTolerance, (uint32_t) weightIdx );
+        }
+
+        // The set statistics are normalized by the total weight, indexed after the weights
+        double fullAccuracy = 0;
+        double fullMSE = 0;
+        double collapsedAccuracy = 0;
+        double collapsedMSE = 0;
+        trainer.GetSetAccuracyAndMSE( fullEntries, fullAccuracy, fullMSE );
+        trainer.GetSetAccuracyAndMSE( collapsedEntries, collapsedAccuracy, collapsedMSE );
+        AddError( result, GetRelativeError( fullAccuracy, collapsedAccuracy, 1e-8 ), settings.m_updateTolerance, (uint32_t) fullGradient.size() );
+        AddError( result, GetRelativeError( fullMSE, collapsedMSE, 1e-8 ), settings.m_updateTolerance, (uint32_t) fullGradient.size() + 1 );
+
+        return result;
+    }
+
+    GradientChecker::Result GradientChecker::CheckPredictionCache( Settings const& settings, Network const& network, TrainingSet const& entries )
+    {
+        assert( entries.size() > 8 );
+
+        uint32_t const numEntries = (uint32_t) entries.size();
+        uint32_t const numRepeatedEntries = 8;
+
+        std::vector<double> inputs;
+        inputs.reserve( (size_t) numEntries * network.GetNumInputs() );
+        for ( auto const& entry : entries )
+        {
+            inputs.insert( inputs.end(), entry.m_inputs.begin(), entry.m_inputs.end() );
+        }
+
+        std::vector<double> referenceOutputs( (size_t) numEntries * network.GetNumOutputs() );
+        std::vector<int32_t> referenceClampedOutputs( referenceOutputs.size() );
+        network.EvaluateBatch( inputs.data(), numEntries, referenceOutputs.data(), referenceClampedOutputs.data() );
+
+        // A few KB per shard so that the entries don't fit and are evicted while the set is evaluated
+        PredictionCache::Settings cacheSettings;
+        cacheSettings.m_maxMemoryBytes = 16 << 10;
+        cacheSettings.m_numShards = 4;
+        PredictionCache cache( cacheSettings, network.GetNumInputs(), network.GetNumOutputs() );
+
+        Result result;
+        uint32_t checkIdx = 0;
+        auto CheckCondition = [&] ( bool condition )
+        {
+            AddError( result, condition ? 0.0 : 1.0, 0.0, checkIdx++ );
+        };
+
+        // Cached and evaluated rows vs Network::EvaluateBatch, the cache must stay within its bound
+        std::vector<double> outputs( referenceOutputs.size() );
+        std::vector<int32_t> clampedOutputs( referenceOutputs.size() );
+        auto EvaluateAndCompare = [&] ( uint64_t modelVersion, uint32_t numRows )
+        {
+            cache.EvaluateBatch( network, modelVersion, inputs.data(), numRows, outputs.data(), clampedOutputs.data() );
+            for ( size_t valueIdx = 0; valueIdx < (size_t) numRows * network.GetNumOutputs(); valueIdx++ )
+            {
+                AddError( result, fabs( outputs[valueIdx] - referenceOutputs[valueIdx] ), settings.m_evaluationTolerance, checkIdx++ );
+                CheckCondition( clampedOutputs[valueIdx] == referenceClampedOutputs[valueIdx] );
+            }
+
+            PredictionCache::Stats const stats = cache.GetStats();
+            CheckCondition( stats.m_numEntries <= stats.m_maxEntries );
+            return stats;
+        };
+
+        // The whole set twice, the second pass mixes hits with rows that were evicted
+        EvaluateAndCompare( 1, numEntries );
+        PredictionCache::Stats const fullSetStats = EvaluateAndCompare( 1, numEntries );
+        CheckCondition( fullSetStats.m_numEvictions > 0 );
+
+        // Rows that were just evaluated must hit
+        PredictionCache::Stats const firstRepeatStats = EvaluateAndCompare( 1, numRepeatedEntries );
+        PredictionCache::Stats const repeatedStats = EvaluateAndCompare( 1, numRepeatedEntries );
+        CheckCondition( repeatedStats.m_numHits == firstRepeatStats.m_numHits + numRepeatedEntries && repeatedStats.m_numMisses == firstRepeatStats.m_numMisses );
+
+        // A newer model version must miss on the same rows
+        std::vector<double> staleOutputs( network.GetNumOutputs() );
+        std::vector<int32_t> staleClampedOutputs( network.GetNumOutputs() );
+        for ( uint32_t entryIdx = 0; entryIdx < numRepeatedEntries; entryIdx++ )
+        {
+            CheckCondition( !cache.Lookup( 2, &inputs[(size_t) entryIdx * network.GetNumInputs()], staleOutputs.data(), staleClampedOutputs.data() ) );
+        }
+        CheckCondition( cache.GetStats().m_numStaleMisses == repeatedStats.m_numStaleMisses + numRepeatedEntries );
+
+        // The new version's results replace the old ones
+        EvaluateAndCompare( 2, numEntries );
+
+        return result;
+    }
+
+    void GradientChecker::PrintResult( std::ostream& stream, char const* pName, Result const& result )
+    {
+        stream << ( result.Passed() ? " PASS " : " FAIL " ) << pName << " - checked: " << result.m_numChecked << ", failed: " << result.m_numFailures
+               << ", max error: " << result.m_maxError << " (index " << result.m_worstIdx << ")" << std::endl;
+    }
+}
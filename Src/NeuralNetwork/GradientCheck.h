@@ -0,0 +1,78 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Numerical checks of the training and evaluation code
+//
+// The gradient check compares the backpropagated gradient against central finite differences of the
+// error, the update checks compare the weights after stochastic and batch training steps against the
+// plain gradient descent step computed from that gradient, and the evaluation checks compare the batch,
+// sparse and incremental evaluation paths against Network::Evaluate. The ensemble vote check builds
+// ensembles with known vote splits and the collapsed gradient check compares a set with duplicate rows
+// against its weighted unique rows. The prediction cache check compares cached outputs against the network
+// and checks that stale model versions miss and that eviction keeps the cache within its bound. Any
+// optimized rewrite of these paths should keep passing them.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class GradientChecker
+    {
+    public:
+
+        struct Settings
+        {
+            double      m_epsilon = 1e-5;               // Finite difference step
+            double      m_gradientTolerance = 1e-6;     // Max relative error between the backpropagated and numerical gradients
+            double      m_updateTolerance = 1e-12;      // Max relative error between the trained weights and the expected step
+            double      m_evaluationTolerance = 0.0;    // Max absolute output difference between evaluation paths
+            double      m_incrementalTolerance = 1e-12; // Max absolute output difference after incremental updates, which round differently
+            double      m_learningRate = 0.01;          // Learning rate for the update checks
+        };
+
+        struct Result
+        {
+            inline bool Passed() const { return m_numFailures == 0; }
+
+            double      m_maxError = 0;
+            uint32_t    m_worstIdx = 0;                 // Weight or output index with the largest error
+            uint32_t    m_numChecked = 0;
+            uint32_t    m_numFailures = 0;
+        };
+
+    public:
+
+        // Backpropagated vs central finite difference gradient of the error summed over the entries
+        static Result CheckGradient( Settings const& settings, Network const& network, TrainingEntry const* pEntries, size_t numEntries );
+
+        // Weights after training on each entry with the stochastic update (no momentum) vs stepping along the gradient of that entry
+        static Result CheckStochasticUpdate( Settings const& settings, Network const& network, TrainingEntry const* pEntries, size_t numEntries );
+
+        // Weights after two batch epochs over the entries vs two steps along the summed gradient
+        static Result CheckBatchUpdate( Settings const& settings, Network const& network, TrainingSet const& entries );
+
+        // Network::EvaluateBatch and the sparse kernels vs Network::Evaluate
+        static Result CheckEvaluation( Settings const& settings, Network const& network, TrainingSet const& entries );
+
+        // IncrementalEvaluator vs Network::Evaluate, stepping from each entry to the next by updating at most two changed inputs at a time
+        static Result CheckIncrementalEvaluation( Settings const& settings, Network const& network, TrainingSet const& entries );
+
+        // Ensembles of 4 and 5 constant members with every split of their votes vs the majority (a tie is undecided)
+        static Result CheckEnsembleVote( Settings const& settings, Network const& network, TrainingSet const& entries );
+
+        // Gradient and set statistics of entries repeated up to 4 times vs the same set collapsed by RowDeduplicator into weighted entries
+        static Result CheckCollapsedGradient( Settings const& settings, Network const& network, TrainingEntry const* pEntries, size_t numEntries );
+
+        // PredictionCache::EvaluateBatch with a few KB of cache vs Network::EvaluateBatch, while entries are evicted, hit and invalidated by a newer model version
+        static Result CheckPredictionCache( Settings const& settings, Network const& network, TrainingSet const& entries );
+
+        static void PrintResult( std::ostream& stream, char const* pName, Result const& result );
+    };
+}
@@ -0,0 +1,284 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "HyperparameterSearch.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    struct HyperparameterSearch::Trial
+    {
+        TrialResult                         m_result;
+        std::unique_ptr<Network>            m_pNetwork;
+        std::unique_ptr<NetworkTrainer>     m_pTrainer;
+
+        std::vector<double>                 m_generalizationSetMSEPerEpoch;
+        double                              m_bestGeneralizationSetMSE = std::numeric_limits<double>::max();
+        uint32_t                            m_numEpochsSinceImprovement = 0;
+        bool                                m_isComplete = false;
+    };
+
+    //-------------------------------------------------------------------------
+
+    HyperparameterSearch::HyperparameterSearch( Settings const& settings, TrainingData const& trainingData, uint32_t numInputs, uint32_t numOutputs )
+        : m_settings( settings )
+        , m_trainingData( trainingData )
+        , m_numInputs( numInputs )
+        , m_numOutputs( numOutputs )
+    {
+        assert( !m_settings.m_hiddenSizes.empty() && !m_settings.m_learningRates.empty() && !m_settings.m_momentums.empty() );
+        assert( m_numInputs > 0 && m_numOutputs > 0 );
+        assert( !m_trainingData.m_trainingSet.empty() && !m_trainingData.m_generalizationSet.empty() );
+        m_settings.m_reductionFactor = std::max( 2u, m_settings.m_reductionFactor );
+        m_settings.m_minEpochsPerRung = std::max( 1u, m_settings.m_minEpochsPerRung );
+        m_settings.m_earlyStoppingMinEpochs = std::max( 1u, m_settings.m_earlyStoppingMinEpochs );
+        m_settings.m_earlyStoppingInterval = std::max( 1u, m_settings.m_earlyStoppingInterval );
+    }
+
+    void HyperparameterSearch::CreateTrials( std::vector<Trial>& trials ) const
+    {
+        std::vector<TrialResult> configurations;
+
+        if ( m_settings.m_strategy == Strategy::Grid )
+        {
+            for ( auto numHidden : m_settings.m_hiddenSizes )
+            {
+                for ( auto learningRate : m_settings.m_learningRates )
+                {
+                    for ( auto momentum : m_settings.m_momentums )
+                    {
+                        TrialResult configuration;
+                        configuration.m_numHidden = numHidden;
+                        configuration.m_learningRate = learningRate;
+                        configuration.m_momentum = momentum;
+                        configurations.push_back( configuration );
+                    }
+                }
+            }
+        }
+        else
+        {
+            // Sample from the range covered by the supplied values, learning rates are sampled on a log scale
+            auto const hiddenRange = std::minmax_element( m_settings.m_hiddenSizes.begin(), m_settings.m_hiddenSizes.end() );
+            auto const learningRateRange = std::minmax_element( m_settings.m_learningRates.begin(), m_settings.m_learningRates.end() );
+            auto const momentumRange = std::minmax_element( m_settings.m_momentums.begin(), m_settings.m_momentums.end() );
+
+            double const logMinLearningRate = std::log( *learningRateRange.first );
+            double const logMaxLearningRate = std::log( *learningRateRange.second );
+
+            // Each trial draws from its own stream, so a configuration only depends on the seed and the trial index
+            for ( uint32_t trialIdx = 0; trialIdx < m_settings.m_numRandomTrials; trialIdx++ )
+            {
+                RandomStream random( m_settings.m_seed, trialIdx );
+
+                TrialResult configuration;
+                configuration.m_numHidden = std::max( 1u, *hiddenRange.first + random.NextUInt32( *hiddenRange.second - *hiddenRange.first + 1 ) );
+                configuration.m_learningRate = std::exp( logMinLearningRate + random.NextDouble() * ( logMaxLearningRate - logMinLearningRate ) );
+                configuration.m_momentum = *momentumRange.first + random.NextDouble() * ( *momentumRange.second - *momentumRange.first );
+                configurations.push_back( configuration );
+            }
+        }
+
+        trials.resize( configurations.size() );
+        for ( uint32_t trialIdx = 0; trialIdx < (uint32_t) configurations.size(); trialIdx++ )
+        {
+            Trial& trial = trials[trialIdx];
+            trial.m_result = configurations[trialIdx];
+            trial.m_result.m_trialIdx = trialIdx;
+
+            // Every trial starts from the same seed so that only the hyperparameters differ
+            Network::Settings networkSettings{ m_numInputs, trial.m_result.m_numHidden, m_numOutputs, m_settings.m_seed };
+            trial.m_pNetwork.reset( new Network( networkSettings ) );
+
+            NetworkTrainer::Settings trainerSettings;
+            trainerSettings.m_learningRate = trial.m_result.m_learningRate;
+            trainerSettings.m_momentum = trial.m_result.m_momentum;
+            trainerSettings.m_useBatchLearning = m_settings.m_useBatchLearning;
+            trainerSettings.m_maxEpochs = m_settings.m_maxEpochs;
+            trainerSettings.m_desiredAccuracy = m_settings.m_desiredAccuracy;
+            trial.m_pTrainer.reset( new NetworkTrainer( trainerSettings, trial.m_pNetwork.get() ) );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    bool HyperparameterSearch::ShouldStopTrial( Trial const& trial, std::vector<double> const& bestMSEPerEpoch ) const
+    {
+        // Compare against the best MSE any trial reached at this epoch
+        uint32_t const epochIdx = trial.m_result.m_numEpochs - 1;
+        assert( epochIdx < bestMSEPerEpoch.size() );
+        return trial.m_result.m_generalizationSetMSE > bestMSEPerEpoch[epochIdx] * m_settings.m_earlyStoppingTolerance;
+    }
+
+    void HyperparameterSearch::TrainTrial( Trial& trial, uint32_t maxEpochs, bool useEarlyStopping )
+    {
+        auto const startTime = std::chrono::steady_clock::now();
+
+        TrialResult& result = trial.m_result;
+        while ( !trial.m_isComplete && result.m_numEpochs < maxEpochs )
+        {
+            trial.m_pTrainer->RunEpoch( m_trainingData.m_trainingSet );
+            trial.m_pTrainer->GetSetAccuracyAndMSE( m_trainingData.m_generalizationSet, result.m_generalizationSetAccuracy, result.m_generalizationSetMSE );
+            result.m_numEpochs++;
+            trial.m_generalizationSetMSEPerEpoch.push_back( result.m_generalizationSetMSE );
+
+            if ( result.m_generalizationSetMSE < trial.m_bestGeneralizationSetMSE )
+            {
+                trial.m_bestGeneralizationSetMSE = result.m_generalizationSetMSE;
+                trial.m_numEpochsSinceImprovement = 0;
+            }
+            else
+            {
+                trial.m_numEpochsSinceImprovement++;
+            }
+
+            // Same stopping conditions as the trainer
+            if ( ( trial.m_pTrainer->GetTrainingSetAccuracy() >= m_settings.m_desiredAccuracy && result.m_generalizationSetAccuracy >= m_settings.m_desiredAccuracy ) || result.m_numEpochs >= m_settings.m_maxEpochs )
+            {
+                trial.m_isComplete = true;
+            }
+            else if ( useEarlyStopping && trial.m_numEpochsSinceImprovement >= m_settings.m_earlyStoppingPatience )
+            {
+                trial.m_isComplete = true;
+                result.m_wasStoppedEarly = true;
+            }
+        }
+
+        result.m_trainingTimeMS += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startTime ).count();
+    }
+
+    //-------------------------------------------------------------------------
+
+    std::vector<HyperparameterSearch::TrialResult> HyperparameterSearch::Run()
+    {
+        std::vector<Trial> trials;
+        CreateTrials( trials );
+
+        ThreadPool threadPool( m_settings.m_numThreads );
+
+        if ( m_settings.m_strategy == Strategy::SuccessiveHalving )
+        {
+            std::vector<Trial*> survivors;
+            for ( auto& trial : trials )
+            {
+                survivors.push_back( &trial );
+            }
+
+            // The last surviving trial is trained to completion
+            uint32_t rungEpochs = ( survivors.size() > 1 ) ? std::min( m_settings.m_minEpochsPerRung, m_settings.m_maxEpochs ) : m_settings.m_maxEpochs;
+            while ( true )
+            {
+                threadPool.ParallelFor( (uint32_t) survivors.size(), [this, &survivors, rungEpochs] ( uint32_t idx ) { TrainTrial( *survivors[idx], rungEpochs, false ); } );
+
+                if ( survivors.size() <= 1 || rungEpochs >= m_settings.m_maxEpochs )
+                {
+                    break;
+                }
+
+                // Keep the best 1/N of the trials
+                std::sort( survivors.begin(), survivors.end(), [] ( Trial const* pA, Trial const* pB ) { return pA->m_result.m_generalizationSetMSE < pB->m_result.m_generalizationSetMSE; } );
+                size_t const numSurvivors = ( survivors.size() + m_settings.m_reductionFactor - 1 ) / m_settings.m_reductionFactor;
+                for ( size_t trialIdx = numSurvivors; trialIdx < survivors.size(); trialIdx++ )
+                {
+                    survivors[trialIdx]->m_result.m_wasStoppedEarly = !survivors[trialIdx]->m_isComplete;
+                }
+                survivors.resize( numSurvivors );
+
+                rungEpochs = ( survivors.size() > 1 ) ? std::min( rungEpochs * m_settings.m_reductionFactor, m_settings.m_maxEpochs ) : m_settings.m_maxEpochs;
+            }
+        }
+        else
+        {
+            std::vector<Trial*> activeTrials;
+            for ( auto& trial : trials )
+            {
+                activeTrials.push_back( &trial );
+            }
+
+            // All active trials train up to the next check epoch before any of them are compared
+            uint32_t checkEpoch = std::min( m_settings.m_earlyStoppingMinEpochs, m_settings.m_maxEpochs );
+            while ( !activeTrials.empty() )
+            {
+                threadPool.ParallelFor( (uint32_t) activeTrials.size(), [this, &activeTrials, checkEpoch] ( uint32_t idx ) { TrainTrial( *activeTrials[idx], checkEpoch, true ); } );
+
+                // Best MSE any trial reached at each epoch, including the trials that have already stopped
+                std::vector<double> bestMSEPerEpoch( checkEpoch, std::numeric_limits<double>::max() );
+                for ( auto const& trial : trials )
+                {
+                    for ( size_t epochIdx = 0; epochIdx < trial.m_generalizationSetMSEPerEpoch.size(); epochIdx++ )
+                    {
+                        bestMSEPerEpoch[epochIdx] = std::min( bestMSEPerEpoch[epochIdx], trial.m_generalizationSetMSEPerEpoch[epochIdx] );
+                    }
+                }
+
+                // Stop poor trials in trial order
+                std::vector<Trial*> remainingTrials;
+                for ( Trial* pTrial : activeTrials )
+                {
+                    if ( !pTrial->m_isComplete && ShouldStopTrial( *pTrial, bestMSEPerEpoch ) )
+                    {
+                        pTrial->m_isComplete = true;
+                        pTrial->m_result.m_wasStoppedEarly = true;
+                    }
+
+                    if ( !pTrial->m_isComplete )
+                    {
+                        remainingTrials.push_back( pTrial );
+                    }
+                }
+                activeTrials.swap( remainingTrials );
+
+                checkEpoch = std::min( checkEpoch + m_settings.m_earlyStoppingInterval, m_settings.m_maxEpochs );
+            }
+        }
+
+        // Validation set results for all trials
+        threadPool.ParallelFor( (uint32_t) trials.size(), [this, &trials] ( uint32_t idx )
+        {
+            TrialResult& result = trials[idx].m_result;
+            trials[idx].m_pTrainer->GetSetAccuracyAndMSE( m_trainingData.m_validationSet, result.m_validationSetAccuracy, result.m_validationSetMSE );
+        } );
+
+        // Rank by generalization set MSE
+        std::vector<TrialResult> results;
+        for ( auto const& trial : trials )
+        {
+            results.push_back( trial.m_result );
+        }
+
+        std::sort( results.begin(), results.end(), [] ( TrialResult const& a, TrialResult const& b ) { return a.m_generalizationSetMSE < b.m_generalizationSetMSE; } );
+        return results;
+    }
+
+    void HyperparameterSearch::PrintResults( std::ostream& stream, std::vector<TrialResult> const& results )
+    {
+        stream << std::endl << " Hyperparameter Search Results (ranked by generalization set MSE): " << std::endl
+               << "==========================================================================================================" << std::endl
+               << std::setw( 5 ) << "Rank" << std::setw( 8 ) << "Hidden" << std::setw( 12 ) << "LR" << std::setw( 10 ) << "Momentum" << std::setw( 8 ) << "Epochs"
+               << std::setw( 10 ) << "Gen Acc" << std::setw( 12 ) << "Gen MSE" << std::setw( 10 ) << "Val Acc" << std::setw( 12 ) << "Val MSE" << std::setw( 12 ) << "Time (ms)" << std::setw( 10 ) << "Status" << std::endl
+               << "==========================================================================================================" << std::endl;
+
+        for ( size_t rank = 0; rank < results.size(); rank++ )
+        {
+            TrialResult const& result = results[rank];
+            stream << std::setw( 5 ) << ( rank + 1 ) << std::setw( 8 ) << result.m_numHidden << std::setw( 12 ) << result.m_learningRate << std::setw( 10 ) << result.m_momentum << std::setw( 8 ) << result.m_numEpochs
+                   << std::setw( 10 ) << result.m_generalizationSetAccuracy << std::setw( 12 ) << result.m_generalizationSetMSE << std::setw( 10 ) << result.m_validationSetAccuracy << std::setw( 12 ) << result.m_validationSetMSE
+                   << std::setw( 12 ) << (uint64_t) result.m_trainingTimeMS << std::setw( 10 ) << ( result.m_wasStoppedEarly ? "stopped" : "complete" ) << std::endl;
+        }
+
+        stream << std::endl;
+    }
+}
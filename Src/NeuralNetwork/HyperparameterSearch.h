@@ -0,0 +1,107 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// In-process hyperparameter search
+//
+// Trains many small networks in parallel over a single shared, read-only data set. Trials are scheduled
+// on a work-stealing thread pool and poorly performing trials are stopped early based on their
+// generalization set MSE. Trials are only compared at fixed check epochs, once every trial has trained
+// that far, so which trials are stopped doesn't depend on the thread timing. Results are ranked by
+// generalization set MSE.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+#include <memory>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class HyperparameterSearch
+    {
+    public:
+
+        enum class Strategy
+        {
+            Grid,                                           // Every combination of the supplied values
+            Random,                                         // Configurations sampled from the range of the supplied values
+            SuccessiveHalving                               // Random configurations, the best 1/N survive each rung and get N times the epochs
+        };
+
+        struct Settings
+        {
+            Strategy                m_strategy = Strategy::Grid;
+
+            // Search space
+            std::vector<uint32_t>   m_hiddenSizes = { 16 };
+            std::vector<double>     m_learningRates = { 0.001 };
+            std::vector<double>     m_momentums = { 0.9 };
+            bool                    m_useBatchLearning = false;
+
+            // Random and successive halving
+            uint32_t                m_numRandomTrials = 32;
+
+            // Seed for sampling the configurations and for the initial weights of every trial
+            uint64_t                m_seed = 0;
+
+            // Successive halving
+            uint32_t                m_minEpochsPerRung = 10;
+            uint32_t                m_reductionFactor = 3;
+
+            // Stopping conditions
+            uint32_t                m_maxEpochs = 150;
+            double                  m_desiredAccuracy = 90;
+            uint32_t                m_earlyStoppingPatience = 15;       // Stop a trial if its generalization MSE hasn't improved for this many epochs
+            uint32_t                m_earlyStoppingMinEpochs = 5;       // Don't compare trials before they have trained this many epochs
+            uint32_t                m_earlyStoppingInterval = 5;        // Compare the trials every this many epochs after the first comparison
+            double                  m_earlyStoppingTolerance = 1.5;     // Stop a trial if its generalization MSE is worse than the best trial's MSE at the same epoch by this factor
+
+            uint32_t                m_numThreads = 0;                   // 0 uses the hardware concurrency
+        };
+
+        struct TrialResult
+        {
+            uint32_t                m_trialIdx = 0;
+            uint32_t                m_numHidden = 0;
+            double                  m_learningRate = 0;
+            double                  m_momentum = 0;
+
+            uint32_t                m_numEpochs = 0;
+            bool                    m_wasStoppedEarly = false;
+            double                  m_trainingTimeMS = 0;
+
+            double                  m_generalizationSetAccuracy = 0;
+            double                  m_generalizationSetMSE = 0;
+            double                  m_validationSetAccuracy = 0;
+            double                  m_validationSetMSE = 0;
+        };
+
+    public:
+
+        HyperparameterSearch( Settings const& settings, TrainingData const& trainingData, uint32_t numInputs, uint32_t numOutputs );
+
+        // Runs the search and returns all trials ranked by generalization set MSE
+        std::vector<TrialResult> Run();
+
+        static void PrintResults( std::ostream& stream, std::vector<TrialResult> const& results );
+
+    private:
+
+        struct Trial;
+
+        void CreateTrials( std::vector<Trial>& trials ) const;
+        void TrainTrial( Trial& trial, uint32_t maxEpochs, bool useEarlyStopping );
+        bool ShouldStopTrial( Trial const& trial, std::vector<double> const& bestMSEPerEpoch ) const;
+
+    private:
+
+        Settings                    m_settings;
+        TrainingData const&         m_trainingData;
+        uint32_t                    m_numInputs;
+        uint32_t                    m_numOutputs;
+    };
+}
@@ -0,0 +1,128 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "IncrementalEvaluator.h"
+#include "Profiling.h"
+#include <assert.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    IncrementalEvaluator::IncrementalEvaluator( Settings const& settings, Network const& network )
+        : m_settings( settings )
+        , m_pNetwork( &network )
+    {
+        m_inputs.resize( network.m_numInputs, 0.0 );
+        m_accumulator.resize( network.m_numHidden, 0.0 );
+        m_hiddenNeurons.resize( network.m_numHidden + 1, 0.0 );
+        m_hiddenNeurons.back() = -1.0;
+        m_outputNeurons.resize( network.m_numOutputs, 0.0 );
+        m_clampedOutputs.resize( network.m_numOutputs, 0 );
+    }
+
+    std::vector<int32_t> const& IncrementalEvaluator::Evaluate( std::vector<double> const& inputs )
+    {
+        assert( inputs.size() == m_inputs.size() );
+        return Evaluate( inputs.data() );
+    }
+
+    std::vector<int32_t> const& IncrementalEvaluator::Evaluate( double const* pInputs )
+    {
+        memcpy( m_inputs.data(), pInputs, m_inputs.size() * sizeof( double ) );
+        RebuildAccumulator();
+        m_hasInputs = true;
+        return EvaluateOutputs();
+    }
+
+    std::vector<int32_t> const& IncrementalEvaluator::Update( InputChange const* pChanges, size_t numChanges )
+    {
+        assert( m_hasInputs );
+
+        Network const& network = *m_pNetwork;
+        int32_t const numHidden = network.m_numHidden;
+
+        // Add the change of every input times its row of weights
+        //-------------------------------------------------------------------------
+
+        for ( size_t changeIdx = 0; changeIdx < numChanges; changeIdx++ )
+        {
+            uint32_t const inputIdx = pChanges[changeIdx].m_inputIdx;
+            assert( inputIdx < m_inputs.size() );
+
+            double const delta = pChanges[changeIdx].m_value - m_inputs[inputIdx];
+            m_inputs[inputIdx] = pChanges[changeIdx].m_value;
+            if ( delta == 0.0 )
+            {
+                continue;
+            }
+
+            double const* pWeights = &network.m_weightsInputHidden[network.GetInputHiddenWeightIndex( inputIdx, 0 )];
+            for ( int32_t hiddenIdx = 0; hiddenIdx < numHidden; hiddenIdx++ )
+            {
+                m_accumulator[hiddenIdx] += delta * pWeights[hiddenIdx];
+            }
+        }
+
+        // Bound the rounding drift
+        m_numUpdatesSinceRebuild++;
+        if ( m_settings.m_refreshInterval > 0 && m_numUpdatesSinceRebuild >= m_settings.m_refreshInterval )
+        {
+            RebuildAccumulator();
+        }
+
+        return EvaluateOutputs();
+    }
+
+    void IncrementalEvaluator::RebuildAccumulator()
+    {
+        Network const& network = *m_pNetwork;
+        int32_t const numInputs = network.m_numInputs;
+        int32_t const numHidden = network.m_numHidden;
+
+        for ( int32_t hiddenIdx = 0; hiddenIdx < numHidden; hiddenIdx++ )
+        {
+            double sum = 0;
+            for ( int32_t inputIdx = 0; inputIdx < numInputs; inputIdx++ )
+            {
+                sum += m_inputs[inputIdx] * network.m_weightsInputHidden[network.GetInputHiddenWeightIndex( inputIdx, hiddenIdx )];
+            }
+
+            // Bias neuron
+            m_accumulator[hiddenIdx] = sum + -1.0 * network.m_weightsInputHidden[network.GetInputHiddenWeightIndex( numInputs, hiddenIdx )];
+        }
+
+        m_numUpdatesSinceRebuild = 0;
+    }
+
+    std::vector<int32_t> const& IncrementalEvaluator::EvaluateOutputs()
+    {
+        BPN_PROFILE_SCOPE( Evaluate );
+
+        Network const& network = *m_pNetwork;
+        int32_t const numHidden = network.m_numHidden;
+
+        for ( int32_t hiddenIdx = 0; hiddenIdx < numHidden; hiddenIdx++ )
+        {
+            m_hiddenNeurons[hiddenIdx] = Network::SigmoidActivationFunction( m_accumulator[hiddenIdx] );
+        }
+
+        for ( int32_t outputIdx = 0; outputIdx < network.m_numOutputs; outputIdx++ )
+        {
+            double sum = 0;
+            for ( int32_t hiddenIdx = 0; hiddenIdx <= numHidden; hiddenIdx++ )
+            {
+                sum += m_hiddenNeurons[hiddenIdx] * network.m_weightsHiddenOutput[network.GetHiddenOutputWeightIndex( hiddenIdx, outputIdx )];
+            }
+
+            m_outputNeurons[outputIdx] = Network::SigmoidActivationFunction( sum );
+            m_clampedOutputs[outputIdx] = Network::ClampOutputValue( m_outputNeurons[outputIdx] );
+        }
+
+        return m_clampedOutputs;
+    }
+}
@@ -0,0 +1,77 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Stateful evaluation of a stream of inputs that differ in only a few values
+//
+// The evaluator keeps the current inputs and the hidden pre-activation sums (the accumulator). When only a
+// few inputs change, each changed input adds ( new - old ) times its row of input->hidden weights to the
+// accumulator, which is O( changed x hidden ) work instead of the O( inputs x hidden ) of a full evaluation.
+// Only the hidden activations and the output layer are then recomputed. The incremental sums can differ from
+// the full ones by rounding, so the accumulator is rebuilt from scratch every refresh interval updates. A full
+// evaluation gives the same results as Network::Evaluate. The network must outlive the evaluator, and after
+// its weights change the evaluator needs a full evaluation before it can be updated again.
+
+#pragma once
+
+#include "NeuralNetwork.h"
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class IncrementalEvaluator
+    {
+    public:
+
+        struct Settings
+        {
+            uint32_t                        m_refreshInterval = 1024;   // Incremental updates between rebuilds of the accumulator, 0 never rebuilds it
+        };
+
+        struct InputChange
+        {
+            uint32_t                        m_inputIdx;
+            double                          m_value;
+        };
+
+    public:
+
+        IncrementalEvaluator( Settings const& settings, Network const& network );
+
+        // Full evaluation, rebuilds the accumulator from the inputs
+        std::vector<int32_t> const& Evaluate( double const* pInputs );
+        std::vector<int32_t> const& Evaluate( std::vector<double> const& inputs );
+
+        // Sets the changed inputs and updates the accumulator with them, requires a previous full evaluation
+        std::vector<int32_t> const& Update( InputChange const* pChanges, size_t numChanges );
+        std::vector<int32_t> const& Update( std::vector<InputChange> const& changes ) { return Update( changes.data(), changes.size() ); }
+
+        inline bool HasInputs() const { return m_hasInputs; }
+        inline std::vector<double> const& GetInputs() const { return m_inputs; }
+
+        // Raw (sigmoid) and clamped outputs of the last evaluation or update
+        inline std::vector<double> const& GetOutputs() const { return m_outputNeurons; }
+        inline std::vector<int32_t> const& GetClampedOutputs() const { return m_clampedOutputs; }
+
+    private:
+
+        // Sums in the same order as Network::Evaluate
+        void RebuildAccumulator();
+        std::vector<int32_t> const& EvaluateOutputs();
+
+    private:
+
+        Settings                            m_settings;
+        Network const*                      m_pNetwork;
+
+        std::vector<double>                 m_inputs;
+        std::vector<double>                 m_accumulator;              // Hidden pre-activation sums including the bias
+        std::vector<double>                 m_hiddenNeurons;            // Includes the bias neuron
+        std::vector<double>                 m_outputNeurons;
+        std::vector<int32_t>                m_clampedOutputs;
+        uint32_t                            m_numUpdatesSinceRebuild = 0;
+        bool                                m_hasInputs = false;
+    };
+}
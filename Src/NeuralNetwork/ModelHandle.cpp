@@ -0,0 +1,147 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "ModelHandle.h"
+#include "NetworkSerialization.h"
+#include <assert.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    ModelHandle::ReadGuard::ReadGuard( ReadGuard&& other )
+        : m_pSlot( other.m_pSlot )
+        , m_pModel( other.m_pModel )
+    {
+        other.m_pSlot = nullptr;
+        other.m_pModel = nullptr;
+    }
+
+    ModelHandle::ReadGuard::~ReadGuard()
+    {
+        if ( m_pSlot != nullptr )
+        {
+            m_pSlot->m_epoch.store( g_inactiveEpoch, std::memory_order_release );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    ModelHandle::ModelHandle( std::unique_ptr<Network const> pNetwork, uint32_t numReaderSlots )
+        : m_readerSlots( std::max( 1u, numReaderSlots ) )
+        , m_pCurrentModel( new Model{ std::move( pNetwork ), 1 } )
+        , m_epoch( g_inactiveEpoch + 1 )
+        , m_currentVersion( 1 )
+        , m_numPublished( 0 )
+        , m_numReclaimed( 0 )
+    {
+        assert( m_pCurrentModel.load()->m_pNetwork != nullptr );
+    }
+
+    ModelHandle::~ModelHandle()
+    {
+        // Guards must not outlive the handle
+        assert( std::all_of( m_readerSlots.begin(), m_readerSlots.end(), [] ( ReaderSlot const& slot ) { return slot.m_epoch == g_inactiveEpoch; } ) );
+
+        for ( auto const& retiredModel : m_retiredModels )
+        {
+            delete retiredModel.m_pModel;
+        }
+        delete m_pCurrentModel.load();
+    }
+
+    ModelHandle::ReadGuard ModelHandle::Acquire() const
+    {
+        // Start looking for a free slot at a per-thread offset so that threads don't all fight over the first one
+        static thread_local size_t const threadSlotOffset = std::hash<std::thread::id>()( std::this_thread::get_id() );
+
+        size_t const numSlots = m_readerSlots.size();
+        size_t slotIdx = threadSlotOffset % numSlots;
+        for ( size_t numAttempts = 1; ; numAttempts++ )
+        {
+            // Claiming the slot with a stale epoch is safe: if a publish advanced the epoch in the meantime then
+            // it either sees our slot and holds off reclaiming, or it scanned before the claim, in which case the
+            // pointer load below is ordered after its pointer swap and can't return the retired model.
+            ReaderSlot& slot = m_readerSlots[slotIdx];
+            uint64_t expectedEpoch = g_inactiveEpoch;
+            if ( slot.m_epoch.load( std::memory_order_relaxed ) == g_inactiveEpoch && slot.m_epoch.compare_exchange_strong( expectedEpoch, m_epoch.load() ) )
+            {
+                return ReadGuard( &slot, m_pCurrentModel.load() );
+            }
+
+            slotIdx = ( slotIdx + 1 ) % numSlots;
+            if ( numAttempts % numSlots == 0 )
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    uint64_t ModelHandle::Publish( std::unique_ptr<Network const> pNetwork )
+    {
+        assert( pNetwork != nullptr );
+
+        std::lock_guard<std::mutex> lock( m_publishMutex );
+
+        Model const* pPreviousModel = m_pCurrentModel.load();
+        uint64_t const version = pPreviousModel->m_version + 1;
+        Model* pRetiredModel = m_pCurrentModel.exchange( new Model{ std::move( pNetwork ), version } );
+        m_currentVersion = version;
+
+        // Readers that claim a slot from here on see the new model
+        uint64_t const retireEpoch = m_epoch.fetch_add( 1 );
+        m_retiredModels.push_back( { pRetiredModel, retireEpoch } );
+        m_numPublished++;
+
+        ReclaimRetiredModels();
+        return version;
+    }
+
+    bool ModelHandle::LoadAndPublish( std::string const& path )
+    {
+        std::unique_ptr<Network> pNetwork;
+        if ( !LoadNetwork( path, pNetwork ) )
+        {
+            return false;
+        }
+
+        Publish( std::move( pNetwork ) );
+        return true;
+    }
+
+    size_t ModelHandle::Reclaim()
+    {
+        std::lock_guard<std::mutex> lock( m_publishMutex );
+        return ReclaimRetiredModels();
+    }
+
+    size_t ModelHandle::ReclaimRetiredModels()
+    {
+        uint64_t minActiveEpoch = std::numeric_limits<uint64_t>::max();
+        for ( auto const& slot : m_readerSlots )
+        {
+            uint64_t const epoch = slot.m_epoch.load();
+            if ( epoch != g_inactiveEpoch )
+            {
+                minActiveEpoch = std::min( minActiveEpoch, epoch );
+            }
+        }
+
+        auto const firstRemaining = std::partition( m_retiredModels.begin(), m_retiredModels.end(), [minActiveEpoch] ( RetiredModel const& retiredModel ) { return retiredModel.m_retireEpoch < minActiveEpoch; } );
+        for ( auto iter = m_retiredModels.begin(); iter != firstRemaining; ++iter )
+        {
+            delete iter->m_pModel;
+            m_numReclaimed++;
+        }
+        m_retiredModels.erase( m_retiredModels.begin(), firstRemaining );
+
+        return m_retiredModels.size();
+    }
+}
@@ -0,0 +1,127 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Hot-swappable handle to a network
+//
+// Readers pin the current network with a ReadGuard, which takes no locks: it claims a reader slot, records
+// the current epoch in it and loads the network pointer. Publishing atomically replaces the pointer, retires
+// the previous network and advances the epoch. A retired network is deleted once no reader slot still holds
+// an epoch at or before the one it was retired in, i.e. once every evaluation that could have seen it is done.
+
+#pragma once
+
+#include "NeuralNetwork.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class ModelHandle
+    {
+        struct Model
+        {
+            std::unique_ptr<Network const>          m_pNetwork;
+            uint64_t                                m_version;
+        };
+
+        // Each slot gets its own cache line so that readers on different threads don't contend
+        struct alignas( 64 ) ReaderSlot
+        {
+            std::atomic<uint64_t>                   m_epoch{ g_inactiveEpoch };
+        };
+
+        struct RetiredModel
+        {
+            Model*                                  m_pModel;
+            uint64_t                                m_retireEpoch;
+        };
+
+        static uint64_t const g_inactiveEpoch = 0;
+
+    public:
+
+        // Pins the network that was current when the guard was created, it stays valid until the guard is destroyed.
+        // Guards are cheap but hold up reclamation, so keep them for the duration of an evaluation rather than indefinitely.
+        class ReadGuard
+        {
+            friend class ModelHandle;
+
+        public:
+
+            ReadGuard( ReadGuard&& other );
+            ~ReadGuard();
+
+            ReadGuard( ReadGuard const& ) = delete;
+            ReadGuard& operator=( ReadGuard const& ) = delete;
+            ReadGuard& operator=( ReadGuard&& ) = delete;
+
+            inline Network const& operator*() const { return *m_pModel->m_pNetwork; }
+            inline Network const* operator->() const { return m_pModel->m_pNetwork.get(); }
+            inline Network const& GetNetwork() const { return *m_pModel->m_pNetwork; }
+
+            // Starts at 1 and increments with every publish
+            inline uint64_t GetVersion() const { return m_pModel->m_version; }
+
+        private:
+
+            ReadGuard( ReaderSlot* pSlot, Model const* pModel ) : m_pSlot( pSlot ), m_pModel( pModel ) {}
+
+        private:
+
+            ReaderSlot*                             m_pSlot;
+            Model const*                            m_pModel;
+        };
+
+    public:
+
+        // numReaderSlots bounds the number of concurrently held guards, acquiring a guard spins while all slots are taken
+        ModelHandle( std::unique_ptr<Network const> pNetwork, uint32_t numReaderSlots = 64 );
+        ~ModelHandle();
+
+        ModelHandle( ModelHandle const& ) = delete;
+        ModelHandle& operator=( ModelHandle const& ) = delete;
+
+        // Lock-free
+        ReadGuard Acquire() const;
+
+        // Atomically replaces the current network and returns the new version. Readers holding a guard keep using
+        // the previous network until they release it. Publishing is serialized with a lock, reading never is.
+        uint64_t Publish( std::unique_ptr<Network const> pNetwork );
+
+        // Loads a model saved with SaveNetwork and publishes it
+        bool LoadAndPublish( std::string const& path );
+
+        // Deletes the retired networks that no reader can still see, returns the number still waiting on readers.
+        // Called by Publish, only needs calling explicitly to release memory sooner when publishing is infrequent.
+        size_t Reclaim();
+
+        inline uint64_t GetVersion() const { return m_currentVersion; }
+
+        // Stats
+        inline uint64_t GetNumPublished() const { return m_numPublished; }
+        inline uint64_t GetNumReclaimed() const { return m_numReclaimed; }
+
+    private:
+
+        size_t ReclaimRetiredModels();
+
+    private:
+
+        mutable std::vector<ReaderSlot>             m_readerSlots;
+        std::atomic<Model*>                         m_pCurrentModel;
+        std::atomic<uint64_t>                       m_epoch;
+        std::atomic<uint64_t>                       m_currentVersion;
+
+        std::mutex                                  m_publishMutex;
+        std::vector<RetiredModel>                   m_retiredModels;
+        std::atomic<uint64_t>                       m_numPublished;
+        std::atomic<uint64_t>                       m_numReclaimed;
+    };
+}
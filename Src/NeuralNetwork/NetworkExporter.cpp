@@ -0,0 +1,246 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "NetworkExporter.h"
+#include <assert.h>
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Hex float literals round-trip exactly
+        std::string ToExactLiteral( double value )
+        {
+            char buffer[64];
+            snprintf( buffer, sizeof( buffer ), "%a", value );
+            return buffer;
+        }
+
+        // Writes comma separated (including a trailing comma) array initializer values
+        void WriteArrayValues( std::ostream& stream, double const* pValues, size_t numValues, size_t valuesPerLine, char const* pIndent )
+        {
+            for ( size_t valueIdx = 0; valueIdx < numValues; valueIdx++ )
+            {
+                if ( valueIdx % valuesPerLine == 0 )
+                {
+                    stream << pIndent;
+                }
+
+                stream << ToExactLiteral( pValues[valueIdx] ) << ",";
+                stream << ( ( valueIdx % valuesPerLine == valuesPerLine - 1 || valueIdx == numValues - 1 ) ? "\n" : " " );
+            }
+        }
+
+        bool WriteFile( std::string const& path, std::string const& contents )
+        {
+            std::ofstream outputFile( path, std::ios::out | std::ios::trunc );
+            if ( !outputFile.is_open() )
+            {
+                return false;
+            }
+
+            outputFile << contents;
+            return outputFile.good();
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    NetworkExporter::NetworkExporter( Settings const& settings, Network const& network )
+        : m_settings( settings )
+        , m_network( network )
+    {
+        assert( !m_settings.m_namespace.empty() && !m_settings.m_functionName.empty() );
+    }
+
+    std::string NetworkExporter::GenerateHeader() const
+    {
+        int32_t const numInputs = m_network.GetNumInputs();
+        int32_t const numHidden = m_network.GetNumHidden();
+        int32_t const numOutputs = m_network.GetNumOutputs();
+
+        // Only the weights used for evaluation are exported, the trainer's input->hidden weight storage has an unused tail
+        size_t const numInputHiddenWeights = ( numInputs + 1 ) * numHidden;
+        size_t const numHiddenOutputWeights = ( numHidden + 1 ) * numOutputs;
+        assert( m_network.GetInputHiddenWeights().size() >= numInputHiddenWeights );
+        assert( m_network.GetHiddenOutputWeights().size() >= numHiddenOutputWeights );
+
+        std::ostringstream stream;
+        stream << "//-------------------------------------------------------------------------\n";
+        stream << "// Generated by BPN::NetworkExporter - do not edit\n";
+        stream << "// " << numInputs << " inputs, " << numHidden << " hidden, " << numOutputs << " outputs\n";
+        stream << "//\n";
+        stream << "// Results are bit-identical to BPN::Network::Evaluate as long as this is compiled without\n";
+        stream << "// fast-math and without floating point contraction (-ffp-contract=off)\n";
+        stream << "//-------------------------------------------------------------------------\n\n";
+        stream << "#pragma once\n\n";
+        stream << "#include <stdint.h>\n";
+        stream << "#include <cmath>\n\n";
+        stream << "#if defined( _MSC_VER ) && !defined( __clang__ )\n";
+        stream << "#pragma fp_contract( off )\n";
+        stream << "#elif defined( __clang__ )\n";
+        stream << "#pragma STDC FP_CONTRACT OFF\n";
+        stream << "#elif defined( __GNUC__ )\n";
+        stream << "#pragma GCC push_options\n";
+        stream << "#pragma GCC optimize( \"fp-contract=off\" )\n";
+        stream << "#endif\n\n";
+
+        stream << "namespace " << m_settings.m_namespace << "\n{\n";
+        stream << "    constexpr uint32_t NumInputs = " << numInputs << ";\n";
+        stream << "    constexpr uint32_t NumHidden = " << numHidden << ";\n";
+        stream << "    constexpr uint32_t NumOutputs = " << numOutputs << ";\n\n";
+
+        stream << "    // [inputIdx][hiddenIdx], bias neuron last\n";
+        stream << "    alignas( 64 ) constexpr double WeightsInputHidden[( NumInputs + 1 ) * NumHidden] =\n    {\n";
+        WriteArrayValues( stream, m_network.GetInputHiddenWeights().data(), numInputHiddenWeights, numHidden, "        " );
+        stream << "    };\n\n";
+
+        stream << "    // [hiddenIdx][outputIdx], bias neuron last\n";
+        stream << "    alignas( 64 ) constexpr double WeightsHiddenOutput[( NumHidden + 1 ) * NumOutputs] =\n    {\n";
+        WriteArrayValues( stream, m_network.GetHiddenOutputWeights().data(), numHiddenOutputWeights, numOutputs, "        " );
+        stream << "    };\n\n";
+
+        stream << R"(    // Evaluates the network: pInputs[NumInputs] -> pOutputs[NumOutputs] (sigmoid outputs) and pClampedOutputs[NumOutputs] (0, 1 or -1 if undecided)
+    inline void )" << m_settings.m_functionName << R"(( double const* pInputs, double* pOutputs, int32_t* pClampedOutputs )
+    {
+        double hidden[NumHidden] = {};
+
+        for ( uint32_t inputIdx = 0; inputIdx < NumInputs; inputIdx++ )
+        {
+            double const inputValue = pInputs[inputIdx];
+            double const* pWeights = &WeightsInputHidden[inputIdx * NumHidden];
+            for ( uint32_t hiddenIdx = 0; hiddenIdx < NumHidden; hiddenIdx++ )
+            {
+                hidden[hiddenIdx] += inputValue * pWeights[hiddenIdx];
+            }
+        }
+
+        for ( uint32_t hiddenIdx = 0; hiddenIdx < NumHidden; hiddenIdx++ )
+        {
+            hidden[hiddenIdx] += -1.0 * WeightsInputHidden[NumInputs * NumHidden + hiddenIdx];
+            hidden[hiddenIdx] = 1.0 / ( 1.0 + std::exp( -hidden[hiddenIdx] ) );
+        }
+
+        double outputs[NumOutputs] = {};
+
+        for ( uint32_t hiddenIdx = 0; hiddenIdx < NumHidden; hiddenIdx++ )
+        {
+            double const hiddenValue = hidden[hiddenIdx];
+            double const* pWeights = &WeightsHiddenOutput[hiddenIdx * NumOutputs];
+            for ( uint32_t outputIdx = 0; outputIdx < NumOutputs; outputIdx++ )
+            {
+                outputs[outputIdx] += hiddenValue * pWeights[outputIdx];
+            }
+        }
+
+        for ( uint32_t outputIdx = 0; outputIdx < NumOutputs; outputIdx++ )
+        {
+            double const output = 1.0 / ( 1.0 + std::exp( -( outputs[outputIdx] + -1.0 * WeightsHiddenOutput[NumHidden * NumOutputs + outputIdx] ) ) );
+            int32_t const isHigh = output > 0.9;
+            int32_t const isUndecided = !( output < 0.1 ) & !( output > 0.9 );
+            pOutputs[outputIdx] = output;
+            pClampedOutputs[outputIdx] = isHigh - isUndecided;
+        }
+    }
+}
+
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#pragma GCC pop_options
+#endif
+)";
+
+        return stream.str();
+    }
+
+    bool NetworkExporter::ExportHeader( std::string const& headerPath ) const
+    {
+        return WriteFile( headerPath, GenerateHeader() );
+    }
+
+    //-------------------------------------------------------------------------
+
+    std::string NetworkExporter::GenerateVerificationProgram( std::string const& headerInclude, std::vector<std::vector<double>> const& inputs ) const
+    {
+        assert( !inputs.empty() );
+
+        int32_t const numInputs = m_network.GetNumInputs();
+        int32_t const numOutputs = m_network.GetNumOutputs();
+        Network referenceNetwork( m_network );
+
+        std::ostringstream expectedOutputs;
+        std::ostringstream expectedClampedOutputs;
+        for ( auto const& input : inputs )
+        {
+            assert( input.size() == numInputs );
+            std::vector<int32_t> const& clampedOutputs = referenceNetwork.Evaluate( input );
+            WriteArrayValues( expectedOutputs, referenceNetwork.GetOutputs().data(), numOutputs, numOutputs, "    " );
+
+            expectedClampedOutputs << "    ";
+            for ( int32_t outputIdx = 0; outputIdx < numOutputs; outputIdx++ )
+            {
+                expectedClampedOutputs << clampedOutputs[outputIdx] << ",";
+            }
+            expectedClampedOutputs << "\n";
+        }
+
+        std::string const& ns = m_settings.m_namespace;
+
+        std::ostringstream stream;
+        stream << "//-------------------------------------------------------------------------\n";
+        stream << "// Generated by BPN::NetworkExporter - do not edit\n";
+        stream << "// Checks the generated scoring function against outputs recorded from BPN::Network::Evaluate\n";
+        stream << "//-------------------------------------------------------------------------\n\n";
+        stream << "#include \"" << headerInclude << "\"\n";
+        stream << "#include <stdio.h>\n";
+        stream << "#include <string.h>\n\n";
+        stream << "static uint32_t const g_numEntries = " << inputs.size() << ";\n\n";
+
+        stream << "static double const g_inputs[g_numEntries * " << ns << "::NumInputs] =\n{\n";
+        for ( auto const& input : inputs )
+        {
+            WriteArrayValues( stream, input.data(), numInputs, numInputs, "    " );
+        }
+        stream << "};\n\n";
+
+        stream << "static double const g_expectedOutputs[g_numEntries * " << ns << "::NumOutputs] =\n{\n";
+        stream << expectedOutputs.str();
+        stream << "};\n\n";
+
+        stream << "static int32_t const g_expectedClampedOutputs[g_numEntries * " << ns << "::NumOutputs] =\n{\n";
+        stream << expectedClampedOutputs.str();
+        stream << "};\n\n";
+
+        stream << "int main()\n{\n";
+        stream << "    uint32_t numMismatches = 0;\n";
+        stream << "    for ( uint32_t entryIdx = 0; entryIdx < g_numEntries; entryIdx++ )\n    {\n";
+        stream << "        double outputs[" << ns << "::NumOutputs];\n";
+        stream << "        int32_t clampedOutputs[" << ns << "::NumOutputs];\n";
+        stream << "        " << ns << "::" << m_settings.m_functionName << "( &g_inputs[entryIdx * " << ns << "::NumInputs], outputs, clampedOutputs );\n\n";
+        stream << "        // Compare the bit patterns, the results must be identical\n";
+        stream << "        if ( memcmp( outputs, &g_expectedOutputs[entryIdx * " << ns << "::NumOutputs], sizeof( outputs ) ) != 0 ||\n";
+        stream << "             memcmp( clampedOutputs, &g_expectedClampedOutputs[entryIdx * " << ns << "::NumOutputs], sizeof( clampedOutputs ) ) != 0 )\n";
+        stream << "        {\n";
+        stream << "            printf( \"Mismatch for entry %u\\n\", entryIdx );\n";
+        stream << "            numMismatches++;\n";
+        stream << "        }\n";
+        stream << "    }\n\n";
+        stream << "    printf( \"%u/%u entries match\\n\", g_numEntries - numMismatches, g_numEntries );\n";
+        stream << "    return numMismatches == 0 ? 0 : 1;\n";
+        stream << "}\n";
+
+        return stream.str();
+    }
+
+    bool NetworkExporter::ExportVerificationProgram( std::string const& programPath, std::string const& headerInclude, std::vector<std::vector<double>> const& inputs ) const
+    {
+        return WriteFile( programPath, GenerateVerificationProgram( headerInclude, inputs ) );
+    }
+}
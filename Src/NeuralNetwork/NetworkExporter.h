@@ -0,0 +1,52 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Ahead-of-time code generation of trained networks
+//
+// Exports a trained network as a self-contained C++ header: the weights are emitted as constexpr
+// arrays (exact hex float literals) together with a branch-free scoring function that has no
+// dependency on this library. The scoring function accumulates in the same order as
+// Network::Evaluate so the results are bit-identical, provided the generated code is not compiled
+// with -ffast-math or floating point contraction (-ffp-contract=off is the default in ISO C++ modes).
+//
+// A verification program can be generated alongside the header. It embeds a set of inputs and the
+// outputs the original network produced for them, and exits with a non-zero code on any mismatch.
+
+#pragma once
+
+#include "NeuralNetwork.h"
+#include <string>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class NetworkExporter
+    {
+    public:
+
+        struct Settings
+        {
+            std::string     m_namespace = "GeneratedNetwork";
+            std::string     m_functionName = "Evaluate";
+        };
+
+    public:
+
+        NetworkExporter( Settings const& settings, Network const& network );
+
+        std::string GenerateHeader() const;
+        bool ExportHeader( std::string const& headerPath ) const;
+
+        // The reference outputs are recorded by evaluating a copy of the exported network on the supplied inputs
+        std::string GenerateVerificationProgram( std::string const& headerInclude, std::vector<std::vector<double>> const& inputs ) const;
+        bool ExportVerificationProgram( std::string const& programPath, std::string const& headerInclude, std::vector<std::vector<double>> const& inputs ) const;
+
+    private:
+
+        Settings                    m_settings;
+        Network const&              m_network;
+    };
+}
@@ -0,0 +1,233 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "NetworkPruning.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        typedef std::function<void( double const*, uint32_t, double*, int32_t* )> BatchEvaluationFunction;
+
+        void GetAccuracyAndMSE( TrainingSet const& evaluationSet, std::vector<double> const& outputs, std::vector<int32_t> const& clampedOutputs, int32_t numOutputs, double& accuracy, double& mse )
+        {
+            double numIncorrectResults = 0;
+            double sumSquaredError = 0;
+            for ( size_t entryIdx = 0; entryIdx < evaluationSet.size(); entryIdx++ )
+            {
+                bool resultCorrect = true;
+                for ( int32_t outputIdx = 0; outputIdx < numOutputs; outputIdx++ )
+                {
+                    int32_t const expectedOutput = evaluationSet[entryIdx].m_expectedOutputs[outputIdx];
+                    if ( clampedOutputs[entryIdx * numOutputs + outputIdx] != expectedOutput )
+                    {
+                        resultCorrect = false;
+                    }
+
+                    sumSquaredError += pow( outputs[entryIdx * numOutputs + outputIdx] - expectedOutput, 2 );
+                }
+
+                if ( !resultCorrect )
+                {
+                    numIncorrectResults++;
+                }
+            }
+
+            accuracy = 100.0 - ( numIncorrectResults / evaluationSet.size() * 100.0 );
+            mse = sumSquaredError / ( numOutputs * evaluationSet.size() );
+        }
+
+        double GetRowsPerSecond( BatchEvaluationFunction const& evaluate, std::vector<double> const& inputs, uint32_t numEntries, uint32_t numOutputs, uint32_t numTimingPasses )
+        {
+            uint32_t const batchSize = 256;
+            std::vector<double> outputs( batchSize * numOutputs );
+            std::vector<int32_t> clampedOutputs( batchSize * numOutputs );
+            uint32_t const numInputs = (uint32_t) ( inputs.size() / numEntries );
+
+            auto const startTime = std::chrono::steady_clock::now();
+            for ( uint32_t passIdx = 0; passIdx < numTimingPasses; passIdx++ )
+            {
+                for ( uint32_t batchStart = 0; batchStart < numEntries; batchStart += batchSize )
+                {
+                    evaluate( &inputs[batchStart * numInputs], std::min( batchSize, numEntries - batchStart ), outputs.data(), clampedOutputs.data() );
+                }
+            }
+            double const elapsedSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+
+            return ( elapsedSeconds > 0 ) ? (double) numEntries * numTimingPasses / elapsedSeconds : 0.0;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    double NetworkPruner::GetInputHiddenSparsity( Network const& network )
+    {
+        size_t numZeroWeights = 0;
+        for ( int32_t inputIdx = 0; inputIdx < network.m_numInputs; inputIdx++ )
+        {
+            for ( int32_t hiddenIdx = 0; hiddenIdx < network.m_numHidden; hiddenIdx++ )
+            {
+                if ( network.m_weightsInputHidden[network.GetInputHiddenWeightIndex( inputIdx, hiddenIdx )] == 0.0 )
+                {
+                    numZeroWeights++;
+                }
+            }
+        }
+
+        return (double) numZeroWeights / ( (size_t) network.m_numInputs * network.m_numHidden );
+    }
+
+    void NetworkPruner::PruneInputHiddenWeights( Network& network, double sparsity, std::vector<uint8_t>& mask )
+    {
+        assert( sparsity >= 0.0 && sparsity <= 1.0 );
+
+        std::vector<double>& weights = network.m_weightsInputHidden;
+        if ( mask.empty() )
+        {
+            mask.resize( weights.size(), 1 );
+        }
+        assert( mask.size() == weights.size() );
+
+        // Gather the candidates, only the non-bias weights that are still unpruned
+        //-------------------------------------------------------------------------
+
+        size_t const numPrunableWeights = (size_t) network.m_numInputs * network.m_numHidden;
+        size_t const numWeightsToPrune = (size_t) std::llround( sparsity * numPrunableWeights );
+
+        std::vector<std::pair<double, int32_t>> candidates;
+        candidates.reserve( numPrunableWeights );
+        for ( int32_t inputIdx = 0; inputIdx < network.m_numInputs; inputIdx++ )
+        {
+            for ( int32_t hiddenIdx = 0; hiddenIdx < network.m_numHidden; hiddenIdx++ )
+            {
+                int32_t const weightIdx = network.GetInputHiddenWeightIndex( inputIdx, hiddenIdx );
+                if ( mask[weightIdx] != 0 )
+                {
+                    candidates.emplace_back( fabs( weights[weightIdx] ), weightIdx );
+                }
+            }
+        }
+
+        size_t const numAlreadyPruned = numPrunableWeights - candidates.size();
+        if ( numWeightsToPrune <= numAlreadyPruned )
+        {
+            return;
+        }
+
+        // Prune the smallest magnitudes, ties are broken by index so that the result is deterministic
+        //-------------------------------------------------------------------------
+
+        size_t const numNewlyPruned = numWeightsToPrune - numAlreadyPruned;
+        std::nth_element( candidates.begin(), candidates.begin() + ( numNewlyPruned - 1 ), candidates.end() );
+        for ( size_t candidateIdx = 0; candidateIdx < numNewlyPruned; candidateIdx++ )
+        {
+            int32_t const weightIdx = candidates[candidateIdx].second;
+            weights[weightIdx] = 0.0;
+            mask[weightIdx] = 0;
+        }
+    }
+
+    double NetworkPruner::GetScheduledSparsity( double targetSparsity, uint32_t startEpoch, uint32_t endEpoch, uint32_t epoch )
+    {
+        if ( epoch >= endEpoch )
+        {
+            return targetSparsity;
+        }
+
+        if ( epoch <= startEpoch )
+        {
+            return 0.0;
+        }
+
+        double const progress = double( epoch - startEpoch ) / ( endEpoch - startEpoch );
+        return targetSparsity * ( 1.0 - pow( 1.0 - progress, 3 ) );
+    }
+
+    //-------------------------------------------------------------------------
+
+    NetworkPruner::Report NetworkPruner::CompareWithDense( Network const& denseNetwork, Network const& prunedNetwork, TrainingSet const& evaluationSet, uint32_t numTimingPasses )
+    {
+        assert( denseNetwork.m_numInputs == prunedNetwork.m_numInputs && denseNetwork.m_numHidden == prunedNetwork.m_numHidden && denseNetwork.m_numOutputs == prunedNetwork.m_numOutputs );
+        assert( !evaluationSet.empty() );
+
+        Report report;
+        SparseNetwork const csrNetwork( prunedNetwork, SparseNetwork::Format::CSR );
+        SparseNetwork const blockSparseNetwork( prunedNetwork, SparseNetwork::Format::BlockSparse );
+
+        report.m_sparsity = GetInputHiddenSparsity( prunedNetwork );
+        report.m_denseSizeBytes = (size_t) ( denseNetwork.m_numInputs + 1 ) * denseNetwork.m_numHidden * sizeof( double );
+        report.m_csrSizeBytes = csrNetwork.GetInputHiddenSizeBytes();
+        report.m_blockSparseSizeBytes = blockSparseNetwork.GetInputHiddenSizeBytes();
+
+        // Accuracy
+        //-------------------------------------------------------------------------
+
+        uint32_t const numEntries = (uint32_t) evaluationSet.size();
+        int32_t const numOutputs = denseNetwork.m_numOutputs;
+
+        std::vector<double> inputs;
+        inputs.reserve( (size_t) numEntries * denseNetwork.m_numInputs );
+        for ( auto const& entry : evaluationSet )
+        {
+            inputs.insert( inputs.end(), entry.m_inputs.begin(), entry.m_inputs.end() );
+        }
+
+        std::vector<double> outputs( (size_t) numEntries * numOutputs );
+        std::vector<int32_t> clampedOutputs( (size_t) numEntries * numOutputs );
+        denseNetwork.EvaluateBatch( inputs.data(), numEntries, outputs.data(), clampedOutputs.data() );
+        GetAccuracyAndMSE( evaluationSet, outputs, clampedOutputs, numOutputs, report.m_denseAccuracy, report.m_denseMSE );
+
+        prunedNetwork.EvaluateBatch( inputs.data(), numEntries, outputs.data(), clampedOutputs.data() );
+        GetAccuracyAndMSE( evaluationSet, outputs, clampedOutputs, numOutputs, report.m_prunedAccuracy, report.m_prunedMSE );
+
+        std::vector<double> sparseOutputs( outputs.size() );
+        for ( SparseNetwork const* pSparseNetwork : { &csrNetwork, &blockSparseNetwork } )
+        {
+            pSparseNetwork->EvaluateBatch( inputs.data(), numEntries, sparseOutputs.data(), clampedOutputs.data() );
+            for ( size_t valueIdx = 0; valueIdx < outputs.size(); valueIdx++ )
+            {
+                report.m_maxSparseOutputError = std::max( report.m_maxSparseOutputError, fabs( sparseOutputs[valueIdx] - outputs[valueIdx] ) );
+            }
+        }
+
+        // Inference throughput
+        //-------------------------------------------------------------------------
+
+        using namespace std::placeholders;
+        report.m_denseRowsPerSecond = GetRowsPerSecond( std::bind( &Network::EvaluateBatch, &denseNetwork, _1, _2, _3, _4 ), inputs, numEntries, numOutputs, numTimingPasses );
+        report.m_prunedDenseRowsPerSecond = GetRowsPerSecond( std::bind( &Network::EvaluateBatch, &prunedNetwork, _1, _2, _3, _4 ), inputs, numEntries, numOutputs, numTimingPasses );
+        report.m_csrRowsPerSecond = GetRowsPerSecond( std::bind( &SparseNetwork::EvaluateBatch, &csrNetwork, _1, _2, _3, _4 ), inputs, numEntries, numOutputs, numTimingPasses );
+        report.m_blockSparseRowsPerSecond = GetRowsPerSecond( std::bind( &SparseNetwork::EvaluateBatch, &blockSparseNetwork, _1, _2, _3, _4 ), inputs, numEntries, numOutputs, numTimingPasses );
+
+        return report;
+    }
+
+    void NetworkPruner::PrintReport( std::ostream& stream, Report const& report )
+    {
+        auto GetSpeedup = [&report] ( double rowsPerSecond ) { return ( report.m_denseRowsPerSecond > 0 ) ? rowsPerSecond / report.m_denseRowsPerSecond : 0.0; };
+
+        stream << std::endl << " Pruning Report: " << std::endl
+               << "==========================================================================" << std::endl
+               << " Input->Hidden Sparsity: " << report.m_sparsity * 100.0 << "%" << std::endl
+               << " Accuracy: " << report.m_denseAccuracy << "% -> " << report.m_prunedAccuracy << "% (delta: " << report.m_prunedAccuracy - report.m_denseAccuracy << ")" << std::endl
+               << " MSE: " << report.m_denseMSE << " -> " << report.m_prunedMSE << " (delta: " << report.m_prunedMSE - report.m_denseMSE << ")" << std::endl
+               << " Input->Hidden Size (bytes) - Dense: " << report.m_denseSizeBytes << ", CSR: " << report.m_csrSizeBytes << ", Block Sparse: " << report.m_blockSparseSizeBytes << std::endl
+               << " Rows/s - Dense: " << report.m_denseRowsPerSecond
+               << ", Pruned Dense: " << report.m_prunedDenseRowsPerSecond << " (" << GetSpeedup( report.m_prunedDenseRowsPerSecond ) << "x)"
+               << ", CSR: " << report.m_csrRowsPerSecond << " (" << GetSpeedup( report.m_csrRowsPerSecond ) << "x)"
+               << ", Block Sparse: " << report.m_blockSparseRowsPerSecond << " (" << GetSpeedup( report.m_blockSparseRowsPerSecond ) << "x)" << std::endl
+               << " Max Sparse Kernel Output Error: " << report.m_maxSparseOutputError << std::endl
+               << "==========================================================================" << std::endl << std::endl;
+    }
+}
@@ -0,0 +1,64 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Magnitude pruning of the input->hidden weights
+//
+// Pruning zeroes the smallest magnitude input->hidden weights, the bias weights are never pruned. A mask
+// records the pruned weights so that training can keep them at zero: one-shot pruning is done through
+// NetworkTrainer::PruneInputHiddenWeights, gradual pruning by setting a target sparsity in the trainer
+// settings, which then prunes on a cubic schedule between the pruning start and end epochs.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include "SparseNetwork.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class NetworkPruner
+    {
+    public:
+
+        struct Report
+        {
+            double                      m_sparsity = 0;                     // Fraction of the non-bias input->hidden weights that are zero
+            size_t                      m_denseSizeBytes = 0;
+            size_t                      m_csrSizeBytes = 0;
+            size_t                      m_blockSparseSizeBytes = 0;
+
+            double                      m_denseAccuracy = 0;
+            double                      m_denseMSE = 0;
+            double                      m_prunedAccuracy = 0;
+            double                      m_prunedMSE = 0;
+
+            double                      m_denseRowsPerSecond = 0;           // Network::EvaluateBatch on the dense network
+            double                      m_prunedDenseRowsPerSecond = 0;     // Network::EvaluateBatch on the pruned network
+            double                      m_csrRowsPerSecond = 0;
+            double                      m_blockSparseRowsPerSecond = 0;
+
+            double                      m_maxSparseOutputError = 0;         // Max difference between the sparse kernels and the pruned dense network
+        };
+
+    public:
+
+        // Fraction of the non-bias input->hidden weights that are zero
+        static double GetInputHiddenSparsity( Network const& network );
+
+        // Zeroes the smallest magnitude non-bias input->hidden weights that aren't masked yet until the requested fraction of them is pruned.
+        // The mask has an entry per input->hidden weight, 0 for pruned weights, an empty mask is initialized with nothing pruned.
+        static void PruneInputHiddenWeights( Network& network, double sparsity, std::vector<uint8_t>& mask );
+
+        // Sparsity the gradual pruning schedule prescribes at the given epoch: s * ( 1 - ( 1 - t )^3 ) for t going from 0 to 1 between the start and end epochs
+        static double GetScheduledSparsity( double targetSparsity, uint32_t startEpoch, uint32_t endEpoch, uint32_t epoch );
+
+        // Compares the accuracy of the pruned network against the dense one on the evaluation set and times the dense and sparse kernels over it
+        static Report CompareWithDense( Network const& denseNetwork, Network const& prunedNetwork, TrainingSet const& evaluationSet, uint32_t numTimingPasses = 20 );
+
+        static void PrintReport( std::ostream& stream, Report const& report );
+    };
+}
@@ -0,0 +1,149 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "NetworkSerialization.h"
+#include <string.h>
+#include <fstream>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        char const      g_modelFileMagic[4] = { 'B', 'P', 'N', 'N' };
+        uint32_t const  g_modelFileVersion = 2;
+        uint32_t const  g_minModelFileVersion = 1;
+
+        // Sanity limit for the layer sizes read from a file
+        uint32_t const  g_maxLayerSize = 1 << 20;
+
+        template<typename T>
+        void Write( std::ostream& stream, T const& value )
+        {
+            stream.write( reinterpret_cast<char const*>( &value ), sizeof( T ) );
+        }
+
+        template<typename T>
+        bool Read( std::istream& stream, T& value )
+        {
+            stream.read( reinterpret_cast<char*>( &value ), sizeof( T ) );
+            return stream.good();
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    bool SaveNetwork( std::string const& path, Network const& network, FeatureNormalizer const& normalizer )
+    {
+        std::ofstream outputFile( path, std::ios::out | std::ios::binary | std::ios::trunc );
+        if ( !outputFile.is_open() )
+        {
+            std::cout << "Error Opening Model File: " << path << std::endl;
+            return false;
+        }
+
+        std::vector<double> const weights = normalizer.FoldIntoNetwork( network ).GetWeights();
+
+        outputFile.write( g_modelFileMagic, sizeof( g_modelFileMagic ) );
+        Write( outputFile, g_modelFileVersion );
+        Write( outputFile, (uint32_t) network.GetNumInputs() );
+        Write( outputFile, (uint32_t) network.GetNumHidden() );
+        Write( outputFile, (uint32_t) network.GetNumOutputs() );
+        Write( outputFile, (uint32_t) normalizer.GetType() );
+        if ( !normalizer.IsIdentity() )
+        {
+            outputFile.write( reinterpret_cast<char const*>( normalizer.GetScales().data() ), normalizer.GetScales().size() * sizeof( double ) );
+            outputFile.write( reinterpret_cast<char const*>( normalizer.GetOffsets().data() ), normalizer.GetOffsets().size() * sizeof( double ) );
+        }
+        outputFile.write( reinterpret_cast<char const*>( weights.data() ), weights.size() * sizeof( double ) );
+
+        if ( !outputFile.good() )
+        {
+            std::cout << "Error Writing Model File: " << path << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool LoadNetwork( std::string const& path, std::unique_ptr<Network>& pNetwork, FeatureNormalizer* pNormalizer )
+    {
+        std::ifstream inputFile( path, std::ios::in | std::ios::binary );
+        if ( !inputFile.is_open() )
+        {
+            std::cout << "Error Opening Model File: " << path << std::endl;
+            return false;
+        }
+
+        char magic[4];
+        uint32_t version = 0;
+        Network::Settings settings;
+        inputFile.read( magic, sizeof( magic ) );
+        if ( !inputFile.good() || memcmp( magic, g_modelFileMagic, sizeof( magic ) ) != 0 || !Read( inputFile, version ) || version < g_minModelFileVersion || version > g_modelFileVersion )
+        {
+            std::cout << "Invalid Model File: " << path << std::endl;
+            return false;
+        }
+
+        if ( !Read( inputFile, settings.m_numInputs ) || !Read( inputFile, settings.m_numHidden ) || !Read( inputFile, settings.m_numOutputs ) ||
+             settings.m_numInputs == 0 || settings.m_numHidden == 0 || settings.m_numOutputs == 0 ||
+             settings.m_numInputs > g_maxLayerSize || settings.m_numHidden > g_maxLayerSize || settings.m_numOutputs > g_maxLayerSize )
+        {
+            std::cout << "Invalid Model File: " << path << std::endl;
+            return false;
+        }
+
+        // Normalization
+        //-------------------------------------------------------------------------
+
+        FeatureNormalizer normalizer;
+        uint32_t normalizationType = (uint32_t) NormalizationType::None;
+        if ( version >= 2 )
+        {
+            if ( !Read( inputFile, normalizationType ) || normalizationType > (uint32_t) NormalizationType::ZScore )
+            {
+                std::cout << "Invalid Model File: " << path << std::endl;
+                return false;
+            }
+
+            if ( normalizationType != (uint32_t) NormalizationType::None )
+            {
+                std::vector<double> scales( settings.m_numInputs );
+                std::vector<double> offsets( settings.m_numInputs );
+                inputFile.read( reinterpret_cast<char*>( scales.data() ), scales.size() * sizeof( double ) );
+                inputFile.read( reinterpret_cast<char*>( offsets.data() ), offsets.size() * sizeof( double ) );
+                if ( !inputFile.good() )
+                {
+                    std::cout << "Error Reading Model File: " << path << std::endl;
+                    return false;
+                }
+
+                normalizer = FeatureNormalizer( (NormalizationType) normalizationType, scales, offsets );
+            }
+        }
+
+        // Weights
+        //-------------------------------------------------------------------------
+
+        size_t const numWeights = ( (size_t) settings.m_numInputs + 1 ) * settings.m_numHidden + ( (size_t) settings.m_numHidden + 1 ) * settings.m_numOutputs;
+        std::vector<double> weights( numWeights );
+        inputFile.read( reinterpret_cast<char*>( weights.data() ), numWeights * sizeof( double ) );
+        if ( !inputFile.good() )
+        {
+            std::cout << "Error Reading Model File: " << path << std::endl;
+            return false;
+        }
+
+        pNetwork.reset( new Network( settings, weights ) );
+        if ( pNormalizer != nullptr )
+        {
+            *pNormalizer = normalizer;
+        }
+        return true;
+    }
+}
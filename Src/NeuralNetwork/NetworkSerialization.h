@@ -0,0 +1,31 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Saving and loading of trained networks
+//
+// Binary model file: "BPNN" magic, uint32 format version, uint32 num inputs/hidden/outputs, uint32 input
+// normalization type followed, unless the type is None, by the per-input normalization scales and offsets,
+// and finally the weights as returned by Network::GetWeights. Values are stored in the host byte order.
+// Version 1 files have no normalization section.
+//
+// The saved weights always take the raw inputs: the normalization is folded into them on save, it is only
+// stored so that tools can normalize new training data the same way.
+
+#pragma once
+
+#include "FeatureNormalizer.h"
+#include <memory>
+#include <string>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    // The network is expected to have been trained on inputs normalized with the supplied normalizer
+    bool SaveNetwork( std::string const& path, Network const& network, FeatureNormalizer const& normalizer = FeatureNormalizer() );
+
+    // The loaded network takes the raw inputs, the normalization it was trained with is optionally returned
+    bool LoadNetwork( std::string const& path, std::unique_ptr<Network>& pNetwork, FeatureNormalizer* pNormalizer = nullptr );
+}
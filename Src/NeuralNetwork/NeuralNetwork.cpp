@@ -1,170 +1,256 @@
-//-------------------------------------------------------------------------
-// Simple back-propagation neural network example
-// 2017 - Bobby Anguelov
-// MIT license: https://opensource.org/licenses/MIT
-//-------------------------------------------------------------------------
-
-#include "NeuralNetwork.h"
-#include <assert.h>
-#include <stdlib.h>
-#include <ctime>
-#include <random>
-
-//-------------------------------------------------------------------------
-
-namespace BPN
-{
-    Network::Network( Settings const& settings )
-        : m_numInputs( settings.m_numInputs )
-        , m_numHidden( settings.m_numHidden )
-        , m_numOutputs( settings.m_numOutputs )
-    {
-        assert( settings.m_numInputs > 0 && settings.m_numOutputs > 0 && settings.m_numHidden > 0 );
-        InitializeNetwork();
-        InitializeWeights();
-    }
-
-    Network::Network( Settings const& settings, std::vector<double> const& weights )
-        : m_numInputs( settings.m_numInputs )
-        , m_numHidden( settings.m_numHidden )
-        , m_numOutputs( settings.m_numOutputs )
-    {
-        assert( settings.m_numInputs > 0 && settings.m_numOutputs > 0 && settings.m_numHidden > 0 );
-        InitializeNetwork();
-        LoadWeights( weights );
-    }
-
-    void Network::InitializeNetwork()
-    {
-        // Create storage and initialize the neurons and the outputs
-        //-------------------------------------------------------------------------
-
-        // Add bias neurons
-        int32_t const totalNumInputs = m_numInputs + 1;
-        int32_t const totalNumHiddens = m_numHidden + 1;
-
-        m_inputNeurons.resize( totalNumInputs );
-        m_hiddenNeurons.resize( totalNumHiddens );
-        m_outputNeurons.resize( m_numOutputs );
-        m_clampedOutputs.resize( m_numOutputs );
-
-        memset( m_inputNeurons.data(), 0, m_inputNeurons.size() * sizeof( double ) );
-        memset( m_hiddenNeurons.data(), 0, m_hiddenNeurons.size() * sizeof( double ) );
-        memset( m_outputNeurons.data(), 0, m_outputNeurons.size() * sizeof( double ) );
-        memset( m_clampedOutputs.data(), 0, m_clampedOutputs.size() * sizeof( int32_t ) );
-
-        // Set bias values
-        m_inputNeurons.back() = -1.0;
-        m_hiddenNeurons.back() = -1.0;
-
-        // Create storage and initialize and layer weights
-        //-------------------------------------------------------------------------
-
-        int32_t const numInputHiddenWeights = totalNumInputs * totalNumHiddens;
-        int32_t const numHiddenOutputWeights = totalNumHiddens * m_numOutputs;
-        m_weightsInputHidden.resize( numInputHiddenWeights );
-        m_weightsHiddenOutput.resize( numHiddenOutputWeights );
-    }
-
-    void Network::InitializeWeights()
-    {
-        std::random_device rd;
-        std::mt19937 generator( rd() );
-
-        double const distributionRangeHalfWidth = ( 2.4 / m_numInputs );
-        double const standardDeviation = distributionRangeHalfWidth * 2 / 6;
-        std::normal_distribution<> normalDistribution( 0, standardDeviation );
-
-        // Set weights to normally distributed random values between [-2.4 / numInputs, 2.4 / numInputs]
-        for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
-        {
-            for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
-            {
-                int32_t const weightIdx = GetInputHiddenWeightIndex( inputIdx, hiddenIdx );
-                double const weight = normalDistribution( generator );
-                m_weightsInputHidden[weightIdx] = weight;
-            }
-        }
-
-        // Set weights to normally distributed random values between [-2.4 / numInputs, 2.4 / numInputs]
-        for ( int32_t hiddenIdx = 0; hiddenIdx <= m_numHidden; hiddenIdx++ )
-        {
-            for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
-            {
-                int32_t const weightIdx = GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
-                double const weight = normalDistribution( generator );
-                m_weightsHiddenOutput[weightIdx] = weight;
-            }
-        }
-    }
-
-    void Network::LoadWeights( std::vector<double> const& weights )
-    {
-        int32_t const numInputHiddenWeights = m_numInputs * m_numHidden;
-        int32_t const numHiddenOutputWeights = m_numHidden * m_numOutputs;
-        assert( weights.size() == numInputHiddenWeights + numHiddenOutputWeights );
-
-        int32_t weightIdx = 0;
-        for ( auto InputHiddenIdx = 0; InputHiddenIdx < numInputHiddenWeights; InputHiddenIdx++ )
-        {
-            m_weightsInputHidden[InputHiddenIdx] = weights[weightIdx];
-            weightIdx++;
-        }
-
-        for ( auto HiddenOutputIdx = 0; HiddenOutputIdx < numHiddenOutputWeights; HiddenOutputIdx++ )
-        {
-            m_weightsHiddenOutput[HiddenOutputIdx] = weights[weightIdx];
-            weightIdx++;
-        }
-    }
-
-    std::vector<int32_t> const& Network::Evaluate( std::vector<double> const& input )
-    {
-        assert( input.size() == m_numInputs );
-        assert( m_inputNeurons.back() == -1.0 && m_hiddenNeurons.back() == -1.0 );
-
-        // Set input values
-        //-------------------------------------------------------------------------
-
-        memcpy( m_inputNeurons.data(), input.data(), input.size() * sizeof( double ) );
-
-        // Update hidden neurons
-        //-------------------------------------------------------------------------
-
-        for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
-        {
-            m_hiddenNeurons[hiddenIdx] = 0;
-
-            // Get weighted sum of pattern and bias neuron
-            for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
-            {
-                int32_t const weightIdx = GetInputHiddenWeightIndex( inputIdx, hiddenIdx );
-                m_hiddenNeurons[hiddenIdx] += m_inputNeurons[inputIdx] * m_weightsInputHidden[weightIdx];
-            }
-
-            // Apply activation function
-            m_hiddenNeurons[hiddenIdx] = SigmoidActivationFunction( m_hiddenNeurons[hiddenIdx] );
-        }
-
-        // Calculate output values - include bias neuron
-        //-------------------------------------------------------------------------
-
-        for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
-        {
-            m_outputNeurons[outputIdx] = 0;
-
-            // Get weighted sum of pattern and bias neuron
-            for ( int32_t hiddenIdx = 0; hiddenIdx <= m_numHidden; hiddenIdx++ )
-            {
-                int32_t const weightIdx = GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
-                m_outputNeurons[outputIdx] += m_hiddenNeurons[hiddenIdx] * m_weightsHiddenOutput[weightIdx];
-            }
-
-            // Apply activation function and clamp the result
-            m_outputNeurons[outputIdx] = SigmoidActivationFunction( m_outputNeurons[outputIdx] );
-            m_clampedOutputs[outputIdx] = ClampOutputValue( m_outputNeurons[outputIdx] );
-        }
-
-        return m_clampedOutputs;
-    }
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "NeuralNetwork.h"
+#include "Gemm.h"
+#include "Profiling.h"
+#include "Random.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <ctime>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    Network::Network( Settings const& settings )
+        : m_numInputs( settings.m_numInputs )
+        , m_numHidden( settings.m_numHidden )
+        , m_numOutputs( settings.m_numOutputs )
+    {
+        assert( settings.m_numInputs > 0 && settings.m_numOutputs > 0 && settings.m_numHidden > 0 );
+        InitializeNetwork();
+        InitializeWeights( settings.m_seed );
+    }
+
+    Network::Network( Settings const& settings, std::vector<double> const& weights )
+        : m_numInputs( settings.m_numInputs )
+        , m_numHidden( settings.m_numHidden )
+        , m_numOutputs( settings.m_numOutputs )
+    {
+        assert( settings.m_numInputs > 0 && settings.m_numOutputs > 0 && settings.m_numHidden > 0 );
+        InitializeNetwork();
+        LoadWeights( weights );
+    }
+
+    void Network::InitializeNetwork()
+    {
+        // Create storage and initialize the neurons and the outputs
+        //-------------------------------------------------------------------------
+
+        // Add bias neurons
+        int32_t const totalNumInputs = m_numInputs + 1;
+        int32_t const totalNumHiddens = m_numHidden + 1;
+
+        m_inputNeurons.resize( totalNumInputs );
+        m_hiddenNeurons.resize( totalNumHiddens );
+        m_outputNeurons.resize( m_numOutputs );
+        m_clampedOutputs.resize( m_numOutputs );
+
+        memset( m_inputNeurons.data(), 0, m_inputNeurons.size() * sizeof( double ) );
+        memset( m_hiddenNeurons.data(), 0, m_hiddenNeurons.size() * sizeof( double ) );
+        memset( m_outputNeurons.data(), 0, m_outputNeurons.size() * sizeof( double ) );
+        memset( m_clampedOutputs.data(), 0, m_clampedOutputs.size() * sizeof( int32_t ) );
+
+        // Set bias values
+        m_inputNeurons.back() = -1.0;
+        m_hiddenNeurons.back() = -1.0;
+
+        // Create storage and initialize and layer weights
+        //-------------------------------------------------------------------------
+
+        int32_t const numInputHiddenWeights = totalNumInputs * totalNumHiddens;
+        int32_t const numHiddenOutputWeights = totalNumHiddens * m_numOutputs;
+        m_weightsInputHidden.resize( numInputHiddenWeights );
+        m_weightsHiddenOutput.resize( numHiddenOutputWeights );
+    }
+
+    void Network::InitializeWeights( uint64_t seed )
+    {
+        RandomStream randomStream( seed );
+
+        double const distributionRangeHalfWidth = ( 2.4 / m_numInputs );
+        double const standardDeviation = distributionRangeHalfWidth * 2 / 6;
+
+        // Set weights to normally distributed random values between [-2.4 / numInputs, 2.4 / numInputs]
+        for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
+        {
+            for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+            {
+                int32_t const weightIdx = GetInputHiddenWeightIndex( inputIdx, hiddenIdx );
+                double const weight = randomStream.NextNormal( 0, standardDeviation );
+                m_weightsInputHidden[weightIdx] = weight;
+            }
+        }
+
+        // Set weights to normally distributed random values between [-2.4 / numInputs, 2.4 / numInputs]
+        for ( int32_t hiddenIdx = 0; hiddenIdx <= m_numHidden; hiddenIdx++ )
+        {
+            for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+            {
+                int32_t const weightIdx = GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
+                double const weight = randomStream.NextNormal( 0, standardDeviation );
+                m_weightsHiddenOutput[weightIdx] = weight;
+            }
+        }
+    }
+
+    void Network::LoadWeights( std::vector<double> const& weights )
+    {
+        // Include the bias neuron weights
+        int32_t const numInputHiddenWeights = ( m_numInputs + 1 ) * m_numHidden;
+        int32_t const numHiddenOutputWeights = ( m_numHidden + 1 ) * m_numOutputs;
+        assert( weights.size() == numInputHiddenWeights + numHiddenOutputWeights );
+
+        int32_t weightIdx = 0;
+        for ( auto InputHiddenIdx = 0; InputHiddenIdx < numInputHiddenWeights; InputHiddenIdx++ )
+        {
+            m_weightsInputHidden[InputHiddenIdx] = weights[weightIdx];
+            weightIdx++;
+        }
+
+        for ( auto HiddenOutputIdx = 0; HiddenOutputIdx < numHiddenOutputWeights; HiddenOutputIdx++ )
+        {
+            m_weightsHiddenOutput[HiddenOutputIdx] = weights[weightIdx];
+            weightIdx++;
+        }
+    }
+
+    std::vector<double> Network::GetWeights() const
+    {
+        int32_t const numInputHiddenWeights = ( m_numInputs + 1 ) * m_numHidden;
+        int32_t const numHiddenOutputWeights = ( m_numHidden + 1 ) * m_numOutputs;
+
+        std::vector<double> weights( m_weightsInputHidden.begin(), m_weightsInputHidden.begin() + numInputHiddenWeights );
+        weights.insert( weights.end(), m_weightsHiddenOutput.begin(), m_weightsHiddenOutput.begin() + numHiddenOutputWeights );
+        return weights;
+    }
+
+    std::vector<int32_t> const& Network::Evaluate( std::vector<double> const& input )
+    {
+        assert( input.size() == m_numInputs );
+        return Evaluate( input.data() );
+    }
+
+    std::vector<int32_t> const& Network::Evaluate( double const* pInputs )
+    {
+        memcpy( m_inputNeurons.data(), pInputs, m_numInputs * sizeof( double ) );
+        return EvaluateInputNeurons();
+    }
+
+    std::vector<int32_t> const& Network::Evaluate( uint8_t const* pInputs )
+    {
+        for ( int32_t inputIdx = 0; inputIdx < m_numInputs; inputIdx++ )
+        {
+            m_inputNeurons[inputIdx] = (double) pInputs[inputIdx];
+        }
+
+        return EvaluateInputNeurons();
+    }
+
+    std::vector<int32_t> const& Network::Evaluate( uint16_t const* pInputs )
+    {
+        for ( int32_t inputIdx = 0; inputIdx < m_numInputs; inputIdx++ )
+        {
+            m_inputNeurons[inputIdx] = (double) pInputs[inputIdx];
+        }
+
+        return EvaluateInputNeurons();
+    }
+
+    std::vector<int32_t> const& Network::EvaluateInputNeurons()
+    {
+        BPN_PROFILE_SCOPE( Evaluate );
+
+        assert( m_inputNeurons.back() == -1.0 && m_hiddenNeurons.back() == -1.0 );
+
+        // Update hidden neurons
+        //-------------------------------------------------------------------------
+
+        for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+        {
+            m_hiddenNeurons[hiddenIdx] = 0;
+
+            // Get weighted sum of pattern and bias neuron
+            for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
+            {
+                int32_t const weightIdx = GetInputHiddenWeightIndex( inputIdx, hiddenIdx );
+                m_hiddenNeurons[hiddenIdx] += m_inputNeurons[inputIdx] * m_weightsInputHidden[weightIdx];
+            }
+
+            // Apply activation function
+            m_hiddenNeurons[hiddenIdx] = SigmoidActivationFunction( m_hiddenNeurons[hiddenIdx] );
+        }
+
+        // Calculate output values - include bias neuron
+        //-------------------------------------------------------------------------
+
+        for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+        {
+            m_outputNeurons[outputIdx] = 0;
+
+            // Get weighted sum of pattern and bias neuron
+            for ( int32_t hiddenIdx = 0; hiddenIdx <= m_numHidden; hiddenIdx++ )
+            {
+                int32_t const weightIdx = GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
+                m_outputNeurons[outputIdx] += m_hiddenNeurons[hiddenIdx] * m_weightsHiddenOutput[weightIdx];
+            }
+
+            // Apply activation function and clamp the result
+            m_outputNeurons[outputIdx] = SigmoidActivationFunction( m_outputNeurons[outputIdx] );
+            m_clampedOutputs[outputIdx] = ClampOutputValue( m_outputNeurons[outputIdx] );
+        }
+
+        return m_clampedOutputs;
+    }
+
+    void Network::EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs ) const
+    {
+        BPN_PROFILE_SCOPE( Evaluate );
+
+        // Rows are evaluated in tiles, each layer being a single matrix multiplication per tile. The built-in GEMM
+        // backends sum in the same order as Evaluate and the bias is added last, so the results are identical.
+        uint32_t const tileSize = 64;
+        std::vector<double> hiddenTile( tileSize * ( m_numHidden + 1 ) );
+        std::vector<double> outputTile( tileSize * m_numOutputs );
+        double* pHiddenTile = hiddenTile.data();
+        double const* pBiasWeights = &m_weightsInputHidden[GetInputHiddenWeightIndex( m_numInputs, 0 )];
+
+        for ( uint32_t tileStart = 0; tileStart < numEntries; tileStart += tileSize )
+        {
+            uint32_t const numTileEntries = std::min( tileSize, numEntries - tileStart );
+
+            // Update hidden neurons
+            //-------------------------------------------------------------------------
+
+            Gemm::Multiply( false, false, numTileEntries, m_numHidden, m_numInputs, 1.0, &pInputs[(size_t) tileStart * m_numInputs], m_numInputs, m_weightsInputHidden.data(), m_numHidden, 0.0, pHiddenTile, m_numHidden + 1 );
+
+            for ( uint32_t rowIdx = 0; rowIdx < numTileEntries; rowIdx++ )
+            {
+                double* pHidden = &pHiddenTile[rowIdx * ( m_numHidden + 1 )];
+                for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+                {
+                    pHidden[hiddenIdx] = SigmoidActivationFunction( pHidden[hiddenIdx] + -1.0 * pBiasWeights[hiddenIdx] );
+                }
+                pHidden[m_numHidden] = -1.0;
+            }
+
+            // Calculate output values - include bias neuron
+            //-------------------------------------------------------------------------
+
+            Gemm::Multiply( false, false, numTileEntries, m_numOutputs, m_numHidden + 1, 1.0, pHiddenTile, m_numHidden + 1, m_weightsHiddenOutput.data(), m_numOutputs, 0.0, outputTile.data(), m_numOutputs );
+
+            for ( uint32_t valueIdx = 0; valueIdx < numTileEntries * m_numOutputs; valueIdx++ )
+            {
+                size_t const outputIdx = (size_t) tileStart * m_numOutputs + valueIdx;
+                pOutputs[outputIdx] = SigmoidActivationFunction( outputTile[valueIdx] );
+                pClampedOutputs[outputIdx] = ClampOutputValue( pOutputs[outputIdx] );
+            }
+        }
+    }
 }
\ No newline at end of file
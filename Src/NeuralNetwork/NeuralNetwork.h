@@ -1,84 +1,116 @@
-//-------------------------------------------------------------------------
-// Simple back-propagation neural network example
-// 2017 - Bobby Anguelov
-// MIT license: https://opensource.org/licenses/MIT
-//-------------------------------------------------------------------------
-// A simple neural network supporting only a single hidden layer
-
-#pragma once
-#include <stdint.h>
-#include <vector>
-
-//-------------------------------------------------------------------------
-
-namespace BPN
-{
-    enum class ActivationFunctionType
-    {
-        Sigmoid
-    };
-
-    //-------------------------------------------------------------------------
-
-    class Network
-    {
-        friend class NetworkTrainer;
-
-        //-------------------------------------------------------------------------
-
-        inline static double SigmoidActivationFunction( double x )
-        {
-            return 1.0 / ( 1.0 + std::exp( -x ) );
-        }
-
-        inline static int32_t ClampOutputValue( double x )
-        {
-            if ( x < 0.1 ) return 0;
-            else if ( x > 0.9 ) return 1;
-            else return -1;
-        }
-
-    public:
-
-        struct Settings
-        {
-            uint32_t                        m_numInputs;
-            uint32_t                        m_numHidden;
-            uint32_t                        m_numOutputs;
-        };
-
-    public:
-
-        Network( Settings const& settings );
-        Network( Settings const& settings, std::vector<double> const& weights );
-
-        std::vector<int32_t> const& Evaluate( std::vector<double> const& input );
-
-        std::vector<double> const& GetInputHiddenWeights() const { return m_weightsInputHidden; }
-        std::vector<double> const& GetHiddenOutputWeights() const { return m_weightsHiddenOutput; }
-
-    private:
-
-        void InitializeNetwork();
-        void InitializeWeights();
-        void LoadWeights( std::vector<double> const& weights );
-
-        int32_t GetInputHiddenWeightIndex( int32_t inputIdx, int32_t hiddenIdx ) const { return inputIdx * m_numHidden + hiddenIdx; }
-        int32_t GetHiddenOutputWeightIndex( int32_t hiddenIdx, int32_t outputIdx ) const { return hiddenIdx * m_numOutputs + outputIdx; }
-
-    private:
-
-        int32_t                 m_numInputs;
-        int32_t                 m_numHidden;
-        int32_t                 m_numOutputs;
-
-        std::vector<double>     m_inputNeurons;
-        std::vector<double>     m_hiddenNeurons;
-        std::vector<double>     m_outputNeurons;
-
-        std::vector<int32_t>    m_clampedOutputs;
-
-        std::vector<double>     m_weightsInputHidden;
-        std::vector<double>     m_weightsHiddenOutput;
-    };
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// A simple neural network supporting only a single hidden layer
+
+#pragma once
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    enum class ActivationFunctionType
+    {
+        Sigmoid
+    };
+
+    //-------------------------------------------------------------------------
+
+    class Network
+    {
+        friend class NetworkTrainer;
+        friend class Ensemble;
+        friend class NetworkPruner;
+        friend class SparseNetwork;
+        friend class GradientChecker;
+        friend class NumaTrainer;
+        friend class DistributedTrainer;
+        friend class IncrementalEvaluator;
+
+        //-------------------------------------------------------------------------
+
+        inline static double SigmoidActivationFunction( double x )
+        {
+            return 1.0 / ( 1.0 + std::exp( -x ) );
+        }
+
+        inline static int32_t ClampOutputValue( double x )
+        {
+            if ( x < 0.1 ) return 0;
+            else if ( x > 0.9 ) return 1;
+            else return -1;
+        }
+
+    public:
+
+        struct Settings
+        {
+            uint32_t                        m_numInputs;
+            uint32_t                        m_numHidden;
+            uint32_t                        m_numOutputs;
+            uint64_t                        m_seed = 0;         // Seed for the initial weights, the same seed always gives the same network
+        };
+
+    public:
+
+        Network( Settings const& settings );
+        Network( Settings const& settings, std::vector<double> const& weights );
+
+        std::vector<int32_t> const& Evaluate( std::vector<double> const& input );
+
+        // Compact integer inputs (see CompactTrainingSet) are widened to doubles as they are loaded into the input neurons,
+        // the results are identical to evaluating the widened values
+        std::vector<int32_t> const& Evaluate( uint8_t const* pInputs );
+        std::vector<int32_t> const& Evaluate( uint16_t const* pInputs );
+        std::vector<int32_t> const& Evaluate( double const* pInputs );
+
+        // Evaluates numEntries contiguous input rows, writes numEntries * numOutputs raw outputs and clamped outputs.
+        // Doesn't modify the network so it is safe to call concurrently, results are identical to Evaluate.
+        void EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs ) const;
+
+        inline int32_t GetNumInputs() const { return m_numInputs; }
+        inline int32_t GetNumHidden() const { return m_numHidden; }
+        inline int32_t GetNumOutputs() const { return m_numOutputs; }
+
+        // Raw (sigmoid) outputs of the last evaluation
+        std::vector<double> const& GetOutputs() const { return m_outputNeurons; }
+
+        // Weights in the layout expected by the weights constructor: ( numInputs + 1 ) * numHidden input->hidden weights followed by ( numHidden + 1 ) * numOutputs hidden->output weights
+        std::vector<double> GetWeights() const;
+
+        std::vector<double> const& GetInputHiddenWeights() const { return m_weightsInputHidden; }
+        std::vector<double> const& GetHiddenOutputWeights() const { return m_weightsHiddenOutput; }
+
+    private:
+
+        void InitializeNetwork();
+        void InitializeWeights( uint64_t seed );
+        void LoadWeights( std::vector<double> const& weights );
+
+        // Forward pass from the current input neuron values
+        std::vector<int32_t> const& EvaluateInputNeurons();
+
+        int32_t GetInputHiddenWeightIndex( int32_t inputIdx, int32_t hiddenIdx ) const { return inputIdx * m_numHidden + hiddenIdx; }
+        int32_t GetHiddenOutputWeightIndex( int32_t hiddenIdx, int32_t outputIdx ) const { return hiddenIdx * m_numOutputs + outputIdx; }
+
+    private:
+
+        int32_t                 m_numInputs;
+        int32_t                 m_numHidden;
+        int32_t                 m_numOutputs;
+
+        std::vector<double>     m_inputNeurons;
+        std::vector<double>     m_hiddenNeurons;
+        std::vector<double>     m_outputNeurons;
+
+        std::vector<int32_t>    m_clampedOutputs;
+
+        std::vector<double>     m_weightsInputHidden;
+        std::vector<double>     m_weightsHiddenOutput;
+    };
 }
\ No newline at end of file
@@ -1,274 +1,836 @@
-//-------------------------------------------------------------------------
-// Simple back-propagation neural network example
-// 2017 - Bobby Anguelov
-// MIT license: https://opensource.org/licenses/MIT
-//-------------------------------------------------------------------------
-
-#include "NeuralNetworkTrainer.h"
-#include <assert.h>
-#include <iostream>
-
-//-------------------------------------------------------------------------
-
-namespace BPN
-{
-    NetworkTrainer::NetworkTrainer( Settings const& settings, Network* pNetwork )
-        : m_pNetwork( pNetwork )
-        , m_learningRate( settings.m_learningRate )
-        , m_momentum( settings.m_momentum )
-        , m_desiredAccuracy( settings.m_desiredAccuracy )
-        , m_maxEpochs( settings.m_maxEpochs )
-        , m_useBatchLearning( settings.m_useBatchLearning )
-        , m_currentEpoch( 0 )
-        , m_trainingSetAccuracy( 0 )
-        , m_validationSetAccuracy( 0 )
-        , m_generalizationSetAccuracy( 0 )
-        , m_trainingSetMSE( 0 )
-        , m_validationSetMSE( 0 )
-        , m_generalizationSetMSE( 0 )
-    {
-        assert( pNetwork != nullptr );
-
-        m_deltaInputHidden.resize( pNetwork->m_weightsInputHidden.size() );
-        m_deltaHiddenOutput.resize( pNetwork->m_weightsHiddenOutput.size() );
-        m_errorGradientsHidden.resize( pNetwork->m_hiddenNeurons.size() );
-        m_errorGradientsOutput.resize( pNetwork->m_outputNeurons.size() );
-
-        memset( m_deltaInputHidden.data(), 0, sizeof( double ) * m_deltaInputHidden.size() );
-        memset( m_deltaHiddenOutput.data(), 0, sizeof( double ) * m_deltaHiddenOutput.size() );
-        memset( m_errorGradientsHidden.data(), 0, sizeof( double ) * m_errorGradientsHidden.size() );
-        memset( m_errorGradientsOutput.data(), 0, sizeof( double ) * m_errorGradientsOutput.size() );
-    }
-
-    void NetworkTrainer::Train( TrainingData const& trainingData )
-    {
-        // Reset training state
-        m_currentEpoch = 0;
-        m_trainingSetAccuracy = 0;
-        m_validationSetAccuracy = 0;
-        m_generalizationSetAccuracy = 0;
-        m_trainingSetMSE = 0;
-        m_validationSetMSE = 0;
-        m_generalizationSetMSE = 0;
-
-        // Print header
-        //-------------------------------------------------------------------------
-
-        std::cout	<< std::endl << " Neural Network Training Starting: " << std::endl
-                    << "==========================================================================" << std::endl
-                    << " LR: " << m_learningRate << ", Momentum: " << m_momentum << ", Max Epochs: " << m_maxEpochs << std::endl
-                    << " " << m_pNetwork->m_numInputs<< " Input Neurons, " << m_pNetwork->m_numHidden << " Hidden Neurons, " << m_pNetwork->m_numOutputs<< " Output Neurons" << std::endl
-                    << "==========================================================================" << std::endl << std::endl;
-
-        // Train network using training dataset for training and generalization dataset for testing
-        //--------------------------------------------------------------------------------------------------------
-
-        while ( ( m_trainingSetAccuracy < m_desiredAccuracy || m_generalizationSetAccuracy < m_desiredAccuracy ) && m_currentEpoch < m_maxEpochs )
-        {
-            // Use training set to train network
-            RunEpoch( trainingData.m_trainingSet );
-
-            // Get generalization set accuracy and MSE
-            GetSetAccuracyAndMSE( trainingData.m_generalizationSet, m_generalizationSetAccuracy, m_generalizationSetMSE );
-
-            std::cout << "Epoch :" << m_currentEpoch;
-            std::cout << " Training Set Accuracy:" << m_trainingSetAccuracy << "%, MSE: " << m_trainingSetMSE;
-            std::cout << " Generalization Set Accuracy:" << m_generalizationSetAccuracy << "%, MSE: " << m_generalizationSetMSE << std::endl;
-
-            m_currentEpoch++;
-        }
-
-        // Get validation set accuracy and MSE
-        GetSetAccuracyAndMSE( trainingData.m_validationSet, m_validationSetAccuracy, m_validationSetMSE );
-
-        // Print validation accuracy and MSE
-        std::cout << std::endl << "Training Complete!!! - > Elapsed Epochs: " << m_currentEpoch << std::endl;
-        std::cout << " Validation Set Accuracy: " << m_validationSetAccuracy << std::endl;
-        std::cout << " Validation Set MSE: " << m_validationSetMSE << std::endl << std::endl;
-    }
-
-    double NetworkTrainer::GetHiddenErrorGradient( int32_t hiddenIdx ) const
-    {
-        // Get sum of hidden->output weights * output error gradients
-        double weightedSum = 0;
-        for ( auto outputIdx = 0; outputIdx < m_pNetwork->m_numOutputs; outputIdx++ )
-        {
-            int32_t const weightIdx = m_pNetwork->GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
-            weightedSum += m_pNetwork->m_weightsHiddenOutput[weightIdx] * m_errorGradientsOutput[outputIdx];
-        }
-        
-        // Return error gradient
-        return m_pNetwork->m_hiddenNeurons[hiddenIdx] * ( 1.0 - m_pNetwork->m_hiddenNeurons[hiddenIdx] ) * weightedSum;
-    }
-
-    void NetworkTrainer::RunEpoch( TrainingSet const& trainingSet )
-    {
-        double incorrectEntries = 0;
-        double MSE = 0;
-
-        for ( auto const& trainingEntry : trainingSet )
-        {
-            // Feed inputs through network and back propagate errors
-            m_pNetwork->Evaluate( trainingEntry.m_inputs );
-            Backpropagate( trainingEntry.m_expectedOutputs );
-
-            // Check all outputs from neural network against desired values
-            bool resultCorrect = true;
-            for ( int outputIdx = 0; outputIdx < m_pNetwork->m_numOutputs; outputIdx++ )
-            {
-                if ( m_pNetwork->m_clampedOutputs[outputIdx] != trainingEntry.m_expectedOutputs[outputIdx] )
-                {
-                    resultCorrect = false;
-                }
-
-                // Calculate MSE
-                MSE += pow( ( m_pNetwork->m_outputNeurons[outputIdx] - trainingEntry.m_expectedOutputs[outputIdx] ), 2);
-            }
-
-            if ( !resultCorrect )
-            {
-                incorrectEntries++;
-            }
-        }
-        
-        // If using batch learning - update the weights
-        if ( m_useBatchLearning )
-        {
-            UpdateWeights();
-        }
-
-        // Update training accuracy and MSE
-        m_trainingSetAccuracy = 100.0 - ( incorrectEntries / trainingSet.size() * 100.0 );
-        m_trainingSetMSE = MSE / ( m_pNetwork->m_numOutputs * trainingSet.size() );
-    }
-
-    void NetworkTrainer::Backpropagate( std::vector<int32_t> const& expectedOutputs )
-    {
-        // Modify deltas between hidden and output layers
-        //--------------------------------------------------------------------------------------------------------
-        for ( auto OutputIdx = 0; OutputIdx < m_pNetwork->m_numOutputs; OutputIdx++ )
-        {
-            // Get error gradient for every output node
-            m_errorGradientsOutput[OutputIdx] = GetOutputErrorGradient( (double) expectedOutputs[OutputIdx], m_pNetwork->m_outputNeurons[OutputIdx] );
-
-            // For all nodes in hidden layer and bias neuron
-            for ( auto hiddenIdx = 0; hiddenIdx <= m_pNetwork->m_numHidden; hiddenIdx++ )
-            {
-                int32_t const weightIdx = m_pNetwork->GetHiddenOutputWeightIndex( hiddenIdx, OutputIdx );
-
-                // Calculate change in weight
-                if ( m_useBatchLearning )
-                {
-                    m_deltaHiddenOutput[weightIdx] += m_learningRate * m_pNetwork->m_hiddenNeurons[hiddenIdx] * m_errorGradientsOutput[OutputIdx];
-                }
-                else
-                {
-                    m_deltaHiddenOutput[weightIdx] = m_learningRate * m_pNetwork->m_hiddenNeurons[hiddenIdx] * m_errorGradientsOutput[OutputIdx] + m_momentum * m_deltaHiddenOutput[weightIdx];
-                }
-            }
-        }
-
-        // Modify deltas between input and hidden layers
-        //--------------------------------------------------------------------------------------------------------
-
-        for ( auto hiddenIdx = 0; hiddenIdx <= m_pNetwork->m_numHidden; hiddenIdx++ )
-        {
-            // Get error gradient for every hidden node
-            m_errorGradientsHidden[hiddenIdx] = GetHiddenErrorGradient( hiddenIdx );
-
-            // For all nodes in input layer and bias neuron
-            for ( auto inputIdx = 0; inputIdx <= m_pNetwork->m_numInputs; inputIdx++ )
-            {
-                int32_t const weightIdx = m_pNetwork->GetInputHiddenWeightIndex( inputIdx, hiddenIdx );
-
-                // Calculate change in weight 
-                if ( m_useBatchLearning )
-                {
-                    m_deltaInputHidden[weightIdx] += m_learningRate * m_pNetwork->m_inputNeurons[inputIdx] * m_errorGradientsHidden[hiddenIdx];
-                }
-                else
-                {
-                    m_deltaInputHidden[weightIdx] = m_learningRate * m_pNetwork->m_inputNeurons[inputIdx] * m_errorGradientsHidden[hiddenIdx] + m_momentum * m_deltaInputHidden[weightIdx];
-                }
-            }
-        }
-
-        // If using stochastic learning update the weights immediately
-        if ( !m_useBatchLearning )
-        {
-            UpdateWeights();
-        }
-    }
-
-    void NetworkTrainer::UpdateWeights()
-    {
-        // Input -> hidden weights
-        //--------------------------------------------------------------------------------------------------------
-
-        for ( auto InputIdx = 0; InputIdx <= m_pNetwork->m_numInputs; InputIdx++ )
-        {
-            for ( auto hiddenIdx = 0; hiddenIdx <= m_pNetwork->m_numHidden; hiddenIdx++ )
-            {
-                int32_t const weightIdx = m_pNetwork->GetInputHiddenWeightIndex( InputIdx, hiddenIdx );
-                m_pNetwork->m_weightsInputHidden[weightIdx] += m_deltaInputHidden[weightIdx];
-
-                // Clear delta only if using batch (previous delta is needed for momentum
-                if ( m_useBatchLearning )
-                {
-                    m_deltaInputHidden[weightIdx] = 0;
-                }
-            }
-        }
-
-        // Hidden -> output weights
-        //--------------------------------------------------------------------------------------------------------
-
-        for ( auto hiddenIdx = 0; hiddenIdx <= m_pNetwork->m_numHidden; hiddenIdx++ )
-        {
-            for ( auto outputIdx = 0; outputIdx < m_pNetwork->m_numOutputs; outputIdx++ )
-            {
-                int32_t const weightIdx = m_pNetwork->GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
-                m_pNetwork->m_weightsHiddenOutput[weightIdx] += m_deltaHiddenOutput[weightIdx];
-
-                // Clear delta only if using batch (previous delta is needed for momentum)
-                if ( m_useBatchLearning )
-                {
-                    m_deltaInputHidden[weightIdx] = 0;
-                }
-            }
-        }
-    }
-
-    void NetworkTrainer::GetSetAccuracyAndMSE( TrainingSet const& trainingSet, double& accuracy, double& MSE ) const
-    {
-        accuracy = 0;
-        MSE = 0;
-
-        double numIncorrectResults = 0;
-        for ( auto const& trainingEntry : trainingSet )
-        {
-            m_pNetwork->Evaluate( trainingEntry.m_inputs );
-
-            // Check if the network outputs match the expected outputs
-            bool correctResult = true;
-            for ( int32_t outputIdx = 0; outputIdx < m_pNetwork->m_numOutputs; outputIdx++ )
-            {
-                if ( (double) m_pNetwork->m_clampedOutputs[outputIdx] != trainingEntry.m_expectedOutputs[outputIdx] )
-                {
-                    correctResult = false;
-                }
-
-                MSE += pow( ( m_pNetwork->m_outputNeurons[outputIdx] - trainingEntry.m_expectedOutputs[outputIdx] ), 2 );
-            }
-
-            if ( !correctResult )
-            {
-                numIncorrectResults++;
-            }
-        }
-
-        accuracy = 100.0f - ( numIncorrectResults / trainingSet.size() * 100.0 );
-        MSE = MSE / ( m_pNetwork->m_numOutputs * trainingSet.size() );
-    }
-
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "NeuralNetworkTrainer.h"
+#include "CompactTrainingSet.h"
+#include "Gemm.h"
+#include "NetworkPruning.h"
+#include "Random.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Entries per batched forward/backward pass, large enough to make the matrix multiplications efficient
+        // while keeping the per-entry scratch in cache
+        constexpr uint32_t g_batchTileSize = 64;
+
+        inline size_t GetNumEntries( TrainingSet const& trainingSet ) { return trainingSet.size(); }
+        inline size_t GetNumEntries( CompactTrainingSet const& trainingSet ) { return trainingSet.GetNumEntries(); }
+    }
+
+    //-------------------------------------------------------------------------
+
+    NetworkTrainer::NetworkTrainer( Settings const& settings, Network* pNetwork )
+        : m_pNetwork( pNetwork )
+        , m_learningRate( settings.m_learningRate )
+        , m_momentum( settings.m_momentum )
+        , m_desiredAccuracy( settings.m_desiredAccuracy )
+        , m_maxEpochs( settings.m_maxEpochs )
+        , m_useBatchLearning( settings.m_useBatchLearning )
+        , m_pTelemetrySink( settings.m_pTelemetrySink )
+        , m_shuffleEachEpoch( settings.m_shuffleEachEpoch )
+        , m_seed( settings.m_seed )
+        , m_targetSparsity( settings.m_targetSparsity )
+        , m_pruningStartEpoch( settings.m_pruningStartEpoch )
+        , m_pruningEndEpoch( std::max( settings.m_pruningEndEpoch, settings.m_pruningStartEpoch ) )
+        , m_pruningInterval( std::max( 1u, settings.m_pruningInterval ) )
+        , m_pTeacherOutputs( nullptr )
+        , m_currentEpoch( 0 )
+        , m_numEpochEntries( 0 )
+        , m_numEpochIncorrectEntries( 0 )
+        , m_epochSumSquaredError( 0 )
+        , m_trainingSetAccuracy( 0 )
+        , m_validationSetAccuracy( 0 )
+        , m_generalizationSetAccuracy( 0 )
+        , m_trainingSetMSE( 0 )
+        , m_validationSetMSE( 0 )
+        , m_generalizationSetMSE( 0 )
+    {
+        assert( pNetwork != nullptr );
+
+        m_deltaInputHidden.resize( pNetwork->m_weightsInputHidden.size() );
+        m_deltaHiddenOutput.resize( pNetwork->m_weightsHiddenOutput.size() );
+        m_errorGradientsHidden.resize( pNetwork->m_hiddenNeurons.size() );
+        m_errorGradientsOutput.resize( pNetwork->m_outputNeurons.size() );
+
+        memset( m_deltaInputHidden.data(), 0, sizeof( double ) * m_deltaInputHidden.size() );
+        memset( m_deltaHiddenOutput.data(), 0, sizeof( double ) * m_deltaHiddenOutput.size() );
+        memset( m_errorGradientsHidden.data(), 0, sizeof( double ) * m_errorGradientsHidden.size() );
+        memset( m_errorGradientsOutput.data(), 0, sizeof( double ) * m_errorGradientsOutput.size() );
+    }
+
+    void NetworkTrainer::Train( TrainingData const& trainingData )
+    {
+        TrainOnData( trainingData );
+    }
+
+    void NetworkTrainer::Train( CompactTrainingData const& trainingData )
+    {
+        TrainOnData( trainingData );
+    }
+
+    void NetworkTrainer::Distill( TrainingData const& trainingData, std::vector<double> const& teacherOutputs )
+    {
+        assert( teacherOutputs.size() == trainingData.m_trainingSet.size() * m_pNetwork->m_numOutputs );
+
+        m_pTeacherOutputs = teacherOutputs.data();
+        TrainOnData( trainingData );
+        m_pTeacherOutputs = nullptr;
+    }
+
+    template<typename DataType>
+    void NetworkTrainer::TrainOnData( DataType const& trainingData )
+    {
+        // Reset training state
+        m_currentEpoch = 0;
+        m_trainingSetAccuracy = 0;
+        m_validationSetAccuracy = 0;
+        m_generalizationSetAccuracy = 0;
+        m_trainingSetMSE = 0;
+        m_validationSetMSE = 0;
+        m_generalizationSetMSE = 0;
+
+        typedef std::chrono::steady_clock Clock;
+        auto const trainingStartTime = Clock::now();
+        Profiling::Counters const trainingStartCounters = Profiling::GetThreadCounters();
+
+        if ( m_pTelemetrySink != nullptr )
+        {
+            TrainingStartTelemetry telemetry;
+            telemetry.m_learningRate = m_learningRate;
+            telemetry.m_momentum = m_momentum;
+            telemetry.m_maxEpochs = m_maxEpochs;
+            telemetry.m_useBatchLearning = m_useBatchLearning;
+            telemetry.m_numInputs = m_pNetwork->m_numInputs;
+            telemetry.m_numHidden = m_pNetwork->m_numHidden;
+            telemetry.m_numOutputs = m_pNetwork->m_numOutputs;
+            telemetry.m_numTrainingEntries = (uint32_t) GetNumEntries( trainingData.m_trainingSet );
+            telemetry.m_dataLoadStats = trainingStartCounters.m_phases[(uint32_t) Profiling::Phase::ReadData];
+            m_pTelemetrySink->OnTrainingStarted( telemetry );
+        }
+
+        // Train network using training dataset for training and generalization dataset for testing
+        //--------------------------------------------------------------------------------------------------------
+
+        bool const isPruning = m_targetSparsity > 0;
+        while ( ( m_trainingSetAccuracy < m_desiredAccuracy || m_generalizationSetAccuracy < m_desiredAccuracy || ( isPruning && m_currentEpoch <= m_pruningEndEpoch ) ) && m_currentEpoch < m_maxEpochs )
+        {
+            auto const epochStartTime = Clock::now();
+            Profiling::Counters const epochStartCounters = Profiling::GetThreadCounters();
+
+            // Gradual pruning step
+            if ( isPruning && m_currentEpoch >= m_pruningStartEpoch && m_currentEpoch <= m_pruningEndEpoch && ( ( m_currentEpoch - m_pruningStartEpoch ) % m_pruningInterval == 0 || m_currentEpoch == m_pruningEndEpoch ) )
+            {
+                PruneInputHiddenWeights( NetworkPruner::GetScheduledSparsity( m_targetSparsity, m_pruningStartEpoch, m_pruningEndEpoch, m_currentEpoch ) );
+            }
+
+            // Use training set to train network
+            RunEpoch( trainingData.m_trainingSet );
+
+            // Get generalization set accuracy and MSE
+            GetSetAccuracyAndMSE( trainingData.m_generalizationSet, m_generalizationSetAccuracy, m_generalizationSetMSE );
+
+            if ( m_pTelemetrySink != nullptr )
+            {
+                EpochTelemetry telemetry;
+                telemetry.m_epoch = m_currentEpoch;
+                telemetry.m_trainingSetAccuracy = m_trainingSetAccuracy;
+                telemetry.m_trainingSetMSE = m_trainingSetMSE;
+                telemetry.m_generalizationSetAccuracy = m_generalizationSetAccuracy;
+                telemetry.m_generalizationSetMSE = m_generalizationSetMSE;
+                telemetry.m_epochTimeMS = std::chrono::duration<double, std::milli>( Clock::now() - epochStartTime ).count();
+                telemetry.m_samplesPerSecond = ( telemetry.m_epochTimeMS > 0 ) ? GetNumEntries( trainingData.m_trainingSet ) / ( telemetry.m_epochTimeMS / 1000.0 ) : 0.0;
+                telemetry.m_counters = Profiling::GetThreadCounters() - epochStartCounters;
+                m_pTelemetrySink->OnEpochComplete( telemetry );
+            }
+
+            m_currentEpoch++;
+        }
+
+        // Get validation set accuracy and MSE
+        GetSetAccuracyAndMSE( trainingData.m_validationSet, m_validationSetAccuracy, m_validationSetMSE );
+
+        if ( m_pTelemetrySink != nullptr )
+        {
+            TrainingCompleteTelemetry telemetry;
+            telemetry.m_numEpochs = m_currentEpoch;
+            telemetry.m_validationSetAccuracy = m_validationSetAccuracy;
+            telemetry.m_validationSetMSE = m_validationSetMSE;
+            telemetry.m_totalTimeMS = std::chrono::duration<double, std::milli>( Clock::now() - trainingStartTime ).count();
+            telemetry.m_counters = Profiling::GetThreadCounters() - trainingStartCounters;
+            m_pTelemetrySink->OnTrainingComplete( telemetry );
+        }
+    }
+
+    void NetworkTrainer::PruneInputHiddenWeights( double sparsity )
+    {
+        NetworkPruner::PruneInputHiddenWeights( *m_pNetwork, sparsity, m_inputHiddenMask );
+
+        // Drop the momentum of the pruned weights
+        for ( size_t weightIdx = 0; weightIdx < m_inputHiddenMask.size(); weightIdx++ )
+        {
+            if ( m_inputHiddenMask[weightIdx] == 0 )
+            {
+                m_deltaInputHidden[weightIdx] = 0;
+            }
+        }
+    }
+
+    double NetworkTrainer::GetHiddenErrorGradient( int32_t hiddenIdx ) const
+    {
+        // Get sum of hidden->output weights * output error gradients
+        double weightedSum = 0;
+        for ( auto outputIdx = 0; outputIdx < m_pNetwork->m_numOutputs; outputIdx++ )
+        {
+            int32_t const weightIdx = m_pNetwork->GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
+            weightedSum += m_pNetwork->m_weightsHiddenOutput[weightIdx] * m_errorGradientsOutput[outputIdx];
+        }
+        
+        // Return error gradient
+        return m_pNetwork->m_hiddenNeurons[hiddenIdx] * ( 1.0 - m_pNetwork->m_hiddenNeurons[hiddenIdx] ) * weightedSum;
+    }
+
+    void NetworkTrainer::RunEpoch( TrainingSet const& trainingSet )
+    {
+        BeginEpoch();
+        if ( m_shuffleEachEpoch )
+        {
+            m_epochOrder.resize( trainingSet.size() );
+            for ( uint32_t entryIdx = 0; entryIdx < (uint32_t) m_epochOrder.size(); entryIdx++ )
+            {
+                m_epochOrder[entryIdx] = entryIdx;
+            }
+
+            RandomStream( m_seed, m_currentEpoch ).Shuffle( m_epochOrder );
+            if ( m_pTeacherOutputs != nullptr )
+            {
+                TrainDistillationEntries( trainingSet, m_epochOrder.data(), m_epochOrder.size() );
+            }
+            else
+            {
+                TrainEntries( trainingSet, m_epochOrder.data(), m_epochOrder.size() );
+            }
+        }
+        else if ( m_pTeacherOutputs != nullptr )
+        {
+            TrainDistillationEntries( trainingSet, nullptr, trainingSet.size() );
+        }
+        else
+        {
+            TrainEntries( trainingSet.data(), trainingSet.size() );
+        }
+        EndEpoch();
+    }
+
+    void NetworkTrainer::RunEpoch( CompactTrainingSet const& trainingSet )
+    {
+        BeginEpoch();
+        if ( m_shuffleEachEpoch )
+        {
+            m_epochOrder.resize( trainingSet.GetNumEntries() );
+            for ( uint32_t entryIdx = 0; entryIdx < (uint32_t) m_epochOrder.size(); entryIdx++ )
+            {
+                m_epochOrder[entryIdx] = entryIdx;
+            }
+
+            RandomStream( m_seed, m_currentEpoch ).Shuffle( m_epochOrder );
+            TrainCompactEntries( trainingSet, m_epochOrder.data(), m_epochOrder.size() );
+        }
+        else
+        {
+            TrainCompactEntries( trainingSet, nullptr, trainingSet.GetNumEntries() );
+        }
+        EndEpoch();
+    }
+
+    void NetworkTrainer::BeginEpoch()
+    {
+        m_numEpochEntries = 0;
+        m_numEpochIncorrectEntries = 0;
+        m_epochSumSquaredError = 0;
+    }
+
+    void NetworkTrainer::TrainEntries( TrainingEntry const* pEntries, size_t numEntries )
+    {
+        if ( m_useBatchLearning )
+        {
+            BackpropagateBatch( pEntries, numEntries, m_epochSumSquaredError, m_numEpochIncorrectEntries );
+            m_numEpochEntries += GetTotalWeight( pEntries, numEntries );
+            return;
+        }
+
+        for ( size_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            TrainEntry( pEntries[entryIdx] );
+        }
+    }
+
+    void NetworkTrainer::TrainEntries( TrainingSet const& entries, uint32_t const* pIndices, size_t numIndices )
+    {
+        if ( m_useBatchLearning )
+        {
+            TrainingEntry const* tileEntries[g_batchTileSize];
+            for ( size_t tileStart = 0; tileStart < numIndices; tileStart += g_batchTileSize )
+            {
+                uint32_t const numTileEntries = (uint32_t) std::min( (size_t) g_batchTileSize, numIndices - tileStart );
+                for ( uint32_t entryIdx = 0; entryIdx < numTileEntries; entryIdx++ )
+                {
+                    tileEntries[entryIdx] = &entries[pIndices[tileStart + entryIdx]];
+                    m_numEpochEntries += tileEntries[entryIdx]->m_weight;
+                }
+
+                m_numEpochIncorrectEntries += BackpropagateBatch( tileEntries, numTileEntries, m_epochSumSquaredError );
+            }
+
+            return;
+        }
+
+        for ( size_t idx = 0; idx < numIndices; idx++ )
+        {
+            TrainEntry( entries[pIndices[idx]] );
+        }
+    }
+
+    void NetworkTrainer::TrainCompactEntries( CompactTrainingSet const& entries, uint32_t const* pIndices, size_t numEntries )
+    {
+        if ( m_useBatchLearning )
+        {
+            for ( size_t tileStart = 0; tileStart < numEntries; tileStart += g_batchTileSize )
+            {
+                uint32_t const numTileEntries = (uint32_t) std::min( (size_t) g_batchTileSize, numEntries - tileStart );
+                m_numEpochIncorrectEntries += BackpropagateBatch( entries, ( pIndices != nullptr ) ? &pIndices[tileStart] : nullptr, tileStart, numTileEntries, m_epochSumSquaredError );
+            }
+
+            m_numEpochEntries += numEntries;
+            return;
+        }
+
+        m_expectedOutputs.resize( entries.GetNumOutputs() );
+        for ( size_t idx = 0; idx < numEntries; idx++ )
+        {
+            size_t const entryIdx = ( pIndices != nullptr ) ? pIndices[idx] : idx;
+            EvaluateCompactEntry( entries, entryIdx );
+            entries.GetExpectedOutputs( entryIdx, m_expectedOutputs.data() );
+            Backpropagate( m_expectedOutputs.data() );
+
+            if ( !CheckOutputs( m_expectedOutputs, 1, m_epochSumSquaredError ) )
+            {
+                m_numEpochIncorrectEntries++;
+            }
+
+            m_numEpochEntries++;
+        }
+    }
+
+    void NetworkTrainer::TrainDistillationEntries( TrainingSet const& entries, uint32_t const* pIndices, size_t numEntries )
+    {
+        assert( m_pTeacherOutputs != nullptr );
+
+        uint32_t const numInputs = m_pNetwork->m_numInputs;
+        uint32_t const numOutputs = m_pNetwork->m_numOutputs;
+
+        if ( m_useBatchLearning )
+        {
+            for ( size_t tileStart = 0; tileStart < numEntries; tileStart += g_batchTileSize )
+            {
+                uint32_t const numTileEntries = (uint32_t) std::min( (size_t) g_batchTileSize, numEntries - tileStart );
+                m_batchInputs.resize( (size_t) numTileEntries * numInputs );
+                m_batchExpectedOutputs.resize( (size_t) numTileEntries * numOutputs );
+                m_batchTargets.resize( (size_t) numTileEntries * numOutputs );
+                m_batchWeights.resize( numTileEntries );
+
+                for ( uint32_t idx = 0; idx < numTileEntries; idx++ )
+                {
+                    size_t const entryIdx = ( pIndices != nullptr ) ? pIndices[tileStart + idx] : tileStart + idx;
+                    memcpy( &m_batchInputs[(size_t) idx * numInputs], entries[entryIdx].m_inputs.data(), numInputs * sizeof( double ) );
+                    memcpy( &m_batchExpectedOutputs[(size_t) idx * numOutputs], entries[entryIdx].m_expectedOutputs.data(), numOutputs * sizeof( int32_t ) );
+                    memcpy( &m_batchTargets[(size_t) idx * numOutputs], &m_pTeacherOutputs[entryIdx * numOutputs], numOutputs * sizeof( double ) );
+                    m_batchWeights[idx] = entries[entryIdx].m_weight;
+                    m_numEpochEntries += entries[entryIdx].m_weight;
+                }
+
+                m_numEpochIncorrectEntries += BackpropagateBatchTile( numTileEntries, m_epochSumSquaredError, m_batchTargets.data(), m_batchWeights.data() );
+            }
+
+            return;
+        }
+
+        for ( size_t idx = 0; idx < numEntries; idx++ )
+        {
+            size_t const entryIdx = ( pIndices != nullptr ) ? pIndices[idx] : idx;
+            m_pNetwork->Evaluate( entries[entryIdx].m_inputs );
+            Backpropagate( &m_pTeacherOutputs[entryIdx * numOutputs] );
+
+            if ( !CheckOutputs( entries[entryIdx].m_expectedOutputs, entries[entryIdx].m_weight, m_epochSumSquaredError ) )
+            {
+                m_numEpochIncorrectEntries += entries[entryIdx].m_weight;
+            }
+
+            m_numEpochEntries += entries[entryIdx].m_weight;
+        }
+    }
+
+    void NetworkTrainer::EvaluateCompactEntry( CompactTrainingSet const& entries, size_t entryIdx ) const
+    {
+        switch ( entries.GetFeatureStorage() )
+        {
+            case FeatureStorage::UInt8: m_pNetwork->Evaluate( entries.GetUInt8Inputs( entryIdx ) ); break;
+            case FeatureStorage::UInt16: m_pNetwork->Evaluate( entries.GetUInt16Inputs( entryIdx ) ); break;
+            case FeatureStorage::Double: m_pNetwork->Evaluate( entries.GetDoubleInputs( entryIdx ) ); break;
+        }
+    }
+
+    void NetworkTrainer::TrainEntry( TrainingEntry const& trainingEntry )
+    {
+        m_pNetwork->Evaluate( trainingEntry.m_inputs );
+        Backpropagate( trainingEntry.m_expectedOutputs.data() );
+
+        if ( !CheckOutputs( trainingEntry.m_expectedOutputs, trainingEntry.m_weight, m_epochSumSquaredError ) )
+        {
+            m_numEpochIncorrectEntries += trainingEntry.m_weight;
+        }
+
+        m_numEpochEntries += trainingEntry.m_weight;
+    }
+
+    bool NetworkTrainer::TrainSample( TrainingEntry const& trainingEntry, double& sumSquaredError )
+    {
+        // Feed inputs through network and back propagate errors
+        m_pNetwork->Evaluate( trainingEntry.m_inputs );
+        Backpropagate( trainingEntry.m_expectedOutputs.data() );
+
+        // Check all outputs from neural network against desired values
+        return CheckOutputs( trainingEntry.m_expectedOutputs, 1, sumSquaredError );
+    }
+
+    bool NetworkTrainer::CheckOutputs( std::vector<int32_t> const& expectedOutputs, uint32_t weight, double& sumSquaredError ) const
+    {
+        bool resultCorrect = true;
+        for ( int outputIdx = 0; outputIdx < m_pNetwork->m_numOutputs; outputIdx++ )
+        {
+            if ( m_pNetwork->m_clampedOutputs[outputIdx] != expectedOutputs[outputIdx] )
+            {
+                resultCorrect = false;
+            }
+
+            // Calculate MSE
+            sumSquaredError += weight * pow( ( m_pNetwork->m_outputNeurons[outputIdx] - expectedOutputs[outputIdx] ), 2 );
+        }
+
+        return resultCorrect;
+    }
+
+    void NetworkTrainer::GetErrorGradient( TrainingEntry const* pEntries, size_t numEntries, std::vector<double>& gradient )
+    {
+        // Run the batch path with a unit learning rate from cleared deltas, the accumulated deltas are then the negated gradient
+        std::vector<double> const deltaInputHidden = m_deltaInputHidden;
+        std::vector<double> const deltaHiddenOutput = m_deltaHiddenOutput;
+        double const learningRate = m_learningRate;
+        bool const useBatchLearning = m_useBatchLearning;
+
+        std::fill( m_deltaInputHidden.begin(), m_deltaInputHidden.end(), 0.0 );
+        std::fill( m_deltaHiddenOutput.begin(), m_deltaHiddenOutput.end(), 0.0 );
+        m_learningRate = 1.0;
+        m_useBatchLearning = true;
+
+        double sumSquaredError = 0;
+        double numIncorrectEntries = 0;
+        BackpropagateBatch( pEntries, numEntries, sumSquaredError, numIncorrectEntries );
+
+        // Same layout as Network::GetWeights
+        size_t const numInputHiddenWeights = ( (size_t) m_pNetwork->m_numInputs + 1 ) * m_pNetwork->m_numHidden;
+        size_t const numHiddenOutputWeights = ( (size_t) m_pNetwork->m_numHidden + 1 ) * m_pNetwork->m_numOutputs;
+        gradient.resize( numInputHiddenWeights + numHiddenOutputWeights );
+        for ( size_t weightIdx = 0; weightIdx < numInputHiddenWeights; weightIdx++ )
+        {
+            gradient[weightIdx] = -m_deltaInputHidden[weightIdx];
+        }
+
+        for ( size_t weightIdx = 0; weightIdx < numHiddenOutputWeights; weightIdx++ )
+        {
+            gradient[numInputHiddenWeights + weightIdx] = -m_deltaHiddenOutput[weightIdx];
+        }
+
+        m_deltaInputHidden = deltaInputHidden;
+        m_deltaHiddenOutput = deltaHiddenOutput;
+        m_learningRate = learningRate;
+        m_useBatchLearning = useBatchLearning;
+    }
+
+    void NetworkTrainer::EndEpoch()
+    {
+        // If using batch learning - update the weights
+        if ( m_useBatchLearning )
+        {
+            UpdateWeights();
+        }
+
+        // Update training accuracy and MSE, an empty epoch reports zero like an empty set does
+        if ( m_numEpochEntries == 0 )
+        {
+            m_trainingSetAccuracy = 0;
+            m_trainingSetMSE = 0;
+            return;
+        }
+
+        m_trainingSetAccuracy = 100.0 - ( m_numEpochIncorrectEntries / m_numEpochEntries * 100.0 );
+        m_trainingSetMSE = m_epochSumSquaredError / ( m_pNetwork->m_numOutputs * m_numEpochEntries );
+    }
+
+    template<typename TargetType>
+    void NetworkTrainer::Backpropagate( TargetType const* pTargets )
+    {
+        BackpropagateDeltas( pTargets );
+
+        // If using stochastic learning update the weights immediately
+        if ( !m_useBatchLearning )
+        {
+            UpdateWeights();
+        }
+    }
+
+    template<typename TargetType>
+    void NetworkTrainer::BackpropagateDeltas( TargetType const* pTargets )
+    {
+        BPN_PROFILE_SCOPE( Backpropagate );
+
+        // Modify deltas between hidden and output layers
+        //--------------------------------------------------------------------------------------------------------
+        for ( auto OutputIdx = 0; OutputIdx < m_pNetwork->m_numOutputs; OutputIdx++ )
+        {
+            // Get error gradient for every output node
+            m_errorGradientsOutput[OutputIdx] = GetOutputErrorGradient( (double) pTargets[OutputIdx], m_pNetwork->m_outputNeurons[OutputIdx] );
+
+            // For all nodes in hidden layer and bias neuron
+            for ( auto hiddenIdx = 0; hiddenIdx <= m_pNetwork->m_numHidden; hiddenIdx++ )
+            {
+                int32_t const weightIdx = m_pNetwork->GetHiddenOutputWeightIndex( hiddenIdx, OutputIdx );
+
+                // Calculate change in weight
+                if ( m_useBatchLearning )
+                {
+                    m_deltaHiddenOutput[weightIdx] += m_learningRate * m_pNetwork->m_hiddenNeurons[hiddenIdx] * m_errorGradientsOutput[OutputIdx];
+                }
+                else
+                {
+                    m_deltaHiddenOutput[weightIdx] = m_learningRate * m_pNetwork->m_hiddenNeurons[hiddenIdx] * m_errorGradientsOutput[OutputIdx] + m_momentum * m_deltaHiddenOutput[weightIdx];
+                }
+            }
+        }
+
+        // Modify deltas between input and hidden layers
+        //--------------------------------------------------------------------------------------------------------
+
+        for ( auto hiddenIdx = 0; hiddenIdx < m_pNetwork->m_numHidden; hiddenIdx++ )
+        {
+            // Get error gradient for every hidden node (the bias neuron has no incoming weights)
+            m_errorGradientsHidden[hiddenIdx] = GetHiddenErrorGradient( hiddenIdx );
+
+            // For all nodes in input layer and bias neuron
+            for ( auto inputIdx = 0; inputIdx <= m_pNetwork->m_numInputs; inputIdx++ )
+            {
+                int32_t const weightIdx = m_pNetwork->GetInputHiddenWeightIndex( inputIdx, hiddenIdx );
+
+                // Calculate change in weight 
+                if ( m_useBatchLearning )
+                {
+                    m_deltaInputHidden[weightIdx] += m_learningRate * m_pNetwork->m_inputNeurons[inputIdx] * m_errorGradientsHidden[hiddenIdx];
+                }
+                else
+                {
+                    m_deltaInputHidden[weightIdx] = m_learningRate * m_pNetwork->m_inputNeurons[inputIdx] * m_errorGradientsHidden[hiddenIdx] + m_momentum * m_deltaInputHidden[weightIdx];
+                }
+            }
+        }
+    }
+
+    void NetworkTrainer::BackpropagateBatch( TrainingEntry const* pEntries, size_t numEntries, double& sumSquaredError, double& numIncorrectEntries )
+    {
+        TrainingEntry const* tileEntries[g_batchTileSize];
+        for ( size_t tileStart = 0; tileStart < numEntries; tileStart += g_batchTileSize )
+        {
+            uint32_t const numTileEntries = (uint32_t) std::min( (size_t) g_batchTileSize, numEntries - tileStart );
+            for ( uint32_t entryIdx = 0; entryIdx < numTileEntries; entryIdx++ )
+            {
+                tileEntries[entryIdx] = &pEntries[tileStart + entryIdx];
+            }
+
+            numIncorrectEntries += BackpropagateBatch( tileEntries, numTileEntries, sumSquaredError );
+        }
+    }
+
+    uint32_t NetworkTrainer::BackpropagateBatch( TrainingEntry const* const* ppEntries, uint32_t numEntries, double& sumSquaredError )
+    {
+        uint32_t const numInputs = m_pNetwork->m_numInputs;
+        uint32_t const numOutputs = m_pNetwork->m_numOutputs;
+        m_batchInputs.resize( (size_t) numEntries * numInputs );
+        m_batchExpectedOutputs.resize( (size_t) numEntries * numOutputs );
+        m_batchWeights.resize( numEntries );
+
+        for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            memcpy( &m_batchInputs[(size_t) entryIdx * numInputs], ppEntries[entryIdx]->m_inputs.data(), numInputs * sizeof( double ) );
+            memcpy( &m_batchExpectedOutputs[(size_t) entryIdx * numOutputs], ppEntries[entryIdx]->m_expectedOutputs.data(), numOutputs * sizeof( int32_t ) );
+            m_batchWeights[entryIdx] = ppEntries[entryIdx]->m_weight;
+        }
+
+        return BackpropagateBatchTile( numEntries, sumSquaredError, nullptr, m_batchWeights.data() );
+    }
+
+    uint32_t NetworkTrainer::BackpropagateBatch( CompactTrainingSet const& entries, uint32_t const* pIndices, size_t firstEntryIdx, uint32_t numEntries, double& sumSquaredError )
+    {
+        uint32_t const numInputs = m_pNetwork->m_numInputs;
+        uint32_t const numOutputs = m_pNetwork->m_numOutputs;
+        m_batchInputs.resize( (size_t) numEntries * numInputs );
+        m_batchExpectedOutputs.resize( (size_t) numEntries * numOutputs );
+
+        for ( uint32_t idx = 0; idx < numEntries; idx++ )
+        {
+            size_t const entryIdx = ( pIndices != nullptr ) ? pIndices[idx] : firstEntryIdx + idx;
+            entries.GetInputs( entryIdx, &m_batchInputs[(size_t) idx * numInputs] );
+            entries.GetExpectedOutputs( entryIdx, &m_batchExpectedOutputs[(size_t) idx * numOutputs] );
+        }
+
+        return BackpropagateBatchTile( numEntries, sumSquaredError );
+    }
+
+    uint32_t NetworkTrainer::BackpropagateBatchTile( uint32_t numEntries, double& sumSquaredError, double const* pTargets, uint32_t const* pWeights )
+    {
+        BPN_PROFILE_SCOPE( Backpropagate );
+
+        Network const& network = *m_pNetwork;
+        uint32_t const numInputs = network.m_numInputs;
+        uint32_t const numHidden = network.m_numHidden;
+        uint32_t const numOutputs = network.m_numOutputs;
+
+        m_batchHiddenNeurons.resize( (size_t) numEntries * ( numHidden + 1 ) );
+        m_batchOutputNeurons.resize( (size_t) numEntries * numOutputs );
+        m_batchErrorGradientsHidden.resize( (size_t) numEntries * numHidden );
+        m_batchErrorGradientsOutput.resize( (size_t) numEntries * numOutputs );
+
+        // Forward pass
+        //--------------------------------------------------------------------------------------------------------
+
+        Gemm::Multiply( false, false, numEntries, numHidden, numInputs, 1.0, m_batchInputs.data(), numInputs, network.m_weightsInputHidden.data(), numHidden, 0.0, m_batchHiddenNeurons.data(), numHidden + 1 );
+
+        double const* pBiasWeights = &network.m_weightsInputHidden[network.GetInputHiddenWeightIndex( numInputs, 0 )];
+        for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            double* pHidden = &m_batchHiddenNeurons[(size_t) entryIdx * ( numHidden + 1 )];
+            for ( uint32_t hiddenIdx = 0; hiddenIdx < numHidden; hiddenIdx++ )
+            {
+                pHidden[hiddenIdx] = Network::SigmoidActivationFunction( pHidden[hiddenIdx] + -1.0 * pBiasWeights[hiddenIdx] );
+            }
+            pHidden[numHidden] = -1.0;
+        }
+
+        Gemm::Multiply( false, false, numEntries, numOutputs, numHidden + 1, 1.0, m_batchHiddenNeurons.data(), numHidden + 1, network.m_weightsHiddenOutput.data(), numOutputs, 0.0, m_batchOutputNeurons.data(), numOutputs );
+
+        // Output error gradients, accuracy and squared errors. The hidden error gradients and all deltas are linear in the
+        // output error gradients, so scaling these by the weight is the same as backpropagating that many copies.
+        //--------------------------------------------------------------------------------------------------------
+
+        uint32_t numIncorrectEntries = 0;
+        for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            int32_t const* pExpectedOutputs = &m_batchExpectedOutputs[(size_t) entryIdx * numOutputs];
+            uint32_t const weight = ( pWeights != nullptr ) ? pWeights[entryIdx] : 1;
+            bool resultCorrect = true;
+            for ( uint32_t outputIdx = 0; outputIdx < numOutputs; outputIdx++ )
+            {
+                size_t const valueIdx = (size_t) entryIdx * numOutputs + outputIdx;
+                double const output = Network::SigmoidActivationFunction( m_batchOutputNeurons[valueIdx] );
+                m_batchOutputNeurons[valueIdx] = output;
+
+                if ( Network::ClampOutputValue( output ) != pExpectedOutputs[outputIdx] )
+                {
+                    resultCorrect = false;
+                }
+
+                sumSquaredError += weight * pow( ( output - pExpectedOutputs[outputIdx] ), 2 );
+                double const target = ( pTargets != nullptr ) ? pTargets[valueIdx] : (double) pExpectedOutputs[outputIdx];
+                m_batchErrorGradientsOutput[valueIdx] = weight * GetOutputErrorGradient( target, output );
+            }
+
+            numIncorrectEntries += resultCorrect ? 0 : weight;
+        }
+
+        // Hidden error gradients, the bias neuron has no incoming weights
+        //--------------------------------------------------------------------------------------------------------
+
+        Gemm::Multiply( false, true, numEntries, numHidden, numOutputs, 1.0, m_batchErrorGradientsOutput.data(), numOutputs, network.m_weightsHiddenOutput.data(), numOutputs, 0.0, m_batchErrorGradientsHidden.data(), numHidden );
+
+        for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            double const* pHidden = &m_batchHiddenNeurons[(size_t) entryIdx * ( numHidden + 1 )];
+            double* pErrorGradients = &m_batchErrorGradientsHidden[(size_t) entryIdx * numHidden];
+            for ( uint32_t hiddenIdx = 0; hiddenIdx < numHidden; hiddenIdx++ )
+            {
+                pErrorGradients[hiddenIdx] *= pHidden[hiddenIdx] * ( 1.0 - pHidden[hiddenIdx] );
+            }
+        }
+
+        // Accumulate deltas: hidden^T * output gradients and inputs^T * hidden gradients, then the input bias row
+        //--------------------------------------------------------------------------------------------------------
+
+        Gemm::Multiply( true, false, numHidden + 1, numOutputs, numEntries, m_learningRate, m_batchHiddenNeurons.data(), numHidden + 1, m_batchErrorGradientsOutput.data(), numOutputs, 1.0, m_deltaHiddenOutput.data(), numOutputs );
+        Gemm::Multiply( true, false, numInputs, numHidden, numEntries, m_learningRate, m_batchInputs.data(), numInputs, m_batchErrorGradientsHidden.data(), numHidden, 1.0, m_deltaInputHidden.data(), numHidden );
+
+        double* pBiasDeltas = &m_deltaInputHidden[network.GetInputHiddenWeightIndex( numInputs, 0 )];
+        for ( uint32_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            double const* pErrorGradients = &m_batchErrorGradientsHidden[(size_t) entryIdx * numHidden];
+            for ( uint32_t hiddenIdx = 0; hiddenIdx < numHidden; hiddenIdx++ )
+            {
+                pBiasDeltas[hiddenIdx] += m_learningRate * -1.0 * pErrorGradients[hiddenIdx];
+            }
+        }
+
+        return numIncorrectEntries;
+    }
+
+    void NetworkTrainer::UpdateWeights()
+    {
+        BPN_PROFILE_SCOPE( UpdateWeights );
+
+        // Input -> hidden weights
+        //--------------------------------------------------------------------------------------------------------
+
+        for ( auto InputIdx = 0; InputIdx <= m_pNetwork->m_numInputs; InputIdx++ )
+        {
+            for ( auto hiddenIdx = 0; hiddenIdx < m_pNetwork->m_numHidden; hiddenIdx++ )
+            {
+                int32_t const weightIdx = m_pNetwork->GetInputHiddenWeightIndex( InputIdx, hiddenIdx );
+                m_pNetwork->m_weightsInputHidden[weightIdx] += m_deltaInputHidden[weightIdx];
+
+                // Keep pruned weights at zero
+                if ( !m_inputHiddenMask.empty() && m_inputHiddenMask[weightIdx] == 0 )
+                {
+                    m_pNetwork->m_weightsInputHidden[weightIdx] = 0;
+                    m_deltaInputHidden[weightIdx] = 0;
+                }
+
+                // Clear delta only if using batch (previous delta is needed for momentum
+                if ( m_useBatchLearning )
+                {
+                    m_deltaInputHidden[weightIdx] = 0;
+                }
+            }
+        }
+
+        // Hidden -> output weights
+        //--------------------------------------------------------------------------------------------------------
+
+        for ( auto hiddenIdx = 0; hiddenIdx <= m_pNetwork->m_numHidden; hiddenIdx++ )
+        {
+            for ( auto outputIdx = 0; outputIdx < m_pNetwork->m_numOutputs; outputIdx++ )
+            {
+                int32_t const weightIdx = m_pNetwork->GetHiddenOutputWeightIndex( hiddenIdx, outputIdx );
+                m_pNetwork->m_weightsHiddenOutput[weightIdx] += m_deltaHiddenOutput[weightIdx];
+
+                // Clear delta only if using batch (previous delta is needed for momentum)
+                if ( m_useBatchLearning )
+                {
+                    m_deltaHiddenOutput[weightIdx] = 0;
+                }
+            }
+        }
+    }
+
+    void NetworkTrainer::GetSetAccuracyAndMSE( TrainingSet const& trainingSet, double& accuracy, double& MSE ) const
+    {
+        BPN_PROFILE_SCOPE( SetEvaluation );
+
+        accuracy = 0;
+        MSE = 0;
+
+        double numIncorrectResults = 0;
+        size_t const totalWeight = GetTotalWeight( trainingSet.data(), trainingSet.size() );
+        for ( auto const& trainingEntry : trainingSet )
+        {
+            // Check if the network outputs match the expected outputs
+            m_pNetwork->Evaluate( trainingEntry.m_inputs );
+            if ( !CheckOutputs( trainingEntry.m_expectedOutputs, trainingEntry.m_weight, MSE ) )
+            {
+                numIncorrectResults += trainingEntry.m_weight;
+            }
+        }
+
+        if ( totalWeight == 0 )
+        {
+            return;
+        }
+
+        accuracy = 100.0f - ( numIncorrectResults / totalWeight * 100.0 );
+        MSE = MSE / ( m_pNetwork->m_numOutputs * totalWeight );
+    }
+
+    void NetworkTrainer::GetSetAccuracyAndMSE( CompactTrainingSet const& trainingSet, double& accuracy, double& MSE ) const
+    {
+        BPN_PROFILE_SCOPE( SetEvaluation );
+
+        accuracy = 0;
+        MSE = 0;
+
+        std::vector<int32_t> expectedOutputs( trainingSet.GetNumOutputs() );
+        double numIncorrectResults = 0;
+        for ( size_t entryIdx = 0; entryIdx < trainingSet.GetNumEntries(); entryIdx++ )
+        {
+            EvaluateCompactEntry( trainingSet, entryIdx );
+            trainingSet.GetExpectedOutputs( entryIdx, expectedOutputs.data() );
+            if ( !CheckOutputs( expectedOutputs, 1, MSE ) )
+            {
+                numIncorrectResults++;
+            }
+        }
+
+        if ( trainingSet.GetNumEntries() == 0 )
+        {
+            return;
+        }
+
+        accuracy = 100.0f - ( numIncorrectResults / trainingSet.GetNumEntries() * 100.0 );
+        MSE = MSE / ( m_pNetwork->m_numOutputs * trainingSet.GetNumEntries() );
+    }
+
+    void NetworkTrainer::GetSetAccuracyAndMSE( TrainingSet const& entries, std::vector<uint32_t> const& indices, double& accuracy, double& MSE ) const
+    {
+        BPN_PROFILE_SCOPE( SetEvaluation );
+
+        accuracy = 0;
+        MSE = 0;
+
+        double numIncorrectResults = 0;
+        size_t totalWeight = 0;
+        for ( auto entryIdx : indices )
+        {
+            m_pNetwork->Evaluate( entries[entryIdx].m_inputs );
+            if ( !CheckOutputs( entries[entryIdx].m_expectedOutputs, entries[entryIdx].m_weight, MSE ) )
+            {
+                numIncorrectResults += entries[entryIdx].m_weight;
+            }
+
+            totalWeight += entries[entryIdx].m_weight;
+        }
+
+        if ( totalWeight == 0 )
+        {
+            return;
+        }
+
+        accuracy = 100.0f - ( numIncorrectResults / totalWeight * 100.0 );
+        MSE = MSE / ( m_pNetwork->m_numOutputs * totalWeight );
+    }
+
 }
\ No newline at end of file
@@ -1,90 +1,218 @@
-//-------------------------------------------------------------------------
-// Simple back-propagation neural network example
-// 2017 - Bobby Anguelov
-// MIT license: https://opensource.org/licenses/MIT
-//-------------------------------------------------------------------------
-// Basic Gradient Descent NN Trainer with Momentum and Batch Learning
-
-#pragma once
-
-#include "NeuralNetwork.h"
-#include <fstream>
-
-namespace BPN
-{
-    struct TrainingEntry
-    {
-        std::vector<double>         m_inputs;
-        std::vector<int32_t>        m_expectedOutputs;
-    };
-
-    typedef std::vector<TrainingEntry> TrainingSet;
-
-    struct TrainingData
-    {
-        TrainingSet m_trainingSet;
-        TrainingSet m_generalizationSet;
-        TrainingSet m_validationSet;
-    };
-
-    //-------------------------------------------------------------------------
-
-    class NetworkTrainer
-    {
-    public:
-
-        struct Settings
-        {
-            // Learning params
-            double      m_learningRate = 0.001;
-            double      m_momentum = 0.9;
-            bool        m_useBatchLearning = false;
-
-            // Stopping conditions
-            uint32_t    m_maxEpochs = 150;
-            double      m_desiredAccuracy = 90;
-        };
-
-    public:
-
-        NetworkTrainer( Settings const& settings, Network* pNetwork );
-
-        void Train( TrainingData const& trainingData );
-
-    private:
-
-        inline double GetOutputErrorGradient( double desiredValue, double outputValue ) const { return outputValue * ( 1.0 - outputValue ) * ( desiredValue - outputValue ); }
-        double GetHiddenErrorGradient( int32_t hiddenIdx ) const;
-
-        void RunEpoch( TrainingSet const& trainingSet );
-        void Backpropagate( std::vector<int32_t> const& expectedOutputs );
-        void UpdateWeights();
-
-        void GetSetAccuracyAndMSE( TrainingSet const& trainingSet, double& accuracy, double& mse ) const;
-
-    private:
-        
-        Network*                    m_pNetwork;                 // Network to train
-
-        // Training settings
-        double                      m_learningRate;             // Adjusts the step size of the weight update
-        double                      m_momentum;                 // Improves performance of stochastic learning (don't use for batch)
-        double                      m_desiredAccuracy;          // Target accuracy for training
-        uint32_t                    m_maxEpochs;                // Max number of training epochs
-        bool                        m_useBatchLearning;         // Should we use batch learning
-
-        // Training data
-        std::vector<double>         m_deltaInputHidden;         // Delta for input hidden layer
-        std::vector<double>         m_deltaHiddenOutput;        // Delta for hidden output layer
-        std::vector<double>         m_errorGradientsHidden;     // Error gradients for the hidden layer
-        std::vector<double>         m_errorGradientsOutput;     // Error gradients for the outputs
-
-        uint32_t                    m_currentEpoch;             // Epoch counter
-        double                      m_trainingSetAccuracy;
-        double                      m_validationSetAccuracy;
-        double                      m_generalizationSetAccuracy;
-        double                      m_trainingSetMSE;
-        double                      m_validationSetMSE;
-        double                      m_generalizationSetMSE;
-    };
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Basic Gradient Descent NN Trainer with Momentum and Batch Learning
+
+#pragma once
+
+#include "NeuralNetwork.h"
+#include "TrainingTelemetry.h"
+#include <fstream>
+
+namespace BPN
+{
+    struct TrainingEntry
+    {
+        std::vector<double>         m_inputs;
+        std::vector<int32_t>        m_expectedOutputs;
+        uint32_t                    m_weight = 1;               // Number of identical rows the entry stands for (see RowDeduplicator)
+    };
+
+    typedef std::vector<TrainingEntry> TrainingSet;
+
+    // Number of rows the entries stand for, set statistics are normalized by this rather than the entry count
+    inline size_t GetTotalWeight( TrainingEntry const* pEntries, size_t numEntries )
+    {
+        size_t totalWeight = 0;
+        for ( size_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            totalWeight += pEntries[entryIdx].m_weight;
+        }
+
+        return totalWeight;
+    }
+
+    inline size_t GetTotalWeight( TrainingSet const& entries ) { return GetTotalWeight( entries.data(), entries.size() ); }
+
+    struct TrainingData
+    {
+        TrainingSet m_trainingSet;
+        TrainingSet m_generalizationSet;
+        TrainingSet m_validationSet;
+    };
+
+    class CompactTrainingSet;
+    struct CompactTrainingData;
+
+    //-------------------------------------------------------------------------
+
+    class NetworkTrainer
+    {
+    public:
+
+        struct Settings
+        {
+            // Learning params
+            double      m_learningRate = 0.001;
+            double      m_momentum = 0.9;
+            bool        m_useBatchLearning = false;
+
+            // Presents the training set in a different order every epoch, the order only depends on the seed and the epoch
+            bool        m_shuffleEachEpoch = false;
+            uint64_t    m_seed = 0;
+
+            // Stopping conditions
+            uint32_t    m_maxEpochs = 150;
+            double      m_desiredAccuracy = 90;
+
+            // Gradual magnitude pruning of the input->hidden weights, disabled when the target sparsity is 0. The sparsity
+            // follows a cubic schedule from the start to the end epoch, pruning every pruning interval epochs, and training
+            // continues until at least the end epoch.
+            double      m_targetSparsity = 0;
+            uint32_t    m_pruningStartEpoch = 0;
+            uint32_t    m_pruningEndEpoch = 50;
+            uint32_t    m_pruningInterval = 5;
+
+            // Progress reporting, no output if not set
+            TrainingTelemetrySink* m_pTelemetrySink = nullptr;
+        };
+
+    public:
+
+        NetworkTrainer( Settings const& settings, Network* pNetwork );
+
+        void Train( TrainingData const& trainingData );
+
+        // Trains on compact copies of the sets (see CompactTrainingSet), the resulting network is identical
+        void Train( CompactTrainingData const& trainingData );
+
+        // Knowledge distillation (see Distiller): trains towards the teacher's raw outputs for the training set, row major, instead
+        // of the expected outputs. Accuracy and MSE are still measured against the expected outputs.
+        void Distill( TrainingData const& trainingData, std::vector<double> const& teacherOutputs );
+
+        // Run a single training pass over the supplied set, updates the training set accuracy and MSE. Entry weights scale the
+        // deltas of the batch learning path and the accuracy and MSE, stochastic learning updates once per entry regardless.
+        void RunEpoch( TrainingSet const& trainingSet );
+        void RunEpoch( CompactTrainingSet const& trainingSet );
+
+        // Incremental version of RunEpoch, allows an epoch to be split into blocks of entries that are interleaved with other work
+        void BeginEpoch();
+        void TrainEntries( TrainingEntry const* pEntries, size_t numEntries );
+        void TrainEntries( TrainingSet const& entries, uint32_t const* pIndices, size_t numIndices );
+        void EndEpoch();
+
+        // Trains on a single entry with the stochastic update, independently of any epoch. Returns whether the outputs
+        // before the update were correct and adds their squared errors to the sum.
+        bool TrainSample( TrainingEntry const& trainingEntry, double& sumSquaredError );
+
+        // Gradient of the error 0.5 * sum( ( expected - output )^2 ) over the entries with respect to the weights, in the
+        // Network::GetWeights layout. Uses the same backpropagation code as training, the training state is left unchanged.
+        void GetErrorGradient( TrainingEntry const* pEntries, size_t numEntries, std::vector<double>& gradient );
+
+        // Evaluate the network over the supplied set without modifying the weights, each entry counts as many times as its weight
+        void GetSetAccuracyAndMSE( TrainingSet const& trainingSet, double& accuracy, double& mse ) const;
+        void GetSetAccuracyAndMSE( CompactTrainingSet const& trainingSet, double& accuracy, double& mse ) const;
+
+        // Evaluate the network over the subset of the supplied entries selected by the indices
+        void GetSetAccuracyAndMSE( TrainingSet const& entries, std::vector<uint32_t> const& indices, double& accuracy, double& mse ) const;
+
+        // One-shot magnitude pruning, see NetworkPruner. Pruned weights are kept at zero by any further training.
+        void PruneInputHiddenWeights( double sparsity );
+
+        inline double GetTrainingSetAccuracy() const { return m_trainingSetAccuracy; }
+        inline double GetTrainingSetMSE() const { return m_trainingSetMSE; }
+
+    private:
+
+        inline double GetOutputErrorGradient( double desiredValue, double outputValue ) const { return outputValue * ( 1.0 - outputValue ) * ( desiredValue - outputValue ); }
+        double GetHiddenErrorGradient( int32_t hiddenIdx ) const;
+
+        template<typename DataType>
+        void TrainOnData( DataType const& trainingData );
+
+        void TrainEntry( TrainingEntry const& trainingEntry );
+
+        // Trains on the entries selected by the indices, or on the first numEntries entries if there are no indices
+        void TrainCompactEntries( CompactTrainingSet const& entries, uint32_t const* pIndices, size_t numEntries );
+
+        // Trains towards the teacher outputs on the entries selected by the indices, or on the first numEntries entries if there are no indices
+        void TrainDistillationEntries( TrainingSet const& entries, uint32_t const* pIndices, size_t numEntries );
+
+        // Loads the widened inputs of the entry into the network and evaluates it
+        void EvaluateCompactEntry( CompactTrainingSet const& entries, size_t entryIdx ) const;
+
+        // Compares the last evaluation's outputs against the expected outputs, adds the squared errors times the weight to the sum
+        bool CheckOutputs( std::vector<int32_t> const& expectedOutputs, uint32_t weight, double& sumSquaredError ) const;
+
+        // The targets are either the expected outputs or soft targets
+        template<typename TargetType>
+        void Backpropagate( TargetType const* pTargets );
+
+        template<typename TargetType>
+        void BackpropagateDeltas( TargetType const* pTargets );
+
+        // Batch learning path: evaluates and backpropagates the entries as matrix multiplications (see Gemm.h), adding the
+        // deltas of all of them at once. Returns the weighted number of incorrect entries and adds their squared errors to the sum.
+        uint32_t BackpropagateBatch( TrainingEntry const* const* ppEntries, uint32_t numEntries, double& sumSquaredError );
+        void BackpropagateBatch( TrainingEntry const* pEntries, size_t numEntries, double& sumSquaredError, double& numIncorrectEntries );
+        uint32_t BackpropagateBatch( CompactTrainingSet const& entries, uint32_t const* pIndices, size_t firstEntryIdx, uint32_t numEntries, double& sumSquaredError );
+
+        // Backpropagates the entries gathered into the batch inputs and expected outputs, towards the batch targets if there are any.
+        // Each entry's error gradients, error and correctness are scaled by its weight if there are weights.
+        uint32_t BackpropagateBatchTile( uint32_t numEntries, double& sumSquaredError, double const* pTargets = nullptr, uint32_t const* pWeights = nullptr );
+        void UpdateWeights();
+
+    private:
+        
+        Network*                    m_pNetwork;                 // Network to train
+
+        // Training settings
+        double                      m_learningRate;             // Adjusts the step size of the weight update
+        double                      m_momentum;                 // Improves performance of stochastic learning (don't use for batch)
+        double                      m_desiredAccuracy;          // Target accuracy for training
+        uint32_t                    m_maxEpochs;                // Max number of training epochs
+        bool                        m_useBatchLearning;         // Should we use batch learning
+        TrainingTelemetrySink*      m_pTelemetrySink;           // Optional progress reporting
+        bool                        m_shuffleEachEpoch;         // Shuffle the training order every epoch
+        uint64_t                    m_seed;                     // Seed for the epoch shuffles
+
+        // Gradual pruning settings
+        double                      m_targetSparsity;
+        uint32_t                    m_pruningStartEpoch;
+        uint32_t                    m_pruningEndEpoch;
+        uint32_t                    m_pruningInterval;
+
+        // Training data
+        std::vector<double>         m_deltaInputHidden;         // Delta for input hidden layer
+        std::vector<double>         m_deltaHiddenOutput;        // Delta for hidden output layer
+        std::vector<double>         m_errorGradientsHidden;     // Error gradients for the hidden layer
+        std::vector<double>         m_errorGradientsOutput;     // Error gradients for the outputs
+        std::vector<uint8_t>        m_inputHiddenMask;          // Pruned input hidden weights are 0, empty if nothing is pruned
+        std::vector<uint32_t>       m_epochOrder;               // Shuffled entry order for the current epoch
+        std::vector<int32_t>        m_expectedOutputs;          // Unpacked expected outputs of the current compact entry
+        double const*               m_pTeacherOutputs;          // Distillation targets for the training set, null when not distilling
+
+        // Batch learning scratch, one row per entry
+        std::vector<double>         m_batchInputs;
+        std::vector<int32_t>        m_batchExpectedOutputs;
+        std::vector<double>         m_batchTargets;             // Teacher outputs when distilling
+        std::vector<uint32_t>       m_batchWeights;
+        std::vector<double>         m_batchHiddenNeurons;       // Includes the bias neuron
+        std::vector<double>         m_batchOutputNeurons;
+        std::vector<double>         m_batchErrorGradientsHidden;
+        std::vector<double>         m_batchErrorGradientsOutput;
+
+        uint32_t                    m_currentEpoch;             // Epoch counter
+        size_t                      m_numEpochEntries;          // Entries trained on in the current epoch
+        double                      m_numEpochIncorrectEntries; // Incorrect entries in the current epoch
+        double                      m_epochSumSquaredError;     // Sum of squared output errors in the current epoch
+        double                      m_trainingSetAccuracy;
+        double                      m_validationSetAccuracy;
+        double                      m_generalizationSetAccuracy;
+        double                      m_trainingSetMSE;
+        double                      m_validationSetMSE;
+        double                      m_generalizationSetMSE;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,555 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "NumaTrainer.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if __linux__
+#include <sched.h>
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        inline double GetElapsedMS( Clock::time_point start, Clock::time_point end )
+        {
+            return std::chrono::duration<double, std::milli>( end - start ).count();
+        }
+
+        class Barrier
+        {
+        public:
+
+            explicit Barrier( uint32_t numThreads ) : m_numThreads( numThreads ) {}
+
+            void Wait()
+            {
+                std::unique_lock<std::mutex> lock( m_mutex );
+                uint64_t const generation = m_generation;
+                if ( ++m_numWaiting == m_numThreads )
+                {
+                    m_numWaiting = 0;
+                    m_generation++;
+                    m_condition.notify_all();
+                }
+                else
+                {
+                    m_condition.wait( lock, [this, generation] { return m_generation != generation; } );
+                }
+            }
+
+        private:
+
+            std::mutex                      m_mutex;
+            std::condition_variable         m_condition;
+            uint32_t const                  m_numThreads;
+            uint32_t                        m_numWaiting = 0;
+            uint64_t                        m_generation = 0;
+        };
+
+        // Everything a worker writes is allocated by the worker itself, aligned so that workers don't share cache lines
+        struct alignas( 64 ) WorkerState
+        {
+            uint32_t                        m_nodeSlotIdx = 0;
+            uint32_t                        m_cpu = 0;
+            bool                            m_isNodeLeader = false;
+            bool                            m_shouldPin = false;
+            bool                            m_hasMigrated = false;
+            size_t                          m_shardStart = 0;
+            size_t                          m_shardEnd = 0;
+            std::vector<double>             m_gradient;
+
+            uint64_t                        m_numEntriesTrained = 0;
+            uint64_t                        m_bytesRead = 0;
+            double                          m_computeTimeMS = 0;
+            double                          m_syncTimeMS = 0;
+            double                          m_numIncorrectEntries = 0;
+            double                          m_sumSquaredError = 0;
+        };
+
+        struct alignas( 64 ) NodeState
+        {
+            std::vector<uint32_t>           m_workers;
+            std::vector<double>             m_gradient;             // Sum of the node's worker gradients
+            std::vector<double>             m_weights;              // Node-local replica of the master weights
+        };
+
+        //-------------------------------------------------------------------------
+
+        // Parses the kernel cpu list format, i.e. "0-3,8-11"
+        std::vector<uint32_t> ParseCpuList( std::string const& list )
+        {
+            std::vector<uint32_t> cpus;
+            std::stringstream stream( list );
+            std::string range;
+            while ( std::getline( stream, range, ',' ) )
+            {
+                if ( range.empty() || range[0] < '0' || range[0] > '9' )
+                {
+                    continue;
+                }
+
+                size_t const dashIdx = range.find( '-' );
+                uint32_t const first = (uint32_t) std::stoul( range.substr( 0, dashIdx ) );
+                uint32_t const last = ( dashIdx == std::string::npos ) ? first : (uint32_t) std::stoul( range.substr( dashIdx + 1 ) );
+                for ( uint32_t cpu = first; cpu <= last; cpu++ )
+                {
+                    cpus.push_back( cpu );
+                }
+            }
+
+            return cpus;
+        }
+
+        bool ReadNumaStat( uint32_t nodeIdx, uint64_t& localAllocations, uint64_t& remoteAllocations, uint64_t& missedAllocations )
+        {
+            #if __linux__
+            std::ifstream numaStatFile( "/sys/devices/system/node/node" + std::to_string( nodeIdx ) + "/numastat" );
+            if ( !numaStatFile.is_open() )
+            {
+                return false;
+            }
+
+            std::string name;
+            uint64_t value = 0;
+            while ( numaStatFile >> name >> value )
+            {
+                if ( name == "local_node" ) localAllocations = value;
+                else if ( name == "other_node" ) remoteAllocations = value;
+                else if ( name == "numa_miss" ) missedAllocations = value;
+            }
+            return true;
+            #else
+            ( void ) nodeIdx; ( void ) localAllocations; ( void ) remoteAllocations; ( void ) missedAllocations;
+            return false;
+            #endif
+        }
+
+        bool PinCurrentThread( uint32_t cpu )
+        {
+            #if __linux__
+            cpu_set_t cpuSet;
+            CPU_ZERO( &cpuSet );
+            CPU_SET( cpu, &cpuSet );
+            return sched_setaffinity( 0, sizeof( cpuSet ), &cpuSet ) == 0;
+            #else
+            ( void ) cpu;
+            return false;
+            #endif
+        }
+
+        int32_t GetCurrentCpu()
+        {
+            #if __linux__
+            return sched_getcpu();
+            #else
+            return -1;
+            #endif
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    std::vector<NumaNode> GetNumaTopology()
+    {
+        std::vector<NumaNode> nodes;
+
+        #if __linux__
+        cpu_set_t allowedCpus;
+        CPU_ZERO( &allowedCpus );
+        bool const hasAffinityMask = sched_getaffinity( 0, sizeof( allowedCpus ), &allowedCpus ) == 0;
+
+        std::ifstream onlineNodesFile( "/sys/devices/system/node/online" );
+        std::string onlineNodes;
+        if ( std::getline( onlineNodesFile, onlineNodes ) )
+        {
+            for ( uint32_t nodeIdx : ParseCpuList( onlineNodes ) )
+            {
+                std::ifstream cpuListFile( "/sys/devices/system/node/node" + std::to_string( nodeIdx ) + "/cpulist" );
+                std::string cpuList;
+                std::getline( cpuListFile, cpuList );
+
+                // Only cpus this process is allowed to run on
+                NumaNode node{ nodeIdx, {} };
+                for ( uint32_t cpu : ParseCpuList( cpuList ) )
+                {
+                    if ( !hasAffinityMask || ( cpu < CPU_SETSIZE && CPU_ISSET( cpu, &allowedCpus ) ) )
+                    {
+                        node.m_cpus.push_back( cpu );
+                    }
+                }
+
+                if ( !node.m_cpus.empty() )
+                {
+                    nodes.push_back( node );
+                }
+            }
+        }
+        #endif
+
+        // Single node fallback
+        if ( nodes.empty() )
+        {
+            NumaNode node{ 0, {} };
+            for ( uint32_t cpu = 0; cpu < std::max( 1u, std::thread::hardware_concurrency() ); cpu++ )
+            {
+                node.m_cpus.push_back( cpu );
+            }
+            nodes.push_back( node );
+        }
+
+        return nodes;
+    }
+
+    //-------------------------------------------------------------------------
+
+    NumaTrainer::NumaTrainer( Settings const& settings, Network* pNetwork )
+        : m_settings( settings )
+        , m_pNetwork( pNetwork )
+    {
+        assert( pNetwork != nullptr );
+        m_settings.m_batchSize = std::max( 1u, m_settings.m_batchSize );
+    }
+
+    void NumaTrainer::Train( TrainingData const& trainingData )
+    {
+        TrainingSet const& trainingSet = trainingData.m_trainingSet;
+        assert( !trainingSet.empty() );
+
+        auto const trainingStartTime = Clock::now();
+
+        // Assign workers to nodes and cpus, interleaved across the nodes
+        //-------------------------------------------------------------------------
+
+        std::vector<NumaNode> const topology = GetNumaTopology();
+        uint32_t numCpus = 0;
+        for ( auto const& node : topology )
+        {
+            numCpus += (uint32_t) node.m_cpus.size();
+        }
+
+        uint32_t const numWorkers = std::max( 1u, std::min( ( m_settings.m_numThreads == 0 ) ? numCpus : m_settings.m_numThreads, (uint32_t) trainingSet.size() ) );
+        uint32_t const numNodeSlots = std::min( numWorkers, (uint32_t) topology.size() );
+
+        std::vector<WorkerState> workers( numWorkers );
+        std::vector<NodeState> nodes( numNodeSlots );
+        size_t const shardSize = ( trainingSet.size() + numWorkers - 1 ) / numWorkers;
+        bool const pinThreads = m_settings.m_pinThreads;
+        for ( uint32_t workerIdx = 0; workerIdx < numWorkers; workerIdx++ )
+        {
+            WorkerState& worker = workers[workerIdx];
+            NumaNode const& node = topology[workerIdx % numNodeSlots];
+            worker.m_nodeSlotIdx = workerIdx % numNodeSlots;
+            worker.m_cpu = node.m_cpus[( workerIdx / numNodeSlots ) % node.m_cpus.size()];
+            worker.m_isNodeLeader = nodes[worker.m_nodeSlotIdx].m_workers.empty();
+            worker.m_shouldPin = pinThreads;
+            worker.m_shardStart = std::min( trainingSet.size(), workerIdx * shardSize );
+            worker.m_shardEnd = std::min( trainingSet.size(), worker.m_shardStart + shardSize );
+            nodes[worker.m_nodeSlotIdx].m_workers.push_back( workerIdx );
+        }
+
+        std::vector<uint64_t> startNumaStats( numNodeSlots * 3, 0 );
+        for ( uint32_t nodeSlotIdx = 0; nodeSlotIdx < numNodeSlots; nodeSlotIdx++ )
+        {
+            ReadNumaStat( topology[nodeSlotIdx].m_nodeIdx, startNumaStats[nodeSlotIdx * 3], startNumaStats[nodeSlotIdx * 3 + 1], startNumaStats[nodeSlotIdx * 3 + 2] );
+        }
+
+        if ( m_settings.m_pTelemetrySink != nullptr )
+        {
+            TrainingStartTelemetry telemetry;
+            telemetry.m_learningRate = m_settings.m_learningRate;
+            telemetry.m_momentum = m_settings.m_momentum;
+            telemetry.m_maxEpochs = m_settings.m_maxEpochs;
+            telemetry.m_useBatchLearning = false;
+            telemetry.m_numInputs = m_pNetwork->m_numInputs;
+            telemetry.m_numHidden = m_pNetwork->m_numHidden;
+            telemetry.m_numOutputs = m_pNetwork->m_numOutputs;
+            telemetry.m_numTrainingEntries = (uint32_t) trainingSet.size();
+            m_settings.m_pTelemetrySink->OnTrainingStarted( telemetry );
+        }
+
+        // Shared state, the master weights and momentum are allocated by the first worker
+        //-------------------------------------------------------------------------
+
+        NetworkTrainer::Settings trainerSettings;
+        trainerSettings.m_learningRate = m_settings.m_learningRate;
+        trainerSettings.m_momentum = m_settings.m_momentum;
+        NetworkTrainer evaluator( trainerSettings, m_pNetwork );
+
+        std::vector<double> masterWeights;
+        std::vector<double> masterDeltas;
+        size_t const numWeights = m_pNetwork->GetWeights().size();
+        size_t const entrySizeBytes = m_pNetwork->m_numInputs * sizeof( double ) + m_pNetwork->m_numOutputs * sizeof( int32_t );
+        uint32_t const numStepsPerEpoch = (uint32_t) ( ( shardSize + m_settings.m_batchSize - 1 ) / m_settings.m_batchSize );
+        double const trainingSetWeight = (double) GetTotalWeight( trainingSet );
+
+        Barrier barrier( numWorkers );
+        bool shouldStop = m_settings.m_maxEpochs == 0;
+        uint32_t epoch = 0;
+        uint64_t numSyncs = 0;
+        auto epochStartTime = Clock::now();
+
+        auto WorkerThread = [&] ( uint32_t workerIdx )
+        {
+            WorkerState& worker = workers[workerIdx];
+            NodeState& node = nodes[worker.m_nodeSlotIdx];
+
+            if ( worker.m_shouldPin )
+            {
+                PinCurrentThread( worker.m_cpu );
+            }
+
+            // First touch: the shard, the network copy and the buffers are allocated and written by the pinned thread
+            TrainingSet const shard( trainingSet.begin() + worker.m_shardStart, trainingSet.begin() + worker.m_shardEnd );
+            double const shardWeight = (double) GetTotalWeight( shard );
+            Network network( *m_pNetwork );
+            NetworkTrainer trainer( trainerSettings, &network );
+            worker.m_gradient.resize( numWeights, 0.0 );
+
+            if ( workerIdx == 0 )
+            {
+                masterWeights = m_pNetwork->GetWeights();
+                masterDeltas.resize( numWeights, 0.0 );
+            }
+
+            if ( worker.m_isNodeLeader )
+            {
+                node.m_gradient.resize( numWeights, 0.0 );
+                node.m_weights = m_pNetwork->GetWeights();
+            }
+
+            barrier.Wait();
+
+            while ( !shouldStop )
+            {
+                for ( uint32_t stepIdx = 0; stepIdx < numStepsPerEpoch; stepIdx++ )
+                {
+                    // Local gradient
+                    //-------------------------------------------------------------------------
+
+                    auto const computeStartTime = Clock::now();
+                    size_t const batchStart = std::min( shard.size(), (size_t) stepIdx * m_settings.m_batchSize );
+                    size_t const batchSize = std::min( (size_t) m_settings.m_batchSize, shard.size() - batchStart );
+                    if ( batchSize > 0 )
+                    {
+                        trainer.GetErrorGradient( &shard[batchStart], batchSize, worker.m_gradient );
+                        worker.m_numEntriesTrained += batchSize;
+                        worker.m_bytesRead += batchSize * entrySizeBytes;
+                    }
+                    else
+                    {
+                        std::fill( worker.m_gradient.begin(), worker.m_gradient.end(), 0.0 );
+                    }
+
+                    auto const syncStartTime = Clock::now();
+                    worker.m_computeTimeMS += GetElapsedMS( computeStartTime, syncStartTime );
+
+                    // Node reduction, then the update of the master weights, then the node replicas
+                    //-------------------------------------------------------------------------
+
+                    barrier.Wait();
+
+                    if ( worker.m_isNodeLeader )
+                    {
+                        node.m_gradient = workers[node.m_workers[0]].m_gradient;
+                        for ( size_t nodeWorkerIdx = 1; nodeWorkerIdx < node.m_workers.size(); nodeWorkerIdx++ )
+                        {
+                            std::vector<double> const& workerGradient = workers[node.m_workers[nodeWorkerIdx]].m_gradient;
+                            for ( size_t weightIdx = 0; weightIdx < numWeights; weightIdx++ )
+                            {
+                                node.m_gradient[weightIdx] += workerGradient[weightIdx];
+                            }
+                        }
+                    }
+
+                    barrier.Wait();
+
+                    if ( workerIdx == 0 )
+                    {
+                        for ( size_t weightIdx = 0; weightIdx < numWeights; weightIdx++ )
+                        {
+                            double gradient = 0;
+                            for ( NodeState const& otherNode : nodes )
+                            {
+                                gradient += otherNode.m_gradient[weightIdx];
+                            }
+
+                            masterDeltas[weightIdx] = -m_settings.m_learningRate * gradient + m_settings.m_momentum * masterDeltas[weightIdx];
+                            masterWeights[weightIdx] += masterDeltas[weightIdx];
+                        }
+                        numSyncs++;
+                    }
+
+                    barrier.Wait();
+
+                    if ( worker.m_isNodeLeader )
+                    {
+                        node.m_weights = masterWeights;
+                    }
+
+                    barrier.Wait();
+
+                    network.LoadWeights( node.m_weights );
+                    worker.m_bytesRead += numWeights * sizeof( double );
+                    worker.m_syncTimeMS += GetElapsedMS( syncStartTime, Clock::now() );
+                }
+
+                // Epoch results, the training set accuracy is gathered from the shards in parallel
+                //-------------------------------------------------------------------------
+
+                // The last workers have no rows when the shards don't divide evenly, they contribute zeros rather than a 0/0 NaN
+                worker.m_numIncorrectEntries = 0;
+                worker.m_sumSquaredError = 0;
+                if ( !shard.empty() )
+                {
+                    double shardAccuracy = 0;
+                    double shardMSE = 0;
+                    trainer.GetSetAccuracyAndMSE( shard, shardAccuracy, shardMSE );
+                    worker.m_numIncorrectEntries = ( 100.0 - shardAccuracy ) / 100.0 * shardWeight;
+                    worker.m_sumSquaredError = shardMSE * m_pNetwork->m_numOutputs * shardWeight;
+                }
+
+                barrier.Wait();
+
+                if ( workerIdx == 0 )
+                {
+                    double numIncorrectEntries = 0;
+                    double sumSquaredError = 0;
+                    for ( WorkerState const& otherWorker : workers )
+                    {
+                        numIncorrectEntries += otherWorker.m_numIncorrectEntries;
+                        sumSquaredError += otherWorker.m_sumSquaredError;
+                    }
+
+                    double const trainingSetAccuracy = 100.0 - ( numIncorrectEntries / trainingSetWeight * 100.0 );
+                    double const trainingSetMSE = sumSquaredError / ( m_pNetwork->m_numOutputs * trainingSetWeight );
+
+                    m_pNetwork->LoadWeights( masterWeights );
+                    double generalizationSetAccuracy = 0;
+                    double generalizationSetMSE = 0;
+                    evaluator.GetSetAccuracyAndMSE( trainingData.m_generalizationSet, generalizationSetAccuracy, generalizationSetMSE );
+
+                    if ( m_settings.m_pTelemetrySink != nullptr )
+                    {
+                        EpochTelemetry telemetry;
+                        telemetry.m_epoch = epoch;
+                        telemetry.m_trainingSetAccuracy = trainingSetAccuracy;
+                        telemetry.m_trainingSetMSE = trainingSetMSE;
+                        telemetry.m_generalizationSetAccuracy = generalizationSetAccuracy;
+                        telemetry.m_generalizationSetMSE = generalizationSetMSE;
+                        telemetry.m_epochTimeMS = GetElapsedMS( epochStartTime, Clock::now() );
+                        telemetry.m_samplesPerSecond = ( telemetry.m_epochTimeMS > 0 ) ? trainingSet.size() / ( telemetry.m_epochTimeMS / 1000.0 ) : 0.0;
+                        m_settings.m_pTelemetrySink->OnEpochComplete( telemetry );
+                    }
+
+                    epoch++;
+                    epochStartTime = Clock::now();
+                    shouldStop = epoch >= m_settings.m_maxEpochs || ( trainingSetAccuracy >= m_settings.m_desiredAccuracy && generalizationSetAccuracy >= m_settings.m_desiredAccuracy );
+                }
+
+                barrier.Wait();
+            }
+
+            int32_t const currentCpu = GetCurrentCpu();
+            if ( worker.m_shouldPin && currentCpu >= 0 )
+            {
+                std::vector<uint32_t> const& nodeCpus = topology[worker.m_nodeSlotIdx].m_cpus;
+                worker.m_hasMigrated = std::find( nodeCpus.begin(), nodeCpus.end(), (uint32_t) currentCpu ) == nodeCpus.end();
+            }
+        };
+
+        // Every worker runs on its own thread, worker 0 included, so that node 0's leader allocates the master and node 0
+        // buffers from a pinned thread. Pinning the calling thread instead would outlive the training.
+        std::vector<std::thread> threads;
+        for ( uint32_t workerIdx = 0; workerIdx < numWorkers; workerIdx++ )
+        {
+            threads.emplace_back( WorkerThread, workerIdx );
+        }
+
+        for ( auto& thread : threads )
+        {
+            thread.join();
+        }
+
+        // Stats
+        //-------------------------------------------------------------------------
+
+        m_stats = Stats();
+        m_stats.m_numWorkers = numWorkers;
+        m_stats.m_numEpochs = epoch;
+        m_stats.m_numSyncs = numSyncs;
+        m_stats.m_nodes.resize( numNodeSlots );
+        for ( uint32_t nodeSlotIdx = 0; nodeSlotIdx < numNodeSlots; nodeSlotIdx++ )
+        {
+            NodeStats& nodeStats = m_stats.m_nodes[nodeSlotIdx];
+            nodeStats.m_nodeIdx = topology[nodeSlotIdx].m_nodeIdx;
+
+            double maxComputeTimeMS = 0;
+            for ( uint32_t workerIdx : nodes[nodeSlotIdx].m_workers )
+            {
+                WorkerState const& worker = workers[workerIdx];
+                nodeStats.m_numWorkers++;
+                nodeStats.m_numMigratedWorkers += worker.m_hasMigrated ? 1 : 0;
+                nodeStats.m_numEntriesTrained += worker.m_numEntriesTrained;
+                nodeStats.m_bytesRead += worker.m_bytesRead;
+                maxComputeTimeMS = std::max( maxComputeTimeMS, worker.m_computeTimeMS );
+                m_stats.m_computeTimeMS = std::max( m_stats.m_computeTimeMS, worker.m_computeTimeMS );
+                m_stats.m_syncTimeMS = std::max( m_stats.m_syncTimeMS, worker.m_syncTimeMS );
+            }
+            nodeStats.m_bandwidthGBs = ( maxComputeTimeMS > 0 ) ? nodeStats.m_bytesRead / ( maxComputeTimeMS / 1000.0 ) / 1e9 : 0.0;
+
+            uint64_t numaStats[3] = {};
+            if ( ReadNumaStat( nodeStats.m_nodeIdx, numaStats[0], numaStats[1], numaStats[2] ) )
+            {
+                nodeStats.m_localAllocations = numaStats[0] - startNumaStats[nodeSlotIdx * 3];
+                nodeStats.m_remoteAllocations = numaStats[1] - startNumaStats[nodeSlotIdx * 3 + 1];
+                nodeStats.m_missedAllocations = numaStats[2] - startNumaStats[nodeSlotIdx * 3 + 2];
+            }
+        }
+        m_stats.m_totalTimeMS = GetElapsedMS( trainingStartTime, Clock::now() );
+
+        if ( m_settings.m_pTelemetrySink != nullptr )
+        {
+            TrainingCompleteTelemetry telemetry;
+            telemetry.m_numEpochs = epoch;
+            evaluator.GetSetAccuracyAndMSE( trainingData.m_validationSet, telemetry.m_validationSetAccuracy, telemetry.m_validationSetMSE );
+            telemetry.m_totalTimeMS = m_stats.m_totalTimeMS;
+            m_settings.m_pTelemetrySink->OnTrainingComplete( telemetry );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    void NumaTrainer::PrintStats( std::ostream& stream, Stats const& stats )
+    {
+        stream << std::endl << " NUMA Training: " << stats.m_numWorkers << " workers on " << stats.m_nodes.size() << " node(s), " << stats.m_numEpochs << " epochs, " << stats.m_numSyncs << " syncs" << std::endl
+               << "==========================================================================" << std::endl
+               << " Time (ms) - total: " << stats.m_totalTimeMS << ", compute: " << stats.m_computeTimeMS << ", sync: " << stats.m_syncTimeMS << std::endl;
+
+        for ( NodeStats const& node : stats.m_nodes )
+        {
+            stream << " Node " << node.m_nodeIdx << " - workers: " << node.m_numWorkers << " (" << node.m_numMigratedWorkers << " migrated), entries: " << node.m_numEntriesTrained
+                   << ", read: " << node.m_bytesRead / ( 1024.0 * 1024.0 ) << " MB, bandwidth: " << node.m_bandwidthGBs << " GB/s"
+                   << ", page allocations - local: " << node.m_localAllocations << ", remote: " << node.m_remoteAllocations << ", missed: " << node.m_missedAllocations << std::endl;
+        }
+
+        stream << "==========================================================================" << std::endl << std::endl;
+    }
+}
@@ -0,0 +1,95 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// NUMA-aware data parallel trainer
+//
+// Workers are spread across the NUMA nodes and pinned to a core. Each worker copies its shard of the
+// training set from its own thread, so that first-touch places the shard on the worker's node, and trains
+// a local copy of the network. At every batch boundary the worker gradients are summed per node, the node
+// sums are combined into a single momentum update of the master weights and each node copies the new
+// weights into a node-local replica that its workers read from. Only one gradient and one set of weights
+// per node cross the interconnect per batch.
+//
+// Topology detection, pinning and the per-node allocation counters are Linux only, on other platforms
+// all workers are treated as a single unpinned node.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    struct NumaNode
+    {
+        uint32_t                            m_nodeIdx;
+        std::vector<uint32_t>               m_cpus;
+    };
+
+    // Nodes with at least one online cpu
+    std::vector<NumaNode> GetNumaTopology();
+
+    //-------------------------------------------------------------------------
+
+    class NumaTrainer
+    {
+    public:
+
+        struct Settings
+        {
+            double                          m_learningRate = 0.001;
+            double                          m_momentum = 0.9;
+            uint32_t                        m_batchSize = 64;           // Entries per worker between synchronizations, the update uses the summed gradient of all workers
+            uint32_t                        m_maxEpochs = 150;
+            double                          m_desiredAccuracy = 90;
+            uint32_t                        m_numThreads = 0;           // 0 uses every online cpu
+            bool                            m_pinThreads = true;
+            TrainingTelemetrySink*          m_pTelemetrySink = nullptr;
+        };
+
+        struct NodeStats
+        {
+            uint32_t                        m_nodeIdx = 0;
+            uint32_t                        m_numWorkers = 0;
+            uint32_t                        m_numMigratedWorkers = 0;   // Workers found running on another node's cpu
+            uint64_t                        m_numEntriesTrained = 0;
+            uint64_t                        m_bytesRead = 0;            // Shard and weight replica bytes read by the node's workers
+            double                          m_bandwidthGBs = 0;         // Bytes read over the node's busiest worker compute time
+
+            // Kernel page allocation counters for the node over the training run (system wide, from numastat)
+            uint64_t                        m_localAllocations = 0;     // Pages allocated here by a process running on this node
+            uint64_t                        m_remoteAllocations = 0;    // Pages allocated here by a process running on another node
+            uint64_t                        m_missedAllocations = 0;    // Pages allocated here although another node was preferred
+        };
+
+        struct Stats
+        {
+            std::vector<NodeStats>          m_nodes;
+            uint32_t                        m_numWorkers = 0;
+            uint32_t                        m_numEpochs = 0;
+            uint64_t                        m_numSyncs = 0;
+            double                          m_computeTimeMS = 0;        // Slowest worker's gradient time
+            double                          m_syncTimeMS = 0;           // Slowest worker's time spent reducing, updating and waiting
+            double                          m_totalTimeMS = 0;
+        };
+
+    public:
+
+        NumaTrainer( Settings const& settings, Network* pNetwork );
+
+        void Train( TrainingData const& trainingData );
+
+        inline Stats const& GetStats() const { return m_stats; }
+        static void PrintStats( std::ostream& stream, Stats const& stats );
+
+    private:
+
+        Settings                            m_settings;
+        Network*                            m_pNetwork;
+        Stats                               m_stats;
+    };
+}
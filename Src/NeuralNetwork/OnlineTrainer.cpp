@@ -0,0 +1,224 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "OnlineTrainer.h"
+#include <algorithm>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        NetworkTrainer::Settings GetStochasticTrainerSettings( OnlineTrainer::Settings const& settings )
+        {
+            NetworkTrainer::Settings trainerSettings;
+            trainerSettings.m_learningRate = settings.m_learningRate;
+            trainerSettings.m_momentum = settings.m_momentum;
+            trainerSettings.m_useBatchLearning = false;
+            return trainerSettings;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    OnlineTrainer::OnlineTrainer( Settings const& settings, Network const& network, ModelHandle* pModelHandle )
+        : m_settings( settings )
+        , m_network( network )
+        , m_trainer( GetStochasticTrainerSettings( settings ), &m_network )
+        , m_pModelHandle( pModelHandle )
+    {
+        m_settings.m_maxSamplesPerCall = std::max( 1u, m_settings.m_maxSamplesPerCall );
+        m_settings.m_rollingWindowSize = std::max( 1u, m_settings.m_rollingWindowSize );
+
+        m_rollingCorrect.reserve( m_settings.m_rollingWindowSize );
+        m_rollingSquaredErrors.reserve( m_settings.m_rollingWindowSize );
+
+        if ( m_pModelHandle != nullptr )
+        {
+            m_snapshotWeights.reserve( m_network.GetWeights().size() );
+            m_publishingThread = std::thread( &OnlineTrainer::PublishingThread, this );
+        }
+    }
+
+    OnlineTrainer::~OnlineTrainer()
+    {
+        if ( m_publishingThread.joinable() )
+        {
+            {
+                std::lock_guard<std::mutex> lock( m_snapshotMutex );
+                m_isStopping = true;
+            }
+            m_snapshotCondition.notify_all();
+            m_publishingThread.join();
+        }
+    }
+
+    size_t OnlineTrainer::Train( TrainingEntry const* pSamples, size_t numSamples )
+    {
+        // Larger calls are cut short rather than blocking ingestion for longer than the bound
+        numSamples = std::min( numSamples, (size_t) m_settings.m_maxSamplesPerCall );
+
+        auto const startTime = std::chrono::steady_clock::now();
+        uint64_t numDeferredSnapshots = 0;
+
+        for ( size_t sampleIdx = 0; sampleIdx < numSamples; sampleIdx++ )
+        {
+            // Score then train
+            double squaredError = 0;
+            bool const isCorrect = m_trainer.TrainSample( pSamples[sampleIdx], squaredError );
+            UpdateRollingMetrics( isCorrect, squaredError );
+
+            // Snapshot once the interval is reached, if the publisher is still busy keep trying on the following samples
+            if ( m_pModelHandle != nullptr && m_settings.m_snapshotInterval > 0 && ++m_numSamplesSinceSnapshot >= m_settings.m_snapshotInterval )
+            {
+                if ( TrySnapshot() )
+                {
+                    m_numSamplesSinceSnapshot = 0;
+                }
+                else
+                {
+                    numDeferredSnapshots++;
+                }
+            }
+        }
+
+        double const callTimeUS = std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now() - startTime ).count();
+
+        // Update stats
+        //-------------------------------------------------------------------------
+
+        size_t const numRollingSamples = m_rollingCorrect.size();
+
+        std::lock_guard<std::mutex> lock( m_statsMutex );
+        m_stats.m_numSamples += numSamples;
+        m_stats.m_numSnapshotsDeferred += numDeferredSnapshots;
+        m_stats.m_numCalls++;
+        m_totalCallTimeUS += callTimeUS;
+        m_stats.m_meanCallTimeUS = m_totalCallTimeUS / m_stats.m_numCalls;
+        m_stats.m_maxCallTimeUS = std::max( m_stats.m_maxCallTimeUS, callTimeUS );
+
+        if ( numRollingSamples > 0 )
+        {
+            m_stats.m_rollingAccuracy = 100.0 * m_numRollingCorrect / numRollingSamples;
+            m_stats.m_rollingMSE = m_rollingSumSquaredError / ( (double) m_network.GetNumOutputs() * numRollingSamples );
+        }
+
+        return numSamples;
+    }
+
+    void OnlineTrainer::UpdateRollingMetrics( bool isCorrect, double squaredError )
+    {
+        if ( m_rollingCorrect.size() < m_settings.m_rollingWindowSize )
+        {
+            m_rollingCorrect.push_back( isCorrect ? 1 : 0 );
+            m_rollingSquaredErrors.push_back( squaredError );
+            m_numRollingCorrect += isCorrect ? 1 : 0;
+            m_rollingSumSquaredError += squaredError;
+            return;
+        }
+
+        m_numRollingCorrect += ( isCorrect ? 1 : 0 ) - m_rollingCorrect[m_nextRollingIdx];
+        m_rollingSumSquaredError += squaredError - m_rollingSquaredErrors[m_nextRollingIdx];
+        m_rollingCorrect[m_nextRollingIdx] = isCorrect ? 1 : 0;
+        m_rollingSquaredErrors[m_nextRollingIdx] = squaredError;
+        m_nextRollingIdx = ( m_nextRollingIdx + 1 ) % m_settings.m_rollingWindowSize;
+
+        // Resum the errors every time the window wraps around so that rounding errors can't accumulate
+        if ( m_nextRollingIdx == 0 )
+        {
+            m_rollingSumSquaredError = 0;
+            for ( auto error : m_rollingSquaredErrors )
+            {
+                m_rollingSumSquaredError += error;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    bool OnlineTrainer::TrySnapshot()
+    {
+        // Never wait on the publisher, the snapshot is simply retried on the next sample
+        std::unique_lock<std::mutex> lock( m_snapshotMutex, std::try_to_lock );
+        if ( !lock.owns_lock() || m_hasPendingSnapshot || m_isPublishing )
+        {
+            return false;
+        }
+
+        CopySnapshotWeights();
+        lock.unlock();
+        m_snapshotCondition.notify_all();
+        return true;
+    }
+
+    void OnlineTrainer::CopySnapshotWeights()
+    {
+        std::vector<double> const& weightsInputHidden = m_network.GetInputHiddenWeights();
+        std::vector<double> const& weightsHiddenOutput = m_network.GetHiddenOutputWeights();
+        size_t const numInputHiddenWeights = (size_t) ( m_network.GetNumInputs() + 1 ) * m_network.GetNumHidden();
+        size_t const numHiddenOutputWeights = (size_t) ( m_network.GetNumHidden() + 1 ) * m_network.GetNumOutputs();
+
+        m_snapshotWeights.assign( weightsInputHidden.begin(), weightsInputHidden.begin() + numInputHiddenWeights );
+        m_snapshotWeights.insert( m_snapshotWeights.end(), weightsHiddenOutput.begin(), weightsHiddenOutput.begin() + numHiddenOutputWeights );
+        m_hasPendingSnapshot = true;
+    }
+
+    void OnlineTrainer::PublishSnapshot()
+    {
+        if ( m_pModelHandle == nullptr )
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock( m_snapshotMutex );
+        m_snapshotCondition.wait( lock, [this] () { return !m_hasPendingSnapshot && !m_isPublishing; } );
+        CopySnapshotWeights();
+        m_numSamplesSinceSnapshot = 0;
+        m_snapshotCondition.notify_all();
+        m_snapshotCondition.wait( lock, [this] () { return !m_hasPendingSnapshot && !m_isPublishing; } );
+    }
+
+    void OnlineTrainer::PublishingThread()
+    {
+        Network::Settings networkSettings;
+        networkSettings.m_numInputs = m_network.GetNumInputs();
+        networkSettings.m_numHidden = m_network.GetNumHidden();
+        networkSettings.m_numOutputs = m_network.GetNumOutputs();
+
+        std::unique_lock<std::mutex> lock( m_snapshotMutex );
+        while ( true )
+        {
+            m_snapshotCondition.wait( lock, [this] () { return m_isStopping || m_hasPendingSnapshot; } );
+            if ( !m_hasPendingSnapshot )
+            {
+                break;
+            }
+
+            // The snapshot buffer isn't written to while publishing, so the network can be built without holding the lock
+            m_hasPendingSnapshot = false;
+            m_isPublishing = true;
+            lock.unlock();
+
+            m_pModelHandle->Publish( std::unique_ptr<Network const>( new Network( networkSettings, m_snapshotWeights ) ) );
+
+            {
+                std::lock_guard<std::mutex> statsLock( m_statsMutex );
+                m_stats.m_numSnapshotsPublished++;
+            }
+
+            lock.lock();
+            m_isPublishing = false;
+            m_snapshotCondition.notify_all();
+        }
+    }
+
+    OnlineTrainer::Stats OnlineTrainer::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock( m_statsMutex );
+        return m_stats;
+    }
+}
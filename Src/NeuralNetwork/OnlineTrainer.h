@@ -0,0 +1,110 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Online/incremental trainer for a live stream of labelled samples
+//
+// Samples are trained on as they arrive with the same stochastic momentum update as the NetworkTrainer.
+// Each sample is scored before it is trained on, which gives the rolling accuracy and MSE over the most
+// recent samples. Every snapshot interval the trained weights are copied into a snapshot which a background
+// thread turns into a network and publishes to a ModelHandle, so scorers pick up the new weights without
+// ingestion ever waiting for them: if the previous snapshot is still being published the copy is deferred.
+
+#pragma once
+
+#include "ModelHandle.h"
+#include "NeuralNetworkTrainer.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class OnlineTrainer
+    {
+    public:
+
+        struct Settings
+        {
+            double                          m_learningRate = 0.001;
+            double                          m_momentum = 0.9;
+            uint32_t                        m_maxSamplesPerCall = 64;       // Bounds the work, and so the latency, of a single Train call
+            uint32_t                        m_rollingWindowSize = 1000;     // Number of recent samples the rolling accuracy and MSE are computed over
+            uint32_t                        m_snapshotInterval = 1000;      // Samples between weight snapshots, 0 disables publishing
+        };
+
+        struct Stats
+        {
+            uint64_t                        m_numSamples = 0;
+            double                          m_rollingAccuracy = 0;          // Over the last rolling window samples, scored before training on them
+            double                          m_rollingMSE = 0;
+            uint64_t                        m_numSnapshotsPublished = 0;
+            uint64_t                        m_numSnapshotsDeferred = 0;     // Snapshots pushed back a sample because the previous one was still being published
+            uint64_t                        m_numCalls = 0;
+            double                          m_meanCallTimeUS = 0;
+            double                          m_maxCallTimeUS = 0;
+        };
+
+    public:
+
+        // Trains a copy of the supplied network. Snapshots are published to the model handle if one is supplied, it must outlive the trainer.
+        OnlineTrainer( Settings const& settings, Network const& network, ModelHandle* pModelHandle = nullptr );
+        ~OnlineTrainer();
+
+        OnlineTrainer( OnlineTrainer const& ) = delete;
+        OnlineTrainer& operator=( OnlineTrainer const& ) = delete;
+
+        // Trains on at most m_maxSamplesPerCall of the supplied samples and returns how many were consumed, the caller feeds
+        // the rest in later calls. Not thread-safe, samples must be fed from a single thread.
+        size_t Train( TrainingEntry const& sample ) { return Train( &sample, 1 ); }
+        size_t Train( TrainingEntry const* pSamples, size_t numSamples );
+
+        // Waits for any pending snapshot to be published, then publishes the current weights
+        void PublishSnapshot();
+
+        Stats GetStats() const;
+
+        // The network being trained, only safe to use from the thread feeding the samples
+        inline Network const& GetNetwork() const { return m_network; }
+
+    private:
+
+        void UpdateRollingMetrics( bool isCorrect, double squaredError );
+        bool TrySnapshot();
+        void CopySnapshotWeights();
+        void PublishingThread();
+
+    private:
+
+        Settings                                m_settings;
+        Network                                 m_network;
+        NetworkTrainer                          m_trainer;
+        ModelHandle*                            m_pModelHandle;
+
+        // Rolling metrics, ring buffers of the per sample results over the window
+        std::vector<uint8_t>                    m_rollingCorrect;
+        std::vector<double>                     m_rollingSquaredErrors;
+        size_t                                  m_nextRollingIdx = 0;
+        uint32_t                                m_numRollingCorrect = 0;
+        double                                  m_rollingSumSquaredError = 0;
+
+        // Snapshot publishing
+        uint64_t                                m_numSamplesSinceSnapshot = 0;
+        std::thread                             m_publishingThread;
+        std::mutex                              m_snapshotMutex;
+        std::condition_variable                 m_snapshotCondition;
+        std::vector<double>                     m_snapshotWeights;
+        bool                                    m_hasPendingSnapshot = false;
+        bool                                    m_isPublishing = false;
+        bool                                    m_isStopping = false;
+
+        // Stats
+        mutable std::mutex                      m_statsMutex;
+        Stats                                   m_stats;
+        double                                  m_totalCallTimeUS = 0;
+    };
+}
@@ -0,0 +1,268 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "PredictionCache.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Approximate heap bytes per entry of the hash to slot index (node and bucket)
+        constexpr size_t g_indexBytesPerEntry = 40;
+
+        inline uint64_t MixHash( uint64_t hash, uint64_t value )
+        {
+            hash ^= value + 0x9E3779B97F4A7C15ull + ( hash << 6 ) + ( hash >> 2 );
+            return hash * 0xFF51AFD7ED558CCDull;
+        }
+
+        // Geometric growth that stops at the shard capacity, so that a full shard doesn't hold up to twice its memory bound
+        template<typename T>
+        void GrowSlotArray( std::vector<T>& values, size_t numValuesPerSlot, uint32_t maxSlots )
+        {
+            size_t const newSize = values.size() + numValuesPerSlot;
+            if ( newSize > values.capacity() )
+            {
+                values.reserve( std::min( std::max( newSize, values.capacity() * 2 ), (size_t) maxSlots * numValuesPerSlot ) );
+            }
+
+            values.resize( newSize );
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    PredictionCache::PredictionCache( Settings const& settings, uint32_t numInputs, uint32_t numOutputs )
+        : m_settings( settings )
+        , m_numInputs( numInputs )
+        , m_numOutputs( numOutputs )
+    {
+        m_settings.m_numShards = std::max( 1u, m_settings.m_numShards );
+        m_entrySizeBytes = ( numInputs + numOutputs ) * sizeof( double ) + numOutputs * sizeof( int8_t ) + 2 * sizeof( uint64_t ) + sizeof( uint8_t ) + g_indexBytesPerEntry;
+        m_maxShardEntries = (uint32_t) std::max( (size_t) 1, m_settings.m_maxMemoryBytes / m_settings.m_numShards / m_entrySizeBytes );
+        m_pShards.reset( new Shard[m_settings.m_numShards] );
+    }
+
+    uint64_t PredictionCache::HashInputs( double const* pInputs, uint32_t numInputs )
+    {
+        uint64_t hash = numInputs;
+        for ( uint32_t inputIdx = 0; inputIdx < numInputs; inputIdx++ )
+        {
+            uint64_t bits;
+            memcpy( &bits, &pInputs[inputIdx], sizeof( bits ) );
+            hash = MixHash( hash, bits );
+        }
+
+        return hash ^ ( hash >> 29 );
+    }
+
+    //-------------------------------------------------------------------------
+
+    bool PredictionCache::Lookup( uint64_t modelVersion, double const* pInputs, double* pOutputs, int32_t* pClampedOutputs )
+    {
+        uint64_t const hash = HashInputs( pInputs, m_numInputs );
+        return Lookup( GetShard( hash ), hash, modelVersion, pInputs, pOutputs, pClampedOutputs );
+    }
+
+    bool PredictionCache::Lookup( Shard& shard, uint64_t hash, uint64_t modelVersion, double const* pInputs, double* pOutputs, int32_t* pClampedOutputs )
+    {
+        std::lock_guard<std::mutex> lock( shard.m_mutex );
+
+        auto const slotIter = shard.m_slotIndices.find( hash );
+        if ( slotIter == shard.m_slotIndices.end() || memcmp( &shard.m_inputs[(size_t) slotIter->second * m_numInputs], pInputs, m_numInputs * sizeof( double ) ) != 0 )
+        {
+            shard.m_numMisses++;
+            return false;
+        }
+
+        uint32_t const slotIdx = slotIter->second;
+        if ( shard.m_versions[slotIdx] != modelVersion )
+        {
+            shard.m_numMisses++;
+            shard.m_numStaleMisses++;
+            return false;
+        }
+
+        memcpy( pOutputs, &shard.m_outputs[(size_t) slotIdx * m_numOutputs], m_numOutputs * sizeof( double ) );
+        for ( uint32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+        {
+            pClampedOutputs[outputIdx] = shard.m_clampedOutputs[(size_t) slotIdx * m_numOutputs + outputIdx];
+        }
+
+        shard.m_isReferenced[slotIdx] = 1;
+        shard.m_numHits++;
+        return true;
+    }
+
+    void PredictionCache::Insert( uint64_t modelVersion, double const* pInputs, double const* pOutputs, int32_t const* pClampedOutputs )
+    {
+        uint64_t const hash = HashInputs( pInputs, m_numInputs );
+        Insert( GetShard( hash ), hash, modelVersion, pInputs, pOutputs, pClampedOutputs );
+    }
+
+    void PredictionCache::Insert( Shard& shard, uint64_t hash, uint64_t modelVersion, double const* pInputs, double const* pOutputs, int32_t const* pClampedOutputs )
+    {
+        std::lock_guard<std::mutex> lock( shard.m_mutex );
+
+        // A row with the same hash (the same row for an older version, or a collision) is replaced in place
+        uint32_t slotIdx;
+        auto const slotIter = shard.m_slotIndices.find( hash );
+        if ( slotIter != shard.m_slotIndices.end() )
+        {
+            slotIdx = slotIter->second;
+        }
+        else
+        {
+            slotIdx = GetFreeSlot( shard );
+            shard.m_slotIndices.emplace( hash, slotIdx );
+        }
+
+        memcpy( &shard.m_inputs[(size_t) slotIdx * m_numInputs], pInputs, m_numInputs * sizeof( double ) );
+        memcpy( &shard.m_outputs[(size_t) slotIdx * m_numOutputs], pOutputs, m_numOutputs * sizeof( double ) );
+        for ( uint32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+        {
+            shard.m_clampedOutputs[(size_t) slotIdx * m_numOutputs + outputIdx] = (int8_t) pClampedOutputs[outputIdx];
+        }
+
+        shard.m_hashes[slotIdx] = hash;
+        shard.m_versions[slotIdx] = modelVersion;
+
+        // New entries need a hit before they survive a pass of the eviction hand, so rows that are only seen once go first
+        shard.m_isReferenced[slotIdx] = 0;
+    }
+
+    uint32_t PredictionCache::GetFreeSlot( Shard& shard )
+    {
+        // Grow until the shard is full
+        uint32_t const numSlots = (uint32_t) shard.m_hashes.size();
+        if ( numSlots < m_maxShardEntries )
+        {
+            GrowSlotArray( shard.m_inputs, m_numInputs, m_maxShardEntries );
+            GrowSlotArray( shard.m_outputs, m_numOutputs, m_maxShardEntries );
+            GrowSlotArray( shard.m_clampedOutputs, m_numOutputs, m_maxShardEntries );
+            GrowSlotArray( shard.m_hashes, 1, m_maxShardEntries );
+            GrowSlotArray( shard.m_versions, 1, m_maxShardEntries );
+            GrowSlotArray( shard.m_isReferenced, 1, m_maxShardEntries );
+            return numSlots;
+        }
+
+        // CLOCK eviction
+        while ( shard.m_isReferenced[shard.m_clockHand] != 0 )
+        {
+            shard.m_isReferenced[shard.m_clockHand] = 0;
+            shard.m_clockHand = ( shard.m_clockHand + 1 ) % numSlots;
+        }
+
+        uint32_t const slotIdx = shard.m_clockHand;
+        shard.m_clockHand = ( shard.m_clockHand + 1 ) % numSlots;
+        shard.m_slotIndices.erase( shard.m_hashes[slotIdx] );
+        shard.m_numEvictions++;
+        return slotIdx;
+    }
+
+    //-------------------------------------------------------------------------
+
+    void PredictionCache::EvaluateBatch( Network const& network, uint64_t modelVersion, double const* pInputs, uint32_t numRows, double* pOutputs, int32_t* pClampedOutputs )
+    {
+        assert( (uint32_t) network.GetNumInputs() == m_numInputs && (uint32_t) network.GetNumOutputs() == m_numOutputs );
+
+        // Copy out the cached rows and gather the others
+        //-------------------------------------------------------------------------
+
+        std::vector<uint32_t> missedRows;
+        std::vector<uint64_t> missedHashes;
+        std::vector<double> missedInputs;
+        for ( uint32_t rowIdx = 0; rowIdx < numRows; rowIdx++ )
+        {
+            double const* pRowInputs = &pInputs[(size_t) rowIdx * m_numInputs];
+            uint64_t const hash = HashInputs( pRowInputs, m_numInputs );
+            if ( !Lookup( GetShard( hash ), hash, modelVersion, pRowInputs, &pOutputs[(size_t) rowIdx * m_numOutputs], &pClampedOutputs[(size_t) rowIdx * m_numOutputs] ) )
+            {
+                missedRows.push_back( rowIdx );
+                missedHashes.push_back( hash );
+                missedInputs.insert( missedInputs.end(), pRowInputs, pRowInputs + m_numInputs );
+            }
+        }
+
+        if ( missedRows.empty() )
+        {
+            return;
+        }
+
+        // Evaluate the missed rows together and cache them
+        //-------------------------------------------------------------------------
+
+        uint32_t const numMissedRows = (uint32_t) missedRows.size();
+        std::vector<double> missedOutputs( (size_t) numMissedRows * m_numOutputs );
+        std::vector<int32_t> missedClampedOutputs( missedOutputs.size() );
+        network.EvaluateBatch( missedInputs.data(), numMissedRows, missedOutputs.data(), missedClampedOutputs.data() );
+
+        for ( uint32_t missIdx = 0; missIdx < numMissedRows; missIdx++ )
+        {
+            size_t const valueOffset = (size_t) missIdx * m_numOutputs;
+            size_t const rowValueOffset = (size_t) missedRows[missIdx] * m_numOutputs;
+            memcpy( &pOutputs[rowValueOffset], &missedOutputs[valueOffset], m_numOutputs * sizeof( double ) );
+            memcpy( &pClampedOutputs[rowValueOffset], &missedClampedOutputs[valueOffset], m_numOutputs * sizeof( int32_t ) );
+
+            Insert( GetShard( missedHashes[missIdx] ), missedHashes[missIdx], modelVersion, &missedInputs[(size_t) missIdx * m_numInputs], &missedOutputs[valueOffset], &missedClampedOutputs[valueOffset] );
+        }
+    }
+
+    void PredictionCache::Clear()
+    {
+        for ( uint32_t shardIdx = 0; shardIdx < m_settings.m_numShards; shardIdx++ )
+        {
+            Shard& shard = m_pShards[shardIdx];
+            std::lock_guard<std::mutex> lock( shard.m_mutex );
+            shard.m_slotIndices.clear();
+            shard.m_inputs.clear();
+            shard.m_outputs.clear();
+            shard.m_clampedOutputs.clear();
+            shard.m_hashes.clear();
+            shard.m_versions.clear();
+            shard.m_isReferenced.clear();
+            shard.m_clockHand = 0;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    PredictionCache::Stats PredictionCache::GetStats() const
+    {
+        Stats stats;
+        stats.m_maxEntries = (uint64_t) m_maxShardEntries * m_settings.m_numShards;
+
+        for ( uint32_t shardIdx = 0; shardIdx < m_settings.m_numShards; shardIdx++ )
+        {
+            Shard const& shard = m_pShards[shardIdx];
+            std::lock_guard<std::mutex> lock( shard.m_mutex );
+            stats.m_numHits += shard.m_numHits;
+            stats.m_numMisses += shard.m_numMisses;
+            stats.m_numStaleMisses += shard.m_numStaleMisses;
+            stats.m_numEvictions += shard.m_numEvictions;
+            stats.m_numEntries += shard.m_hashes.size();
+            stats.m_memoryBytes += shard.m_inputs.capacity() * sizeof( double ) + shard.m_outputs.capacity() * sizeof( double ) + shard.m_clampedOutputs.capacity() * sizeof( int8_t )
+                                 + ( shard.m_hashes.capacity() + shard.m_versions.capacity() ) * sizeof( uint64_t ) + shard.m_isReferenced.capacity() * sizeof( uint8_t )
+                                 + shard.m_slotIndices.size() * ( g_indexBytesPerEntry - sizeof( void* ) ) + shard.m_slotIndices.bucket_count() * sizeof( void* );
+        }
+
+        uint64_t const numLookups = stats.m_numHits + stats.m_numMisses;
+        stats.m_hitRate = ( numLookups > 0 ) ? stats.m_numHits * 100.0 / numLookups : 0.0;
+        return stats;
+    }
+
+    void PredictionCache::PrintStats( std::ostream& stream, Stats const& stats )
+    {
+        stream << "Prediction cache - Hit Rate: " << stats.m_hitRate << "% (" << stats.m_numHits << " hits, " << stats.m_numMisses << " misses, " << stats.m_numStaleMisses << " stale)"
+               << ", Entries: " << stats.m_numEntries << "/" << stats.m_maxEntries << ", Evictions: " << stats.m_numEvictions << ", Memory: " << stats.m_memoryBytes / 1024.0 << " KB" << std::endl;
+    }
+}
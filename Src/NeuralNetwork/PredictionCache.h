@@ -0,0 +1,112 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Bounded cache of network outputs for repeated input rows
+//
+// With small discrete features many scoring requests repeat exact input rows. The cache maps a hash of a
+// row to its raw and clamped outputs for a given model version (see ModelHandle::ReadGuard::GetVersion),
+// so a repeat costs a lookup instead of an evaluation. The rows are stored and compared in full, so a hash
+// collision can't return the outputs of another row, and entries of older model versions are never
+// returned: they are overwritten or evicted as the new version's results come in.
+//
+// The cache is split into shards by hash, each with its own lock, so that concurrent workers rarely
+// contend. Each shard holds a bounded number of entries and evicts with the CLOCK algorithm: a hit marks
+// its entry and the eviction hand skips (and unmarks) marked entries once.
+
+#pragma once
+
+#include "NeuralNetwork.h"
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class PredictionCache
+    {
+    public:
+
+        struct Settings
+        {
+            size_t                          m_maxMemoryBytes = 64 << 20;    // Bound on the stored entries and their index
+            uint32_t                        m_numShards = 16;
+        };
+
+        struct Stats
+        {
+            uint64_t                        m_numHits = 0;
+            uint64_t                        m_numMisses = 0;
+            uint64_t                        m_numStaleMisses = 0;           // Misses on a row that is cached for another model version
+            uint64_t                        m_numEvictions = 0;
+            uint64_t                        m_numEntries = 0;
+            uint64_t                        m_maxEntries = 0;
+            uint64_t                        m_memoryBytes = 0;              // Estimate including the index
+            double                          m_hitRate = 0;                  // Percentage of lookups that hit
+        };
+
+    public:
+
+        PredictionCache( Settings const& settings, uint32_t numInputs, uint32_t numOutputs );
+
+        PredictionCache( PredictionCache const& ) = delete;
+        PredictionCache& operator=( PredictionCache const& ) = delete;
+
+        static uint64_t HashInputs( double const* pInputs, uint32_t numInputs );
+
+        // Copies the cached outputs of the row for the model version, returns false if there are none
+        bool Lookup( uint64_t modelVersion, double const* pInputs, double* pOutputs, int32_t* pClampedOutputs );
+
+        void Insert( uint64_t modelVersion, double const* pInputs, double const* pOutputs, int32_t const* pClampedOutputs );
+
+        // Same results as Network::EvaluateBatch. The cached rows are copied and the others are evaluated as one batch and
+        // inserted. Thread-safe.
+        void EvaluateBatch( Network const& network, uint64_t modelVersion, double const* pInputs, uint32_t numRows, double* pOutputs, int32_t* pClampedOutputs );
+
+        void Clear();
+
+        Stats GetStats() const;
+        static void PrintStats( std::ostream& stream, Stats const& stats );
+
+    private:
+
+        // Entries are stored in flat arrays indexed by slot
+        struct alignas( 64 ) Shard
+        {
+            mutable std::mutex                      m_mutex;
+            std::unordered_map<uint64_t, uint32_t>  m_slotIndices;          // Hash to slot
+            std::vector<double>                     m_inputs;
+            std::vector<double>                     m_outputs;
+            std::vector<int8_t>                     m_clampedOutputs;
+            std::vector<uint64_t>                   m_hashes;
+            std::vector<uint64_t>                   m_versions;
+            std::vector<uint8_t>                    m_isReferenced;
+            uint32_t                                m_clockHand = 0;
+
+            uint64_t                                m_numHits = 0;
+            uint64_t                                m_numMisses = 0;
+            uint64_t                                m_numStaleMisses = 0;
+            uint64_t                                m_numEvictions = 0;
+        };
+
+        inline Shard& GetShard( uint64_t hash ) const { return m_pShards[( hash >> 32 ) % m_settings.m_numShards]; }
+
+        bool Lookup( Shard& shard, uint64_t hash, uint64_t modelVersion, double const* pInputs, double* pOutputs, int32_t* pClampedOutputs );
+        void Insert( Shard& shard, uint64_t hash, uint64_t modelVersion, double const* pInputs, double const* pOutputs, int32_t const* pClampedOutputs );
+        uint32_t GetFreeSlot( Shard& shard );
+
+    private:
+
+        Settings                                    m_settings;
+        uint32_t                                    m_numInputs;
+        uint32_t                                    m_numOutputs;
+        size_t                                      m_entrySizeBytes;
+        uint32_t                                    m_maxShardEntries;
+        std::unique_ptr<Shard[]>                    m_pShards;
+    };
+}
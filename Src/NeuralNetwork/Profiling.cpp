@@ -0,0 +1,172 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "Profiling.h"
+#include <stdlib.h>
+#include <new>
+
+#if _MSC_VER
+#include <malloc.h>
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace Profiling
+    {
+        static thread_local Counters g_threadCounters;
+
+        char const* GetPhaseName( Phase phase )
+        {
+            switch ( phase )
+            {
+                case Phase::Evaluate: return "evaluate";
+                case Phase::Backpropagate: return "backpropagate";
+                case Phase::UpdateWeights: return "updateWeights";
+                case Phase::SetEvaluation: return "setEvaluation";
+                case Phase::ReadData: return "readData";
+                default: return "unknown";
+            }
+        }
+
+        Counters Counters::operator-( Counters const& rhs ) const
+        {
+            Counters result;
+            for ( uint32_t phaseIdx = 0; phaseIdx < NumPhases; phaseIdx++ )
+            {
+                result.m_phases[phaseIdx].m_totalTimeNS = m_phases[phaseIdx].m_totalTimeNS - rhs.m_phases[phaseIdx].m_totalTimeNS;
+                result.m_phases[phaseIdx].m_numCalls = m_phases[phaseIdx].m_numCalls - rhs.m_phases[phaseIdx].m_numCalls;
+            }
+            result.m_numAllocations = m_numAllocations - rhs.m_numAllocations;
+            result.m_numAllocatedBytes = m_numAllocatedBytes - rhs.m_numAllocatedBytes;
+            return result;
+        }
+
+        Counters& GetThreadCounters()
+        {
+            return g_threadCounters;
+        }
+
+        void ResetThreadCounters()
+        {
+            g_threadCounters = Counters();
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// Allocation tracking - only replace the global allocator when profiling is enabled, every form of
+// operator new/delete is replaced so that the counts include aligned allocations
+//-------------------------------------------------------------------------
+
+#if BPN_ENABLE_PROFILING
+
+namespace
+{
+    void* AllocateAligned( size_t size, std::align_val_t alignment )
+    {
+        BPN::Profiling::Counters& counters = BPN::Profiling::GetThreadCounters();
+        counters.m_numAllocations++;
+        counters.m_numAllocatedBytes += size;
+
+        #if _MSC_VER
+        void* pMemory = _aligned_malloc( size == 0 ? 1 : size, (size_t) alignment );
+        #else
+        // aligned_alloc requires the size to be a multiple of the alignment
+        size_t const alignedSize = ( ( size == 0 ? 1 : size ) + (size_t) alignment - 1 ) & ~( (size_t) alignment - 1 );
+        void* pMemory = aligned_alloc( (size_t) alignment, alignedSize );
+        #endif
+
+        if ( pMemory == nullptr )
+        {
+            throw std::bad_alloc();
+        }
+        return pMemory;
+    }
+
+    void FreeAligned( void* pMemory )
+    {
+        #if _MSC_VER
+        _aligned_free( pMemory );
+        #else
+        free( pMemory );
+        #endif
+    }
+}
+
+void* operator new( size_t size )
+{
+    BPN::Profiling::Counters& counters = BPN::Profiling::GetThreadCounters();
+    counters.m_numAllocations++;
+    counters.m_numAllocatedBytes += size;
+
+    void* pMemory = malloc( size == 0 ? 1 : size );
+    if ( pMemory == nullptr )
+    {
+        throw std::bad_alloc();
+    }
+    return pMemory;
+}
+
+void* operator new[]( size_t size )
+{
+    return operator new( size );
+}
+
+void* operator new( size_t size, std::nothrow_t const& ) noexcept
+{
+    try
+    {
+        return operator new( size );
+    }
+    catch ( ... )
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[]( size_t size, std::nothrow_t const& ) noexcept
+{
+    return operator new( size, std::nothrow );
+}
+
+void operator delete( void* pMemory ) noexcept { free( pMemory ); }
+void operator delete[]( void* pMemory ) noexcept { free( pMemory ); }
+void operator delete( void* pMemory, size_t ) noexcept { free( pMemory ); }
+void operator delete[]( void* pMemory, size_t ) noexcept { free( pMemory ); }
+void operator delete( void* pMemory, std::nothrow_t const& ) noexcept { free( pMemory ); }
+void operator delete[]( void* pMemory, std::nothrow_t const& ) noexcept { free( pMemory ); }
+
+// Over-aligned types (i.e. the cache line aligned slots of ModelHandle and PredictionCache) use these overloads
+void* operator new( size_t size, std::align_val_t alignment ) { return AllocateAligned( size, alignment ); }
+void* operator new[]( size_t size, std::align_val_t alignment ) { return AllocateAligned( size, alignment ); }
+
+void* operator new( size_t size, std::align_val_t alignment, std::nothrow_t const& ) noexcept
+{
+    try
+    {
+        return AllocateAligned( size, alignment );
+    }
+    catch ( ... )
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[]( size_t size, std::align_val_t alignment, std::nothrow_t const& ) noexcept
+{
+    return operator new( size, alignment, std::nothrow );
+}
+
+void operator delete( void* pMemory, std::align_val_t ) noexcept { FreeAligned( pMemory ); }
+void operator delete[]( void* pMemory, std::align_val_t ) noexcept { FreeAligned( pMemory ); }
+void operator delete( void* pMemory, size_t, std::align_val_t ) noexcept { FreeAligned( pMemory ); }
+void operator delete[]( void* pMemory, size_t, std::align_val_t ) noexcept { FreeAligned( pMemory ); }
+void operator delete( void* pMemory, std::align_val_t, std::nothrow_t const& ) noexcept { FreeAligned( pMemory ); }
+void operator delete[]( void* pMemory, std::align_val_t, std::nothrow_t const& ) noexcept { FreeAligned( pMemory ); }
+
+#endif
@@ -0,0 +1,103 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Low overhead scoped timers and counters for the training hot paths
+//
+// All counters are per-thread so concurrent trainers do not interfere with each other.
+// Define BPN_ENABLE_PROFILING=1 to enable, otherwise the scope macros compile out entirely.
+//
+// To count allocations the enabled build replaces the global operator new/delete (all forms, including the
+// aligned and nothrow ones) with malloc/free based versions, for every executable that links the library.
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+
+#ifndef BPN_ENABLE_PROFILING
+#define BPN_ENABLE_PROFILING 0
+#endif
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace Profiling
+    {
+        enum class Phase : uint8_t
+        {
+            Evaluate = 0,
+            Backpropagate,
+            UpdateWeights,
+            SetEvaluation,                  // Includes the evaluate calls made during set evaluation
+            ReadData,
+
+            NumPhases
+        };
+
+        constexpr uint32_t NumPhases = (uint32_t) Phase::NumPhases;
+
+        char const* GetPhaseName( Phase phase );
+
+        //-------------------------------------------------------------------------
+
+        struct PhaseStats
+        {
+            uint64_t                m_totalTimeNS = 0;
+            uint64_t                m_numCalls = 0;
+        };
+
+        struct Counters
+        {
+            Counters operator-( Counters const& rhs ) const;
+
+            PhaseStats              m_phases[NumPhases];
+            uint64_t                m_numAllocations = 0;
+            uint64_t                m_numAllocatedBytes = 0;
+        };
+
+        // Is the instrumentation compiled in
+        constexpr bool IsEnabled() { return BPN_ENABLE_PROFILING != 0; }
+
+        // Counters for the calling thread
+        Counters& GetThreadCounters();
+        void ResetThreadCounters();
+
+        //-------------------------------------------------------------------------
+
+        class ScopedTimer
+        {
+        public:
+
+            explicit ScopedTimer( Phase phase )
+                : m_phase( phase )
+                , m_startTime( std::chrono::steady_clock::now() )
+            {}
+
+            ~ScopedTimer()
+            {
+                PhaseStats& stats = GetThreadCounters().m_phases[(uint32_t) m_phase];
+                stats.m_totalTimeNS += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_startTime ).count();
+                stats.m_numCalls++;
+            }
+
+        private:
+
+            Phase                                       m_phase;
+            std::chrono::steady_clock::time_point       m_startTime;
+        };
+    }
+}
+
+//-------------------------------------------------------------------------
+
+#define BPN_PROFILE_CONCAT_INTERNAL( a, b ) a##b
+#define BPN_PROFILE_CONCAT( a, b ) BPN_PROFILE_CONCAT_INTERNAL( a, b )
+
+#if BPN_ENABLE_PROFILING
+#define BPN_PROFILE_SCOPE( phase ) BPN::Profiling::ScopedTimer BPN_PROFILE_CONCAT( _bpnScopedTimer, __LINE__ )( BPN::Profiling::Phase::phase )
+#else
+#define BPN_PROFILE_SCOPE( phase )
+#endif
@@ -0,0 +1,90 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Counter-based random number streams
+//
+// Every value is a pure function of ( seed, stream index, counter ), there is no shared generator state.
+// Parallel work gets one stream per task (i.e. per ensemble member or per fold) rather than per thread, so
+// the results for a given seed don't depend on how the tasks are scheduled. The distributions are
+// implemented here rather than with <random> since the standard distributions and std::shuffle are
+// implementation defined, and the same seed should give the same network with any standard library.
+
+#pragma once
+
+#include <stdint.h>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class RandomStream
+    {
+        static uint64_t const g_increment = 0x9E3779B97F4A7C15ull;
+
+        // SplitMix64 finalizer
+        inline static uint64_t Mix( uint64_t x )
+        {
+            x = ( x ^ ( x >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+            x = ( x ^ ( x >> 27 ) ) * 0x94D049BB133111EBull;
+            return x ^ ( x >> 31 );
+        }
+
+    public:
+
+        RandomStream( uint64_t seed, uint64_t streamIdx = 0 )
+            : m_key( Mix( seed + Mix( streamIdx + g_increment ) ) )
+        {}
+
+        // Seed for a dependent object, i.e. the network of an ensemble member
+        inline static uint64_t DeriveSeed( uint64_t seed, uint64_t streamIdx ) { return RandomStream( seed, streamIdx ).NextUInt64(); }
+
+        inline uint64_t GetCounter() const { return m_counter; }
+
+        inline uint64_t NextUInt64()
+        {
+            m_counter++;
+            return Mix( m_key + m_counter * g_increment );
+        }
+
+        // Uniform in [0, 1)
+        inline double NextDouble()
+        {
+            return ( NextUInt64() >> 11 ) * ( 1.0 / 9007199254740992.0 );
+        }
+
+        // Uniform in [0, bound), the bias is at most bound / 2^32
+        inline uint32_t NextUInt32( uint32_t bound )
+        {
+            return (uint32_t) ( ( ( NextUInt64() >> 32 ) * bound ) >> 32 );
+        }
+
+        // Box-Muller transform, uses two values per sample
+        inline double NextNormal( double mean, double standardDeviation )
+        {
+            double const u1 = 1.0 - NextDouble();
+            double const u2 = NextDouble();
+            return mean + standardDeviation * sqrt( -2.0 * log( u1 ) ) * cos( 6.283185307179586 * u2 );
+        }
+
+        // Fisher-Yates shuffle
+        template<typename T>
+        void Shuffle( std::vector<T>& values )
+        {
+            for ( size_t idx = values.size(); idx > 1; idx-- )
+            {
+                size_t const swapIdx = NextUInt32( (uint32_t) idx );
+                std::swap( values[idx - 1], values[swapIdx] );
+            }
+        }
+
+    private:
+
+        uint64_t                        m_key;
+        uint64_t                        m_counter = 0;
+    };
+}
@@ -0,0 +1,149 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "RowDeduplicator.h"
+#include "ThreadPool.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <unordered_set>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Entries per parallel hashing chunk
+        uint32_t const g_entriesPerChunk = 4096;
+
+        // Number of hash partitions deduplicated independently, the top bits of the hash select the partition
+        uint32_t const g_numPartitionBits = 6;
+        uint32_t const g_numPartitions = 1u << g_numPartitionBits;
+
+        inline uint64_t MixHash( uint64_t hash, uint64_t value )
+        {
+            hash ^= value + 0x9E3779B97F4A7C15ull + ( hash << 6 ) + ( hash >> 2 );
+            return hash * 0xFF51AFD7ED558CCDull;
+        }
+
+        uint64_t HashEntry( TrainingEntry const& entry )
+        {
+            uint64_t hash = entry.m_inputs.size();
+            for ( double value : entry.m_inputs )
+            {
+                uint64_t bits;
+                memcpy( &bits, &value, sizeof( bits ) );
+                hash = MixHash( hash, bits );
+            }
+
+            for ( int32_t value : entry.m_expectedOutputs )
+            {
+                hash = MixHash( hash, (uint32_t) value );
+            }
+
+            return hash ^ ( hash >> 29 );
+        }
+
+        // Rows are compared bitwise, consistently with the hash
+        bool AreEntriesEqual( TrainingEntry const& a, TrainingEntry const& b )
+        {
+            return a.m_inputs.size() == b.m_inputs.size() && a.m_expectedOutputs == b.m_expectedOutputs
+                && memcmp( a.m_inputs.data(), b.m_inputs.data(), a.m_inputs.size() * sizeof( double ) ) == 0;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    RowDeduplicator::Stats RowDeduplicator::Collapse( TrainingEntry const* pEntries, size_t numEntries, TrainingSet& uniqueEntries, uint32_t numThreads )
+    {
+        assert( numEntries < UINT32_MAX );
+
+        auto const startTime = std::chrono::steady_clock::now();
+
+        Stats stats;
+        uniqueEntries.clear();
+        if ( numEntries == 0 )
+        {
+            return stats;
+        }
+
+        uint32_t const numChunks = (uint32_t) ( ( numEntries + g_entriesPerChunk - 1 ) / g_entriesPerChunk );
+        ThreadPool threadPool( std::max( 1u, std::min( numThreads == 0 ? std::thread::hardware_concurrency() : numThreads, std::max( numChunks, g_numPartitions ) ) ) );
+
+        // Hash the rows and sort them into partitions, per chunk so that the partitions list their rows in order
+        //-------------------------------------------------------------------------
+
+        std::vector<uint64_t> hashes( numEntries );
+        std::vector<std::vector<std::vector<uint32_t>>> chunkPartitionRows( numChunks, std::vector<std::vector<uint32_t>>( g_numPartitions ) );
+        threadPool.ParallelFor( numChunks, [&] ( uint32_t chunkIdx )
+        {
+            size_t const chunkEnd = std::min( numEntries, ( (size_t) chunkIdx + 1 ) * g_entriesPerChunk );
+            for ( size_t entryIdx = (size_t) chunkIdx * g_entriesPerChunk; entryIdx < chunkEnd; entryIdx++ )
+            {
+                hashes[entryIdx] = HashEntry( pEntries[entryIdx] );
+                chunkPartitionRows[chunkIdx][hashes[entryIdx] >> ( 64 - g_numPartitionBits )].push_back( (uint32_t) entryIdx );
+            }
+        } );
+
+        // Find the first occurrence of every row, partitions never share a row so they need no synchronization
+        //-------------------------------------------------------------------------
+
+        auto RowHash = [&hashes] ( uint32_t rowIdx ) { return (size_t) hashes[rowIdx]; };
+        auto RowEqual = [pEntries] ( uint32_t a, uint32_t b ) { return AreEntriesEqual( pEntries[a], pEntries[b] ); };
+
+        std::vector<uint32_t> firstOccurrences( numEntries );
+        threadPool.ParallelFor( g_numPartitions, [&] ( uint32_t partitionIdx )
+        {
+            std::unordered_set<uint32_t, decltype( RowHash ), decltype( RowEqual )> uniqueRows( 64, RowHash, RowEqual );
+            for ( uint32_t chunkIdx = 0; chunkIdx < numChunks; chunkIdx++ )
+            {
+                for ( uint32_t rowIdx : chunkPartitionRows[chunkIdx][partitionIdx] )
+                {
+                    firstOccurrences[rowIdx] = *uniqueRows.insert( rowIdx ).first;
+                }
+            }
+        } );
+
+        // Gather the unique rows in order of first occurrence and sum the weights of their copies
+        //-------------------------------------------------------------------------
+
+        std::vector<uint32_t> uniqueIndices( numEntries );
+        for ( size_t entryIdx = 0; entryIdx < numEntries; entryIdx++ )
+        {
+            uint32_t const firstOccurrence = firstOccurrences[entryIdx];
+            if ( firstOccurrence == entryIdx )
+            {
+                uniqueIndices[entryIdx] = (uint32_t) uniqueEntries.size();
+                uniqueEntries.push_back( pEntries[entryIdx] );
+            }
+            else
+            {
+                uniqueEntries[uniqueIndices[firstOccurrence]].m_weight += pEntries[entryIdx].m_weight;
+            }
+
+            stats.m_numRows += pEntries[entryIdx].m_weight;
+        }
+
+        stats.m_numUniqueRows = uniqueEntries.size();
+        for ( auto const& entry : uniqueEntries )
+        {
+            stats.m_maxWeight = std::max( stats.m_maxWeight, entry.m_weight );
+        }
+
+        stats.m_timeMS = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - startTime ).count();
+        return stats;
+    }
+
+    void RowDeduplicator::PrintStats( std::ostream& stream, char const* pSetName, Stats const& stats )
+    {
+        stream << "Collapsed duplicate rows of the " << pSetName << " set: " << stats.m_numRows << " rows -> " << stats.m_numUniqueRows << " unique rows ("
+               << ( stats.m_numUniqueRows > 0 ? (double) stats.m_numRows / stats.m_numUniqueRows : 0.0 ) << "x fewer, max weight " << stats.m_maxWeight << ") in " << stats.m_timeMS << " ms" << std::endl;
+    }
+}
@@ -0,0 +1,47 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Collapses identical rows of a training set into weighted unique rows
+//
+// Data sets with discrete features often contain many copies of the same row. Rows with identical inputs and
+// expected outputs are replaced by their first occurrence with a weight equal to the sum of the weights of the
+// copies. The batch learning path and the set accuracy/MSE of NetworkTrainer scale each entry's contribution
+// by its weight, so training on the collapsed set gives the same results (up to rounding of the sums) at the
+// cost of the unique rows only.
+//
+// The rows are hashed in parallel chunks and then split into hash partitions, each deduplicated by its own
+// task with a full comparison of the rows. Unique rows keep the order of their first occurrence, so the
+// result doesn't depend on the thread count.
+
+#pragma once
+
+#include "NeuralNetworkTrainer.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class RowDeduplicator
+    {
+    public:
+
+        struct Stats
+        {
+            uint64_t                    m_numRows = 0;                  // Sum of the weights of the input rows
+            uint64_t                    m_numUniqueRows = 0;
+            uint32_t                    m_maxWeight = 0;
+            double                      m_timeMS = 0;
+        };
+
+    public:
+
+        // A thread count of 0 uses the hardware concurrency
+        static Stats Collapse( TrainingEntry const* pEntries, size_t numEntries, TrainingSet& uniqueEntries, uint32_t numThreads = 0 );
+        static Stats Collapse( TrainingSet const& entries, TrainingSet& uniqueEntries, uint32_t numThreads = 0 ) { return Collapse( entries.data(), entries.size(), uniqueEntries, numThreads ); }
+
+        static void PrintStats( std::ostream& stream, char const* pSetName, Stats const& stats );
+    };
+}
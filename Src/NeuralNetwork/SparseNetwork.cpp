@@ -0,0 +1,203 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "SparseNetwork.h"
+#include "Profiling.h"
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        uint32_t const g_tileSize = 4;
+    }
+
+    //-------------------------------------------------------------------------
+
+    SparseNetwork::SparseNetwork( Network const& network, Format format )
+        : m_format( format )
+        , m_numInputs( network.m_numInputs )
+        , m_numHidden( network.m_numHidden )
+        , m_numOutputs( network.m_numOutputs )
+    {
+        std::vector<double> const& weights = network.m_weightsInputHidden;
+
+        if ( m_format == Format::CSR )
+        {
+            m_rowStarts.reserve( m_numHidden + 1 );
+            for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+            {
+                m_rowStarts.push_back( (uint32_t) m_values.size() );
+                for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
+                {
+                    double const weight = weights[network.GetInputHiddenWeightIndex( inputIdx, hiddenIdx )];
+                    if ( weight != 0.0 )
+                    {
+                        m_columnIndices.push_back( inputIdx );
+                        m_values.push_back( weight );
+                    }
+                }
+            }
+            m_rowStarts.push_back( (uint32_t) m_values.size() );
+        }
+        else
+        {
+            int32_t const numBlocks = ( m_numHidden + g_blockSize - 1 ) / g_blockSize;
+
+            m_rowStarts.reserve( m_numInputs + 2 );
+            for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
+            {
+                m_rowStarts.push_back( (uint32_t) m_columnIndices.size() );
+                for ( int32_t blockIdx = 0; blockIdx < numBlocks; blockIdx++ )
+                {
+                    double block[g_blockSize] = {};
+                    bool isBlockEmpty = true;
+                    for ( uint32_t laneIdx = 0; laneIdx < g_blockSize; laneIdx++ )
+                    {
+                        int32_t const hiddenIdx = blockIdx * g_blockSize + laneIdx;
+                        if ( hiddenIdx < m_numHidden )
+                        {
+                            block[laneIdx] = weights[network.GetInputHiddenWeightIndex( inputIdx, hiddenIdx )];
+                            isBlockEmpty = isBlockEmpty && block[laneIdx] == 0.0;
+                        }
+                    }
+
+                    if ( !isBlockEmpty )
+                    {
+                        m_columnIndices.push_back( blockIdx );
+                        m_values.insert( m_values.end(), block, block + g_blockSize );
+                    }
+                }
+            }
+            m_rowStarts.push_back( (uint32_t) m_columnIndices.size() );
+        }
+
+        m_weightsHiddenOutput.assign( network.m_weightsHiddenOutput.begin(), network.m_weightsHiddenOutput.begin() + ( m_numHidden + 1 ) * m_numOutputs );
+    }
+
+    size_t SparseNetwork::GetInputHiddenSizeBytes() const
+    {
+        return m_rowStarts.size() * sizeof( uint32_t ) + m_columnIndices.size() * sizeof( uint32_t ) + m_values.size() * sizeof( double );
+    }
+
+    //-------------------------------------------------------------------------
+
+    void SparseNetwork::EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs ) const
+    {
+        BPN_PROFILE_SCOPE( Evaluate );
+
+        // The tile inputs have the bias appended to each row so that the kernels don't need to special case it.
+        // The hidden tile rows are padded to whole blocks for the block sparse kernel.
+        int32_t const inputStride = m_numInputs + 1;
+        int32_t const hiddenStride = ( ( m_numHidden + g_blockSize - 1 ) / g_blockSize ) * g_blockSize + 1;
+        std::vector<double> tileInputs( g_tileSize * inputStride );
+        std::vector<double> hiddenTile( g_tileSize * hiddenStride );
+
+        for ( uint32_t tileStart = 0; tileStart < numEntries; tileStart += g_tileSize )
+        {
+            uint32_t const numTileEntries = std::min( g_tileSize, numEntries - tileStart );
+
+            for ( uint32_t rowIdx = 0; rowIdx < numTileEntries; rowIdx++ )
+            {
+                memcpy( &tileInputs[rowIdx * inputStride], &pInputs[( tileStart + rowIdx ) * m_numInputs], m_numInputs * sizeof( double ) );
+                tileInputs[rowIdx * inputStride + m_numInputs] = -1.0;
+            }
+
+            // Update hidden neurons
+            //-------------------------------------------------------------------------
+
+            if ( m_format == Format::CSR )
+            {
+                EvaluateHiddenCSR( tileInputs.data(), numTileEntries, hiddenTile.data() );
+            }
+            else
+            {
+                EvaluateHiddenBlockSparse( tileInputs.data(), numTileEntries, hiddenTile.data() );
+            }
+
+            // Calculate output values - include bias neuron
+            //-------------------------------------------------------------------------
+
+            for ( uint32_t rowIdx = 0; rowIdx < numTileEntries; rowIdx++ )
+            {
+                double* pHidden = &hiddenTile[rowIdx * hiddenStride];
+                for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+                {
+                    pHidden[hiddenIdx] = Network::SigmoidActivationFunction( pHidden[hiddenIdx] );
+                }
+                pHidden[m_numHidden] = -1.0;
+
+                double* pRowOutputs = &pOutputs[( tileStart + rowIdx ) * m_numOutputs];
+                int32_t* pRowClampedOutputs = &pClampedOutputs[( tileStart + rowIdx ) * m_numOutputs];
+                for ( int32_t outputIdx = 0; outputIdx < m_numOutputs; outputIdx++ )
+                {
+                    double output = 0;
+                    for ( int32_t hiddenIdx = 0; hiddenIdx <= m_numHidden; hiddenIdx++ )
+                    {
+                        output += pHidden[hiddenIdx] * m_weightsHiddenOutput[hiddenIdx * m_numOutputs + outputIdx];
+                    }
+
+                    pRowOutputs[outputIdx] = Network::SigmoidActivationFunction( output );
+                    pRowClampedOutputs[outputIdx] = Network::ClampOutputValue( pRowOutputs[outputIdx] );
+                }
+            }
+        }
+    }
+
+    void SparseNetwork::EvaluateHiddenCSR( double const* pTileInputs, uint32_t numTileEntries, double* pHiddenTile ) const
+    {
+        int32_t const inputStride = m_numInputs + 1;
+        int32_t const hiddenStride = ( ( m_numHidden + g_blockSize - 1 ) / g_blockSize ) * g_blockSize + 1;
+
+        for ( int32_t hiddenIdx = 0; hiddenIdx < m_numHidden; hiddenIdx++ )
+        {
+            uint32_t const rowStart = m_rowStarts[hiddenIdx];
+            uint32_t const rowEnd = m_rowStarts[hiddenIdx + 1];
+            for ( uint32_t rowIdx = 0; rowIdx < numTileEntries; rowIdx++ )
+            {
+                double const* pRowInputs = &pTileInputs[rowIdx * inputStride];
+                double sum = 0;
+                for ( uint32_t valueIdx = rowStart; valueIdx < rowEnd; valueIdx++ )
+                {
+                    sum += pRowInputs[m_columnIndices[valueIdx]] * m_values[valueIdx];
+                }
+                pHiddenTile[rowIdx * hiddenStride + hiddenIdx] = sum;
+            }
+        }
+    }
+
+    void SparseNetwork::EvaluateHiddenBlockSparse( double const* pTileInputs, uint32_t numTileEntries, double* pHiddenTile ) const
+    {
+        int32_t const inputStride = m_numInputs + 1;
+        int32_t const hiddenStride = ( ( m_numHidden + g_blockSize - 1 ) / g_blockSize ) * g_blockSize + 1;
+
+        memset( pHiddenTile, 0, numTileEntries * hiddenStride * sizeof( double ) );
+
+        for ( int32_t inputIdx = 0; inputIdx <= m_numInputs; inputIdx++ )
+        {
+            uint32_t const rowStart = m_rowStarts[inputIdx];
+            uint32_t const rowEnd = m_rowStarts[inputIdx + 1];
+            for ( uint32_t rowIdx = 0; rowIdx < numTileEntries; rowIdx++ )
+            {
+                double const inputValue = pTileInputs[rowIdx * inputStride + inputIdx];
+                double* pHidden = &pHiddenTile[rowIdx * hiddenStride];
+                for ( uint32_t blockIdx = rowStart; blockIdx < rowEnd; blockIdx++ )
+                {
+                    double* pBlockHidden = &pHidden[m_columnIndices[blockIdx] * g_blockSize];
+                    double const* pBlockWeights = &m_values[blockIdx * g_blockSize];
+                    for ( uint32_t laneIdx = 0; laneIdx < g_blockSize; laneIdx++ )
+                    {
+                        pBlockHidden[laneIdx] += inputValue * pBlockWeights[laneIdx];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Inference-only copy of a pruned network with sparse input->hidden weights
+//
+// Only the non-zero input->hidden weights are stored, either in CSR form (a row of non-zero input weights
+// per hidden neuron) or as 1x4 blocks (per input, the runs of four consecutive hidden neurons that contain
+// a non-zero weight). The hidden->output weights are kept dense. The weighted sums are accumulated in the
+// same input order as Network::Evaluate and skipping zero weights doesn't change them, so the outputs are
+// identical to evaluating the pruned dense network.
+
+#pragma once
+
+#include "NeuralNetwork.h"
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class SparseNetwork
+    {
+    public:
+
+        enum class Format
+        {
+            CSR,
+            BlockSparse
+        };
+
+        static uint32_t const g_blockSize = 4;
+
+    public:
+
+        SparseNetwork( Network const& network, Format format );
+
+        // Evaluates numEntries contiguous input rows, writes numEntries * numOutputs raw outputs and clamped outputs
+        void EvaluateBatch( double const* pInputs, uint32_t numEntries, double* pOutputs, int32_t* pClampedOutputs ) const;
+
+        inline Format GetFormat() const { return m_format; }
+        inline int32_t GetNumInputs() const { return m_numInputs; }
+        inline int32_t GetNumHidden() const { return m_numHidden; }
+        inline int32_t GetNumOutputs() const { return m_numOutputs; }
+
+        // Stored input->hidden weights including the bias weights, for the block format this includes the zeros padding the blocks
+        inline size_t GetNumStoredWeights() const { return m_values.size(); }
+
+        // Memory used by the input->hidden weights and their indices
+        size_t GetInputHiddenSizeBytes() const;
+
+    private:
+
+        void EvaluateHiddenCSR( double const* pTileInputs, uint32_t numTileEntries, double* pHiddenTile ) const;
+        void EvaluateHiddenBlockSparse( double const* pTileInputs, uint32_t numTileEntries, double* pHiddenTile ) const;
+
+    private:
+
+        Format                          m_format;
+        int32_t                         m_numInputs;
+        int32_t                         m_numHidden;
+        int32_t                         m_numOutputs;
+
+        // CSR: one row per hidden neuron, column indices are input indices with the bias as input numInputs
+        // Block sparse: one row per input (bias last), column indices are block indices, values hold g_blockSize weights per block
+        std::vector<uint32_t>           m_rowStarts;
+        std::vector<uint32_t>           m_columnIndices;
+        std::vector<double>             m_values;
+
+        std::vector<double>             m_weightsHiddenOutput;
+    };
+}
@@ -0,0 +1,178 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "ThreadPool.h"
+#include <assert.h>
+#include <algorithm>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // Identifies the pool and queue of the current thread if it is a pool worker
+        thread_local ThreadPool const*  g_pCurrentPool = nullptr;
+        thread_local uint32_t           g_currentWorkerIdx = 0;
+    }
+
+    //-------------------------------------------------------------------------
+
+    ThreadPool::ThreadPool( uint32_t numThreads )
+        : m_numIncompleteTasks( 0 )
+        , m_nextQueueIdx( 0 )
+    {
+        if ( numThreads == 0 )
+        {
+            numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+        }
+
+        for ( uint32_t workerIdx = 0; workerIdx < numThreads; workerIdx++ )
+        {
+            m_queues.emplace_back( new WorkerQueue() );
+        }
+
+        for ( uint32_t workerIdx = 0; workerIdx < numThreads; workerIdx++ )
+        {
+            m_threads.emplace_back( &ThreadPool::WorkerThread, this, workerIdx );
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        WaitForAll();
+
+        {
+            std::lock_guard<std::mutex> lock( m_stateMutex );
+            m_isShuttingDown = true;
+        }
+        m_workAvailableCondition.notify_all();
+
+        for ( auto& thread : m_threads )
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::Submit( Task&& task )
+    {
+        uint32_t const queueIdx = ( g_pCurrentPool == this ) ? g_currentWorkerIdx : m_nextQueueIdx.fetch_add( 1 ) % GetNumThreads();
+        m_numIncompleteTasks.fetch_add( 1 );
+
+        // Count the task before it becomes visible so that the queued count never underflows
+        {
+            std::lock_guard<std::mutex> lock( m_stateMutex );
+            m_numQueuedTasks++;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_queues[queueIdx]->m_mutex );
+            m_queues[queueIdx]->m_tasks.emplace_back( std::move( task ) );
+        }
+
+        m_workAvailableCondition.notify_one();
+    }
+
+    bool ThreadPool::TryGetTask( uint32_t queueIdx, Task& task )
+    {
+        // Own queue first - most recently submitted task
+        {
+            WorkerQueue& queue = *m_queues[queueIdx];
+            std::lock_guard<std::mutex> lock( queue.m_mutex );
+            if ( !queue.m_tasks.empty() )
+            {
+                task = std::move( queue.m_tasks.back() );
+                queue.m_tasks.pop_back();
+                return true;
+            }
+        }
+
+        // Steal the oldest task from the other queues
+        uint32_t const numQueues = (uint32_t) m_queues.size();
+        for ( uint32_t offset = 1; offset < numQueues; offset++ )
+        {
+            WorkerQueue& queue = *m_queues[( queueIdx + offset ) % numQueues];
+            std::lock_guard<std::mutex> lock( queue.m_mutex );
+            if ( !queue.m_tasks.empty() )
+            {
+                task = std::move( queue.m_tasks.front() );
+                queue.m_tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ThreadPool::RunTask( Task& task )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_stateMutex );
+            assert( m_numQueuedTasks > 0 );
+            m_numQueuedTasks--;
+        }
+
+        task();
+        task = nullptr;
+
+        if ( m_numIncompleteTasks.fetch_sub( 1 ) == 1 )
+        {
+            std::lock_guard<std::mutex> lock( m_stateMutex );
+            m_allTasksCompleteCondition.notify_all();
+        }
+    }
+
+    void ThreadPool::WorkerThread( uint32_t workerIdx )
+    {
+        g_pCurrentPool = this;
+        g_currentWorkerIdx = workerIdx;
+
+        Task task;
+        while ( true )
+        {
+            if ( TryGetTask( workerIdx, task ) )
+            {
+                RunTask( task );
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock( m_stateMutex );
+            m_workAvailableCondition.wait( lock, [this] () { return m_isShuttingDown || m_numQueuedTasks > 0; } );
+            if ( m_isShuttingDown && m_numQueuedTasks == 0 )
+            {
+                break;
+            }
+        }
+
+        g_pCurrentPool = nullptr;
+    }
+
+    void ThreadPool::WaitForAll()
+    {
+        // Waiting from inside a task would wait on itself
+        assert( g_pCurrentPool != this );
+
+        // Help out while there is queued work
+        Task task;
+        while ( m_numIncompleteTasks.load() > 0 && TryGetTask( 0, task ) )
+        {
+            RunTask( task );
+        }
+
+        std::unique_lock<std::mutex> lock( m_stateMutex );
+        m_allTasksCompleteCondition.wait( lock, [this] () { return m_numIncompleteTasks.load() == 0; } );
+    }
+
+    void ThreadPool::ParallelFor( uint32_t count, std::function<void( uint32_t )> const& function )
+    {
+        for ( uint32_t idx = 0; idx < count; idx++ )
+        {
+            Submit( [&function, idx] () { function( idx ); } );
+        }
+
+        WaitForAll();
+    }
+}
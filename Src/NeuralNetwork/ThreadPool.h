@@ -0,0 +1,79 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Work-stealing thread pool
+//
+// Each worker owns a task queue, it pops its own tasks LIFO and steals from the other workers FIFO
+// when it runs out. Tasks submitted from a worker go to that worker's queue, tasks submitted from
+// outside the pool are distributed round-robin.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class ThreadPool
+    {
+    public:
+
+        typedef std::function<void()> Task;
+
+    public:
+
+        // A thread count of 0 uses the hardware concurrency
+        explicit ThreadPool( uint32_t numThreads = 0 );
+        ~ThreadPool();
+
+        ThreadPool( ThreadPool const& ) = delete;
+        ThreadPool& operator=( ThreadPool const& ) = delete;
+
+        inline uint32_t GetNumThreads() const { return (uint32_t) m_threads.size(); }
+
+        void Submit( Task&& task );
+
+        // Blocks until all submitted tasks have completed, the calling thread helps execute tasks while waiting.
+        // Must not be called from inside a task.
+        void WaitForAll();
+
+        // Runs function( idx ) for idx = [0, count) across the pool and waits for completion
+        void ParallelFor( uint32_t count, std::function<void( uint32_t )> const& function );
+
+    private:
+
+        struct WorkerQueue
+        {
+            std::mutex                              m_mutex;
+            std::deque<Task>                        m_tasks;
+        };
+
+        void WorkerThread( uint32_t workerIdx );
+        bool TryGetTask( uint32_t queueIdx, Task& task );
+        void RunTask( Task& task );
+
+    private:
+
+        std::vector<std::unique_ptr<WorkerQueue>>   m_queues;
+        std::vector<std::thread>                    m_threads;
+
+        std::mutex                                  m_stateMutex;
+        std::condition_variable                     m_workAvailableCondition;
+        std::condition_variable                     m_allTasksCompleteCondition;
+        uint32_t                                    m_numQueuedTasks = 0;       // Protected by m_stateMutex
+        std::atomic<uint32_t>                       m_numIncompleteTasks;
+        std::atomic<uint32_t>                       m_nextQueueIdx;
+        bool                                        m_isShuttingDown = false;   // Protected by m_stateMutex
+    };
+}
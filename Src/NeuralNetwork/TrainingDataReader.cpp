@@ -1,122 +1,219 @@
-//-------------------------------------------------------------------------
-// Simple back-propagation neural network example
-// 2017 - Bobby Anguelov
-// MIT license: https://opensource.org/licenses/MIT
-//-------------------------------------------------------------------------
-
-#include "TrainingDataReader.h"
-#include <assert.h>
-#include <iosfwd>
-#include <algorithm>
-#include <iostream>
-
-//-------------------------------------------------------------------------
-
-
-namespace BPN
-{
-    TrainingDataReader::TrainingDataReader( std::string const& filename, int32_t numInputs, int32_t numOutputs )
-        : m_filename( filename )
-        , m_numInputs( numInputs )
-        , m_numOutputs( numOutputs )
-    {
-        assert( !filename.empty() && m_numInputs > 0 && m_numOutputs > 0 );
-    }
-
-    bool TrainingDataReader::ReadData()
-    {
-        assert( !m_filename.empty() );
-
-        std::fstream inputFile;
-        inputFile.open( m_filename, std::ios::in );
-
-        if ( inputFile.is_open() )
-        {
-            std::string line;
-
-            // Read data
-            //-------------------------------------------------------------------------
-
-            int32_t const totalValuesToRead = m_numInputs + m_numOutputs;
-
-            while ( !inputFile.eof() )
-            {
-                std::getline( inputFile, line );
-                if ( line.length() > 2 )
-                {
-                    m_entries.push_back( TrainingEntry() );
-                    TrainingEntry& entry = m_entries.back();
-
-                    char* cstr = new char[line.size() + 1];
-                    strcpy_s( cstr, line.size() + 1, line.c_str() );
-
-                    // Read values
-                    int i = 0;
-                    char* nextToken = nullptr;
-                    char* pToken = strtok_s( cstr, ",", &nextToken );
-
-                    while ( pToken != nullptr && i < totalValuesToRead )
-                    {
-                        if ( i < m_numInputs )
-                        {
-                            entry.m_inputs.push_back( atof( pToken ) );
-                        }
-                        else
-                        {
-                            double const outputValue = atof( pToken );
-                            entry.m_expectedOutputs.push_back( (int32_t) outputValue );
-                        }
-
-                        pToken = strtok_s( nullptr, ",", &nextToken );
-                        i++;
-                    }
-                }
-            }
-
-            inputFile.close();
-
-            if ( !m_entries.empty() )
-            {
-                CreateTrainingData();
-            }
-
-            std::cout << "Input file: " << m_filename << "\nRead complete: " << m_entries.size() << " inputs loaded" << std::endl;
-            return true;
-        }
-        else
-        {
-            std::cout << "Error Opening Input File: " << m_filename << std::endl;
-            return false;
-        }
-    }
-
-    void TrainingDataReader::CreateTrainingData()
-    {
-        assert( !m_entries.empty() );
-
-        std::random_shuffle( m_entries.begin(), m_entries.end() );
-
-        // Training set
-        int32_t const numEntries = (int32_t) m_entries.size();
-        int32_t const numTrainingEntries  = (int32_t) ( 0.6 * numEntries );
-        int32_t const numGeneralizationEntries = (int32_t) ( ceil( 0.2 * numEntries ) );
-
-        int32_t entryIdx = 0;
-        for ( ; entryIdx < numTrainingEntries; entryIdx++ )
-        {
-            m_data.m_trainingSet.push_back( m_entries[entryIdx] );
-        }
-
-        // Generalization set
-        for ( ; entryIdx < numTrainingEntries + numGeneralizationEntries; entryIdx++ )
-        {
-            m_data.m_generalizationSet.push_back( m_entries[entryIdx] );
-        }
-
-        // Validation set
-        for ( ; entryIdx < numEntries; entryIdx++ )
-        {
-            m_data.m_validationSet.push_back( m_entries[entryIdx] );
-        }
-    }
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "TrainingDataReader.h"
+#include "Profiling.h"
+#include "Random.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+
+//-------------------------------------------------------------------------
+
+
+namespace BPN
+{
+    TrainingDataReader::TrainingDataReader( std::string const& filename, int32_t numInputs, int32_t numOutputs, NormalizationType normalization, uint64_t seed )
+        : m_filename( filename )
+        , m_numInputs( numInputs )
+        , m_numOutputs( numOutputs )
+        , m_normalization( normalization )
+        , m_seed( seed )
+    {
+        assert( !filename.empty() && m_numInputs > 0 && m_numOutputs > 0 );
+    }
+
+    bool TrainingDataReader::ReadData()
+    {
+        BPN_PROFILE_SCOPE( ReadData );
+
+        assert( !m_filename.empty() );
+
+        AsyncFileReader inputFile( m_readSettings );
+        if ( inputFile.Open( m_filename ) )
+        {
+            // Read data, lines are parsed in place in the read buffers and only a line split across two blocks is copied
+            //-------------------------------------------------------------------------
+
+            // Rows with fewer values than the network has inputs and outputs are skipped, the first few line numbers are reported
+            uint64_t lineNumber = 0;
+            uint64_t numMalformedLines = 0;
+            std::vector<uint64_t> malformedLineNumbers;
+            auto ParseNextLine = [&] ( char const* pLine, size_t length )
+            {
+                lineNumber++;
+                if ( !ParseLine( pLine, length ) )
+                {
+                    if ( malformedLineNumbers.size() < 10 )
+                    {
+                        malformedLineNumbers.push_back( lineNumber );
+                    }
+                    numMalformedLines++;
+                }
+            };
+
+            std::string splitLine;
+            char* pBlock = nullptr;
+            size_t blockSize = 0;
+            while ( inputFile.GetNextBlock( pBlock, blockSize ) )
+            {
+                char* pLineStart = pBlock;
+                char* const pBlockEnd = pBlock + blockSize;
+                while ( char* pLineEnd = (char*) memchr( pLineStart, '\n', pBlockEnd - pLineStart ) )
+                {
+                    if ( splitLine.empty() )
+                    {
+                        *pLineEnd = 0;
+                        ParseNextLine( pLineStart, pLineEnd - pLineStart );
+                    }
+                    else
+                    {
+                        splitLine.append( pLineStart, pLineEnd );
+                        ParseNextLine( splitLine.c_str(), splitLine.length() );
+                        splitLine.clear();
+                    }
+
+                    pLineStart = pLineEnd + 1;
+                }
+
+                splitLine.append( pLineStart, pBlockEnd );
+            }
+
+            if ( inputFile.HasFailed() )
+            {
+                std::cout << "Error Reading Input File: " << m_filename << std::endl;
+                return false;
+            }
+
+            // The last line doesn't need to end with a new line
+            ParseNextLine( splitLine.c_str(), splitLine.length() );
+
+            m_readStats = inputFile.GetStats();
+            inputFile.Close();
+
+            size_t const numEntries = m_entries.size();
+            if ( numEntries > 0 )
+            {
+                CreateTrainingData();
+            }
+
+            std::cout << "Input file: " << m_filename << "\nRead complete: " << numEntries << " inputs loaded" << std::endl;
+            if ( numMalformedLines > 0 )
+            {
+                std::cout << "Skipped " << numMalformedLines << " malformed line(s) with fewer than " << ( m_numInputs + m_numOutputs ) << " values, line(s):";
+                for ( uint64_t malformedLineNumber : malformedLineNumbers )
+                {
+                    std::cout << " " << malformedLineNumber;
+                }
+                std::cout << ( numMalformedLines > malformedLineNumbers.size() ? " ..." : "" ) << std::endl;
+            }
+
+            return true;
+        }
+        else
+        {
+            std::cout << "Error Opening Input File: " << m_filename << std::endl;
+            return false;
+        }
+    }
+
+    bool TrainingDataReader::ParseLine( char const* pLine, size_t length )
+    {
+        if ( length <= 2 )
+        {
+            return true;
+        }
+
+        m_entries.push_back( TrainingEntry() );
+        TrainingEntry& entry = m_entries.back();
+
+        // Read values
+        int32_t const totalValuesToRead = m_numInputs + m_numOutputs;
+        char const* pCurrent = pLine;
+        for ( int32_t i = 0; i < totalValuesToRead; i++ )
+        {
+            char* pEnd = nullptr;
+            double const value = strtod( pCurrent, &pEnd );
+            // Truncated rows would be read past their end by the evaluation paths, they are dropped
+            if ( pEnd == pCurrent )
+            {
+                m_entries.pop_back();
+                return false;
+            }
+
+            if ( i < m_numInputs )
+            {
+                entry.m_inputs.push_back( value );
+            }
+            else
+            {
+                entry.m_expectedOutputs.push_back( (int32_t) value );
+            }
+
+            // Skip separator
+            pCurrent = ( *pEnd == ',' ) ? pEnd + 1 : pEnd;
+        }
+
+        return true;
+    }
+
+    void TrainingDataReader::CreateTrainingData()
+    {
+        assert( !m_entries.empty() );
+
+        RandomStream( m_seed ).Shuffle( m_entries );
+
+        int32_t const numEntries = (int32_t) m_entries.size();
+        int32_t const numTrainingEntries  = (int32_t) ( 0.6 * numEntries );
+        int32_t const numGeneralizationEntries = (int32_t) ( ceil( 0.2 * numEntries ) );
+
+        // Normalize inputs, the statistics only come from the training entries so that nothing leaks from the held out sets
+        if ( m_normalization != NormalizationType::None )
+        {
+            m_normalizer = FeatureNormalizer::Compute( m_normalization, m_entries.data(), numTrainingEntries );
+            m_normalizer.Apply( m_entries );
+        }
+
+        // Compact storage packs each set from the moved entries, so the double precision copies are released set by set
+        if ( m_useCompactStorage )
+        {
+            auto PackEntries = [this] ( int32_t startIdx, int32_t endIdx )
+            {
+                TrainingSet const entries( std::make_move_iterator( m_entries.begin() + startIdx ), std::make_move_iterator( m_entries.begin() + endIdx ) );
+                return CompactTrainingSet( entries );
+            };
+
+            m_compactData.m_trainingSet = PackEntries( 0, numTrainingEntries );
+            m_compactData.m_generalizationSet = PackEntries( numTrainingEntries, numTrainingEntries + numGeneralizationEntries );
+            m_compactData.m_validationSet = PackEntries( numTrainingEntries + numGeneralizationEntries, numEntries );
+            m_entries = TrainingSet();
+            return;
+        }
+
+        // Training set
+        int32_t entryIdx = 0;
+        for ( ; entryIdx < numTrainingEntries; entryIdx++ )
+        {
+            m_data.m_trainingSet.push_back( m_entries[entryIdx] );
+        }
+
+        // Generalization set
+        for ( ; entryIdx < numTrainingEntries + numGeneralizationEntries; entryIdx++ )
+        {
+            m_data.m_generalizationSet.push_back( m_entries[entryIdx] );
+        }
+
+        // Validation set
+        for ( ; entryIdx < numEntries; entryIdx++ )
+        {
+            m_data.m_validationSet.push_back( m_entries[entryIdx] );
+        }
+    }
 }
\ No newline at end of file
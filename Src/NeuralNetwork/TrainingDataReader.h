@@ -1,43 +1,75 @@
-//-------------------------------------------------------------------------
-// Simple back-propagation neural network example
-// 2017 - Bobby Anguelov
-// MIT license: https://opensource.org/licenses/MIT
-//-------------------------------------------------------------------------
-
-#pragma once
-
-#include "NeuralNetworkTrainer.h"
-#include <string>
-
-//-------------------------------------------------------------------------
-
-namespace BPN
-{
-    class TrainingDataReader
-    {
-    public:
-
-        TrainingDataReader( std::string const& filename, int32_t numInputs, int32_t numOutputs );
-
-        bool ReadData();
-
-        inline int32_t GetNumInputs() const { return m_numInputs; }
-        inline int32_t GetNumOutputs() const { return m_numOutputs; }
-
-        inline int32_t GetNumTrainingSets() const { return 0; }
-        TrainingData const& GetTrainingData() const { return m_data; }
-
-    private:
-
-        void CreateTrainingData();
-
-    private:
-
-        std::string                     m_filename;
-        int32_t                         m_numInputs;
-        int32_t                         m_numOutputs;
-
-        std::vector<TrainingEntry>      m_entries;
-        TrainingData                    m_data;
-    };
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#pragma once
+
+#include "AsyncFileReader.h"
+#include "CompactTrainingSet.h"
+#include "FeatureNormalizer.h"
+#include <string>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    class TrainingDataReader
+    {
+    public:
+
+        // The entries are shuffled with the seed before being split into the sets. The normalization statistics are
+        // computed over the training set only and then applied to all entries.
+        TrainingDataReader( std::string const& filename, int32_t numInputs, int32_t numOutputs, NormalizationType normalization = NormalizationType::None, uint64_t seed = 0 );
+
+        // Reads are issued asynchronously with these settings, call before reading the data
+        inline void SetReadSettings( AsyncFileReader::Settings const& settings ) { m_readSettings = settings; }
+
+        // Keeps the sets in compact form only, the entries and double precision sets are released once they are packed
+        // and stay empty. Call before reading the data.
+        inline void SetUseCompactStorage( bool useCompactStorage ) { m_useCompactStorage = useCompactStorage; }
+
+        bool ReadData();
+
+        inline int32_t GetNumInputs() const { return m_numInputs; }
+        inline int32_t GetNumOutputs() const { return m_numOutputs; }
+
+        inline int32_t GetNumTrainingSets() const { return 0; }
+        TrainingData const& GetTrainingData() const { return m_data; }
+
+        // The same sets in the narrowest storage that holds their values, only built with compact storage enabled
+        CompactTrainingData const& GetCompactTrainingData() const { return m_compactData; }
+
+        // All loaded entries in shuffled order
+        TrainingSet const& GetEntries() const { return m_entries; }
+
+        // Normalization applied to the inputs of all entries
+        FeatureNormalizer const& GetNormalizer() const { return m_normalizer; }
+
+        // How the file was read: backend, throughput and the time spent waiting on reads
+        AsyncFileReader::Stats const& GetReadStats() const { return m_readStats; }
+
+    private:
+
+        // Returns false for rows with fewer values than the inputs and outputs, which are not stored
+        bool ParseLine( char const* pLine, size_t length );
+        void CreateTrainingData();
+
+    private:
+
+        std::string                     m_filename;
+        int32_t                         m_numInputs;
+        int32_t                         m_numOutputs;
+        NormalizationType               m_normalization;
+        uint64_t                        m_seed;
+        FeatureNormalizer               m_normalizer;
+        AsyncFileReader::Settings       m_readSettings;
+        AsyncFileReader::Stats          m_readStats;
+        bool                            m_useCompactStorage = false;
+
+        std::vector<TrainingEntry>      m_entries;
+        TrainingData                    m_data;
+        CompactTrainingData             m_compactData;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "TrainingTelemetry.h"
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    namespace
+    {
+        // JSON has no representation for NaN or infinity
+        struct JsonNumber
+        {
+            double m_value;
+        };
+
+        std::ostream& operator<<( std::ostream& stream, JsonNumber number )
+        {
+            if ( std::isfinite( number.m_value ) )
+            {
+                return stream << number.m_value;
+            }
+
+            return stream << "null";
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
+    ConsoleTelemetrySink::ConsoleTelemetrySink()
+        : m_stream( std::cout )
+    {}
+
+    void ConsoleTelemetrySink::OnTrainingStarted( TrainingStartTelemetry const& telemetry )
+    {
+        m_stream    << std::endl << " Neural Network Training Starting: " << std::endl
+                    << "==========================================================================" << std::endl
+                    << " LR: " << telemetry.m_learningRate << ", Momentum: " << telemetry.m_momentum << ", Max Epochs: " << telemetry.m_maxEpochs << std::endl
+                    << " " << telemetry.m_numInputs << " Input Neurons, " << telemetry.m_numHidden << " Hidden Neurons, " << telemetry.m_numOutputs << " Output Neurons" << std::endl
+                    << "==========================================================================" << std::endl << std::endl;
+    }
+
+    void ConsoleTelemetrySink::OnEpochComplete( EpochTelemetry const& telemetry )
+    {
+        m_stream << "Epoch :" << telemetry.m_epoch;
+        m_stream << " Training Set Accuracy:" << telemetry.m_trainingSetAccuracy << "%, MSE: " << telemetry.m_trainingSetMSE;
+        m_stream << " Generalization Set Accuracy:" << telemetry.m_generalizationSetAccuracy << "%, MSE: " << telemetry.m_generalizationSetMSE << std::endl;
+
+        if ( Profiling::IsEnabled() )
+        {
+            m_stream << "    " << telemetry.m_epochTimeMS << "ms, " << telemetry.m_samplesPerSecond << " samples/s";
+            for ( uint32_t phaseIdx = 0; phaseIdx < Profiling::NumPhases; phaseIdx++ )
+            {
+                Profiling::PhaseStats const& stats = telemetry.m_counters.m_phases[phaseIdx];
+                if ( stats.m_numCalls > 0 )
+                {
+                    m_stream << ", " << Profiling::GetPhaseName( (Profiling::Phase) phaseIdx ) << ": " << stats.m_totalTimeNS / 1000000.0 << "ms";
+                }
+            }
+            m_stream << ", allocations: " << telemetry.m_counters.m_numAllocations << std::endl;
+        }
+    }
+
+    void ConsoleTelemetrySink::OnTrainingComplete( TrainingCompleteTelemetry const& telemetry )
+    {
+        m_stream << std::endl << "Training Complete!!! - > Elapsed Epochs: " << telemetry.m_numEpochs << std::endl;
+        m_stream << " Validation Set Accuracy: " << telemetry.m_validationSetAccuracy << std::endl;
+        m_stream << " Validation Set MSE: " << telemetry.m_validationSetMSE << std::endl << std::endl;
+    }
+
+    //-------------------------------------------------------------------------
+
+    void JsonLinesTelemetrySink::OnTrainingStarted( TrainingStartTelemetry const& telemetry )
+    {
+        m_stream << "{\"event\":\"trainingStarted\"";
+        m_stream << ",\"learningRate\":" << JsonNumber{ telemetry.m_learningRate };
+        m_stream << ",\"momentum\":" << JsonNumber{ telemetry.m_momentum };
+        m_stream << ",\"maxEpochs\":" << telemetry.m_maxEpochs;
+        m_stream << ",\"batchLearning\":" << ( telemetry.m_useBatchLearning ? "true" : "false" );
+        m_stream << ",\"inputs\":" << telemetry.m_numInputs;
+        m_stream << ",\"hidden\":" << telemetry.m_numHidden;
+        m_stream << ",\"outputs\":" << telemetry.m_numOutputs;
+        m_stream << ",\"trainingEntries\":" << telemetry.m_numTrainingEntries;
+        m_stream << ",\"profiling\":" << ( Profiling::IsEnabled() ? "true" : "false" );
+
+        if ( Profiling::IsEnabled() )
+        {
+            m_stream << ",\"readData\":{\"ms\":" << telemetry.m_dataLoadStats.m_totalTimeNS / 1000000.0 << ",\"calls\":" << telemetry.m_dataLoadStats.m_numCalls << "}";
+        }
+
+        m_stream << "}" << std::endl;
+    }
+
+    void JsonLinesTelemetrySink::OnEpochComplete( EpochTelemetry const& telemetry )
+    {
+        m_stream << "{\"event\":\"epoch\"";
+        m_stream << ",\"epoch\":" << telemetry.m_epoch;
+        m_stream << ",\"trainingAccuracy\":" << JsonNumber{ telemetry.m_trainingSetAccuracy };
+        m_stream << ",\"trainingMSE\":" << JsonNumber{ telemetry.m_trainingSetMSE };
+        m_stream << ",\"generalizationAccuracy\":" << JsonNumber{ telemetry.m_generalizationSetAccuracy };
+        m_stream << ",\"generalizationMSE\":" << JsonNumber{ telemetry.m_generalizationSetMSE };
+        m_stream << ",\"epochTimeMs\":" << JsonNumber{ telemetry.m_epochTimeMS };
+        m_stream << ",\"samplesPerSec\":" << JsonNumber{ telemetry.m_samplesPerSecond };
+        WriteCounters( telemetry.m_counters );
+        m_stream << "}" << std::endl;
+    }
+
+    void JsonLinesTelemetrySink::OnTrainingComplete( TrainingCompleteTelemetry const& telemetry )
+    {
+        m_stream << "{\"event\":\"trainingComplete\"";
+        m_stream << ",\"epochs\":" << telemetry.m_numEpochs;
+        m_stream << ",\"validationAccuracy\":" << JsonNumber{ telemetry.m_validationSetAccuracy };
+        m_stream << ",\"validationMSE\":" << JsonNumber{ telemetry.m_validationSetMSE };
+        m_stream << ",\"totalTimeMs\":" << JsonNumber{ telemetry.m_totalTimeMS };
+        WriteCounters( telemetry.m_counters );
+        m_stream << "}" << std::endl;
+    }
+
+    void JsonLinesTelemetrySink::WriteCounters( Profiling::Counters const& counters )
+    {
+        if ( !Profiling::IsEnabled() )
+        {
+            return;
+        }
+
+        m_stream << ",\"phases\":{";
+        for ( uint32_t phaseIdx = 0; phaseIdx < Profiling::NumPhases; phaseIdx++ )
+        {
+            Profiling::PhaseStats const& stats = counters.m_phases[phaseIdx];
+            m_stream << ( phaseIdx > 0 ? "," : "" ) << "\"" << Profiling::GetPhaseName( (Profiling::Phase) phaseIdx ) << "\":{\"ms\":" << stats.m_totalTimeNS / 1000000.0 << ",\"calls\":" << stats.m_numCalls << "}";
+        }
+        m_stream << "}";
+        m_stream << ",\"allocations\":" << counters.m_numAllocations;
+        m_stream << ",\"allocatedBytes\":" << counters.m_numAllocatedBytes;
+    }
+}
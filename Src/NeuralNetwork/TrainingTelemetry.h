@@ -0,0 +1,105 @@
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+// Structured training telemetry
+//
+// The trainer reports its progress through a telemetry sink. The per-phase timing breakdowns and
+// allocation counts are only populated when the profiling instrumentation is compiled in.
+
+#pragma once
+
+#include "Profiling.h"
+#include <iosfwd>
+
+//-------------------------------------------------------------------------
+
+namespace BPN
+{
+    struct TrainingStartTelemetry
+    {
+        double                      m_learningRate = 0;
+        double                      m_momentum = 0;
+        uint32_t                    m_maxEpochs = 0;
+        bool                        m_useBatchLearning = false;
+        int32_t                     m_numInputs = 0;
+        int32_t                     m_numHidden = 0;
+        int32_t                     m_numOutputs = 0;
+        uint32_t                    m_numTrainingEntries = 0;
+        Profiling::PhaseStats       m_dataLoadStats;            // All data reads performed on the training thread prior to training
+    };
+
+    struct EpochTelemetry
+    {
+        uint32_t                    m_epoch = 0;
+        double                      m_trainingSetAccuracy = 0;
+        double                      m_trainingSetMSE = 0;
+        double                      m_generalizationSetAccuracy = 0;
+        double                      m_generalizationSetMSE = 0;
+        double                      m_epochTimeMS = 0;          // Training pass and generalization set evaluation
+        double                      m_samplesPerSecond = 0;     // Training samples processed per second of epoch time
+        Profiling::Counters         m_counters;                 // Counters for this epoch only
+    };
+
+    struct TrainingCompleteTelemetry
+    {
+        uint32_t                    m_numEpochs = 0;
+        double                      m_validationSetAccuracy = 0;
+        double                      m_validationSetMSE = 0;
+        double                      m_totalTimeMS = 0;
+        Profiling::Counters         m_counters;                 // Counters for the whole training run
+    };
+
+    //-------------------------------------------------------------------------
+
+    class TrainingTelemetrySink
+    {
+    public:
+
+        virtual ~TrainingTelemetrySink() = default;
+
+        virtual void OnTrainingStarted( TrainingStartTelemetry const& ) {}
+        virtual void OnEpochComplete( EpochTelemetry const& ) {}
+        virtual void OnTrainingComplete( TrainingCompleteTelemetry const& ) {}
+    };
+
+    //-------------------------------------------------------------------------
+
+    // Human readable progress output
+    class ConsoleTelemetrySink : public TrainingTelemetrySink
+    {
+    public:
+
+        ConsoleTelemetrySink();
+        explicit ConsoleTelemetrySink( std::ostream& stream ) : m_stream( stream ) {}
+
+        virtual void OnTrainingStarted( TrainingStartTelemetry const& telemetry ) override;
+        virtual void OnEpochComplete( EpochTelemetry const& telemetry ) override;
+        virtual void OnTrainingComplete( TrainingCompleteTelemetry const& telemetry ) override;
+
+    private:
+
+        std::ostream&               m_stream;
+    };
+
+    // Writes a single JSON object per event, one event per line
+    class JsonLinesTelemetrySink : public TrainingTelemetrySink
+    {
+    public:
+
+        explicit JsonLinesTelemetrySink( std::ostream& stream ) : m_stream( stream ) {}
+
+        virtual void OnTrainingStarted( TrainingStartTelemetry const& telemetry ) override;
+        virtual void OnEpochComplete( EpochTelemetry const& telemetry ) override;
+        virtual void OnTrainingComplete( TrainingCompleteTelemetry const& telemetry ) override;
+
+    private:
+
+        void WriteCounters( Profiling::Counters const& counters );
+
+    private:
+
+        std::ostream&               m_stream;
+    };
+}
@@ -1,65 +1,595 @@
-//-------------------------------------------------------------------------
-// Simple back-propagation neural network example
-// 2017 - Bobby Anguelov
-// MIT license: https://opensource.org/licenses/MIT
-//-------------------------------------------------------------------------
-
-#include "NeuralNetwork/neuralNetworkTrainer.h"
-#include "NeuralNetwork/TrainingDataReader.h"
-#include <iostream>
-
-#if _MSC_VER
-#pragma warning(push, 0)
-#pragma warning(disable: 4702)
-#endif
-
-#include "cmdParser.h"
-
-#if _MSC_VER
-#pragma warning(pop)
-#endif
-
-//-------------------------------------------------------------------------
-
-int main( int argc, char* argv[] )
-{
-    cli::Parser cmdParser( argc, argv );
-    cmdParser.set_required<std::string>( "d", "DataFile", "Path to training data csv file." );
-    cmdParser.set_required<uint32_t>( "in", "NumInputs", "Num Input neurons." );
-    cmdParser.set_required<uint32_t>( "hidden", "NumHidden", "Num Hidden neurons." );
-    cmdParser.set_required<uint32_t>( "out", "NumOutputs", "Num Output neurons." );
-
-    if ( !cmdParser.run() )
-    {
-        std::cout << "Invalid command line arguments";
-        return 1;
-    }
-
-    std::string trainingDataPath = cmdParser.get<std::string>( "d" ).c_str();
-    uint32_t const numInputs = cmdParser.get<uint32_t>( "in" );
-    uint32_t const numHidden = cmdParser.get<uint32_t>( "hidden" );
-    uint32_t const numOutputs = cmdParser.get<uint32_t>( "out" );
-
-    BPN::TrainingDataReader dataReader( trainingDataPath, numInputs, numOutputs );
-    if ( !dataReader.ReadData() )
-    {
-        return 1;
-    }
-
-    // Create neural network
-    BPN::Network::Settings networkSettings{ numInputs, numHidden, numOutputs };
-    BPN::Network nn( networkSettings );
-
-    // Create neural network trainer
-    BPN::NetworkTrainer::Settings trainerSettings;
-    trainerSettings.m_learningRate = 0.001;
-    trainerSettings.m_momentum = 0.9;
-    trainerSettings.m_useBatchLearning = false;
-    trainerSettings.m_maxEpochs = 200;
-    trainerSettings.m_desiredAccuracy = 90;
-
-    BPN::NetworkTrainer trainer( trainerSettings, &nn );
-    trainer.Train( dataReader.GetTrainingData() );
-
-    return 0;
-}
+//-------------------------------------------------------------------------
+// Simple back-propagation neural network example
+// 2017 - Bobby Anguelov
+// MIT license: https://opensource.org/licenses/MIT
+//-------------------------------------------------------------------------
+
+#include "NeuralNetwork/Autotuner.h"
+#include "NeuralNetwork/CrossValidation.h"
+#include "NeuralNetwork/DistributedTrainer.h"
+#include "NeuralNetwork/Distillation.h"
+#include "NeuralNetwork/Ensemble.h"
+#include "NeuralNetwork/Gemm.h"
+#include "NeuralNetwork/HyperparameterSearch.h"
+#include "NeuralNetwork/NeuralNetworkTrainer.h"
+#include "NeuralNetwork/NetworkExporter.h"
+#include "NeuralNetwork/NetworkPruning.h"
+#include "NeuralNetwork/NetworkSerialization.h"
+#include "NeuralNetwork/NumaTrainer.h"
+#include "NeuralNetwork/OnlineTrainer.h"
+#include "NeuralNetwork/RowDeduplicator.h"
+#include "NeuralNetwork/TrainingDataReader.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#if _MSC_VER
+#pragma warning(push, 0)
+#pragma warning(disable: 4702)
+#endif
+
+#include "cmdParser.h"
+
+#if _MSC_VER
+#pragma warning(pop)
+#endif
+
+//-------------------------------------------------------------------------
+
+int main( int argc, char* argv[] )
+{
+    cli::Parser cmdParser( argc, argv );
+    cmdParser.set_required<std::string>( "d", "DataFile", "Path to training data csv file." );
+    cmdParser.set_required<uint32_t>( "in", "NumInputs", "Num Input neurons." );
+    cmdParser.set_required<uint32_t>( "hidden", "NumHidden", "Num Hidden neurons." );
+    cmdParser.set_required<uint32_t>( "out", "NumOutputs", "Num Output neurons." );
+    cmdParser.set_optional<std::string>( "export", "ExportHeader", "", "Export the trained network as a standalone C++ header, a verification program is written alongside it." );
+    cmdParser.set_optional<std::string>( "save", "ModelFile", "", "Save the trained network to this model file, i.e. for the inference server." );
+    cmdParser.set_optional<std::string>( "normalize", "Normalization", "none", "Normalize the inputs with statistics from the training set: none, minmax or zscore. Saved and exported networks take the raw inputs." );
+    cmdParser.set_optional<std::string>( "telemetry", "TelemetryFile", "", "Write training telemetry as JSON lines to this file instead of the console." );
+    cmdParser.set_optional<uint32_t>( "ensemble", "NumEnsembleMembers", 0, "Train an ensemble of this many networks instead of a single network." );
+    cmdParser.set_optional<bool>( "ensembleVote", "EnsembleVote", false, "Combine the ensemble members by voting instead of averaging their outputs." );
+    cmdParser.set_optional<double>( "prune", "PruneSparsity", 0.0, "Prune this fraction of the input->hidden weights from the trained network, gradually while fine-tuning it, and report the accuracy and inference speed against the dense network." );
+    cmdParser.set_optional<uint32_t>( "distill", "DistillHidden", 0, "Distill the trained network into a student with this many hidden neurons, trained on the teacher's raw outputs, and report their agreement and inference speed. The student replaces the teacher for saving and exporting." );
+    cmdParser.set_optional<bool>( "pruneOneShot", "PruneOneShot", false, "Prune the trained network in one shot without fine-tuning it." );
+    cmdParser.set_optional<uint32_t>( "online", "OnlineBatchSize", 0, "Stream the training set through the online trainer in batches of this many samples instead of training in epochs." );
+    cmdParser.set_optional<uint32_t>( "numa", "NumaBatchSize", 0, "Train data parallel with workers pinned across the NUMA nodes, synchronizing every this many samples per worker." );
+    cmdParser.set_optional<uint32_t>( "processes", "NumProcesses", 0, "Train data parallel across this many local processes, which sum their gradients with a ring all-reduce after every batch." );
+    cmdParser.set_optional<std::string>( "transport", "Transport", "shm", "Transport between the local processes: shm (POSIX shared memory) or tcp (loopback ports starting at -ringPort)." );
+    cmdParser.set_optional<uint32_t>( "ringPort", "RingPort", 5600, "First loopback port used by the local processes with the tcp transport." );
+    cmdParser.set_optional<std::vector<std::string>>( "peers", "Peers", {}, "host:port of every rank for data parallel training across hosts over TCP, run one process per host with its -rank." );
+    cmdParser.set_optional<uint32_t>( "rank", "Rank", 0, "Index of this process in -peers, rank 0 reports the training progress and saves/exports the network." );
+    cmdParser.set_optional<uint32_t>( "processBatch", "ProcessBatchSize", 64, "Samples trained by each process between all-reduces." );
+    cmdParser.set_optional<uint32_t>( "kfold", "NumFolds", 0, "Run k-fold cross-validation with this many folds (at least 3) instead of training a single network." );
+    cmdParser.set_optional<std::string>( "search", "SearchStrategy", "", "Run a hyperparameter search instead of training a single network: grid, random or halving." );
+    cmdParser.set_optional<std::vector<uint32_t>>( "searchHidden", "SearchHidden", {}, "Hidden layer sizes to search, defaults to the -hidden value." );
+    cmdParser.set_optional<std::vector<double>>( "searchLR", "SearchLearningRates", { 0.001 }, "Learning rates to search." );
+    cmdParser.set_optional<std::vector<double>>( "searchMomentum", "SearchMomentums", { 0.9 }, "Momentum values to search." );
+    cmdParser.set_optional<uint32_t>( "searchTrials", "SearchTrials", 32, "Number of sampled configurations for the random and halving strategies." );
+    cmdParser.set_optional<std::string>( "reader", "ReadBackend", "uring", "How the data file is read: uring (io_uring with registered buffers, falls back to threads where unavailable) or threads (pool of threads issuing positional reads)." );
+    cmdParser.set_optional<uint32_t>( "readBlockKB", "ReadBlockKB", 1024, "Size of the blocks the data file is read in." );
+    cmdParser.set_optional<uint32_t>( "readQueueDepth", "ReadQueueDepth", 8, "Number of data file reads kept in flight while parsing." );
+    cmdParser.set_optional<bool>( "readStats", "ReadStats", false, "Report the data file read throughput against what the device delivers for the same file with direct reads." );
+    cmdParser.set_optional<uint32_t>( "seed", "Seed", 0, "Seed for the data split, the initial weights, the epoch shuffles and the search configurations. Runs with the same seed and thread count are identical." );
+    cmdParser.set_optional<bool>( "shuffle", "ShuffleEachEpoch", false, "Shuffle the training set order every epoch." );
+    cmdParser.set_optional<bool>( "batch", "BatchLearning", false, "Accumulate the weight updates over the whole training set and apply them once per epoch instead of after every entry." );
+    cmdParser.set_optional<bool>( "dedup", "CollapseDuplicates", false, "Collapse identical rows of the data sets into unique rows weighted by their count before training, requires -batch. Epochs only process the unique rows and the results are the same up to rounding." );
+    cmdParser.set_optional<bool>( "compact", "CompactStorage", false, "Train on the data sets stored as uint8/uint16 features and bit labels when their values allow it, the trained network is identical." );
+    cmdParser.set_optional<std::string>( "gemm", "GemmBackend", "kernel", "Matrix multiplication backend of the batch evaluation and training paths: reference, kernel or blas (builds with NN_BLAS only)." );
+    cmdParser.set_optional<uint32_t>( "threads", "NumThreads", 0, "Number of worker threads, 0 uses the hardware concurrency." );
+    cmdParser.set_optional<bool>( "autotune", "Autotune", false, "Measure the fastest data parallel batch size, thread count and GEMM backend for the network shape on this machine, or reuse the cached choice, and train with them. An explicit -numa batch size or -threads count takes precedence." );
+    cmdParser.set_optional<std::string>( "autotuneCache", "AutotuneCacheFile", "NeuralNetwork.autotune", "File the autotuned configurations are cached in." );
+    cmdParser.set_optional<bool>( "retune", "Retune", false, "Measure the autotune candidates again even if the cache has an entry for this shape and machine." );
+
+    if ( !cmdParser.run() )
+    {
+        std::cout << "Invalid command line arguments";
+        return 1;
+    }
+
+    std::string trainingDataPath = cmdParser.get<std::string>( "d" ).c_str();
+    uint32_t const numInputs = cmdParser.get<uint32_t>( "in" );
+    uint32_t const numHidden = cmdParser.get<uint32_t>( "hidden" );
+    uint32_t const numOutputs = cmdParser.get<uint32_t>( "out" );
+    uint32_t const seed = cmdParser.get<uint32_t>( "seed" );
+
+    std::string const gemmBackendName = cmdParser.get<std::string>( "gemm" );
+    BPN::Gemm::Backend gemmBackend = BPN::Gemm::Backend::MicroKernel;
+    if ( !BPN::Gemm::ParseBackendName( gemmBackendName.c_str(), gemmBackend ) || !BPN::Gemm::SetBackend( gemmBackend ) )
+    {
+        std::cout << "Unavailable GEMM backend: " << gemmBackendName << std::endl;
+        return 1;
+    }
+
+    BPN::NormalizationType normalization = BPN::NormalizationType::None;
+    std::string const normalizationName = cmdParser.get<std::string>( "normalize" );
+    if ( normalizationName == "minmax" )
+    {
+        normalization = BPN::NormalizationType::MinMax;
+    }
+    else if ( normalizationName == "zscore" )
+    {
+        normalization = BPN::NormalizationType::ZScore;
+    }
+    else if ( normalizationName != "none" )
+    {
+        std::cout << "Unknown normalization: " << normalizationName << std::endl;
+        return 1;
+    }
+
+    BPN::AsyncFileReader::Settings readSettings;
+    std::string const readBackendName = cmdParser.get<std::string>( "reader" );
+    if ( readBackendName != "uring" && readBackendName != "threads" )
+    {
+        std::cout << "Unknown reader: " << readBackendName << std::endl;
+        return 1;
+    }
+    readSettings.m_allowIoUring = readBackendName == "uring";
+    readSettings.m_blockSize = std::max( 4u, cmdParser.get<uint32_t>( "readBlockKB" ) ) * 1024;
+    readSettings.m_queueDepth = std::max( 1u, cmdParser.get<uint32_t>( "readQueueDepth" ) );
+
+    // Compact storage releases the double precision sets, which only single network training can do without
+    bool const useCompactStorage = cmdParser.get<bool>( "compact" );
+    if ( useCompactStorage && ( !cmdParser.get<std::string>( "search" ).empty() || cmdParser.get<uint32_t>( "kfold" ) > 0 || cmdParser.get<uint32_t>( "ensemble" ) > 0
+        || cmdParser.get<uint32_t>( "online" ) > 0 || cmdParser.get<uint32_t>( "processes" ) > 1 || !cmdParser.get<std::vector<std::string>>( "peers" ).empty()
+        || cmdParser.get<uint32_t>( "numa" ) > 0 || cmdParser.get<bool>( "autotune" ) || cmdParser.get<uint32_t>( "distill" ) > 0 || cmdParser.get<double>( "prune" ) > 0
+        || !cmdParser.get<std::string>( "export" ).empty() ) )
+    {
+        std::cout << "-compact only supports training a single network, it can't be combined with -search, -kfold, -ensemble, -online, -processes, -peers, -numa, -autotune, -distill, -prune or -export" << std::endl;
+        return 1;
+    }
+
+    // Only the single network batch trainer collapses the sets, the other trainers would silently train on every row
+    if ( cmdParser.get<bool>( "dedup" ) && ( !cmdParser.get<std::string>( "search" ).empty() || cmdParser.get<uint32_t>( "kfold" ) > 0 || cmdParser.get<uint32_t>( "ensemble" ) > 0
+        || cmdParser.get<uint32_t>( "online" ) > 0 || cmdParser.get<uint32_t>( "processes" ) > 1 || !cmdParser.get<std::vector<std::string>>( "peers" ).empty()
+        || cmdParser.get<uint32_t>( "numa" ) > 0 || cmdParser.get<bool>( "autotune" ) ) )
+    {
+        std::cout << "-dedup only supports training a single network, it can't be combined with -search, -kfold, -ensemble, -online, -processes, -peers, -numa or -autotune" << std::endl;
+        return 1;
+    }
+
+    // Cross-validation normalizes each fold with its own training statistics, so the entries are loaded raw
+    bool const isCrossValidating = cmdParser.get<uint32_t>( "kfold" ) > 0;
+    BPN::TrainingDataReader dataReader( trainingDataPath, numInputs, numOutputs, isCrossValidating ? BPN::NormalizationType::None : normalization, seed );
+    dataReader.SetReadSettings( readSettings );
+    dataReader.SetUseCompactStorage( useCompactStorage );
+    if ( !dataReader.ReadData() )
+    {
+        return 1;
+    }
+
+    if ( cmdParser.get<bool>( "readStats" ) )
+    {
+        double const deviceThroughputMBs = BPN::AsyncFileReader::MeasureDeviceThroughputMBs( trainingDataPath, readSettings );
+        BPN::AsyncFileReader::PrintStats( std::cout, dataReader.GetReadStats(), BPN::AsyncFileReader::GetDeviceName( trainingDataPath ), deviceThroughputMBs );
+    }
+
+    // Hyperparameter search
+    std::string const searchStrategy = cmdParser.get<std::string>( "search" );
+    if ( !searchStrategy.empty() )
+    {
+        BPN::HyperparameterSearch::Settings searchSettings;
+        if ( searchStrategy == "grid" )
+        {
+            searchSettings.m_strategy = BPN::HyperparameterSearch::Strategy::Grid;
+        }
+        else if ( searchStrategy == "random" )
+        {
+            searchSettings.m_strategy = BPN::HyperparameterSearch::Strategy::Random;
+        }
+        else if ( searchStrategy == "halving" )
+        {
+            searchSettings.m_strategy = BPN::HyperparameterSearch::Strategy::SuccessiveHalving;
+        }
+        else
+        {
+            std::cout << "Unknown search strategy: " << searchStrategy << std::endl;
+            return 1;
+        }
+
+        searchSettings.m_hiddenSizes = cmdParser.get<std::vector<uint32_t>>( "searchHidden" );
+        if ( searchSettings.m_hiddenSizes.empty() )
+        {
+            searchSettings.m_hiddenSizes.push_back( numHidden );
+        }
+        searchSettings.m_learningRates = cmdParser.get<std::vector<double>>( "searchLR" );
+        searchSettings.m_momentums = cmdParser.get<std::vector<double>>( "searchMomentum" );
+        searchSettings.m_numRandomTrials = cmdParser.get<uint32_t>( "searchTrials" );
+        searchSettings.m_seed = seed;
+        searchSettings.m_numThreads = cmdParser.get<uint32_t>( "threads" );
+        searchSettings.m_maxEpochs = 200;
+        searchSettings.m_desiredAccuracy = 90;
+
+        BPN::HyperparameterSearch search( searchSettings, dataReader.GetTrainingData(), numInputs, numOutputs );
+        BPN::HyperparameterSearch::PrintResults( std::cout, search.Run() );
+        return 0;
+    }
+
+    // Create neural network
+    BPN::Network::Settings networkSettings{ numInputs, numHidden, numOutputs, seed };
+    BPN::Network nn( networkSettings );
+
+    // Create neural network trainer
+    BPN::NetworkTrainer::Settings trainerSettings;
+    trainerSettings.m_learningRate = 0.001;
+    trainerSettings.m_momentum = 0.9;
+    trainerSettings.m_useBatchLearning = cmdParser.get<bool>( "batch" );
+    if ( cmdParser.get<bool>( "dedup" ) && !trainerSettings.m_useBatchLearning )
+    {
+        std::cout << "-dedup requires -batch, stochastic learning applies one update per row" << std::endl;
+        return 1;
+    }
+
+    if ( cmdParser.get<bool>( "dedup" ) && useCompactStorage )
+    {
+        std::cout << "-dedup can't be combined with -compact, compact sets don't store row weights" << std::endl;
+        return 1;
+    }
+
+    trainerSettings.m_maxEpochs = 200;
+    trainerSettings.m_desiredAccuracy = 90;
+    trainerSettings.m_shuffleEachEpoch = cmdParser.get<bool>( "shuffle" );
+    trainerSettings.m_seed = seed;
+
+    // Create telemetry output
+    BPN::ConsoleTelemetrySink consoleTelemetrySink;
+    std::ofstream telemetryFile;
+    std::unique_ptr<BPN::JsonLinesTelemetrySink> pJsonTelemetrySink;
+
+    std::string const telemetryPath = cmdParser.get<std::string>( "telemetry" );
+    if ( !telemetryPath.empty() )
+    {
+        telemetryFile.open( telemetryPath, std::ios::out | std::ios::trunc );
+        if ( !telemetryFile.is_open() )
+        {
+            std::cout << "Error Opening Telemetry File: " << telemetryPath << std::endl;
+            return 1;
+        }
+
+        pJsonTelemetrySink.reset( new BPN::JsonLinesTelemetrySink( telemetryFile ) );
+        trainerSettings.m_pTelemetrySink = pJsonTelemetrySink.get();
+    }
+    else
+    {
+        trainerSettings.m_pTelemetrySink = &consoleTelemetrySink;
+    }
+
+    // K-fold cross-validation
+    uint32_t const numFolds = cmdParser.get<uint32_t>( "kfold" );
+    if ( numFolds > 0 )
+    {
+        if ( numFolds < 3 || numFolds > dataReader.GetEntries().size() )
+        {
+            std::cout << "Invalid number of folds: " << numFolds << std::endl;
+            return 1;
+        }
+
+        if ( !cmdParser.get<std::string>( "save" ).empty() || !cmdParser.get<std::string>( "export" ).empty() )
+        {
+            std::cout << "Saving and exporting are not supported for cross-validation, it trains one network per fold" << std::endl;
+            return 1;
+        }
+
+        BPN::CrossValidation::Settings crossValidationSettings;
+        crossValidationSettings.m_numFolds = numFolds;
+        crossValidationSettings.m_normalization = normalization;
+        crossValidationSettings.m_numThreads = cmdParser.get<uint32_t>( "threads" );
+
+        BPN::CrossValidation crossValidation( crossValidationSettings, dataReader.GetEntries() );
+        BPN::CrossValidation::PrintResults( std::cout, crossValidation.Run( networkSettings, trainerSettings ) );
+        return 0;
+    }
+
+    // Ensemble training
+    uint32_t const numEnsembleMembers = cmdParser.get<uint32_t>( "ensemble" );
+    if ( numEnsembleMembers > 0 )
+    {
+        if ( !cmdParser.get<std::string>( "save" ).empty() || !cmdParser.get<std::string>( "export" ).empty() )
+        {
+            std::cout << "Saving and exporting are not supported for ensembles" << std::endl;
+            return 1;
+        }
+
+        BPN::Ensemble::Settings ensembleSettings;
+        ensembleSettings.m_numMembers = numEnsembleMembers;
+        ensembleSettings.m_combineMode = cmdParser.get<bool>( "ensembleVote" ) ? BPN::Ensemble::CombineMode::Vote : BPN::Ensemble::CombineMode::Average;
+        ensembleSettings.m_numThreads = cmdParser.get<uint32_t>( "threads" );
+
+        BPN::Ensemble ensemble( ensembleSettings, networkSettings );
+        ensemble.Train( trainerSettings, dataReader.GetTrainingData() );
+        return 0;
+    }
+
+    // Online training
+    uint32_t const onlineBatchSize = cmdParser.get<uint32_t>( "online" );
+    if ( onlineBatchSize > 0 )
+    {
+        BPN::ModelHandle modelHandle( std::unique_ptr<BPN::Network const>( new BPN::Network( nn ) ) );
+
+        BPN::OnlineTrainer::Settings onlineSettings;
+        onlineSettings.m_learningRate = trainerSettings.m_learningRate;
+        onlineSettings.m_momentum = trainerSettings.m_momentum;
+        onlineSettings.m_maxSamplesPerCall = onlineBatchSize;
+        BPN::OnlineTrainer onlineTrainer( onlineSettings, nn, &modelHandle );
+
+        // Replay the training set as if its samples were arriving live
+        BPN::TrainingSet const& trainingSet = dataReader.GetTrainingData().m_trainingSet;
+        for ( uint32_t passIdx = 0; passIdx < trainerSettings.m_maxEpochs; passIdx++ )
+        {
+            for ( size_t sampleIdx = 0; sampleIdx < trainingSet.size(); )
+            {
+                sampleIdx += onlineTrainer.Train( &trainingSet[sampleIdx], std::min( (size_t) onlineBatchSize, trainingSet.size() - sampleIdx ) );
+            }
+
+            BPN::OnlineTrainer::Stats const stats = onlineTrainer.GetStats();
+            std::cout << "Pass: " << passIdx << " Samples: " << stats.m_numSamples << " Rolling Accuracy: " << stats.m_rollingAccuracy << "% Rolling MSE: " << stats.m_rollingMSE
+                      << " Snapshots: " << stats.m_numSnapshotsPublished << " (" << stats.m_numSnapshotsDeferred << " deferred) Call Time us - mean: " << stats.m_meanCallTimeUS << " max: " << stats.m_maxCallTimeUS << std::endl;
+
+            if ( stats.m_rollingAccuracy >= trainerSettings.m_desiredAccuracy )
+            {
+                break;
+            }
+        }
+
+        // Score the validation set with the latest published snapshot, the same weights a scorer would be using
+        onlineTrainer.PublishSnapshot();
+        BPN::ModelHandle::ReadGuard const pPublishedNetwork = modelHandle.Acquire();
+        BPN::Network publishedNetwork( *pPublishedNetwork );
+
+        BPN::NetworkTrainer::Settings evaluationSettings = trainerSettings;
+        evaluationSettings.m_pTelemetrySink = nullptr;
+        BPN::NetworkTrainer evaluator( evaluationSettings, &publishedNetwork );
+
+        double validationSetAccuracy = 0;
+        double validationSetMSE = 0;
+        evaluator.GetSetAccuracyAndMSE( dataReader.GetTrainingData().m_validationSet, validationSetAccuracy, validationSetMSE );
+        std::cout << "Published model version " << pPublishedNetwork.GetVersion() << " - Validation Set Accuracy: " << validationSetAccuracy << "% Validation Set MSE: " << validationSetMSE << std::endl;
+
+        std::string const modelPath = cmdParser.get<std::string>( "save" );
+        if ( !modelPath.empty() )
+        {
+            if ( !BPN::SaveNetwork( modelPath, publishedNetwork, dataReader.GetNormalizer() ) )
+            {
+                return 1;
+            }
+
+            std::cout << "Saved network to: " << modelPath << std::endl;
+        }
+
+        return 0;
+    }
+
+    // Autotuned execution settings, the data parallel trainer is used with the tuned batch size and thread count
+    uint32_t numaBatchSize = cmdParser.get<uint32_t>( "numa" );
+    uint32_t numThreads = cmdParser.get<uint32_t>( "threads" );
+    if ( cmdParser.get<bool>( "autotune" ) )
+    {
+        BPN::Autotuner::Settings autotunerSettings;
+        autotunerSettings.m_cachePath = cmdParser.get<std::string>( "autotuneCache" );
+        autotunerSettings.m_forceRetune = cmdParser.get<bool>( "retune" );
+        autotunerSettings.m_seed = seed;
+
+        BPN::Autotuner autotuner( autotunerSettings, numInputs, numHidden, numOutputs );
+        BPN::Autotuner::Result<BPN::Autotuner::TrainingConfig> const autotuneResult = autotuner.TuneTraining();
+        BPN::Autotuner::PrintResult( std::cout, autotuneResult );
+
+        BPN::Gemm::SetBackend( autotuneResult.m_best.m_backend );
+        numaBatchSize = ( numaBatchSize == 0 ) ? autotuneResult.m_best.m_batchSize : numaBatchSize;
+        numThreads = ( numThreads == 0 ) ? autotuneResult.m_best.m_numThreads : numThreads;
+    }
+
+    // Multi-process data parallel training, only rank 0 continues past training
+    uint32_t const numLocalProcesses = cmdParser.get<uint32_t>( "processes" );
+    std::vector<std::string> peers = cmdParser.get<std::vector<std::string>>( "peers" );
+    if ( numLocalProcesses > 1 || !peers.empty() )
+    {
+        uint32_t rank = cmdParser.get<uint32_t>( "rank" );
+        std::vector<int> childProcessIDs;
+        std::unique_ptr<BPN::RingTransport> pTransport;
+
+        if ( peers.empty() )
+        {
+            std::string const transportName = cmdParser.get<std::string>( "transport" );
+            if ( transportName == "shm" )
+            {
+                std::unique_ptr<BPN::SharedMemoryTransport> pSharedMemoryTransport = BPN::SharedMemoryTransport::Create( numLocalProcesses );
+                if ( pSharedMemoryTransport == nullptr || !BPN::ForkLocalRanks( numLocalProcesses, rank, childProcessIDs ) )
+                {
+                    return 1;
+                }
+
+                pSharedMemoryTransport->SetRank( rank );
+                pTransport = std::move( pSharedMemoryTransport );
+            }
+            else if ( transportName == "tcp" )
+            {
+                for ( uint32_t localRank = 0; localRank < numLocalProcesses; localRank++ )
+                {
+                    peers.push_back( "127.0.0.1:" + std::to_string( cmdParser.get<uint32_t>( "ringPort" ) + localRank ) );
+                }
+
+                if ( !BPN::ForkLocalRanks( numLocalProcesses, rank, childProcessIDs ) )
+                {
+                    return 1;
+                }
+
+                pTransport = BPN::TcpTransport::Connect( rank, peers );
+            }
+            else
+            {
+                std::cout << "Unknown transport: " << transportName << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            if ( rank >= peers.size() )
+            {
+                std::cout << "Invalid rank: " << rank << std::endl;
+                return 1;
+            }
+
+            pTransport = BPN::TcpTransport::Connect( rank, peers );
+        }
+
+        BPN::DistributedTrainer::Settings distributedSettings;
+        distributedSettings.m_learningRate = trainerSettings.m_learningRate;
+        distributedSettings.m_momentum = trainerSettings.m_momentum;
+        distributedSettings.m_batchSize = cmdParser.get<uint32_t>( "processBatch" );
+        distributedSettings.m_maxEpochs = trainerSettings.m_maxEpochs;
+        distributedSettings.m_desiredAccuracy = trainerSettings.m_desiredAccuracy;
+        distributedSettings.m_pTelemetrySink = ( rank == 0 ) ? trainerSettings.m_pTelemetrySink : nullptr;
+
+        BPN::DistributedTrainer distributedTrainer( distributedSettings, &nn );
+        bool const trainingSucceeded = pTransport != nullptr && distributedTrainer.Train( dataReader.GetTrainingData(), *pTransport );
+        if ( rank != 0 )
+        {
+            return trainingSucceeded ? 0 : 1;
+        }
+
+        if ( !BPN::WaitForLocalRanks( childProcessIDs ) || !trainingSucceeded )
+        {
+            std::cout << "Distributed training failed" << std::endl;
+            return 1;
+        }
+
+        BPN::DistributedTrainer::PrintStats( std::cout, pTransport->GetNumRanks(), distributedTrainer.GetStats() );
+    }
+    else if ( numaBatchSize > 0 )
+    {
+        // NUMA-aware data parallel training
+        BPN::NumaTrainer::Settings numaSettings;
+        numaSettings.m_learningRate = trainerSettings.m_learningRate;
+        numaSettings.m_momentum = trainerSettings.m_momentum;
+        numaSettings.m_batchSize = numaBatchSize;
+        numaSettings.m_maxEpochs = trainerSettings.m_maxEpochs;
+        numaSettings.m_desiredAccuracy = trainerSettings.m_desiredAccuracy;
+        numaSettings.m_numThreads = numThreads;
+        numaSettings.m_pTelemetrySink = trainerSettings.m_pTelemetrySink;
+
+        BPN::NumaTrainer numaTrainer( numaSettings, &nn );
+        numaTrainer.Train( dataReader.GetTrainingData() );
+        BPN::NumaTrainer::PrintStats( std::cout, numaTrainer.GetStats() );
+    }
+    else if ( useCompactStorage )
+    {
+        BPN::CompactTrainingSet::PrintStats( std::cout, dataReader.GetCompactTrainingData().m_trainingSet );
+
+        BPN::NetworkTrainer trainer( trainerSettings, &nn );
+        trainer.Train( dataReader.GetCompactTrainingData() );
+    }
+    else if ( cmdParser.get<bool>( "dedup" ) )
+    {
+        BPN::TrainingData const& trainingData = dataReader.GetTrainingData();
+        BPN::TrainingData uniqueData;
+        BPN::RowDeduplicator::PrintStats( std::cout, "training", BPN::RowDeduplicator::Collapse( trainingData.m_trainingSet, uniqueData.m_trainingSet, numThreads ) );
+        BPN::RowDeduplicator::PrintStats( std::cout, "generalization", BPN::RowDeduplicator::Collapse( trainingData.m_generalizationSet, uniqueData.m_generalizationSet, numThreads ) );
+        BPN::RowDeduplicator::PrintStats( std::cout, "validation", BPN::RowDeduplicator::Collapse( trainingData.m_validationSet, uniqueData.m_validationSet, numThreads ) );
+
+        BPN::NetworkTrainer trainer( trainerSettings, &nn );
+        trainer.Train( uniqueData );
+    }
+    else
+    {
+        BPN::NetworkTrainer trainer( trainerSettings, &nn );
+        trainer.Train( dataReader.GetTrainingData() );
+    }
+
+    // Distill trained network into a smaller student, the student replaces the teacher for pruning, saving and exporting
+    uint32_t const distillNumHidden = cmdParser.get<uint32_t>( "distill" );
+    if ( distillNumHidden > 0 )
+    {
+        std::vector<double> teacherOutputs;
+        BPN::Distiller::GetTeacherOutputs( nn, dataReader.GetTrainingData().m_trainingSet, teacherOutputs );
+
+        BPN::Network student( BPN::Network::Settings{ numInputs, distillNumHidden, numOutputs, seed } );
+        BPN::NetworkTrainer studentTrainer( trainerSettings, &student );
+        studentTrainer.Distill( dataReader.GetTrainingData(), teacherOutputs );
+
+        BPN::Distiller::PrintReport( std::cout, BPN::Distiller::CompareWithTeacher( nn, student, dataReader.GetTrainingData().m_validationSet ) );
+        nn = student;
+    }
+
+    // Prune trained network, the pruned network replaces the dense one for saving and exporting
+    double const pruneSparsity = cmdParser.get<double>( "prune" );
+    if ( pruneSparsity > 0 )
+    {
+        if ( pruneSparsity >= 1.0 )
+        {
+            std::cout << "Invalid pruning sparsity: " << pruneSparsity << std::endl;
+            return 1;
+        }
+
+        BPN::Network prunedNetwork( nn );
+        BPN::NetworkTrainer::Settings pruningTrainerSettings = trainerSettings;
+        if ( cmdParser.get<bool>( "pruneOneShot" ) )
+        {
+            BPN::NetworkTrainer pruningTrainer( pruningTrainerSettings, &prunedNetwork );
+            pruningTrainer.PruneInputHiddenWeights( pruneSparsity );
+        }
+        else
+        {
+            pruningTrainerSettings.m_targetSparsity = pruneSparsity;
+            BPN::NetworkTrainer pruningTrainer( pruningTrainerSettings, &prunedNetwork );
+            pruningTrainer.Train( dataReader.GetTrainingData() );
+        }
+
+        BPN::NetworkPruner::PrintReport( std::cout, BPN::NetworkPruner::CompareWithDense( nn, prunedNetwork, dataReader.GetTrainingData().m_validationSet ) );
+        nn = prunedNetwork;
+    }
+
+    // Save trained network
+    std::string const modelPath = cmdParser.get<std::string>( "save" );
+    if ( !modelPath.empty() )
+    {
+        if ( !BPN::SaveNetwork( modelPath, nn, dataReader.GetNormalizer() ) )
+        {
+            return 1;
+        }
+
+        std::cout << "Saved network to: " << modelPath << std::endl;
+    }
+
+    // Export trained network
+    std::string const exportPath = cmdParser.get<std::string>( "export" );
+    if ( !exportPath.empty() )
+    {
+        // The exported network takes the raw inputs
+        BPN::Network const exportedNetwork = dataReader.GetNormalizer().FoldIntoNetwork( nn );
+        BPN::NetworkExporter::Settings exporterSettings;
+        BPN::NetworkExporter exporter( exporterSettings, exportedNetwork );
+        if ( !exporter.ExportHeader( exportPath ) )
+        {
+            std::cout << "Error Writing Export File: " << exportPath << std::endl;
+            return 1;
+        }
+
+        // Verify against the validation set
+        std::vector<std::vector<double>> verificationInputs;
+        for ( auto const& entry : dataReader.GetTrainingData().m_validationSet )
+        {
+            verificationInputs.push_back( entry.m_inputs );
+            dataReader.GetNormalizer().Restore( verificationInputs.back() );
+            if ( verificationInputs.size() == 1000 )
+            {
+                break;
+            }
+        }
+
+        size_t const filenameStart = exportPath.find_last_of( "/\\" );
+        std::string const headerFilename = ( filenameStart == std::string::npos ) ? exportPath : exportPath.substr( filenameStart + 1 );
+        size_t const extensionStart = exportPath.find_last_of( '.' );
+        bool const hasExtension = extensionStart != std::string::npos && ( filenameStart == std::string::npos || extensionStart > filenameStart );
+        std::string const verificationPath = ( hasExtension ? exportPath.substr( 0, extensionStart ) : exportPath ) + "_Verify.cpp";
+        if ( verificationInputs.empty() || !exporter.ExportVerificationProgram( verificationPath, headerFilename, verificationInputs ) )
+        {
+            std::cout << "Error Writing Verification Program: " << verificationPath << std::endl;
+            return 1;
+        }
+
+        std::cout << "Exported network to: " << exportPath << ", verification program: " << verificationPath << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#-------------------------------------------------------------------------
+# Simple back-propagation neural network example
+# 2017 - Bobby Anguelov
+# MIT license: https://opensource.org/licenses/MIT
+#-------------------------------------------------------------------------
+# Profile guided optimization workflow
+#
+# Builds an instrumented release build, trains on the example data set to collect a profile and then
+# rebuilds the same build directory using that profile. The same build directory is reused for both
+# stages since GCC keys its profile data on the object file paths.
+#
+# Usage: cmake -DNN_PGO_BINARY_DIR=<build dir> [-DNN_ARCH=native] [-DCMAKE_CXX_COMPILER=clang++] -P cmake/ProfileGuidedBuild.cmake
+
+cmake_minimum_required( VERSION 3.13 )
+
+get_filename_component( NN_SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE )
+
+if ( NOT NN_PGO_BINARY_DIR )
+    set( NN_PGO_BINARY_DIR "${NN_SOURCE_DIR}/build-pgo" )
+endif ()
+
+set( NN_PGO_PROFILE_DIR "${NN_PGO_BINARY_DIR}/pgo-profile" )
+set( NN_CONFIGURE_ARGS -S "${NN_SOURCE_DIR}" -B "${NN_PGO_BINARY_DIR}" -DCMAKE_BUILD_TYPE=Release "-DNN_PGO_PROFILE_DIR=${NN_PGO_PROFILE_DIR}" )
+
+if ( NN_ARCH )
+    list( APPEND NN_CONFIGURE_ARGS "-DNN_ARCH=${NN_ARCH}" )
+endif ()
+
+if ( CMAKE_CXX_COMPILER )
+    list( APPEND NN_CONFIGURE_ARGS "-DCMAKE_CXX_COMPILER=${CMAKE_CXX_COMPILER}" )
+endif ()
+
+function( nn_run_step description )
+    message( STATUS "PGO: ${description}" )
+    execute_process( COMMAND ${ARGN} RESULT_VARIABLE result )
+    if ( NOT result EQUAL 0 )
+        message( FATAL_ERROR "PGO: ${description} failed" )
+    endif ()
+endfunction ()
+
+file( REMOVE_RECURSE "${NN_PGO_PROFILE_DIR}" )
+
+nn_run_step( "Configuring instrumented build" ${CMAKE_COMMAND} ${NN_CONFIGURE_ARGS} -DNN_PGO=GENERATE )
+nn_run_step( "Building instrumented build" ${CMAKE_COMMAND} --build "${NN_PGO_BINARY_DIR}" --config Release )
+nn_run_step( "Training on the example data set" ${CMAKE_COMMAND} --build "${NN_PGO_BINARY_DIR}" --config Release --target pgo-train )
+nn_run_step( "Configuring optimized build" ${CMAKE_COMMAND} ${NN_CONFIGURE_ARGS} -DNN_PGO=USE )
+nn_run_step( "Building optimized build" ${CMAKE_COMMAND} --build "${NN_PGO_BINARY_DIR}" --config Release )
+
+message( STATUS "PGO: Optimized build complete in ${NN_PGO_BINARY_DIR}" )